@@ -95,6 +95,10 @@
 //----------------------------------------------------------------------------
 #define MAX_DISK                4
 //----------------------------------------------------------------------------
+/**
+ *  @param  DISK_NAME_SIZE      Longest disk image file name ( with NUL )   */
+#define DISK_NAME_SIZE          256
+//----------------------------------------------------------------------------
 
 /****************************************************************************
  * Enumerations
@@ -108,6 +112,51 @@
  ****************************************************************************/
 
 //----------------------------------------------------------------------------
+/**
+ *  @param  machine_t           Guest machine context ( machine.h )         */
+struct  machine_t;
+//----------------------------------------------------------------------------
+/**
+ *  @param  bios_drive_image_t  Snapshot of one drive                       */
+struct  bios_drive_image_t
+{
+    /**
+     *  @param  disk_name       Mounted image file, empty when none         */
+    char                        disk_name[ DISK_NAME_SIZE ];
+    /**
+     *  @param  track_num       Track number for the next W/R               */
+    uint16_t                    track_num;
+    /**
+     *  @param  sector_num      Sector number for the next W/R              */
+    uint16_t                    sector_num;
+    /**
+     *  @param  dma_addr        Disk data W/R transfer address              */
+    uint16_t                    dma_addr;
+    /**
+     *  @param  sec_track       Number of sectors per track                 */
+    uint16_t                    sec_track;
+    /**
+     *  @param  disk_parm_tbl   Disk Parameter Table                        */
+    uint16_t                    disk_parm_tbl;
+};
+//----------------------------------------------------------------------------
+/**
+ *  @param  bios_image_t        Snapshot of the devices of a guest          */
+struct  bios_image_t
+{
+    /**
+     *  @param  disk_id         Currently selected disk ID                  */
+    uint8_t                     disk_id;
+    /**
+     *  @param  conin_state     Extended character sequence being read      */
+    uint8_t                     conin_state;
+    /**
+     *  @param  console         BOOT had set up the console and devices     */
+    uint8_t                     console;
+    /**
+     *  @param  drive           The mount table                             */
+    struct  bios_drive_image_t  drive[ MAX_DISK ];
+};
 //----------------------------------------------------------------------------
 
 /****************************************************************************
@@ -139,6 +188,28 @@ bios_mount(
     );
 //----------------------------------------------------------------------------
 void
+bios_overlay(
+    int                         drive_num,
+    char                    *   file_name
+    );
+//----------------------------------------------------------------------------
+void
+bios_commit(
+    int                         drive_num
+    );
+//----------------------------------------------------------------------------
+void
+bios_discard(
+    int                         drive_num
+    );
+//----------------------------------------------------------------------------
+bool
+bios_cache(
+    const
+    char                    *   request
+    );
+//----------------------------------------------------------------------------
+void
 cpm_bios(
     void
     );
@@ -148,6 +219,38 @@ bios_shutdown(
     void
     );
 //----------------------------------------------------------------------------
+void
+bios_create(
+    struct  machine_t       *   guest
+    );
+//----------------------------------------------------------------------------
+void
+bios_destroy(
+    struct  machine_t       *   guest
+    );
+//----------------------------------------------------------------------------
+void
+bios_console_fd(
+    int                         in_fd,
+    int                         out_fd
+    );
+//----------------------------------------------------------------------------
+void
+bios_private_disks(
+    void
+    );
+//----------------------------------------------------------------------------
+void
+bios_save(
+    struct  bios_image_t    *   image
+    );
+//----------------------------------------------------------------------------
+void
+bios_load(
+    const
+    struct  bios_image_t    *   image
+    );
+//----------------------------------------------------------------------------
 
 /****************************************************************************/
 
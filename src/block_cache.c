@@ -0,0 +1,782 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Decoded basic block cache.
+ *
+ *  A block is a straight line run of instructions starting at a guest
+ *  Program Counter.  Each instruction is decoded once into the inlined body
+ *  that executes it, its op-code, its immediate operand and the Program
+ *  Counter that follows it.  A block ends after a jump, call, return or
+ *  restart, after any instruction that is not inlined (it runs through the
+ *  op-code tables which decode their own operands), when the next
+ *  instruction starts in another 256 byte page or when it is full.
+ *
+ *  Every byte covered by a block is marked in a per-page code bitmap.  A
+ *  write through memory_put_8( ), memory_put_16( ) or memory_load( ) to a
+ *  marked byte discards the blocks that contain it.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <unistd.h>             //  UNIX standard library.
+#include <stdio.h>              //  Standard I/O definitions
+#include <string.h>             //  Functions for managing strings
+                                //*******************************************
+
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "memory.h"             //  Memory management and access
+#include "inst_threaded.h"      //  Threaded code interpreter
+#include "block_cache.h"        //  Decoded basic block cache
+#include "jit.h"                //  x86-64 translator
+#include "machine.h"            //  Guest machine context
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  BLOCK_PAGES         Number of 256 byte pages in main memory     */
+#define BLOCK_PAGES             ( 256 )
+//----------------------------------------------------------------------------
+/**
+ *  @param  CACHE               Cached blocks of the bound guest            */
+#define CACHE                   ( machine->block_cache )
+//----------------------------------------------------------------------------
+/**
+ *  @param  IS_CODE             Is the byte at 'A' part of a cached block   */
+#define IS_CODE( A )            ( CACHE->block_code_map[ ( A ) >> 8 ][ ( ( A ) >> 3 ) & 0x1F ] \
+                                  & ( 1 << ( ( A ) & 0x07 ) ) )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  block_cache_t       The cached blocks of one guest              */
+struct  block_cache_t
+{
+    /**
+     *  @param  block_map       Cached block for each Program Counter       */
+    struct  block_t         *   block_map[ 0x10000 ];
+    /**
+     *  @param  block_page      Blocks that start in each page              */
+    struct  block_t         *   block_page[ BLOCK_PAGES ];
+    /**
+     *  @param  block_code_map  One bit for every byte of cached code       */
+    uint8_t                     block_code_map[ BLOCK_PAGES ][ 32 ];
+    /**
+     *  @param  block_retired   Invalidated blocks waiting to be freed      */
+    struct  block_t         *   block_retired;
+    /**
+     *  @param  block_cpu       CPU mode the cached blocks were decoded for */
+    enum    CPU_e               block_cpu;
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Number of bytes in an inlined instruction.
+ *
+ *  @param  th_op               The inlined body
+ *
+ *  @return                     Instruction length
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+int
+block_op_length(
+    uint8_t                     th_op
+    )
+{
+    /**
+     *  @param  length          Instruction length                          */
+    int                         length;
+
+    switch( th_op )
+    {
+        case    TH_LD_RN:
+        case    TH_LD_HLN:
+        case    TH_ADD_N:
+        case    TH_ADC_N:
+        case    TH_SUB_N:
+        case    TH_SBC_N:
+        case    TH_AND_N:
+        case    TH_OR_N:
+        case    TH_XOR_N:
+        case    TH_CP_N:
+        case    TH_JR:
+        case    TH_JR_CC:
+        case    TH_DJNZ:
+            length = 2;
+            break;
+
+        case    TH_LD_ANN:
+        case    TH_LD_NNA:
+        case    TH_LD_SSNN:
+        case    TH_LD_HLNN:
+        case    TH_LD_NNHL:
+        case    TH_JP:
+        case    TH_JP_CC:
+        case    TH_CALL_NN:
+        case    TH_CALL_CC:
+            length = 3;
+            break;
+
+        default:
+            length = 1;
+    }
+
+    //  DONE!
+    return( length );
+}
+
+/****************************************************************************/
+/**
+ *  Does the instruction end a block ?
+ *
+ *  @param  th_op               The inlined body
+ *
+ *  @return                     true when no more instructions follow it
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+bool
+block_op_ends(
+    uint8_t                     th_op
+    )
+{
+    switch( th_op )
+    {
+        case    TH_CALL:
+        case    TH_JP:
+        case    TH_JP_CC:
+        case    TH_JP_HL:
+        case    TH_JR:
+        case    TH_JR_CC:
+        case    TH_DJNZ:
+        case    TH_CALL_NN:
+        case    TH_CALL_CC:
+        case    TH_RET:
+        case    TH_RET_CC:
+        case    TH_RST:
+            return( true );
+    }
+
+    //  DONE!
+    return( false );
+}
+
+/****************************************************************************/
+/**
+ *  Free the blocks that were invalidated while they may have been running.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+block_free_retired(
+    void
+    )
+{
+    /**
+     *  @param  block           Block being freed                           */
+    struct  block_t         *   block;
+
+    //  Loop through the retired list
+    while( CACHE->block_retired != NULL )
+    {
+        block = CACHE->block_retired;
+        CACHE->block_retired = block->page_next;
+        free( block );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Decode a new block.
+ *
+ *  @param  pc                  Address of the first instruction
+ *  @param  th_table            Inlined body for each op-code
+ *
+ *  @return                     The new block
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+struct  block_t *
+block_build(
+    uint16_t                    pc,
+    const
+    uint8_t                 *   th_table
+    )
+{
+    /**
+     *  @param  entry           Decoded instructions                        */
+    struct  block_entry_t       entry[ BLOCK_MAX_ENTRIES + 1 ];
+    /**
+     *  @param  count           Number of decoded instructions              */
+    int                         count;
+    /**
+     *  @param  address         Address of the instruction being decoded    */
+    uint32_t                    address;
+    /**
+     *  @param  length          Instruction length                          */
+    int                         length;
+    /**
+     *  @param  code            Address of a decoded byte                   */
+    uint32_t                    code;
+    /**
+     *  @param  block           The new block                               */
+    struct  block_t         *   block;
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    //  Nothing has been decoded yet
+    count = 0;
+    address = pc;
+
+    /************************************************************************
+     *  Function Code
+     ************************************************************************/
+
+    //  Decode instructions until the block has to end
+    while( count < BLOCK_MAX_ENTRIES )
+    {
+        entry[ count ].op_code = memory_get_8( (uint16_t)address );
+        entry[ count ].th_op   = th_table[ entry[ count ].op_code ];
+        entry[ count ].operand = 0;
+
+        //  Is this instruction run from the op-code tables ?
+        if ( entry[ count ].th_op == TH_CALL )
+        {
+            //  YES:    The handler fetches its own operands
+            length = 1;
+        }
+        else
+        {
+            //  NO:     Decode the immediate operand
+            length = block_op_length( entry[ count ].th_op );
+
+            if ( length == 2 )
+            {
+                entry[ count ].operand = memory_get_8( (uint16_t)( address + 1 ) );
+
+                //  Relative jumps get a sign extended displacement
+                if (    ( entry[ count ].th_op == TH_JR    )
+                     || ( entry[ count ].th_op == TH_JR_CC )
+                     || ( entry[ count ].th_op == TH_DJNZ  ) )
+                {
+                    entry[ count ].operand = (uint16_t)(int8_t)entry[ count ].operand;
+                }
+            }
+            else
+            if ( length == 3 )
+            {
+                entry[ count ].operand = (uint16_t)(
+                      ( memory_get_8( (uint16_t)( address + 1 ) )      )
+                    | ( memory_get_8( (uint16_t)( address + 2 ) ) << 8 ) );
+            }
+        }
+
+        address += length;
+        entry[ count ].pc_next = (uint16_t)address;
+        count += 1;
+
+        //  Does this instruction end the block ?
+        if ( block_op_ends( entry[ count - 1 ].th_op ) == true )
+        {
+            //  YES:    Done
+            break;
+        }
+
+        //  Does the next instruction start in another page ?
+        if ( ( address >> 8 ) != ( pc >> 8 ) )
+        {
+            //  YES:    Done
+            break;
+        }
+    }
+
+    //  Terminate the block
+    entry[ count ].th_op   = TH_BLOCK_END;
+    entry[ count ].op_code = 0;
+    entry[ count ].pc_next = 0;
+    entry[ count ].operand = 0;
+
+    //  Allocate the block
+    block = malloc( sizeof( struct block_t )
+                  + sizeof( struct block_entry_t ) * ( count + 1 ) );
+    if ( block == NULL )
+    {
+        printf( "block_cache: out of memory\n" );
+        exit( 1 );
+    }
+    block->pc  = pc;
+    block->end = address;
+    block->hits = 0;
+    block->jit_code = NULL;
+    block->jit_count = 0;
+    block->count = count;
+    memcpy( block->entry, entry, sizeof( struct block_entry_t ) * ( count + 1 ) );
+
+    //  Link it into the cache
+    CACHE->block_map[ pc ] = block;
+    block->page_next = CACHE->block_page[ pc >> 8 ];
+    CACHE->block_page[ pc >> 8 ] = block;
+
+    //  Mark the bytes it was decoded from
+    for( code = pc; code < address; code += 1 )
+    {
+        CACHE->block_code_map[ ( code >> 8 ) & 0xFF ][ ( code >> 3 ) & 0x1F ]
+            |= ( 1 << ( code & 0x07 ) );
+    }
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    //  DONE!
+    return( block );
+}
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Get the block that starts at 'pc', decoding it when it isn't cached.
+ *
+ *  @param  pc                  Program Counter
+ *  @param  th_table            Inlined body for each op-code
+ *
+ *  @return                     The block
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+struct  block_t *
+block_cache_lookup(
+    uint16_t                    pc,
+    const
+    uint8_t                 *   th_table
+    )
+{
+    /**
+     *  @param  block           The block                                   */
+    struct  block_t         *   block;
+
+    //  Nothing that runs from here on can be stale
+    machine->block_stale = false;
+
+    //  Is the block already cached ?
+    block = CACHE->block_map[ pc ];
+    if ( block == NULL )
+    {
+        //  NO:     Nothing can be running an invalidated block now
+        block_free_retired( );
+
+        //  Decode it
+        block = block_build( pc, th_table );
+    }
+
+    //  DONE!
+    return( block );
+}
+
+/****************************************************************************/
+/**
+ *  Main memory is about to change.  Discard every block that was decoded
+ *  from the byte at 'address'.
+ *
+ *  @param  address             Memory address
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Blocks never start in one page and run past the first two bytes of
+ *      the next, so only two page lists have to be searched.
+ *
+ ****************************************************************************/
+
+void
+block_cache_write(
+    uint16_t                    address
+    )
+{
+    /**
+     *  @param  page            Page being searched                         */
+    int                         page;
+    /**
+     *  @param  link            Link to the block being checked             */
+    struct  block_t         **  link;
+    /**
+     *  @param  block           The block being checked                     */
+    struct  block_t         *   block;
+
+    //  Is this byte part of a cached block ?
+    if ( IS_CODE( address ) == 0 )
+    {
+        //  NO:     Nothing to do
+        return;
+    }
+
+    //  Search this page and (when near its start) the previous one
+    for( page = address >> 8;
+         page >= ( ( address & 0xFF ) < 2 ? ( address >> 8 ) - 1 : ( address >> 8 ) );
+         page -= 1 )
+    {
+        link = &CACHE->block_page[ page & 0xFF ];
+
+        while( *link != NULL )
+        {
+            block = *link;
+
+            //  Was the block decoded from this byte ?
+            if ( (uint16_t)( address - block->pc ) < ( block->end - block->pc ) )
+            {
+                //  YES:    Unlink it and retire it
+                *link = block->page_next;
+                CACHE->block_map[ block->pc ] = NULL;
+                block->page_next = CACHE->block_retired;
+                CACHE->block_retired = block;
+                machine->block_stale = true;
+            }
+            else
+            {
+                link = &block->page_next;
+            }
+        }
+    }
+
+    //  No remaining block covers this byte
+    CACHE->block_code_map[ address >> 8 ][ ( address >> 3 ) & 0x1F ]
+        &= ~( 1 << ( address & 0x07 ) );
+}
+
+/****************************************************************************/
+/**
+ *  A range of main memory is about to change.  Discard every block that
+ *  was decoded from any byte of it.
+ *
+ *  @param  address             First memory address
+ *  @param  size                Number of bytes
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Works a page at a time, so a bank switch costs one pass over the
+ *      page lists rather than one block_cache_write( ) per byte.
+ *
+ ****************************************************************************/
+
+void
+block_cache_write_range(
+    uint16_t                    address,
+    uint32_t                    size
+    )
+{
+    /**
+     *  @param  page            Page being searched                         */
+    uint32_t                    page;
+    /**
+     *  @param  last            Last page of the range                      */
+    uint32_t                    last;
+    /**
+     *  @param  link            Link to the block being checked             */
+    struct  block_t         **  link;
+    /**
+     *  @param  block           The block being checked                     */
+    struct  block_t         *   block;
+    /**
+     *  @param  offset          Offset of the byte being unmarked           */
+    uint32_t                    offset;
+
+    //  Is there anything to discard ?
+    if ( size == 0 )
+    {
+        //  NO:     Nothing to do
+        return;
+    }
+    if ( size > MEMORY_SIZE )
+    {
+        size = MEMORY_SIZE;
+    }
+    last = ( (uint32_t)address + size - 1 ) >> 8;
+
+    //  Search every page of the range and the one before it, whose blocks
+    //  can run into the first page
+    for( page = ( address >> 8 ) + BLOCK_PAGES - 1;
+         page <= last + BLOCK_PAGES;
+         page += 1 )
+    {
+        link = &CACHE->block_page[ page & 0xFF ];
+
+        while( *link != NULL )
+        {
+            block = *link;
+
+            //  Does the block overlap the range ?
+            if (    ( (uint16_t)( block->pc - address ) < size )
+                 || ( (uint16_t)( address - block->pc ) < ( block->end - block->pc ) ) )
+            {
+                //  YES:    Unlink it and retire it
+                *link = block->page_next;
+                CACHE->block_map[ block->pc ] = NULL;
+                block->page_next = CACHE->block_retired;
+                CACHE->block_retired = block;
+                machine->block_stale = true;
+            }
+            else
+            {
+                link = &block->page_next;
+            }
+        }
+    }
+
+    //  No remaining block covers the range, whole pages are unmarked at once
+    for( offset = 0; offset < size; )
+    {
+        page = ( (uint16_t)( address + offset ) ) >> 8;
+
+        if (    ( ( ( address + offset ) & 0xFF ) == 0 )
+             && ( ( size - offset ) >= 256 ) )
+        {
+            memset( CACHE->block_code_map[ page ], 0,
+                    sizeof( CACHE->block_code_map[ page ] ) );
+            offset += 256;
+        }
+        else
+        {
+            CACHE->block_code_map[ page ][ ( ( address + offset ) >> 3 ) & 0x1F ]
+                &= ~( 1 << ( ( address + offset ) & 0x07 ) );
+            offset += 1;
+        }
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Make sure the cached blocks were decoded for the requested CPU mode.
+ *
+ *  @param  cpu                 The CPU mode about to run
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+block_cache_select(
+    enum    CPU_e               cpu
+    )
+{
+    //  Were the blocks decoded for another CPU ?
+    if ( CACHE->block_cpu != cpu )
+    {
+        //  YES:    Throw them away
+        block_cache_flush( );
+        CACHE->block_cpu = cpu;
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Discard every cached block.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+block_cache_flush(
+    void
+    )
+{
+    /**
+     *  @param  page            Page being flushed                          */
+    int                         page;
+    /**
+     *  @param  block           The block being discarded                   */
+    struct  block_t         *   block;
+
+    //  Loop through all pages
+    for( page = 0; page < BLOCK_PAGES; page += 1 )
+    {
+        //  Retire every block that starts in this page
+        while( CACHE->block_page[ page ] != NULL )
+        {
+            block = CACHE->block_page[ page ];
+            CACHE->block_page[ page ] = block->page_next;
+            CACHE->block_map[ block->pc ] = NULL;
+            block->page_next = CACHE->block_retired;
+            CACHE->block_retired = block;
+        }
+    }
+
+    //  Nothing is cached anymore
+    memset( CACHE->block_code_map, 0, sizeof( CACHE->block_code_map ) );
+    machine->block_stale = true;
+
+#if JIT_ENABLE
+    //  None of the translated code can be reached anymore
+    jit_flush( );
+#endif
+}
+
+/****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Give a new guest an empty block cache.
+ *
+ *  @param  guest               The guest
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called by machine_create( ).
+ *
+ ****************************************************************************/
+
+void
+block_cache_create(
+    struct  machine_t       *   guest
+    )
+{
+    guest->block_cache = calloc( 1, sizeof( struct block_cache_t ) );
+    if ( guest->block_cache == NULL )
+    {
+        printf( "block_cache: out of memory\n" );
+        exit( 1 );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Free the block cache of a guest.
+ *
+ *  @param  guest               The guest
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called by machine_destroy( ), the guest need not be bound.
+ *
+ ****************************************************************************/
+
+void
+block_cache_destroy(
+    struct  machine_t       *   guest
+    )
+{
+    /**
+     *  @param  cache           The cache being freed                       */
+    struct  block_cache_t   *   cache;
+    /**
+     *  @param  page            Page being freed                            */
+    int                         page;
+    /**
+     *  @param  block           The block being freed                       */
+    struct  block_t         *   block;
+
+    cache = guest->block_cache;
+
+    //  Was a cache ever created ?
+    if ( cache == NULL )
+    {
+        //  NO:     Nothing to do
+        return;
+    }
+
+    //  Free the cached and the retired blocks
+    for( page = 0; page < BLOCK_PAGES; page += 1 )
+    {
+        while( cache->block_page[ page ] != NULL )
+        {
+            block = cache->block_page[ page ];
+            cache->block_page[ page ] = block->page_next;
+            free( block );
+        }
+    }
+    while( cache->block_retired != NULL )
+    {
+        block = cache->block_retired;
+        cache->block_retired = block->page_next;
+        free( block );
+    }
+
+    free( cache );
+    guest->block_cache = NULL;
+}
+
+/****************************************************************************/
@@ -0,0 +1,168 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+#ifndef BLOCK_CACHE_H
+#define BLOCK_CACHE_H
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Decoded basic block cache.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * System APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Application APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  BLOCK_MAX_ENTRIES   Maximum instructions in one decoded block   */
+#define BLOCK_MAX_ENTRIES       ( 32 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  machine_t           Guest machine context ( machine.h )         */
+struct  machine_t;
+//----------------------------------------------------------------------------
+/**
+ *  @param  block_entry_t       One pre-decoded instruction                 */
+struct  block_entry_t
+{
+    /**
+     *  @param  th_op           Inlined body (enum threaded_op_e)           */
+    uint8_t                     th_op;
+    /**
+     *  @param  op_code         The operation code of the instruction       */
+    uint8_t                     op_code;
+    /**
+     *  @param  pc_next         Program Counter when the body starts        */
+    uint16_t                    pc_next;
+    /**
+     *  @param  operand         Immediate n, nn or sign extended e          */
+    uint16_t                    operand;
+};
+//----------------------------------------------------------------------------
+/**
+ *  @param  block_t             A straight line run of decoded instructions */
+struct  block_t
+{
+    /**
+     *  @param  pc              Address of the first instruction            */
+    uint16_t                    pc;
+    /**
+     *  @param  end             Address following the last byte decoded     */
+    uint32_t                    end;
+    /**
+     *  @param  page_next       Next block that starts in the same page     */
+    struct  block_t         *   page_next;
+    /**
+     *  @param  hits            Number of times the block was entered       */
+    uint32_t                    hits;
+    /**
+     *  @param  jit_code        Translated host code or NULL                */
+    void                    *   jit_code;
+    /**
+     *  @param  jit_count       Number of leading entries translated        */
+    uint8_t                     jit_count;
+    /**
+     *  @param  count           Number of entries (excluding TH_BLOCK_END)  */
+    uint8_t                     count;
+    /**
+     *  @param  entry           Instructions followed by TH_BLOCK_END       */
+    struct  block_entry_t       entry[ ];
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Prototypes
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+struct  block_t *
+block_cache_lookup(
+    uint16_t                    pc,
+    const
+    uint8_t                 *   th_table
+    );
+//----------------------------------------------------------------------------
+void
+block_cache_write(
+    uint16_t                    address
+    );
+//----------------------------------------------------------------------------
+void
+block_cache_write_range(
+    uint16_t                    address,
+    uint32_t                    size
+    );
+//----------------------------------------------------------------------------
+void
+block_cache_select(
+    enum    CPU_e               cpu
+    );
+//----------------------------------------------------------------------------
+void
+block_cache_flush(
+    void
+    );
+//----------------------------------------------------------------------------
+void
+block_cache_create(
+    struct  machine_t       *   guest
+    );
+//----------------------------------------------------------------------------
+void
+block_cache_destroy(
+    struct  machine_t       *   guest
+    );
+//----------------------------------------------------------------------------
+
+/****************************************************************************/
+
+#endif                      //    BLOCK_CACHE_H
@@ -39,6 +39,9 @@
 #include "memory.h"             //  Memory management and access
 #include "registers.h"          //  All things CPU registers.
 #include "call.h"               //  Call instructions
+#include "profile.h"            //  Guest hot-spot profiler
+#include "interrupt.h"          //  Maskable interrupts
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -127,9 +130,10 @@ call_nn_i80(
 
     //  Jump to the address
     CPU_REG_PC = address;
+    PROFILE_CALL( address );
 
     //  Set the number of states for this instruction
-    operation_rc.states   =  17;
+    machine->operation_rc.states   =  17;
 }
 
 /****************************************************************************/
@@ -184,16 +188,17 @@ call_ccnn_i80(
 
         //  Jump to the address
         CPU_REG_PC = address;
+        PROFILE_CALL( address );
 
         //  Set the number of states for this instruction
-        operation_rc.states   =  17;
+        machine->operation_rc.states   =  17;
     }
     else
     {
         //  NO:     The the program continues with the next instruction
 
         //  Set the number of states for this instruction
-        operation_rc.states   =  10;
+        machine->operation_rc.states   =  10;
     }
 }
 
@@ -225,9 +230,10 @@ ret_i80(
 {
     //  Jump to the address
     CPU_REG_PC = pop( );
+    PROFILE_RET( );
 
     //  Set the number of states for this instruction
-    operation_rc.states   =  10;
+    machine->operation_rc.states   =  10;
 }
 
 /****************************************************************************/
@@ -270,16 +276,17 @@ ret_cc_i80(
     {
         //  YES:    Pop the new PC address from the stack
         CPU_REG_PC = pop( );
+        PROFILE_RET( );
 
         //  Set the number of states for this instruction
-        operation_rc.states   =  11;
+        machine->operation_rc.states   =  11;
     }
     else
     {
         //  NO:     The the program continues with the next instruction
 
         //  Set the number of states for this instruction
-        operation_rc.states   =   5;
+        machine->operation_rc.states   =   5;
     }
 }
 
@@ -332,9 +339,10 @@ rst_t_i80(
 
     //  YES:    Pop the new PC address from the stack
     CPU_REG_PC = ( op_code & 0x38 );
+    PROFILE_CALL( CPU_REG_PC );
 
     //  Set the number of states for this instruction
-    operation_rc.states   =  11;
+    machine->operation_rc.states   =  11;
 }
 
 /****************************************************************************/
@@ -359,9 +367,6 @@ rst_t_i80(
  *  @return                     No information is returned from this function.
  *
  *  @note
- *      This is ONLY a placeholder instruction for the foreseeable future.
- *      We are running in a simulator and there isn't any hardware and
- *      thus no interrupts.
  *
  ****************************************************************************/
 
@@ -370,8 +375,12 @@ reti_ED(
     uint8_t                     op_code
     )
 {
+    //  Return from the service routine
+    CPU_REG_PC = pop( );
+    PROFILE_RET( );
+
     //  Set the number of states for this instruction
-    operation_rc.states   =  14;
+    machine->operation_rc.states   =  14;
 }
 
 /****************************************************************************/
@@ -389,9 +398,6 @@ reti_ED(
  *  @return                     No information is returned from this function.
  *
  *  @note
- *      This is ONLY a placeholder instruction for the foreseeable future.
- *      We are running in a simulator and there isn't any hardware and
- *      thus no interrupts.
  *
  ****************************************************************************/
 
@@ -400,7 +406,14 @@ retn_ED(
     uint8_t                     op_code
     )
 {
+    //  Return from the service routine
+    CPU_REG_PC = pop( );
+    PROFILE_RET( );
+
+    //  IFF1 <- IFF2
+    interrupt_restore( );
+
     //  Set the number of states for this instruction
-    operation_rc.states   =  14;
+    machine->operation_rc.states   =  14;
 }
 /****************************************************************************/
\ No newline at end of file
@@ -27,6 +27,8 @@
 #include <stdlib.h>             //  ANSI standard library.
 #include <unistd.h>             //  UNIX standard library.
 #include <stdio.h>              //  Standard I/O definitions
+#include <pthread.h>            //  Host threads
+#include <stdatomic.h>          //  Atomic flags
                                 //*******************************************
 
 
@@ -40,6 +42,8 @@
 #include "registers.h"          //  All things CPU registers.
 #include "op_code.h"            //  OP-Code instruction maps
 #include "call.h"               //  Call instructions
+#include "interrupt.h"          //  Maskable interrupts
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -1572,6 +1576,634 @@ tc_rst_t_00(
     return( post_rc );
 }
 
+/****************************************************************************/
+/**
+ *  CALL    nn          (self modifying code)
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      The loop rewrites the operand of the subroutine every time it is
+ *      called.  It runs often enough for its blocks to be translated to
+ *      native code when the JIT is enabled.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_call_smc_00(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        0x31, 0x00, 0x01,       //  0000    LD      SP, x'0100
+        0x0E, 0x80,             //  0003    LD      C, x'80
+        0xCD, 0x10, 0x00,       //  0005 L1:CALL    x'0010
+        0x32, 0x11, 0x00,       //  0008    LD      (x'0011), A
+        0x0D,                   //  000B    DEC     C
+        0xC2, 0x05, 0x00,       //  000C    JP      NZ, L1
+        0x76,                   //  000F    HALT
+        0x3E, 0x00,             //  0010    LD      A, x'00
+        0x3C,                   //  0012    INC     A
+        0xC9      };            //  0013    RET
+
+    /************************************************************************
+     *  Run the program
+     ************************************************************************/
+
+    //  Assume a successful test run.
+    post_rc = true;
+
+    //  Load the program
+    memory_load( 0x0000, sizeof( program ), program );
+
+    //  Run the program
+    inst_fetch( );
+
+    /************************************************************************
+     *  Verify the results
+     ************************************************************************/
+
+    if (    (    CPU_REG_PC           != 0x0010 )
+         || (    CPU_REG_SP           != 0x0100 )
+         || (    GET_A( )             !=   0x80 )
+         || (    memory_get_8( 0x0011 ) != 0x80 ) )
+    {
+        //  NO:     Write an error message
+        printf( "POST: tc_call_smc_00 failed: [call nn]\n" );
+        printf( "POST: PC       = 0x%04X\n", CPU_REG_PC );
+        printf( "POST: SP       = 0x%04X\n", CPU_REG_SP );
+        printf( "POST: A        = 0x%02X\n", GET_A( ) );
+        printf( "POST: (0x0011) = 0x%02X\n", memory_get_8( 0x0011 ) );
+
+        //  Set the return code to FALSE.
+        post_rc = false;
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
+/****************************************************************************/
+/**
+ *  Interrupt   RST n ( IM 0 )
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      HALT waits for the interrupt, the device puts RST 10h on the data
+ *      bus.  The second HALT ends the run, the interrupt disabled IFF1.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_int_rst_00(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        0x31, 0x00, 0x02,       //  0000    LD      SP, x'0200
+        0x3E, 0x00,             //  0003    LD      A, x'00
+        0x00,                   //  0005    NOP
+        0x00,                   //  0006    NOP
+        0x00,                   //  0007    NOP
+        0x00,                   //  0008    NOP
+        0xFB,                   //  0009    EI
+        0x76,                   //  000A    HALT
+        0x06, 0x99,             //  000B    LD      B, x'99
+        0x76      };            //  000D    HALT
+
+    /**
+     *  @param  isr                 The interrupt service routine           */
+    uint8_t                     isr[ ] = {
+        0x3E, 0x77,             //  0010    LD      A, x'77
+        0xC9      };            //  0012    RET
+
+    /************************************************************************
+     *  Run the program
+     ************************************************************************/
+
+    //  Assume a successful test run.
+    post_rc = true;
+
+    //  Load the program
+    memory_load( 0x0000, sizeof( program ), program );
+    memory_load( 0x0010, sizeof( isr ), isr );
+
+    //  A device requests an interrupt
+    interrupt_raise( machine, 0xD7 );
+
+    //  Run the program
+    inst_fetch( );
+
+    /************************************************************************
+     *  Verify the results
+     ************************************************************************/
+
+    if (    (    CPU_REG_PC           != 0x000E )
+         || (    CPU_REG_SP           != 0x0200 )
+         || (    GET_A( )             !=   0x77 )
+         || (    CPU_REG_BC           != 0x9900 )
+         || (    machine->interrupt.line       !=      0 ) )
+    {
+        //  NO:     Write an error message
+        printf( "POST: tc_int_rst_00 failed: [interrupt]\n" );
+        printf( "POST: PC       = 0x%04X\n", CPU_REG_PC );
+        printf( "POST: SP       = 0x%04X\n", CPU_REG_SP );
+        printf( "POST: A        = 0x%02X\n", GET_A( ) );
+        printf( "POST: B        = 0x%02X\n", CPU_REG_BC >> 8 );
+
+        //  Set the return code to FALSE.
+        post_rc = false;
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
+/****************************************************************************/
+/**
+ *  The device of tc_int_halt_00
+ *
+ *  @param  arg                 The guest it interrupts.
+ *
+ *  @return                     NULL
+ *
+ *  @note
+ *      Raises the interrupt once the guest is halted and goes away.
+ *
+ ****************************************************************************/
+
+static
+void *
+tc_int_device(
+    void                    *   arg
+    )
+{
+    /**
+     *  @param  guest               The guest to interrupt                  */
+    struct  machine_t       *   guest;
+
+    guest = arg;
+
+    //  Wait for the HALT
+    while ( atomic_load( &guest->interrupt_wait.halted ) == false )
+    {
+        //  Spin
+    }
+
+    //  Put RST 10h on the data bus and leave
+    interrupt_raise( guest, 0xD7 );
+    interrupt_source( guest, false );
+
+    //  DONE!
+    return( NULL );
+}
+
+/****************************************************************************/
+/**
+ *  Interrupt   from another host thread
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      HALT sleeps until a device thread raises the interrupt.  The second
+ *      HALT ends the run, the interrupt disabled IFF1.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_int_halt_00(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+    /**
+     *  @param  device              The device thread                       */
+    pthread_t                   device;
+
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        0x31, 0x00, 0x02,       //  0000    LD      SP, x'0200
+        0x3E, 0x00,             //  0003    LD      A, x'00
+        0xFB,                   //  0005    EI
+        0x00,                   //  0006    NOP
+        0x76,                   //  0007    HALT
+        0x06, 0x99,             //  0008    LD      B, x'99
+        0x76      };            //  000A    HALT
+
+    /**
+     *  @param  isr                 The interrupt service routine           */
+    uint8_t                     isr[ ] = {
+        0x3E, 0x77,             //  0010    LD      A, x'77
+        0xC9      };            //  0012    RET
+
+    /************************************************************************
+     *  Run the program
+     ************************************************************************/
+
+    //  Assume a successful test run.
+    post_rc = true;
+
+    //  Load the program
+    memory_load( 0x0000, sizeof( program ), program );
+    memory_load( 0x0010, sizeof( isr ), isr );
+
+    //  Attach a device that runs on its own thread
+    interrupt_source( machine, true );
+    if ( pthread_create( &device, NULL, tc_int_device, machine ) != 0 )
+    {
+        printf( "POST: tc_int_halt_00 failed: pthread_create\n" );
+        exit( 1 );
+    }
+
+    //  Run the program
+    inst_fetch( );
+    pthread_join( device, NULL );
+
+    /************************************************************************
+     *  Verify the results
+     ************************************************************************/
+
+    if (    (    CPU_REG_PC           != 0x000B )
+         || (    CPU_REG_SP           != 0x0200 )
+         || (    GET_A( )             !=   0x77 )
+         || (    CPU_REG_BC           != 0x9900 )
+         || (    machine->interrupt.line       !=      0 ) )
+    {
+        //  NO:     Write an error message
+        printf( "POST: tc_int_halt_00 failed: [interrupt]\n" );
+        printf( "POST: PC       = 0x%04X\n", CPU_REG_PC );
+        printf( "POST: SP       = 0x%04X\n", CPU_REG_SP );
+        printf( "POST: A        = 0x%02X\n", GET_A( ) );
+        printf( "POST: B        = 0x%02X\n", CPU_REG_BC >> 8 );
+
+        //  Set the return code to FALSE.
+        post_rc = false;
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
+/****************************************************************************/
+/**
+ *  HALT        with interrupts enabled and no device
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      Nothing can raise an interrupt, HALT ends the run.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_int_halt_01(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        0x31, 0x00, 0x02,       //  0000    LD      SP, x'0200
+        0xFB,                   //  0003    EI
+        0x76,                   //  0004    HALT
+        0x06, 0x99,             //  0005    LD      B, x'99
+        0x76      };            //  0007    HALT
+
+    /************************************************************************
+     *  Run the program
+     ************************************************************************/
+
+    //  Assume a successful test run.
+    post_rc = true;
+
+    //  Load the program
+    memory_load( 0x0000, sizeof( program ), program );
+
+    //  Run the program
+    inst_fetch( );
+
+    /************************************************************************
+     *  Verify the results
+     ************************************************************************/
+
+    if (    (    CPU_REG_PC           != 0x0005 )
+         || (    CPU_REG_SP           != 0x0200 )
+         || (    CPU_REG_BC           != 0x0000 )
+         || (    machine->interrupt.iff1       != true ) )
+    {
+        //  NO:     Write an error message
+        printf( "POST: tc_int_halt_01 failed: [halt]\n" );
+        printf( "POST: PC       = 0x%04X\n", CPU_REG_PC );
+        printf( "POST: SP       = 0x%04X\n", CPU_REG_SP );
+        printf( "POST: B        = 0x%02X\n", CPU_REG_BC >> 8 );
+
+        //  Set the return code to FALSE.
+        post_rc = false;
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
+/****************************************************************************/
+/**
+ *  Interrupt   IM 1
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      The interrupt restarts at x'0038 and returns with RETI.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_int_im1_00(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        0x31, 0x00, 0x02,       //  0000    LD      SP, x'0200
+        0x3E, 0x00,             //  0003    LD      A, x'00
+        0x00,                   //  0005    NOP
+        0x00,                   //  0006    NOP
+        0xED, 0x56,             //  0007    IM      1
+        0xFB,                   //  0009    EI
+        0x76,                   //  000A    HALT
+        0x06, 0x99,             //  000B    LD      B, x'99
+        0x76      };            //  000D    HALT
+
+    /**
+     *  @param  isr                 The interrupt service routine           */
+    uint8_t                     isr[ ] = {
+        0x3E, 0x55,             //  0038    LD      A, x'55
+        0xED, 0x4D };           //  003A    RETI
+
+    /************************************************************************
+     *  Run the program
+     ************************************************************************/
+
+    //  Assume a successful test run.
+    post_rc = true;
+
+    //  Load the program
+    memory_load( 0x0000, sizeof( program ), program );
+    memory_load( 0x0038, sizeof( isr ), isr );
+
+    //  A device requests an interrupt
+    interrupt_raise( machine, 0xFF );
+
+    //  Run the program
+    inst_fetch( );
+
+    /************************************************************************
+     *  Verify the results
+     ************************************************************************/
+
+    if (    (    CPU_REG_PC           != 0x000E )
+         || (    CPU_REG_SP           != 0x0200 )
+         || (    GET_A( )             !=   0x55 )
+         || (    CPU_REG_BC           != 0x9900 )
+         || (    machine->interrupt.line       !=      0 ) )
+    {
+        //  NO:     Write an error message
+        printf( "POST: tc_int_im1_00 failed: [interrupt]\n" );
+        printf( "POST: PC       = 0x%04X\n", CPU_REG_PC );
+        printf( "POST: SP       = 0x%04X\n", CPU_REG_SP );
+        printf( "POST: A        = 0x%02X\n", GET_A( ) );
+        printf( "POST: B        = 0x%02X\n", CPU_REG_BC >> 8 );
+
+        //  Set the return code to FALSE.
+        post_rc = false;
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
+/****************************************************************************/
+/**
+ *  Interrupt   IM 1    Memory Refresh register
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      LD A, R before EI and first thing in the service routine.  Between
+ *      them are LD C, A, EI, HALT, the acknowledge cycle and the two op-code
+ *      fetches of LD A, R, six M1 cycles.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_int_im1_01(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        0x31, 0x00, 0x02,       //  0000    LD      SP, x'0200
+        0xED, 0x56,             //  0003    IM      1
+        0xAF,                   //  0005    XOR     A
+        0xED, 0x4F,             //  0006    LD      R, A
+        0xED, 0x5F,             //  0008    LD      A, R
+        0x4F,                   //  000A    LD      C, A
+        0xFB,                   //  000B    EI
+        0x76,                   //  000C    HALT
+        0x76      };            //  000D    HALT
+
+    /**
+     *  @param  isr                 The interrupt service routine           */
+    uint8_t                     isr[ ] = {
+        0xED, 0x5F,             //  0038    LD      A, R
+        0x47,                   //  003A    LD      B, A
+        0xED, 0x4D };           //  003B    RETI
+
+    /************************************************************************
+     *  Run the program
+     ************************************************************************/
+
+    //  Assume a successful test run.
+    post_rc = true;
+
+    //  Load the program
+    memory_load( 0x0000, sizeof( program ), program );
+    memory_load( 0x0038, sizeof( isr ), isr );
+
+    //  A device requests an interrupt
+    interrupt_raise( machine, 0xFF );
+
+    //  Run the program
+    inst_fetch( );
+
+    /************************************************************************
+     *  Verify the results
+     ************************************************************************/
+
+    if (    (    CPU_REG_PC           != 0x000E )
+         || (    CPU_REG_SP           != 0x0200 )
+         || (    CPU_REG_BC           != 0x0802 )
+         || (    machine->interrupt.line       !=      0 ) )
+    {
+        //  NO:     Write an error message
+        printf( "POST: tc_int_im1_01 failed: [interrupt]\n" );
+        printf( "POST: PC       = 0x%04X\n", CPU_REG_PC );
+        printf( "POST: SP       = 0x%04X\n", CPU_REG_SP );
+        printf( "POST: B        = 0x%02X\n", CPU_REG_BC >> 8 );
+        printf( "POST: C        = 0x%02X\n", CPU_REG_BC & 0xFF );
+
+        //  Set the return code to FALSE.
+        post_rc = false;
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
+/****************************************************************************/
+/**
+ *  Interrupt   IM 2
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      The device supplies vector x'10, the service routine address is
+ *      the word at I * 256 + x'10.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_int_im2_00(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        0x31, 0x00, 0x02,       //  0000    LD      SP, x'0200
+        0x3E, 0x01,             //  0003    LD      A, x'01
+        0xED, 0x47,             //  0005    LD      I, A
+        0xED, 0x5E,             //  0007    IM      2
+        0xFB,                   //  0009    EI
+        0x76,                   //  000A    HALT
+        0x06, 0x99,             //  000B    LD      B, x'99
+        0x76      };            //  000D    HALT
+
+    /**
+     *  @param  vector              The vector table entry                  */
+    uint8_t                     vector[ ] = {
+        0x40, 0x00 };           //  0110    DW      x'0040
+
+    /**
+     *  @param  isr                 The interrupt service routine           */
+    uint8_t                     isr[ ] = {
+        0x3E, 0x66,             //  0040    LD      A, x'66
+        0xED, 0x4D };           //  0042    RETI
+
+    /************************************************************************
+     *  Run the program
+     ************************************************************************/
+
+    //  Assume a successful test run.
+    post_rc = true;
+
+    //  Load the program
+    memory_load( 0x0000, sizeof( program ), program );
+    memory_load( 0x0110, sizeof( vector ), vector );
+    memory_load( 0x0040, sizeof( isr ), isr );
+
+    //  A device requests an interrupt
+    interrupt_raise( machine, 0x10 );
+
+    //  Run the program
+    inst_fetch( );
+
+    /************************************************************************
+     *  Verify the results
+     ************************************************************************/
+
+    if (    (    CPU_REG_PC           != 0x000E )
+         || (    CPU_REG_SP           != 0x0200 )
+         || (    GET_A( )             !=   0x66 )
+         || (    CPU_REG_BC           != 0x9900 )
+         || (    machine->interrupt.line       !=      0 ) )
+    {
+        //  NO:     Write an error message
+        printf( "POST: tc_int_im2_00 failed: [interrupt]\n" );
+        printf( "POST: PC       = 0x%04X\n", CPU_REG_PC );
+        printf( "POST: SP       = 0x%04X\n", CPU_REG_SP );
+        printf( "POST: A        = 0x%02X\n", GET_A( ) );
+        printf( "POST: B        = 0x%02X\n", CPU_REG_BC >> 8 );
+
+        //  Set the return code to FALSE.
+        post_rc = false;
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
 /****************************************************************************
  * MAIN
  ****************************************************************************/
@@ -1646,9 +2278,18 @@ call_post(
 
         if ( post_rc == true )      post_rc = tc_rst_t_00( );       //  RET  T
 
+        if ( post_rc == true )      post_rc = tc_call_smc_00( );    //  CALL nn  (self modifying)
+
+        if ( post_rc == true )      post_rc = tc_int_rst_00( );     //  Interrupt RST n
+        if ( post_rc == true )      post_rc = tc_int_halt_00( );    //  Interrupt from a thread
+        if ( post_rc == true )      post_rc = tc_int_halt_01( );    //  HALT without a device
+
         //  Z80 ONLY instructions
         if( CPU == CPU_Z80 )
         {
+            if ( post_rc == true )  post_rc = tc_int_im1_00( );     //  Interrupt IM 1
+            if ( post_rc == true )  post_rc = tc_int_im1_01( );     //  Interrupt IM 1 and R
+            if ( post_rc == true )  post_rc = tc_int_im2_00( );     //  Interrupt IM 2
         }
 
         //  Was the test suite successfully complete :
@@ -39,6 +39,8 @@
 #include "memory.h"             //  Memory management and access
 #include "registers.h"          //  All things CPU registers.
 #include "control.h"            //  Control (NOP, HLT, etc.) instrucions.
+#include "interrupt.h"          //  Maskable interrupts
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -107,7 +109,7 @@ control_nop_i80(
     )
 {
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -124,10 +126,9 @@ control_nop_i80(
  *  @return                     No information is returned from this function.
  *
  *  @note
- *      This is ONLY a placeholder instruction for the foreseeable future.
- *      We are running in a simulator and there isn't any hardware or anything
- *      else that could resume processing.  Effectively this would be a wait
- *      forever loop.
+ *      With interrupts disabled, or no device that can raise one, nothing
+ *      could resume processing, so the emulator stops instead of waiting
+ *      forever.
  *
  ****************************************************************************/
 
@@ -136,11 +137,18 @@ control_hlt_i80(
     uint8_t                     op_code
     )
 {
-    //  Set the number of states for this instruction
-    operation_rc.states =   4;
-
-    //  @note   Setting the states value to zero '0' will terminate.
-    operation_rc.states =   0;
+    //  Did an interrupt resume processing ?
+    if (    ( machine->interrupt.iff1 == true )
+         && ( interrupt_halt( ) == true ) )
+    {
+        //  YES:    Set the number of states for this instruction
+        machine->operation_rc.states =   4;
+    }
+    else
+    {
+        //  NO:     @note   Setting the states value to zero '0' will terminate.
+        machine->operation_rc.states =   0;
+    }
 }
 
 /****************************************************************************/
@@ -156,9 +164,6 @@ control_hlt_i80(
  *  @return                     No information is returned from this function.
  *
  *  @note
- *      This is ONLY a placeholder instruction for the foreseeable future.
- *      We are running in a simulator and there isn't any hardware and
- *      thus no interrupts.
  *
  ****************************************************************************/
 
@@ -167,8 +172,11 @@ control_di_i80(
     uint8_t                     op_code
     )
 {
+    //  DI
+    interrupt_enable( false );
+
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -184,19 +192,21 @@ control_di_i80(
  *  @return                     No information is returned from this function.
  *
  *  @note
- *      This is ONLY a placeholder instruction for the foreseeable future.
- *      We are running in a simulator and there isn't any hardware and
- *      thus no interrupts.
+ *      The instruction that follows EI finishes before an interrupt is
+ *      accepted.
  *
  ****************************************************************************/
 
 void
-control_ei_api(
+control_ei_i80(
     uint8_t                     op_code
     )
 {
+    //  EI
+    interrupt_enable( true );
+
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -224,9 +234,6 @@ control_ei_api(
  *  @return                     No information is returned from this function.
  *
  *  @note
- *      This is ONLY a placeholder instruction for the foreseeable future.
- *      We are running in a simulator and there isn't any hardware and
- *      thus no interrupts.
  *
  ****************************************************************************/
 
@@ -239,16 +246,20 @@ control_im_ED(
     switch( ( op_code >> 3 ) & 0x03 )
     {
         case    0:              // Mode 0
+            machine->interrupt.mode = 0;
             break;
         case    1:              // Mode ?
+            machine->interrupt.mode = 0;
             break;
         case    2:              // Mode 1
+            machine->interrupt.mode = 1;
             break;
         case    3:              // Mode 2
+            machine->interrupt.mode = 2;
             break;
     }
 
     //  Set the number of states for this instruction
-    operation_rc.states =   9;
+    machine->operation_rc.states =   9;
 }
 /****************************************************************************/
\ No newline at end of file
@@ -87,7 +87,7 @@ control_di_i80(
     );
 //------------------------------------------------------------------------ 183
 void
-control_ei_api(
+control_ei_i80(
     uint8_t                     op_code
     );
 //------------------------------------------------------------------------ 184
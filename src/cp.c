@@ -48,6 +48,8 @@
 #include "registers.h"          //  All things CPU registers.
 #include "op_code.h"            //  OP-Code instruction maps
 #include "bios.h"               //  CP/M BIOS
+#include "stats.h"              //  Performance counters
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -301,6 +303,177 @@ cp_mount(
     }
 }
 
+/****************************************************************************/
+/**
+ *  Find the drive letter of a CP command.
+ *
+ *  @param  command             The CP command
+ *  @param  cmd_ndx_p           Where the index after the ':' goes.
+ *
+ *  @return                     The drive number ( A=0 etc ), -1 when the
+ *                              command has no valid drive letter.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+int
+cp_drive(
+    char                    *   command,
+    int                     *   cmd_ndx_p
+    )
+{
+    /**
+     *  @param  drive_num       Number reflecting the drive letter A=1 etc  */
+    int                         drive_num;
+    /**
+     *  @param  cmd_ndx         Index into the command buffer               */
+    int                         cmd_ndx;
+
+    //  Assume an invalid command format
+    drive_num = -1;
+
+    //  Look for the drive letter
+    for ( cmd_ndx = 0;
+          cmd_ndx < strlen( command );
+          cmd_ndx += 1 )
+    {
+        if (    ( isalpha( command[ cmd_ndx ] ) !=  0  )
+             && ( command[ cmd_ndx + 1 ]        == ':' ) )
+        {
+            //  Translate the letter to a number (a=A=1, b=B=2, etc)
+            drive_num = command[ cmd_ndx ] & 0x0F;
+
+            //  Exit the loop now that we have a drive letter
+            break;
+        }
+    }
+    *cmd_ndx_p = cmd_ndx + 2;
+
+    //  Was the command format valid ?
+    if ( drive_num > 0 && 15 > drive_num )
+    {
+        //  YES:    Zero based
+        return( drive_num - 1 );
+    }
+
+    //  DONE!
+    return( -1 );
+}
+
+/****************************************************************************/
+/**
+ *  #CP OVERLAY {drive_letter}: {file_name}
+ *      Put a copy-on-write overlay over the image mounted on a drive.
+ *
+ *  @param  command             The CP command
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The overlay file must not exist.  The image becomes its read only
+ *      base and the overlay is mounted in its place.
+ *
+ ****************************************************************************/
+
+void
+cp_overlay(
+    char                    *   command
+    )
+{
+    /**
+     *  @param  drive_num       Number reflecting the drive letter A=0 etc  */
+    int                         drive_num;
+    /**
+     *  @param  file_name       Name of the overlay file                    */
+    char                        file_name[ 255 ];
+    /**
+     *  @param  cmd_ndx         Index into the command buffer               */
+    int                         cmd_ndx;
+
+    drive_num = cp_drive( command, &cmd_ndx );
+
+    //  Was the command format valid ?
+    if ( drive_num >= 0 )
+    {
+        //  Move past all space characters between the drive and file name.
+        for ( ;
+              cmd_ndx < strlen( command );
+              cmd_ndx += 1 )
+        {
+            //  is this another space character ?
+            if ( command[ cmd_ndx ] != ' ' )
+            {
+                //  NO:     This is the start of the file name.
+                break;
+            }
+        }
+
+        //  Was a file name present that fits into the buffer ?
+        if (    ( strlen( &command[ cmd_ndx ] ) > 0 )
+             && ( strlen( &command[ cmd_ndx ] ) < sizeof( file_name ) ) )
+        {
+            //  YES:    Pass it over to the BIOS
+            snprintf( file_name, sizeof( file_name ), "%s", &command[ cmd_ndx ] );
+            bios_overlay( drive_num, file_name );
+            return;
+        }
+    }
+
+    //  Write an error / help message
+    printf( "\r\nCP OVERLAY: Improper drive or file name\r\n" );
+    printf( "            Try 'overlay {drive_letter}: {file_name}\r\n" );
+    printf( "            For example:  overlay A: job_1.ovl\r\n" );
+}
+
+/****************************************************************************/
+/**
+ *  #CP COMMIT {drive_letter}:
+ *  #CP DISCARD {drive_letter}:
+ *      Write the overlay on a drive into its base, or throw it away.
+ *
+ *  @param  command             The CP command
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Either way the overlay stays mounted, empty.
+ *
+ ****************************************************************************/
+
+void
+cp_commit(
+    char                    *   command
+    )
+{
+    /**
+     *  @param  drive_num       Number reflecting the drive letter A=0 etc  */
+    int                         drive_num;
+    /**
+     *  @param  cmd_ndx         Index into the command buffer               */
+    int                         cmd_ndx;
+
+    drive_num = cp_drive( command, &cmd_ndx );
+
+    //  Was the command format valid ?
+    if ( drive_num < 0 )
+    {
+        //  NO:     Write an error / help message
+        printf( "\r\nCP COMMIT / DISCARD: Improper drive defined\r\n" );
+        printf( "          For example:  commit A:\r\n" );
+        printf( "          or            DISCARD b:\r\n" );
+    }
+    else if ( toupper( command[ 0 ] ) == 'C' )
+    {
+        bios_commit( drive_num );
+    }
+    else
+    {
+        bios_discard( drive_num );
+    }
+}
+
 /****************************************************************************/
 /**
  *  #CP MKDSK {file_name}:
@@ -406,6 +579,157 @@ cp_mkdsk(
 
 }
 
+/****************************************************************************/
+/**
+ *  #CP SAVE {file_name}
+ *      Write a snapshot of the machine to a Linux file.
+ *
+ *  @param  command             The CP command
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The snapshot resumes at the CP/M prompt, see LOAD and --resume.
+ *
+ ****************************************************************************/
+
+void
+cp_save(
+    char                    *   command
+    )
+{
+    /**
+     *  @param  cmd_ndx         Index into the command buffer               */
+    int                         cmd_ndx;
+
+    //  Move the index past the command {Save} and spaces.
+    for ( cmd_ndx = 4;
+          cmd_ndx < strlen( command );
+          cmd_ndx += 1 )
+    {
+        //  is this another space character ?
+        if ( command[ cmd_ndx ] != ' ' )
+        {
+            //  NO:     This is the start of the file name.
+            break;
+        }
+    }
+
+    //  Was a file name present ?
+    if ( strlen( &command[ cmd_ndx ] ) > 0 )
+    {
+        //  YES:    Write the snapshot
+        if ( machine_save( &command[ cmd_ndx ] ) == false )
+        {
+            printf( "\r\nCP SAVE: Unable to write file '%s'\r\n",
+                    &command[ cmd_ndx ] );
+        }
+    }
+    else
+    {
+        //  NO:     Failed to include a file name
+        printf( "\r\nCP SAVE: No file name in the command.\r\n" );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  #CP CACHE [FLUSH | WBOOT | IDLE | TIMER | SHUTDOWN]
+ *      Flush the track cache or change when it is flushed, then display
+ *      its statistics.
+ *
+ *  @param  command             The CP command
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+cp_cache(
+    char                    *   command
+    )
+{
+    /**
+     *  @param  cmd_ndx         Index into the command buffer               */
+    int                         cmd_ndx;
+
+    //  Move the index past the command {Cache} and spaces.
+    for ( cmd_ndx = 5;
+          cmd_ndx < strlen( command );
+          cmd_ndx += 1 )
+    {
+        //  is this another space character ?
+        if ( command[ cmd_ndx ] != ' ' )
+        {
+            //  NO:     This is the start of the request.
+            break;
+        }
+    }
+
+    //  Was the request understood ?
+    if ( bios_cache( &command[ cmd_ndx ] ) == false )
+    {
+        //  NO:     Error message
+        printf( "\r\nCP CACHE: '%s' is not FLUSH, WBOOT, IDLE, TIMER "
+                "or SHUTDOWN\r\n", &command[ cmd_ndx ] );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  #CP LOAD {file_name}
+ *      Restore the machine from a snapshot written by SAVE.
+ *
+ *  @param  command             The CP command
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The guest continues where the snapshot was saved.
+ *
+ ****************************************************************************/
+
+void
+cp_load(
+    char                    *   command
+    )
+{
+    /**
+     *  @param  cmd_ndx         Index into the command buffer               */
+    int                         cmd_ndx;
+
+    //  Move the index past the command {Load} and spaces.
+    for ( cmd_ndx = 4;
+          cmd_ndx < strlen( command );
+          cmd_ndx += 1 )
+    {
+        //  is this another space character ?
+        if ( command[ cmd_ndx ] != ' ' )
+        {
+            //  NO:     This is the start of the file name.
+            break;
+        }
+    }
+
+    //  Was a file name present ?
+    if ( strlen( &command[ cmd_ndx ] ) > 0 )
+    {
+        //  YES:    Restore the snapshot
+        if ( machine_load( &command[ cmd_ndx ] ) == false )
+        {
+            printf( "\r\nCP LOAD: '%s' is not a snapshot of this build\r\n",
+                    &command[ cmd_ndx ] );
+        }
+    }
+    else
+    {
+        //  NO:     Failed to include a file name
+        printf( "\r\nCP LOAD: No file name in the command.\r\n" );
+    }
+}
+
 /****************************************************************************/
 /**
  *  #CP IMPORT {file_name}
@@ -557,7 +881,13 @@ cp_import(
  *          DEBUG               Set debug mode.
  *          MOUNT               Mount a Linux file to a CP/M drive.
  *          EJECT               Dismount a CP/M drive.
+ *          OVERLAY             Mount a copy-on-write overlay over a drive.
+ *          COMMIT              Write an overlay into its base.
+ *          DISCARD             Throw an overlay's writes away.
  *          MKDSK               Create a new CP/M Disk
+ *          STATS               Display the performance counters.
+ *          SAVE                Write a snapshot of the machine.
+ *          LOAD                Restore a snapshot of the machine.
  *
  ****************************************************************************/
 
@@ -647,6 +977,23 @@ cp(
         cp_eject( command );
     }
     //========================================================================
+    //  OVERLAY             Put a copy-on-write overlay over a drive ?
+    else
+    if ( strncasecmp( command, "OVERLAY",   7 ) == 0 )
+    {
+        //  YES:    Do it.
+        cp_overlay( command );
+    }
+    //========================================================================
+    //  COMMIT / DISCARD    Write or drop the overlay of a drive ?
+    else
+    if (    ( strncasecmp( command, "COMMIT",  6 ) == 0 )
+         || ( strncasecmp( command, "DISCARD", 7 ) == 0 ) )
+    {
+        //  YES:    Do it.
+        cp_commit( command );
+    }
+    //========================================================================
     //  MKDSK               Create a new CP/M Disk ?
     else
     if ( strncasecmp( command, "MKDSK",     5 ) == 0 )
@@ -669,6 +1016,38 @@ cp(
     {
     }
     //========================================================================
+    //  STATS               Display the performance counters ?
+    else
+    if ( strncasecmp( command, "STATS",     5 ) == 0 )
+    {
+        //  YES:    Do it.
+        stats_report( );
+    }
+    //========================================================================
+    //  CACHE               Flush or tune the track cache ?
+    else
+    if ( strncasecmp( command, "CACHE",     5 ) == 0 )
+    {
+        //  YES:    Do it.
+        cp_cache( command );
+    }
+    //========================================================================
+    //  SAVE                Write a snapshot of the machine ?
+    else
+    if ( strncasecmp( command, "SAVE",      4 ) == 0 )
+    {
+        //  YES:    Do it.
+        cp_save( command );
+    }
+    //========================================================================
+    //  LOAD                Restore a snapshot of the machine ?
+    else
+    if ( strncasecmp( command, "LOAD",      4 ) == 0 )
+    {
+        //  YES:    Do it.
+        cp_load( command );
+    }
+    //========================================================================
     //  SHUTDOWN            Terminate CP/M ?
     else
     if ( strncasecmp( command, "SHUTDOWN",  8 ) == 0 )
@@ -688,7 +1067,14 @@ cp(
         printf( "DEBUG  {mode}          - Set debug mode.\r\n" );
         printf( "MOUNT  {disk}: {file}  - Mount a Linux file to a CP/M drive.\r\n" );
         printf( "EJECT  {disk}:         - Dismount a CP/M drive.\r\n" );
+        printf( "OVERLAY {disk}: {file} - Mount a copy-on-write overlay.\r\n" );
+        printf( "COMMIT {disk}:         - Write an overlay into its base.\r\n" );
+        printf( "DISCARD {disk}:        - Throw an overlay's writes away.\r\n" );
         printf( "MKDSK  {file}          - Create a new CP/M Disk\r\n" );
+        printf( "STATS                  - Display the performance counters.\r\n" );
+        printf( "CACHE  [policy|FLUSH]  - Flush / tune / report the track cache.\r\n" );
+        printf( "SAVE   {file}          - Write a snapshot of the machine.\r\n" );
+        printf( "LOAD   {file}          - Restore a snapshot of the machine.\r\n" );
     }
 }
 /****************************************************************************/
\ No newline at end of file
@@ -35,6 +35,7 @@
 #include <unistd.h>             //  UNIX standard library.
 #include <stdio.h>              //  Standard I/O definitions
 #include <string.h>             //  Functions for managing strings
+#include <strings.h>            //  strcasecmp( )
                                 //*******************************************
 #include <ctype.h>              //
 #include <sys/types.h>          //
@@ -44,6 +45,7 @@
 #include <curses.h>             //
 #include <ncurses.h>            //
 #include <termios.h>            //
+#include <poll.h>               //  Console input ready
                                 //*******************************************
 
 /****************************************************************************
@@ -53,10 +55,17 @@
                                 //*******************************************
 #include "global.h"             //  Global definitions
 #include "memory.h"             //  Memory management and access
+#include "disk.h"               //  Disk images
+#include "disk_cache.h"         //  Track cache
+#include "disk_overlay.h"       //  Copy-on-write overlays
 #include "registers.h"          //  All things CPU registers.
 #include "boot_rom.h"           //  Boot ROM
 #include "bios.h"               //  CP/M BIOS
 #include "cp.h"                 //  Command Processor
+#include "stats.h"              //  Performance counters
+#include "idle.h"               //  Console idle detection
+#include "zygote.h"             //  Fork server for batch jobs
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -71,6 +80,16 @@ enum disk_state_e
     DS_OPEN = 1                 //  The disk file system is open
 };
 //----------------------------------------------------------------------------
+/**
+ *  @param  conin_state_e       Extended character sequence being read      */
+enum    conin_state_e
+{
+    CS_IDLE                 =   0,
+    CS_1B                   =   1,
+    CS_5B                   =   2,
+    CS_7E                   =   3
+};
+//----------------------------------------------------------------------------
 
 /****************************************************************************
  * Definitions
@@ -86,6 +105,10 @@ enum disk_state_e
 #define READER                  "/home/greg/CPM/reader.txt"
 #define PRINTER                 "/home/greg/CPM/printer.txt"
 //----------------------------------------------------------------------------
+/**
+ *  @param  BIOS                Devices of the bound guest                  */
+#define BIOS                    ( machine->bios )
+//----------------------------------------------------------------------------
 #define BLOCK_SIZE              0x0080
 //----------------------------------------------------------------------------
 #define I8080_MAJ               1
@@ -112,17 +135,14 @@ enum disk_state_e
 struct  disk_io_t
 {
     /**
-     *  @param  disk_fd             RAM Disk File Descriptor                */
-    int                         disk_fd;
+     *  @param  disk                The mounted image                       */
+    struct  disk_t              disk;
     /**
      *  @param  sector              Sector number                           */
     uint8_t                     sector;
     /**
      *  @param  track               Track  number                           */
     uint8_t                     track;
-    /**
-     *  @param  data                Read or write data.                     */
-    uint8_t                     data[ BLOCK_SIZE ];
     /**
      *  @param  track_num           Track number for the next W/R           */
     uint16_t                    track_num;
@@ -141,6 +161,46 @@ struct  disk_io_t
     /**
      *  @param  lba                 Logical Block Address                   */
     int                         lba;
+    /**
+     *  @param  disk_name           Mounted image file, empty when none     */
+    char                        disk_name[ DISK_NAME_SIZE ];
+};
+//----------------------------------------------------------------------------
+/**
+ *  @param  bios_t              The devices of one guest                    */
+struct  bios_t
+{
+    /**
+     *  @param  disk_id             Currently selected disk ID              */
+    uint8_t                     disk_id;
+    /**
+     *  @param  disk_io             Management information for each drive   */
+    struct  disk_io_t           disk_io[ MAX_DISK ];
+    /**
+     *  @param  cache               Track cache of the drives               */
+    struct  disk_cache_t    *   cache;
+    /**
+     *  @param  punch_fp            Paper Tape Punch File Descriptor        */
+    FILE                    *   punch_fp;
+    /**
+     *  @param  reader_fp           Paper Tape Reader File Descriptor       */
+    FILE                    *   reader_fp;
+    /**
+     *  @param  printer_fp          Line Printer File Descriptor            */
+    FILE                    *   printer_fp;
+    /**
+     *  @param  kb_buffer           Keyboard (stdin) buffer                 */
+    uint8_t                     kb_read_size;
+    uint8_t                     kb_buffer[ 128 ];
+    /**
+     *  @param  conin_state         Extended character sequence             */
+    enum    conin_state_e       conin_state;
+    /**
+     *  @param  console_in          Console input, -1 for the terminal      */
+    int                         console_in;
+    /**
+     *  @param  console_out         Console output, -1 for the terminal     */
+    int                         console_out;
 };
 //----------------------------------------------------------------------------
 
@@ -149,6 +209,10 @@ struct  disk_io_t
  ****************************************************************************/
 
 //----------------------------------------------------------------------------
+/**
+ *  @param  bios_console_ready  The console ( process wide ) is set up      */
+static
+bool                            bios_console_ready;
 //----------------------------------------------------------------------------
 
 /****************************************************************************
@@ -156,36 +220,197 @@ struct  disk_io_t
  ****************************************************************************/
 
 //----------------------------------------------------------------------------
-/**
- *  @param  disk_id                 Currently selected disk ID              */
-uint8_t                         disk_id;
-//----------------------------------------------------------------------------
-/**
- *  @param  disk_io                 Management information for DRIVE-0      */
-struct  disk_io_t               disk_io[ MAX_DISK ];
 //----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
 /**
- *  @param  punch_fp                Paper Tape Punch File Descriptor        */
-FILE                        *   punch_fp;
-//----------------------------------------------------------------------------
+ *  Write back the dirty tracks of every drive and flush the images.
+ *
+ *  @param
+ *
+ *  @return                         No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+bios_flush(
+    void
+    )
+{
+    /**
+     *  @param  disk                Drive number                            */
+    int                         disk;
+
+    for( disk = 0; disk < MAX_DISK; disk += 1 )
+    {
+        //  Is this disk opened ?
+        if ( disk_mounted( &BIOS->disk_io[ disk ].disk ) == true )
+        {
+            //  YES:    Write it back
+            if ( disk_cache_flush( BIOS->cache, &BIOS->disk_io[ disk ].disk ) != 0x00 )
+            {
+                printf( "\r\nBIOS: Write back of drive %c: failed\r\n", disk + 'A' );
+            }
+        }
+    }
+}
+
+/****************************************************************************/
 /**
- *  @param  reader_fp               Paper Tape Reader File Descriptor       */
-FILE                        *   reader_fp;
-//----------------------------------------------------------------------------
+ *  Wait until the I/O thread has written every track back.
+ *
+ *  @param
+ *
+ *  @return                         No information is returned from this function.
+ *
+ *  @note
+ *      Returns at once without DISK_ASYNC.  Once the sectors are written
+ *      the bitmap of every overlay can say that they are there.
+ *
+ ****************************************************************************/
+
+static
+void
+bios_barrier(
+    void
+    )
+{
+    /**
+     *  @param  disk                Drive number                            */
+    int                         disk;
+
+    //  Did a write-back fail ?
+    if ( disk_cache_barrier( BIOS->cache ) != 0x00 )
+    {
+        //  YES:    Tell the user, CP/M was told it worked
+        printf( "\r\nBIOS: Write-behind to a disk image failed\r\n" );
+        return;
+    }
+
+    //  Loop through the drives
+    for( disk = 0; disk < MAX_DISK; disk += 1 )
+    {
+        //  Is there an overlay on this drive ?
+        if (    ( disk_mounted( &BIOS->disk_io[ disk ].disk ) == true )
+             && ( BIOS->disk_io[ disk ].disk.overlay != NULL ) )
+        {
+            //  YES:    Its sectors are out, now its bitmap
+            disk_flush( &BIOS->disk_io[ disk ].disk );
+        }
+    }
+}
+
+/****************************************************************************/
 /**
- *  @param  printer_fp              Line Printer File Descriptor            */
-FILE                        *   printer_fp;
-//----------------------------------------------------------------------------
+ *  Flush when the flush policy of the track cache asks for it.
+ *
+ *  @param  idle                    TRUE when the guest waits for a key.
+ *
+ *  @return                         No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+bios_flush_due(
+    bool                        idle
+    )
+{
+    //  Is it time ?
+    if ( disk_cache_due( BIOS->cache, idle ) == true )
+    {
+        //  YES:    Flush
+        bios_flush( );
+    }
+}
+
+/****************************************************************************/
 /**
- *  @param  kb_buffer               Keyboard (stdin) buffer                 */
-uint8_t                         kb_read_size;
-uint8_t                         kb_buffer[ 128 ];
-//----------------------------------------------------------------------------
+ *  Write back and close the image of a drive.
+ *
+ *  @param  disk                    Drive number
+ *
+ *  @return                         No information is returned from this function.
+ *
+ *  @note
+ *      Nothing happens when no image is open.
+ *
+ ****************************************************************************/
 
-/****************************************************************************
- * Private Functions
+static
+void
+bios_disk_close(
+    int                         disk
+    )
+{
+    //  Is this disk opened ?
+    if ( disk_mounted( &BIOS->disk_io[ disk ].disk ) == true )
+    {
+        //  YES:    Its cached tracks go first
+        disk_cache_flush( BIOS->cache, &BIOS->disk_io[ disk ].disk );
+        bios_barrier( );
+        disk_cache_drop( BIOS->cache, &BIOS->disk_io[ disk ].disk );
+        disk_close( &BIOS->disk_io[ disk ].disk );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Find the overlay on a drive and bring it up to date.
+ *
+ *  @param  drive_num           Number reflecting the drive letter A=0 etc
+ *  @param  request             The CP command, for the messages.
+ *
+ *  @return                     The disk, NULL when there is no overlay.
+ *
+ *  @note
+ *      The cached tracks are written back and dropped, afterwards the
+ *      overlay file holds everything the guest wrote.
+ *
  ****************************************************************************/
 
+static
+struct  disk_t  *
+bios_overlay_disk(
+    int                         drive_num,
+    const
+    char                    *   request
+    )
+{
+    /**
+     *  @param  disk            The disk on the drive                       */
+    struct  disk_t          *   disk;
+
+    //  Is there an overlay on the drive ?
+    if (    ( drive_num < 0 ) || ( drive_num >= MAX_DISK )
+         || ( disk_mounted( &BIOS->disk_io[ drive_num ].disk ) == false )
+         || ( BIOS->disk_io[ drive_num ].disk.overlay == NULL ) )
+    {
+        //  NO:     Error Message
+        printf( "\r\nCP %s: Drive %c: has no overlay mounted\r\n",
+                request, ( ( drive_num + 1 ) | '@' ) );
+        return( NULL );
+    }
+    disk = &BIOS->disk_io[ drive_num ].disk;
+
+    disk_cache_flush( BIOS->cache, disk );
+    bios_barrier( );
+    disk_cache_drop( BIOS->cache, disk );
+    disk_flush( disk );
+
+    //  DONE!
+    return( disk );
+}
+
 /****************************************************************************/
 /**
  *  SELDSK          Select disc drive
@@ -229,19 +454,19 @@ bios_seldsk(
 #endif
 
     //  Save the selected disk ID.
-    disk_id = GET_C( );
+    BIOS->disk_id = GET_C( );
 
     //  Is this a valid disk ID ?
-    if (    (       disk_id < MAX_DISK       )
-         && ( disk_io[ disk_id ].disk_fd > 0 ) )
+    if (    (       BIOS->disk_id < MAX_DISK       )
+         && ( disk_mounted( &BIOS->disk_io[ BIOS->disk_id ].disk ) == true ) )
     {
         //  Locate the Disk Parameter Header for this disk.
-        disk_io[ disk_id ].disk_parm_tbl = ( DPH_BASE + ( disk_id * DPH_SIZE ) );
-        CPU_REG_HL = disk_io[ disk_id ].disk_parm_tbl;
+        BIOS->disk_io[ BIOS->disk_id ].disk_parm_tbl = ( DPH_BASE + ( BIOS->disk_id * DPH_SIZE ) );
+        CPU_REG_HL = BIOS->disk_io[ BIOS->disk_id ].disk_parm_tbl;
 
         //  Get the address of the disk parameter block
-        dpb = memory_get_16_p( DPH_BASE + ( 16 * disk_id ) + DPH_DPB_OFFSET );
-        disk_io[ disk_id ].sec_track = memory_get_16_p( dpb + DPB_SPT_OFFSET );
+        dpb = memory_get_16_p( DPH_BASE + ( 16 * BIOS->disk_id ) + DPH_DPB_OFFSET );
+        BIOS->disk_io[ BIOS->disk_id ].sec_track = memory_get_16_p( dpb + DPB_SPT_OFFSET );
     }
     else
     {
@@ -283,7 +508,7 @@ bios_settrk(
 #endif
 
     //  Save the track number
-    disk_io[ disk_id ].track_num = CPU_REG_BC;
+    BIOS->disk_io[ BIOS->disk_id ].track_num = CPU_REG_BC;
 }
 
 /****************************************************************************/
@@ -316,7 +541,7 @@ bios_setsec(
     printf( "\tSector Number = BC = x'%04X\r\n", CPU_REG_BC );
 #endif
     //  Save the track number
-    disk_io[ disk_id ].sector_num = CPU_REG_BC;
+    BIOS->disk_io[ BIOS->disk_id ].sector_num = CPU_REG_BC;
 }
 
 /****************************************************************************/
@@ -395,7 +620,7 @@ bios_setdma(
 #endif
 
     //  Save the W/R data address
-    disk_io[ disk_id ].dma_addr = CPU_REG_BC;
+    BIOS->disk_io[ BIOS->disk_id ].dma_addr = CPU_REG_BC;
 }
 
 /****************************************************************************/
@@ -453,38 +678,28 @@ bios_read(
 #endif
 
     //  Calculate the logical block address
-    disk_io[ disk_id ].lba
-            = ( disk_io[ disk_id ].track_num * disk_io[ disk_id ].sec_track )
-                + (disk_io[ disk_id ].sector_num - 1 );
-
-    //  Seek to the first boot block
-    lseek( disk_io[ disk_id ].disk_fd,
-            BLOCK_SIZE * disk_io[ disk_id ].lba,
-           SEEK_SET );
-
-    //  Read a block from the disk
-    read( disk_io[ disk_id ].disk_fd,
-            disk_io[ disk_id ].data,
-          BLOCK_SIZE );
-
-    //  Copy the data block to CPU memory.
-    memory_load( disk_io[ disk_id ].dma_addr,
-            BLOCK_SIZE,
-                 disk_io[ disk_id ].data );
+    BIOS->disk_io[ BIOS->disk_id ].lba
+            = ( BIOS->disk_io[ BIOS->disk_id ].track_num * BIOS->disk_io[ BIOS->disk_id ].sec_track )
+                + (BIOS->disk_io[ BIOS->disk_id ].sector_num - 1 );
+
+    //  Read the block through the track cache and set the return code
+    PUT_A( disk_cache_read( BIOS->cache,
+                            &BIOS->disk_io[ BIOS->disk_id ].disk,
+                            BIOS->disk_io[ BIOS->disk_id ].lba,
+                            BIOS->disk_io[ BIOS->disk_id ].sec_track,
+                            BIOS->disk_io[ BIOS->disk_id ].dma_addr ) );
+    bios_flush_due( false );
 #if DEBUG_MODE
     printf( "Disk: %d, Track: %2d, Sector: %2d, lSeek: %X, LBA: %04X\r\n",
-            disk_id,
-            disk_io[ disk_id ].track_num,
-            disk_io[ disk_id ].sector_num,
-            BLOCK_SIZE * disk_io[ disk_id ].lba,
-            disk_io[ disk_id ].lba );
+            BIOS->disk_id,
+            BIOS->disk_io[ BIOS->disk_id ].track_num,
+            BIOS->disk_io[ BIOS->disk_id ].sector_num,
+            BLOCK_SIZE * BIOS->disk_io[ BIOS->disk_id ].lba,
+            BIOS->disk_io[ BIOS->disk_id ].lba );
 
-    memory_dump( disk_io[ disk_id ].dma_addr, BLOCK_SIZE );
+    memory_dump( BIOS->disk_io[ BIOS->disk_id ].dma_addr, BLOCK_SIZE );
 #endif
 
-    //  Set the return code
-    PUT_A( 0x00 );
-
 #if DEBUG_MODE
     //  Log the call
     printf( "\tReturn Code =  A = x'%02X\r\n", GET_A( )   );
@@ -517,57 +732,45 @@ bios_write(
     void
     )
 {
-    /**
-     *  @param  seek_offset         The resulting offset  location          */
-    off_t                       seek_offset;
-
 #if DEBUG_MODE
     //  Log the call
     printf( "===========================================================\r\n" );
     printf( "DEBUG: BIOS call 'WRITE'\r\n" );
 #endif
 
-    //  Copy the data block from CPU memory.
-    memory_read( disk_io[ disk_id ].data,
-                 BLOCK_SIZE,
-                 disk_io[ disk_id ].dma_addr );
-
     //  Calculate the logical block address
-    disk_io[ disk_id ].lba
-             =    ( disk_io[ disk_id ].track_num * disk_io[ disk_id ].sec_track )
-                + ( disk_io[ disk_id ].sector_num - 1 );
-
-    //  Seek to the first boot block
-    seek_offset = lseek( disk_io[ disk_id ].disk_fd,
-                         BLOCK_SIZE * disk_io[ disk_id ].lba,
-                         SEEK_SET );
+    BIOS->disk_io[ BIOS->disk_id ].lba
+             =    ( BIOS->disk_io[ BIOS->disk_id ].track_num * BIOS->disk_io[ BIOS->disk_id ].sec_track )
+                + ( BIOS->disk_io[ BIOS->disk_id ].sector_num - 1 );
 
-    //  Was the disk successful ?
-    if ( seek_offset == -1 )
-    {
-        //  NO:
-        printf( "BIOS: bios_write( ); Seek failure.\r\n:" );
-        perror( "                     " );
-    }
 #if DEBUG_MODE
     //  Log the call
     printf( "Disk: %d, Track: %2d, Sector: %2d, lSeek: %X, LBA: %04X\r\n",
-            disk_id,
-            disk_io[ disk_id ].track_num,
-            disk_io[ disk_id ].sector_num,
-            BLOCK_SIZE * disk_io[ disk_id ].lba,
-            disk_io[ disk_id ].lba );
+            BIOS->disk_id,
+            BIOS->disk_io[ BIOS->disk_id ].track_num,
+            BIOS->disk_io[ BIOS->disk_id ].sector_num,
+            BLOCK_SIZE * BIOS->disk_io[ BIOS->disk_id ].lba,
+            BIOS->disk_io[ BIOS->disk_id ].lba );
 
-    memory_dump( disk_io[ disk_id ].dma_addr, BLOCK_SIZE );
+    memory_dump( BIOS->disk_io[ BIOS->disk_id ].dma_addr, BLOCK_SIZE );
 #endif
 
-    //  Read a block from the disk
-    write( disk_io[ disk_id ].disk_fd,
-           disk_io[ disk_id ].data,
-           BLOCK_SIZE );
-
-    //  Set the return code
-    PUT_A( 0x00 );
+    //  Write the block into the track cache and set the return code
+    PUT_A( disk_cache_write( BIOS->cache,
+                             &BIOS->disk_io[ BIOS->disk_id ].disk,
+                             BIOS->disk_io[ BIOS->disk_id ].lba,
+                             BIOS->disk_io[ BIOS->disk_id ].sec_track,
+                             BIOS->disk_io[ BIOS->disk_id ].dma_addr,
+                             GET_C( ) ) );
+    bios_flush_due( false );
+
+    //  Was the write successful ?
+    if ( GET_A( ) != 0x00 )
+    {
+        //  NO:
+        printf( "BIOS: bios_write( ); Write failure.\r\n:" );
+        perror( "                     " );
+    }
 
 #if DEBUG_MODE
     //  Log the call
@@ -577,32 +780,24 @@ bios_write(
 
 /****************************************************************************/
 /**
- *  BOOT        Cold start routine
- *      This function is completely implementation-dependent and should never
- *      be called from user code.
+ *  Set up the console.
  *
  *  @param
  *
  *  @return                         No information is returned from this function.
  *
  *  @note
+ *      Called by BOOT, and by bios_load( ) when a snapshot is restored
+ *      before this process ever booted.
  *
  ****************************************************************************/
 
 static
 void
-bios_boot(
+bios_console(
     void
     )
 {
-    /**
-     *  @param  disk                Disk being initialized                  */
-    uint8_t                     disk;
-#if DEBUG_MODE
-    printf( "===========================================================\r\n" );
-    printf( "DEBUG: BIOS call 'BOOT'\r\n" );
-#endif
-
 #if CON_V3
 
     //  List programs and version numbers.
@@ -662,94 +857,37 @@ bios_boot(
     fcntl( 0, F_SETFL, fcntl( 0, F_GETFL ) | O_NONBLOCK );
 #endif
 
-    //  Close all open disks
-    for ( disk = 0;
-            disk < MAX_DISK;
-          disk += 1 )
-    {
-        //  Is this disk opened ?
-        if ( disk_io[ disk ].disk_fd > 0 )
-        {
-            //  YES:    Close it
-            close( disk_io[ disk ].disk_fd );
-        }
-        //  Mark it as closed
-        disk_io[ disk ].disk_fd = -1;
-    }
-
-    //------------------------------------------------------------------------
-    //  Mount disk      A:
-    //------------------------------------------------------------------------
-
-    //  Open the primary disk for write & read operations
-    disk_io[ 0 ].disk_fd = open( DISK_A, O_RDWR );
-
-    //  Was the open successful ?
-    if ( disk_io[ 0 ].disk_fd <= 0 )
-    {
-        //  NO:     Message and terminate
-        printf( "BIOS: bios_boot( ); "
-                "Unable to mount DISK 0 [ A: ] (%s)\r\n:", DISK_A );
-        perror( "                    " );
-    }
-
-    //------------------------------------------------------------------------
-    //  Mount disk      B:
-    //------------------------------------------------------------------------
-
-    //  Open the primary disk for write & read operations
-    disk_io[ 1 ].disk_fd = open( DISK_B, O_RDWR );
-
-    //  Was the open successful ?
-    if ( disk_io[ 1 ].disk_fd <= 0 )
-    {
-        //  NO:     Message and terminate
-        printf( "BIOS: bios_boot( ); "
-                "Unable to mount DISK 1 [ B: ] (%s)\r\n:", DISK_B );
-        perror( "                    " );
-    }
-
-    //------------------------------------------------------------------------
-    //  Mount disk      C:
-    //------------------------------------------------------------------------
-
-    //  Open the primary disk for write & read operations
-    disk_io[ 2 ].disk_fd = open( DISK_C, O_RDWR );
-
-    //  Was the open successful ?
-    if ( disk_io[ 2 ].disk_fd <= 0 )
-    {
-        //  NO:     Message and terminate
-        printf( "BIOS: bios_boot( ); "
-                "Unable to mount DISK 2 [ C: ] (%s)\r\n:", DISK_C );
-        perror( "                    " );
-    }
-
-    //------------------------------------------------------------------------
-    //  Mount disk      D:
-    //------------------------------------------------------------------------
-
-    //  Open the primary disk for write & read operations
-    disk_io[ 3 ].disk_fd = open( DISK_D, O_RDWR );
+    //  The console is ready
+    bios_console_ready = true;
+}
 
-    //  Was the open successful ?
-    if ( disk_io[ 3 ].disk_fd <= 0 )
-    {
-        //  NO:     Message and terminate
-        printf( "BIOS: bios_boot( ); "
-                "Unable to mount DISK 3 [ D: ] (%s)\r\n:", DISK_D );
-        perror( "                    " );
-    }
+/****************************************************************************/
+/**
+ *  Open the character devices ( punch, reader and printer ).
+ *
+ *  @param
+ *
+ *  @return                         No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
 
+static
+void
+bios_devices(
+    void
+    )
+{
     //------------------------------------------------------------------------
     //  Punch
     //------------------------------------------------------------------------
 
     //  Open the primary disk for write & read operations
-    punch_fp = fopen( PUNCH, "a+" );
+    BIOS->punch_fp = fopen( PUNCH, "a+" );
 
     //  Was the open successful ?
-    if ( punch_fp <= 0 )
+    if ( BIOS->punch_fp <= 0 )
     {
         //  NO:     Message and terminate
         printf( "BIOS: bios_boot( ); "
@@ -762,11 +900,11 @@ bios_boot(
     //------------------------------------------------------------------------
 
     //  Is the paper tape reader open ?
-    if( reader_fp > 0 )
+    if( BIOS->reader_fp > 0 )
     {
         //  YES:    Close it.
-        fclose( reader_fp );
-        reader_fp = NULL;
+        fclose( BIOS->reader_fp );
+        BIOS->reader_fp = NULL;
     }
 
     //------------------------------------------------------------------------
@@ -774,10 +912,10 @@ bios_boot(
     //------------------------------------------------------------------------
 
     //  Open the primary disk for write & read operations
-    printer_fp = fopen( PRINTER, "a" );
+    BIOS->printer_fp = fopen( PRINTER, "a" );
 
     //  Was the open successful ?
-    if ( printer_fp <= 0 )
+    if ( BIOS->printer_fp <= 0 )
     {
         //  NO:     Message and terminate
         printf( "BIOS: bios_boot( ); "
@@ -788,7 +926,132 @@ bios_boot(
 
 /****************************************************************************/
 /**
- *  WBOOT           Warm boot - reload command processor
+ *  BOOT        Cold start routine
+ *      This function is completely implementation-dependent and should never
+ *      be called from user code.
+ *
+ *  @param
+ *
+ *  @return                         No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+bios_boot(
+    void
+    )
+{
+    /**
+     *  @param  disk                Disk being initialized                  */
+    uint8_t                     disk;
+#if DEBUG_MODE
+    printf( "===========================================================\r\n" );
+    printf( "DEBUG: BIOS call 'BOOT'\r\n" );
+#endif
+
+    //  Is the console the terminal ?
+    if ( BIOS->console_out < 0 )
+    {
+        //  YES:    Set it up
+        bios_console( );
+    }
+
+    //  Close all open disks
+    for ( disk = 0;
+            disk < MAX_DISK;
+          disk += 1 )
+    {
+        //  Write back and close it, if it is open
+        bios_disk_close( disk );
+        BIOS->disk_io[ disk ].disk_name[ 0 ] = '\0';
+    }
+
+    //------------------------------------------------------------------------
+    //  Mount disk      A:
+    //------------------------------------------------------------------------
+
+    //  Open the primary disk for write & read operations
+    //  Was the open successful ?
+    if ( disk_open( &BIOS->disk_io[ 0 ].disk, DISK_A ) == false )
+    {
+        //  NO:     Message and terminate
+        printf( "BIOS: bios_boot( ); "
+                "Unable to mount DISK 0 [ A: ] (%s)\r\n:", DISK_A );
+        perror( "                    " );
+    }
+    else
+    {
+        //  YES:    Remember what is mounted
+        strcpy( BIOS->disk_io[ 0 ].disk_name, DISK_A );
+    }
+
+    //------------------------------------------------------------------------
+    //  Mount disk      B:
+    //------------------------------------------------------------------------
+
+    //  Open the primary disk for write & read operations
+    //  Was the open successful ?
+    if ( disk_open( &BIOS->disk_io[ 1 ].disk, DISK_B ) == false )
+    {
+        //  NO:     Message and terminate
+        printf( "BIOS: bios_boot( ); "
+                "Unable to mount DISK 1 [ B: ] (%s)\r\n:", DISK_B );
+        perror( "                    " );
+    }
+    else
+    {
+        //  YES:    Remember what is mounted
+        strcpy( BIOS->disk_io[ 1 ].disk_name, DISK_B );
+    }
+
+    //------------------------------------------------------------------------
+    //  Mount disk      C:
+    //------------------------------------------------------------------------
+
+    //  Open the primary disk for write & read operations
+    //  Was the open successful ?
+    if ( disk_open( &BIOS->disk_io[ 2 ].disk, DISK_C ) == false )
+    {
+        //  NO:     Message and terminate
+        printf( "BIOS: bios_boot( ); "
+                "Unable to mount DISK 2 [ C: ] (%s)\r\n:", DISK_C );
+        perror( "                    " );
+    }
+    else
+    {
+        //  YES:    Remember what is mounted
+        strcpy( BIOS->disk_io[ 2 ].disk_name, DISK_C );
+    }
+
+    //------------------------------------------------------------------------
+    //  Mount disk      D:
+    //------------------------------------------------------------------------
+
+    //  Open the primary disk for write & read operations
+    //  Was the open successful ?
+    if ( disk_open( &BIOS->disk_io[ 3 ].disk, DISK_D ) == false )
+    {
+        //  NO:     Message and terminate
+        printf( "BIOS: bios_boot( ); "
+                "Unable to mount DISK 3 [ D: ] (%s)\r\n:", DISK_D );
+        perror( "                    " );
+    }
+    else
+    {
+        //  YES:    Remember what is mounted
+        strcpy( BIOS->disk_io[ 3 ].disk_name, DISK_D );
+    }
+
+    //  Open the character devices
+    bios_devices( );
+}
+
+/****************************************************************************/
+/**
+ *  WBOOT           Warm boot - reload command processor
  *      Reloads the command processor and (on some systems) the BDOS as well.
  *      How it does this is implementation-dependent; it may use the reserved
  *      tracks of a floppy disc or extra memory.
@@ -883,16 +1146,23 @@ bios_wboot(
     close( disk_fd );
 #else
 
+    //  Write back what the last program wrote
+    if ( BIOS->cache->policy == DISK_FLUSH_WBOOT )
+    {
+        bios_flush( );
+    }
+    bios_barrier( );
+
     //  Save the currently selected DISK-ID
-    old_disk_id = disk_id;
+    old_disk_id = BIOS->disk_id;
 
     //  Select disk 0 (A:) for the boot
     PUT_C( 0 );
     bios_seldsk( );
-    disk_io[ disk_id ].disk_parm_tbl = CPU_REG_HL;
+    BIOS->disk_io[ BIOS->disk_id ].disk_parm_tbl = CPU_REG_HL;
 
     //  Was the selection successful ?
-    if ( disk_io[ disk_id ].disk_parm_tbl == 0 )
+    if ( BIOS->disk_io[ BIOS->disk_id ].disk_parm_tbl == 0 )
     {
         //  NO:     OOPS..
         printf( "BIOS: Unable to select boot device\n:" );
@@ -908,14 +1178,14 @@ bios_wboot(
           block_num += 1 )
     {
         //  Set the track number
-        CPU_REG_BC = ( block_num / disk_io[ disk_id ].sec_track );
+        CPU_REG_BC = ( block_num / BIOS->disk_io[ BIOS->disk_id ].sec_track );
         bios_settrk( );
 
 #if 0   //  @ToDo   Pick one
         //  @NOTE:  Sector translation
         //  Translate the sector number
-        CPU_REG_BC = ( block_num % disk_io[ disk_id ].sec_track );
-        CPU_REG_DE = memory_get_16_p( disk_io[ disk_id ].disk_parm_tbl
+        CPU_REG_BC = ( block_num % BIOS->disk_io[ BIOS->disk_id ].sec_track );
+        CPU_REG_DE = memory_get_16_p( BIOS->disk_io[ BIOS->disk_id ].disk_parm_tbl
                                       + DPH_TRANSLATE_OFFSET );
         bios_sectran( );
 
@@ -924,7 +1194,7 @@ bios_wboot(
         bios_setsec( );
 #else   //  @NOTE:  No sector translation
         //  Set the sector number
-        CPU_REG_BC = ( block_num % disk_io[ disk_id ].sec_track );
+        CPU_REG_BC = ( block_num % BIOS->disk_io[ BIOS->disk_id ].sec_track );
         bios_setsec( );
 #endif
 
@@ -956,6 +1226,107 @@ bios_wboot(
     }
 }
 
+/****************************************************************************/
+/**
+ *  CONST for a console routed to a file descriptor.
+ *
+ *  @param
+ *
+ *  @return                         No information is returned from this function.
+ *
+ *  @note
+ *      The end of the input counts as input, CONIN ends the job there.
+ *
+ ****************************************************************************/
+
+static
+void
+bios_const_fd(
+    void
+    )
+{
+    /**
+     *  @param  console             The console input                       */
+    struct  pollfd              console;
+
+    //  Is this the fork server ?
+    if ( zygote_armed( ) == true )
+    {
+        //  YES:    Nothing is typed until a job arrives
+        PUT_A( 0 );
+        return;
+    }
+
+    console.fd = BIOS->console_in;
+    console.events = POLLIN;
+    console.revents = 0;
+
+    //  Is there data waiting, or did some arrive while the guest waited ?
+    if (    ( poll( &console, 1, 0 )            >  0    )
+         || ( idle_poll( BIOS->console_in )     == true ) )
+    {
+        //  YES:    Set a return code for data available.
+        idle_input( );
+        PUT_A( 0xFF );
+    }
+    else
+    {
+        //  NO:     Set a return code for no data.
+        PUT_A( 0 );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  CONIN for a console routed to a file descriptor.
+ *
+ *  @param
+ *
+ *  @return                         No information is returned from this function.
+ *
+ *  @note
+ *      The fork server waits here for its jobs.  A job ends, and its process
+ *      exits, when CP/M asks for more input than the client sent.
+ *
+ ****************************************************************************/
+
+static
+void
+bios_conin_fd(
+    void
+    )
+{
+    /**
+     *  @param  data                The character                           */
+    uint8_t                     data;
+
+    //  Is this the fork server ?
+    if ( zygote_armed( ) == true )
+    {
+        //  YES:    The jobs copy the images, write them back first
+        bios_flush( );
+        bios_barrier( );
+
+        //  Only returns in a job
+        zygote_serve( );
+    }
+
+    //  Is the input used up ?
+    if ( read( BIOS->console_in, &data, 1 ) != 1 )
+    {
+        //  YES:    The job is done
+        exit( 0 );
+    }
+
+    //  Lines end with a carriage return on CP/M
+    if ( data == 0x0A )
+    {
+        data = 0x0D;
+    }
+
+    PUT_A( data );
+}
+
 /****************************************************************************/
 /**
  *  CONST           Console status
@@ -981,6 +1352,17 @@ bios_const(
     void
     )
 {
+    //  A program polling the keyboard can still be busy
+    bios_flush_due( false );
+
+    //  Is the console routed to a file descriptor ?
+    if ( BIOS->console_in >= 0 )
+    {
+        //  YES:    Look there
+        bios_const_fd( );
+        return;
+    }
+
 #if CON_V3
 //    PUT_A( 0 );
     /**
@@ -994,12 +1376,25 @@ bios_const(
     if (    ( ioctl( 0, FIONREAD, &bytes ) == 0 )
          && ( bytes                        == 0 ) )
     {
-        //  NO:     Set a return code for no data.
-        PUT_A( 0 );
+        //  NO:     Is the guest only waiting, and did a key arrive while
+        //          the emulator waited for it ?
+        if (    ( idle_poll( 0 )                 == true )
+             && ( ioctl( 0, FIONREAD, &bytes )   == 0 )
+             && ( bytes                          != 0 ) )
+        {
+            //  YES:    Set a return code for data available.
+            PUT_A( 0xFF );
+        }
+        else
+        {
+            //  NO:     Set a return code for no data.
+            PUT_A( 0 );
+        }
     }
     else
     {
         //  YES:    Set a return code for data available.
+        idle_input( );
         PUT_A( 0xFF );
     }
 #elif CON_V2
@@ -1014,17 +1409,30 @@ bios_const(
     if (    ( ioctl( 0, FIONREAD, &bytes ) == 0 )
          && ( bytes                        == 0 ) )
     {
-        //  NO:     Set a return code for no data.
-        PUT_A( 0 );
+        //  NO:     Is the guest only waiting, and did a key arrive while
+        //          the emulator waited for it ?
+        if (    ( idle_poll( 0 )                 == true )
+             && ( ioctl( 0, FIONREAD, &bytes )   == 0 )
+             && ( bytes                          != 0 ) )
+        {
+            //  YES:    Set a return code for data available.
+            PUT_A( 0xFF );
+        }
+        else
+        {
+            //  NO:     Set a return code for no data.
+            PUT_A( 0 );
+        }
     }
     else
     {
         //  YES:    Set a return code for data available.
+        idle_input( );
         PUT_A( 0xFF );
     }
 #elif CON_V1
     //  Is there any data in the keyboard buffer ?
-    if ( strlen( kb_buffer ) > 0 )
+    if ( strlen( BIOS->kb_buffer ) > 0 )
     {
         //  YES:    Set a return code for data available.
         PUT_A( 0xFF );
@@ -1032,9 +1440,9 @@ bios_const(
     else
     {
         //  NO:     Try reading to see if there is new data
-        kb_read_size = read( 0, kb_buffer, sizeof ( kb_buffer ) );
+        BIOS->kb_read_size = read( 0, BIOS->kb_buffer, sizeof ( BIOS->kb_buffer ) );
 
-        if ( kb_read_size != 255 )
+        if ( BIOS->kb_read_size != 255 )
         {
             //  YES:    Set a return code for data available.
             PUT_A( 0xFF );
@@ -1095,21 +1503,21 @@ p_conin(
     //  Are we switching to the command processor ?
     if ( kb_char == 0x06 )      //  CTL-F
     {
-        //  YES:    The command processor will read the remainder
-        cp( );
-
-        //  Get the CP/M command prompt back
+        //  YES:    Get the CP/M command prompt back
         PUT_A( 0x0A );
+
+        //  The command processor will read the remainder
+        cp( );
     }
 #elif CON_V1
     //  Sanity check: Is there data in the buffer ?
-    if ( strlen( kb_buffer ) > 0 )
+    if ( strlen( BIOS->kb_buffer ) > 0 )
     {
         //  Return the first character.
-        PUT_A( kb_buffer[ 0 ] );
+        PUT_A( BIOS->kb_buffer[ 0 ] );
 
         //  Left shift the data buffer
-        memcpy( &kb_buffer[ 0 ], &kb_buffer[ 1 ], strlen( kb_buffer ) );
+        memcpy( &BIOS->kb_buffer[ 0 ], &BIOS->kb_buffer[ 1 ], strlen( BIOS->kb_buffer ) );
 
         //  Was that the last byte in the buffer ?
         //      if ( strlen( kb_buffer ) == 0 )
@@ -1126,15 +1534,18 @@ p_conin(
         //  NO:     We need to get something before we return
         do
         {
+            //  Display the counters if SIGUSR1 asked for them
+            stats_poll( );
+
             //  Get data from the keyboard
             bios_const( );
-        } while ( strlen( kb_buffer ) == 0 );
+        } while ( strlen( BIOS->kb_buffer ) == 0 );
 
         //  Return the first character.
-        PUT_A( kb_buffer[ 0 ] );
+        PUT_A( BIOS->kb_buffer[ 0 ] );
 
         //  Left shift the data buffer
-        memcpy( &kb_buffer[ 0 ], &kb_buffer[ 1 ], strlen( kb_buffer ) );
+        memcpy( &BIOS->kb_buffer[ 0 ], &BIOS->kb_buffer[ 1 ], strlen( BIOS->kb_buffer ) );
     }
 #endif
 }
@@ -1153,30 +1564,32 @@ p_conin(
  *
  ****************************************************************************/
 
-enum    conin_state_e
-{
-    CS_IDLE                 =   0,
-    CS_1B                   =   1,
-    CS_5B                   =   2,
-    CS_7E                   =   3
-};
-    /**
-     *  @param  conin_state     Extended character sequence                 */
-static
-    enum    conin_state_e       conin_state = CS_IDLE;
-
 static
 void
 bios_conin(
     void
     )
 {
+    //  The guest waits for a key
+    bios_flush_due( true );
+
+    //  Is the console routed to a file descriptor ?
+    if ( BIOS->console_in >= 0 )
+    {
+        //  YES:    Read it from there
+        bios_conin_fd( );
+        return;
+    }
+
 #if CON_V3
     /** @param  kb_char         Data from the keyboard                      */
     int                         kb_char;
 
     do
     {
+        //  Display the counters if SIGUSR1 asked for them
+        stats_poll( );
+
         //  Read from keyboard
         kb_char = getch( );
 
@@ -1186,8 +1599,9 @@ bios_conin(
     switch( kb_char )
     {
         case    0x109:          //      F1
-            cp( );
+            //  Return LF, set first so a SAVE snapshot resumes the same way
             PUT_A( 0x0A );
+            cp( );
             break;
         case    0x221:          //      WORD    -   PREVIOUS
             PUT_A( 0x01 );      //                          CTL-A
@@ -1259,7 +1673,7 @@ COMMAND CONTROL CHARACTERS
         p_conin( );
 
         //  Set the rules based on the previous character
-        switch ( conin_state )
+        switch ( BIOS->conin_state )
         {
             //----------------------------------------------------------------
             case CS_IDLE:
@@ -1268,7 +1682,7 @@ COMMAND CONTROL CHARACTERS
                 if ( GET_A( ) == 0x1B )
                 {
                     //  YES:    Change state
-                    conin_state = CS_1B;
+                    BIOS->conin_state = CS_1B;
                 }
                 //  Keyboard backspace to ASCII backspace
                 else
@@ -1285,7 +1699,7 @@ COMMAND CONTROL CHARACTERS
                 if ( GET_A( ) == 0x5B )
                 {
                     //  YES:    Change state
-                    conin_state = CS_5B;
+                    BIOS->conin_state = CS_5B;
                 }
             }   break;
             //----------------------------------------------------------------
@@ -1319,7 +1733,7 @@ COMMAND CONTROL CHARACTERS
                         break;
                 }
                 //  Update the keyboard state
-                conin_state = CS_IDLE;
+                BIOS->conin_state = CS_IDLE;
 
             }   break;
             //----------------------------------------------------------------
@@ -1329,7 +1743,7 @@ COMMAND CONTROL CHARACTERS
         }
 
     //  Are we done reading a character ?
-    }   while ( conin_state != CS_IDLE );
+    }   while ( BIOS->conin_state != CS_IDLE );
 #elif CON_V1
     //  Read another character from the keyboard
     p_conin( );
@@ -1365,6 +1779,10 @@ bios_conout(
     void
     )
 {
+    /**
+     *  @param  data            The character                               */
+    uint8_t                     data;
+
 #if DEBUG_MODE
     //  Log the call
     printf( "===========================================================\r\n" );
@@ -1375,6 +1793,15 @@ bios_conout(
         printf( "\tCharacter   =  C = x'%02X\r\n", GET_C( ) );
 #endif
 
+    //  Is the console routed to a file descriptor ?
+    if ( BIOS->console_out >= 0 )
+    {
+        //  YES:    Write it there
+        data = GET_C( );
+        write( BIOS->console_out, &data, 1 );
+        return;
+    }
+
     //  Write a single character
     fputc( GET_C( ), stdout);
 
@@ -1414,10 +1841,10 @@ bios_list(
 #endif
 
     //  Write a single character
-    putc( (int)GET_C( ), printer_fp );
+    putc( (int)GET_C( ), BIOS->printer_fp );
 
     //  Update the display for each and every character.
-    fflush( printer_fp );
+    fflush( BIOS->printer_fp );
 }
 
 /****************************************************************************/
@@ -1454,10 +1881,10 @@ bios_punch(
 #endif
 
     //  Write a single character
-    fputc( GET_C( ), punch_fp );
+    fputc( GET_C( ), BIOS->punch_fp );
 
     //  Update the display for each and every character.
-    fflush( punch_fp );
+    fflush( BIOS->punch_fp );
 }
 
 /****************************************************************************/
@@ -1499,13 +1926,13 @@ bios_reader(
     //------------------------------------------------------------------------
 
     //  Is the reader already opened ?
-    if( reader_fp == NULL )
+    if( BIOS->reader_fp == NULL )
     {
         //  NO:     Open it.
-        reader_fp = fopen( READER, "a+" );
+        BIOS->reader_fp = fopen( READER, "a+" );
 
         //  Was the open successful ?
-        if ( reader_fp == NULL )
+        if ( BIOS->reader_fp == NULL )
         {
             //  NO:     Message and terminate
             printf( "BIOS: bios_boot( ); "
@@ -1520,7 +1947,7 @@ bios_reader(
     //------------------------------------------------------------------------
 
     //  Read a character from the reader
-    rdr_c = fgetc( reader_fp );
+    rdr_c = fgetc( BIOS->reader_fp );
 
     //  Was there something to read ?
     if( rdr_c == 0xFF )
@@ -1529,8 +1956,8 @@ bios_reader(
         rdr_c = 0x1A;
 
         //  And close the device
-        fclose( reader_fp );
-        reader_fp = NULL;
+        fclose( BIOS->reader_fp );
+        BIOS->reader_fp = NULL;
     }
 
     //  Put the read character in register 'A'
@@ -1570,7 +1997,7 @@ bios_listst(
 #endif
 
     //  Is the printer file opened ?
-    if( printer_fp < 0 )
+    if( BIOS->printer_fp < 0 )
     {
         //  NO:     Report NOT READY
         PUT_A( 0 );
@@ -1641,6 +2068,9 @@ cpm_bios(
     )
 {
 
+    //  Count the BIOS call
+    machine->stats.bios_traps += 1;
+
     /************************************************************************
      *  BIOS Function Decode
      ************************************************************************/
@@ -1667,7 +2097,7 @@ cpm_bios(
             CPU_REG_DE = 0;
             CPU_REG_HL = 0;
             CPU_REG_I  = 0;
-            CPU_REG_R  = 0;
+            refresh_put( 0 );
             CPU_REG_PC = CCP_BASE;
 
         }   break;
@@ -1786,13 +2216,11 @@ bios_eject(
     )
 {
     //  Is this disk opened ?
-    if ( disk_io[ drive_num ].disk_fd > 0 )
+    if ( disk_mounted( &BIOS->disk_io[ drive_num ].disk ) == true )
     {
-        //  YES:    Close it
-        close( disk_io[ drive_num ].disk_fd );
-
-        //  Mark it as closed
-        disk_io[ drive_num ].disk_fd = -1;
+        //  YES:    Write it back and close it
+        bios_disk_close( drive_num );
+        BIOS->disk_io[ drive_num ].disk_name[ 0 ] = '\0';
     }
     else
     {
@@ -1823,18 +2251,21 @@ bios_mount(
     //  Is this disk opened ?
     if ( drive_num < MAX_DISK )
     {
-        if ( disk_io[ drive_num ].disk_fd == -1 )
+        if ( disk_mounted( &BIOS->disk_io[ drive_num ].disk ) == false )
         {
-            //  Open the primary disk for write & read operations
-            disk_io[ drive_num ].disk_fd = open( file_name, O_RDWR );
-
-            //  Was the open successful ?
-            if ( disk_io[ drive_num ].disk_fd <= 0 )
+            //  Open the disk for write & read operations, was it successful ?
+            if ( disk_open( &BIOS->disk_io[ drive_num ].disk, file_name ) == false )
             {
                 //  NO:     Message and terminate
                 printf( "\r\nCP MOUNT: Unable to open file '%s'\r\n:", file_name );
                 perror(   "          " );
             }
+            else
+            {
+                //  YES:    Remember what is mounted
+                snprintf( BIOS->disk_io[ drive_num ].disk_name,
+                          DISK_NAME_SIZE, "%s", file_name );
+            }
         }
         else
         {
@@ -1849,6 +2280,205 @@ bios_mount(
     }
 }
 
+/****************************************************************************/
+/**
+ *  Flush, change the flush policy of or report on the track cache.
+ *
+ *  @param  request             FLUSH, the name of a flush policy, or an
+ *                              empty string to only report.
+ *
+ *  @return                     FALSE when the request is not known.
+ *
+ *  @note
+ *      The policy and the statistics are reported after the request.
+ *
+ ****************************************************************************/
+
+bool
+bios_cache(
+    const
+    char                    *   request
+    )
+{
+    /**
+     *  @param  policy          The flush policy requested                  */
+    int                         policy;
+
+    //  Is there a request ?
+    if ( request[ 0 ] != '\0' )
+    {
+        //  YES:    Flush now ?
+        if ( strcasecmp( request, "FLUSH" ) == 0 )
+        {
+            bios_flush( );
+        }
+        else
+        {
+            //  NO:     A new policy
+            policy = disk_cache_policy( request );
+            if ( policy < 0 )
+            {
+                return( false );
+            }
+            BIOS->cache->policy = policy;
+        }
+    }
+
+    disk_cache_report( BIOS->cache );
+
+    //  DONE!
+    return( true );
+}
+
+/****************************************************************************/
+/**
+ *  Put a copy-on-write overlay over the image on a drive.
+ *
+ *  @param  drive_num           Number reflecting the drive letter A=0 etc
+ *  @param  file_name           The new overlay file.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      From here on the image on the drive is only read, the guest's writes
+ *      go to the overlay, which is what is mounted now.
+ *
+ ****************************************************************************/
+
+void
+bios_overlay(
+    int                         drive_num,
+    char                    *   file_name
+    )
+{
+    /**
+     *  @param  base_name       The image that becomes the base             */
+    char                        base_name[ DISK_NAME_SIZE ];
+
+    //  Is there a plain image on the drive ?
+    if (    ( drive_num >= MAX_DISK )
+         || ( disk_mounted( &BIOS->disk_io[ drive_num ].disk ) == false ) )
+    {
+        //  NO:     Error Message
+        printf( "\r\nCP OVERLAY: Drive %c: has nothing mounted\r\n",
+                ( ( drive_num + 1 ) | '@' ) );
+        return;
+    }
+    if ( BIOS->disk_io[ drive_num ].disk.overlay != NULL )
+    {
+        printf( "\r\nCP OVERLAY: Drive %c: already has an overlay\r\n",
+                ( ( drive_num + 1 ) | '@' ) );
+        return;
+    }
+
+    //  The base must hold everything the guest wrote so far
+    bios_disk_close( drive_num );
+    memcpy( base_name, BIOS->disk_io[ drive_num ].disk_name, DISK_NAME_SIZE );
+    BIOS->disk_io[ drive_num ].disk_name[ 0 ] = '\0';
+
+    //  Was the overlay created ?
+    if ( disk_overlay_create( file_name, base_name ) == false )
+    {
+        //  NO:     Message and mount the base again
+        printf( "\r\nCP OVERLAY: Unable to create file '%s'\r\n:", file_name );
+        perror(   "            " );
+        bios_mount( drive_num, base_name );
+        return;
+    }
+
+    bios_mount( drive_num, file_name );
+
+    //  Did the overlay mount ?
+    if ( disk_mounted( &BIOS->disk_io[ drive_num ].disk ) == false )
+    {
+        //  NO:     The base then
+        bios_mount( drive_num, base_name );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Write the overlay on a drive into its base and empty it.
+ *
+ *  @param  drive_num           Number reflecting the drive letter A=0 etc
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Every guest sharing the base sees the sectors its own overlay does
+ *      not hold.
+ *
+ ****************************************************************************/
+
+void
+bios_commit(
+    int                         drive_num
+    )
+{
+    /**
+     *  @param  disk            The disk on the drive                       */
+    struct  disk_t          *   disk;
+    /**
+     *  @param  count           Sectors held by the overlay                 */
+    uint32_t                    count;
+
+    disk = bios_overlay_disk( drive_num, "COMMIT" );
+    if ( disk == NULL )
+    {
+        return;
+    }
+
+    count = disk_overlay_count( disk );
+
+    //  Was the base written ?
+    if ( disk_overlay_commit( disk ) == false )
+    {
+        //  NO:     Message, the overlay is kept
+        printf( "\r\nCP COMMIT: Unable to write the base image\r\n:" );
+        perror(   "           " );
+        return;
+    }
+
+    printf( "\r\nCP COMMIT: %u sectors written to the base image\r\n", count );
+}
+
+/****************************************************************************/
+/**
+ *  Throw away what the guest wrote to the overlay on a drive.
+ *
+ *  @param  drive_num           Number reflecting the drive letter A=0 etc
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The drive reads as its base again.
+ *
+ ****************************************************************************/
+
+void
+bios_discard(
+    int                         drive_num
+    )
+{
+    /**
+     *  @param  disk            The disk on the drive                       */
+    struct  disk_t          *   disk;
+    /**
+     *  @param  count           Sectors held by the overlay                 */
+    uint32_t                    count;
+
+    disk = bios_overlay_disk( drive_num, "DISCARD" );
+    if ( disk == NULL )
+    {
+        return;
+    }
+
+    count = disk_overlay_count( disk );
+    disk_overlay_discard( disk );
+
+    printf( "\r\nCP DISCARD: %u sectors dropped\r\n", count );
+}
+
 /****************************************************************************/
 /**
  *  This functin is only called when shutting the system down.
@@ -1866,17 +2496,329 @@ bios_shutdown(
     void
     )
 {
+    /**
+     *  @param  disk                Drive number                            */
+    int                         disk;
+
     //  Shutdown the curses interface
     endwin( );
 
-    //  Close the disk drives
-    if( disk_io[ 0 ].disk_fd != -1 );
-        close( disk_io[ 0 ].disk_fd );
-    if( disk_io[ 1 ].disk_fd != -1 );
-        close( disk_io[ 1 ].disk_fd );
-    if( disk_io[ 1 ].disk_fd != -1 );
-        close( disk_io[ 2 ].disk_fd );
-    if( disk_io[ 1 ].disk_fd != -1 );
-        close( disk_io[ 3 ].disk_fd );
+    //  Report the performance counters
+    stats_json( stderr );
+
+    //  Write back and close the disk drives
+    for( disk = 0; disk < MAX_DISK; disk += 1 )
+    {
+        bios_disk_close( disk );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Give a new guest its devices.
+ *
+ *  @param  guest               The guest
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called by machine_create( ).  No drive is open until the guest boots.
+ *
+ ****************************************************************************/
+
+void
+bios_create(
+    struct  machine_t       *   guest
+    )
+{
+    /**
+     *  @param  disk            Drive number                                */
+    int                         disk;
+
+    guest->bios = calloc( 1, sizeof( struct bios_t ) );
+    if ( guest->bios == NULL )
+    {
+        printf( "bios: out of memory\n" );
+        exit( 1 );
+    }
+
+    //  No drive is open
+    for( disk = 0; disk < MAX_DISK; disk += 1 )
+    {
+        disk_init( &guest->bios->disk_io[ disk ].disk );
+    }
+    guest->bios->cache = disk_cache_create( );
+    if ( guest->bios->cache == NULL )
+    {
+        printf( "bios: out of memory\n" );
+        exit( 1 );
+    }
+
+    //  The console is the terminal
+    guest->bios->console_in = -1;
+    guest->bios->console_out = -1;
+}
+
+/****************************************************************************/
+/**
+ *  Close and free the devices of a guest.
+ *
+ *  @param  guest               The guest
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called by machine_destroy( ), the guest need not be bound.
+ *
+ ****************************************************************************/
+
+void
+bios_destroy(
+    struct  machine_t       *   guest
+    )
+{
+    /**
+     *  @param  bios            The devices being freed                     */
+    struct  bios_t          *   bios;
+    /**
+     *  @param  disk            Drive number                                */
+    int                         disk;
+
+    bios = guest->bios;
+
+    //  Were the devices ever created ?
+    if ( bios == NULL )
+    {
+        //  NO:     Nothing to do
+        return;
+    }
+
+    //  Write back and close the disk drives
+    for( disk = 0; disk < MAX_DISK; disk += 1 )
+    {
+        if ( disk_mounted( &bios->disk_io[ disk ].disk ) == true )
+        {
+            disk_cache_flush( bios->cache, &bios->disk_io[ disk ].disk );
+        }
+    }
+    disk_cache_barrier( bios->cache );
+    for( disk = 0; disk < MAX_DISK; disk += 1 )
+    {
+        disk_close( &bios->disk_io[ disk ].disk );
+    }
+    disk_cache_destroy( bios->cache );
+
+    //  Close the character devices
+    if ( bios->punch_fp != NULL )
+        fclose( bios->punch_fp );
+    if ( bios->reader_fp != NULL )
+        fclose( bios->reader_fp );
+    if ( bios->printer_fp != NULL )
+        fclose( bios->printer_fp );
+
+    free( bios );
+    guest->bios = NULL;
+}
+
+/****************************************************************************/
+/**
+ *  Copy the devices of the bound guest into a snapshot.
+ *
+ *  @param  image               Where the snapshot is written.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Mounted images are recorded by name, the character devices are not
+ *      recorded.
+ *
+ ****************************************************************************/
+
+void
+bios_save(
+    struct  bios_image_t    *   image
+    )
+{
+    /**
+     *  @param  disk            Drive number                                */
+    int                         disk;
+
+    memset( image, 0, sizeof( struct bios_image_t ) );
+
+    //  The recorded images must hold what the guest wrote
+    bios_flush( );
+    bios_barrier( );
+
+    image->disk_id      = BIOS->disk_id;
+    image->conin_state  = BIOS->conin_state;
+    image->console      = bios_console_ready;
+
+    //  The mount table
+    for( disk = 0; disk < MAX_DISK; disk += 1 )
+    {
+        memcpy( image->drive[ disk ].disk_name,
+                BIOS->disk_io[ disk ].disk_name, DISK_NAME_SIZE );
+        image->drive[ disk ].track_num      = BIOS->disk_io[ disk ].track_num;
+        image->drive[ disk ].sector_num     = BIOS->disk_io[ disk ].sector_num;
+        image->drive[ disk ].dma_addr       = BIOS->disk_io[ disk ].dma_addr;
+        image->drive[ disk ].sec_track      = BIOS->disk_io[ disk ].sec_track;
+        image->drive[ disk ].disk_parm_tbl  = BIOS->disk_io[ disk ].disk_parm_tbl;
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Give the bound guest the devices recorded in a snapshot.
+ *
+ *  @param  image               The snapshot.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Every drive is ejected and the recorded images are mounted again.  A
+ *      guest that never booted also gets the console and the character
+ *      devices set up the way BOOT does it.
+ *
+ ****************************************************************************/
+
+void
+bios_load(
+    const
+    struct  bios_image_t    *   image
+    )
+{
+    /**
+     *  @param  disk            Drive number                                */
+    int                         disk;
+
+    //  Had the guest booted when the snapshot was taken ?
+    if ( image->console != 0 )
+    {
+        //  YES:    Has this process set up the console ?
+        if ( bios_console_ready == false )
+        {
+            //  NO:     Do it now
+            bios_console( );
+        }
+
+        //  Has this guest opened its character devices ?
+        if ( BIOS->punch_fp == NULL && BIOS->printer_fp == NULL )
+        {
+            //  NO:     Do it now
+            bios_devices( );
+        }
+    }
+
+    BIOS->disk_id       = image->disk_id;
+    BIOS->conin_state   = image->conin_state;
+
+    //  The mount table
+    for( disk = 0; disk < MAX_DISK; disk += 1 )
+    {
+        //  Eject what is mounted now
+        bios_disk_close( disk );
+        BIOS->disk_io[ disk ].disk_name[ 0 ] = '\0';
+
+        BIOS->disk_io[ disk ].track_num     = image->drive[ disk ].track_num;
+        BIOS->disk_io[ disk ].sector_num    = image->drive[ disk ].sector_num;
+        BIOS->disk_io[ disk ].dma_addr      = image->drive[ disk ].dma_addr;
+        BIOS->disk_io[ disk ].sec_track     = image->drive[ disk ].sec_track;
+        BIOS->disk_io[ disk ].disk_parm_tbl = image->drive[ disk ].disk_parm_tbl;
+
+        //  Was an image mounted on this drive ?
+        if ( image->drive[ disk ].disk_name[ 0 ] != '\0' )
+        {
+            //  YES:    Mount it again
+            bios_mount( disk, (char *)image->drive[ disk ].disk_name );
+        }
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Route the console of the bound guest to file descriptors.
+ *
+ *  @param  in_fd               Console input, -1 for the terminal.
+ *  @param  out_fd              Console output, -1 for the terminal.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called before BOOT the terminal is never set up.  Characters pass
+ *      unchanged except that LF is read as CR.
+ *
+ ****************************************************************************/
+
+void
+bios_console_fd(
+    int                         in_fd,
+    int                         out_fd
+    )
+{
+    BIOS->console_in = in_fd;
+    BIOS->console_out = out_fd;
+}
+
+/****************************************************************************/
+/**
+ *  Give the bound guest private copies of its mounted disks.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Each disk is replaced by a copy-on-write overlay in an anonymous
+ *      memory file, the image is shared and later writes never reach it.
+ *      A drive that can't have one is ejected rather than shared.
+ *
+ ****************************************************************************/
+
+void
+bios_private_disks(
+    void
+    )
+{
+    /**
+     *  @param  disk            Drive number                                */
+    int                         disk;
+    /**
+     *  @param  copy_fd         The private overlay                         */
+    int                         copy_fd;
+
+    //  The I/O thread stayed in the fork server
+    if ( BIOS->cache->async != NULL )
+    {
+        disk_async_forked( BIOS->cache->async );
+    }
+
+    for( disk = 0; disk < MAX_DISK; disk += 1 )
+    {
+        //  Is this disk opened ?
+        if ( disk_mounted( &BIOS->disk_io[ disk ].disk ) == false )
+        {
+            //  NO:     Nothing to copy
+            continue;
+        }
+
+        //  Put an overlay over the image
+        copy_fd = disk_overlay_private( &BIOS->disk_io[ disk ].disk,
+                                        BIOS->disk_io[ disk ].disk_name );
+
+        //  Use the overlay from now on ( nothing is dirty in a new job, the
+        //  cached tracks stay and are written back to the overlay )
+        disk_close( &BIOS->disk_io[ disk ].disk );
+
+        //  Could the overlay be made and mounted ?
+        if (    ( copy_fd < 0 )
+             || ( disk_attach( &BIOS->disk_io[ disk ].disk, copy_fd ) == false ) )
+        {
+            //  NO:     Eject the drive
+            disk_cache_drop( BIOS->cache, &BIOS->disk_io[ disk ].disk );
+            printf( "\r\nBIOS: Unable to copy drive %c:\r\n", disk + 'A' );
+            BIOS->disk_io[ disk ].disk_name[ 0 ] = '\0';
+        }
+    }
 }
-/****************************************************************************/
\ No newline at end of file
+
+/****************************************************************************/
@@ -41,6 +41,7 @@
 #include "registers.h"          //  All things CPU registers.
 #include "bios.h"               //  CP/M BIOS
 #include "boot_rom.h"           //  Boot ROM
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -40,6 +40,8 @@
 #include "global.h"             //  Global definitions
 #include "memory.h"             //  Memory management and access
 #include "registers.h"          //  All things CPU registers.
+#include "disassemble.h"        //  Disassembler
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -89,35 +91,40 @@
 
 /****************************************************************************/
 /**
- *  Disassemble the current Op-Code.
+ *  Look up the mnemonic of an Op-Code.
  *
- *  @parm   pc                      Program Counter
- *  @parm   op_code                 The operation code of the current instruction.
+ *  @parm   eis                     Extended Instruction Set of the op-code.
+ *  @parm   op_code                 The operation code.
+ *  @parm   mnemonic                DISASSEMBLE_SIZE byte buffer for the
+ *                                  mnemonic.
  *
- *  @return                         No information is returned from this function.
+ *  @return                         The instruction length in bytes, zero
+ *                                  when the op-code isn't decoded.
  *
  *  @note
+ *      Only the base and 'ED' instruction sets are decoded.
  *
  ****************************************************************************/
 
-void
-disassemble(
-    uint16_t                    pc,
-    uint8_t                     op_code
+int
+disassemble_mnemonic(
+    enum    EIS_e               eis,
+    uint8_t                     op_code,
+    char                    *   mnemonic
     )
 {
-    /**
-     *  @param  mnemonic           Instruction mnemonic                     */
-    char                        mnemonic[ 32 ];
     /**
      *  @param  inst_len            Instruction length                      */
     int                         inst_len;
 
     //  Clean the mnemonic buffer
-    memset( mnemonic, 0x00, sizeof( mnemonic ) );
+    memset( mnemonic, 0x00, DISASSEMBLE_SIZE );
+
+    //  Nothing decoded yet
+    inst_len = 0;
 
     //  Base Intel 8080 or Z80 instruction set ?
-    if( EIS == EIS_BASE )
+    if( eis == EIS_BASE )
     {
         //  YES:    Op-Code decode
         switch( op_code )
@@ -656,7 +663,7 @@ disassemble(
 
     //  Z80 Extended Instruction Set 'ED' ?
     else
-    if( EIS == EIS_ED )
+    if( eis == EIS_ED )
     {
         //  YES:    Op-Code decode
         switch( op_code )
@@ -1002,6 +1009,39 @@ disassemble(
         //========================================================================
         }
     }
+
+    return( inst_len );
+}
+
+/****************************************************************************/
+/**
+ *  Disassemble the current Op-Code.
+ *
+ *  @parm   pc                      Program Counter
+ *  @parm   op_code                 The operation code of the current instruction.
+ *
+ *  @return                         No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+disassemble(
+    uint16_t                    pc,
+    uint8_t                     op_code
+    )
+{
+    /**
+     *  @param  mnemonic           Instruction mnemonic                     */
+    char                        mnemonic[ DISASSEMBLE_SIZE ];
+    /**
+     *  @param  inst_len            Instruction length                      */
+    int                         inst_len;
+
+    //  Decode the op-code
+    inst_len = disassemble_mnemonic( EIS, op_code, mnemonic );
+
     //  Write the instruction address.
     printf( "%04X - ", pc );
 
@@ -1037,6 +1077,9 @@ disassemble(
                 memory_get_8( pc + 2 ),
                 memory_get_8( pc + 3 )  );
 
+    //  Show the real flags
+    FLAGS_SYNC( );
+
     printf( "%s - AF:%04X BC:%04X DE:%04X HL:%04X SP:%04X (%04X)\n",
             mnemonic, CPU_REG_AF, CPU_REG_BC, CPU_REG_DE, CPU_REG_HL,
             CPU_REG_SP, memory_get_16( CPU_REG_SP ) );
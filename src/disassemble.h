@@ -43,6 +43,9 @@
  ****************************************************************************/
 
 //----------------------------------------------------------------------------
+/**
+ *  @param  DISASSEMBLE_SIZE    Size of a mnemonic buffer                   */
+#define DISASSEMBLE_SIZE        ( 32 )
 //----------------------------------------------------------------------------
 
 /****************************************************************************
@@ -71,6 +74,13 @@
  ****************************************************************************/
 
 //----------------------------------------------------------------------------
+int
+disassemble_mnemonic(
+    enum    EIS_e               eis,
+    uint8_t                     op_code,
+    char                    *   mnemonic
+    );
+//----------------------------------------------------------------------------
 void
 disassemble(
     uint16_t                    pc,
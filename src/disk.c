@@ -0,0 +1,731 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Disk images behind the CP/M drives.
+ *
+ *  An image is mapped MAP_SHARED when it is opened, so a sector READ or
+ *  WRITE is one memcpy between the mapping and the DMA address, with no
+ *  system call.  The bytes written since the last flush are tracked as one
+ *  range that disk_flush( ) hands to msync( ); the BIOS flushes on WBOOT,
+ *  EJECT and shutdown.
+ *
+ *  A sector past the end of the mapping is read and written with pread( )
+ *  and pwrite( ).  A write that grows the image maps it again.  An image
+ *  that can not be mapped at all ( an empty file ) only uses that path.
+ *
+ *  A file that starts with an overlay header is a copy-on-write overlay
+ *  of a read only base ( disk_overlay.c ).  Its sectors start at origin in
+ *  the file, the map points there, and a sector the overlay does not hold
+ *  comes from the base.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+#define _DEFAULT_SOURCE         //  pread( ), pwrite( ), msync( )
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <unistd.h>             //  UNIX standard library.
+#include <stdio.h>              //  Standard I/O definitions
+#include <string.h>             //  Functions for managing strings
+#include <fcntl.h>              //  open( )
+#include <sys/stat.h>           //  fstat( )
+#include <sys/mman.h>           //  mmap( ), msync( )
+                                //*******************************************
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "disk.h"               //  Disk images
+#include "disk_overlay.h"       //  Copy-on-write overlays
+#include "machine.h"            //  Guest machine context
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  DISK_EMPTY          What a freshly formatted sector holds       */
+#define DISK_EMPTY              ( 0xE5 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Map the whole image.
+ *
+ *  @param  disk                The disk, its fd is open.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Replaces an older mapping.  When the image can not be mapped every
+ *      sector goes through pread( ) and pwrite( ).
+ *
+ ****************************************************************************/
+
+static
+void
+disk_map(
+    struct  disk_t          *   disk
+    )
+{
+    /**
+     *  @param  file_stat       Size of the image                           */
+    struct  stat                file_stat;
+    /**
+     *  @param  map             The new mapping                             */
+    void                    *   map;
+
+    //  Write back and drop the old mapping
+    if ( disk->map != NULL )
+    {
+        disk_flush( disk );
+        munmap( disk->map, disk->size );
+        disk->map = NULL;
+        disk->size = 0;
+    }
+
+    //  Is there anything to map ?
+    if (    ( fstat( disk->fd, &file_stat ) != 0 )
+         || ( file_stat.st_size <= 0 ) )
+    {
+        //  NO:     System calls only
+        return;
+    }
+
+    map = mmap( NULL, (size_t)file_stat.st_size,
+                PROT_READ | PROT_WRITE, MAP_SHARED, disk->fd, 0 );
+    if ( map != MAP_FAILED )
+    {
+        disk->map  = map;
+        disk->size = (size_t)file_stat.st_size;
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Remember that a range of the mapping has to be flushed.
+ *
+ *  @param  disk                The disk.
+ *  @param  offset              First byte written.
+ *  @param  length              Bytes written.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+disk_dirty(
+    struct  disk_t          *   disk,
+    size_t                      offset,
+    size_t                      length
+    )
+{
+    //  Is this the first write since the last flush ?
+    if ( disk->dirty_hi == 0 )
+    {
+        //  YES:    It is the range
+        disk->dirty_lo = offset;
+        disk->dirty_hi = offset + length;
+    }
+    else
+    {
+        //  NO:     Grow the range
+        if ( offset < disk->dirty_lo )
+            disk->dirty_lo = offset;
+        if ( ( offset + length ) > disk->dirty_hi )
+            disk->dirty_hi = offset + length;
+    }
+}
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Mark a disk as not open.
+ *
+ *  @param  disk                The disk.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+disk_init(
+    struct  disk_t          *   disk
+    )
+{
+    memset( disk, 0, sizeof( struct disk_t ) );
+    disk->fd = -1;
+}
+
+/****************************************************************************/
+/**
+ *  Open a disk image for write & read operations.
+ *
+ *  @param  disk                The disk, it is not open.
+ *  @param  file_name           The image file.
+ *
+ *  @return                     TRUE when the image is open, else FALSE is
+ *                              returned and errno tells why.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+int
+disk_open(
+    struct  disk_t          *   disk,
+    const
+    char                    *   file_name
+    )
+{
+    /**
+     *  @param  fd              File Descriptor                             */
+    int                         fd;
+
+    fd = open( file_name, O_RDWR );
+    if ( fd < 0 )
+    {
+        return( false );
+    }
+
+    //  DONE!
+    return( disk_attach( disk, fd ) );
+}
+
+/****************************************************************************/
+/**
+ *  Use an open file as the disk image.
+ *
+ *  @param  disk                The disk, it is not open.
+ *  @param  fd                  The image, the disk owns it from now on.
+ *
+ *  @return                     TRUE
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+int
+disk_attach(
+    struct  disk_t          *   disk,
+    int                         fd
+    )
+{
+    disk_init( disk );
+    disk->fd = fd;
+
+    //  Is it an overlay ?
+    switch( disk_overlay_attach( disk ) )
+    {
+        case 0:
+            //  NO:     Map the image
+            disk_map( disk );
+            break;
+        case 1:
+            //  YES:    Mapped already
+            break;
+        default:
+            //  Broken or its base is gone
+            perror( "DISK: overlay" );
+            close( fd );
+            disk_init( disk );
+            return( false );
+    }
+
+    //  DONE!
+    return( true );
+}
+
+/****************************************************************************/
+/**
+ *  Is an image open ?
+ *
+ *  @param  disk                The disk.
+ *
+ *  @return                     TRUE when an image is open, else FALSE.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+bool
+disk_mounted(
+    const
+    struct  disk_t          *   disk
+    )
+{
+    //  DONE!
+    return( disk->fd >= 0 );
+}
+
+/****************************************************************************/
+/**
+ *  Copy a sector into CPU memory.
+ *
+ *  @param  dma_addr            Where the sector goes.
+ *  @param  data_p              The sector.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      A DMA buffer that wraps past x'FFFF is copied a byte at a time.
+ *
+ ****************************************************************************/
+
+void
+disk_dma_load(
+    uint16_t                    dma_addr,
+    const
+    uint8_t                 *   data_p
+    )
+{
+    /**
+     *  @param  ndx             Byte being copied                           */
+    int                         ndx;
+
+    //  Does the buffer fit below the end of memory ?
+    if ( ( (uint32_t)dma_addr + DISK_SECTOR_SIZE ) <= MEMORY_SIZE )
+    {
+        //  YES:    One copy
+        memory_load( dma_addr, DISK_SECTOR_SIZE, (uint8_t *)data_p );
+        return;
+    }
+
+    for( ndx = 0; ndx < DISK_SECTOR_SIZE; ndx += 1 )
+    {
+        memory_put_8( (uint16_t)( dma_addr + ndx ), data_p[ ndx ] );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Copy a sector out of CPU memory.
+ *
+ *  @param  data_p              Where the sector goes.
+ *  @param  dma_addr            The sector.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The mirror image of disk_dma_load( ).
+ *
+ ****************************************************************************/
+
+void
+disk_dma_store(
+    uint8_t                 *   data_p,
+    uint16_t                    dma_addr
+    )
+{
+    /**
+     *  @param  ndx             Byte being copied                           */
+    int                         ndx;
+
+    //  Does the buffer fit below the end of memory ?
+    if ( ( (uint32_t)dma_addr + DISK_SECTOR_SIZE ) <= MEMORY_SIZE )
+    {
+        //  YES:    One copy
+        memory_read( data_p, DISK_SECTOR_SIZE, dma_addr );
+        return;
+    }
+
+    for( ndx = 0; ndx < DISK_SECTOR_SIZE; ndx += 1 )
+    {
+        data_p[ ndx ] = memory_get_8( (uint16_t)( dma_addr + ndx ) );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Read a sector into CPU memory.
+ *
+ *  @param  disk                The disk.
+ *  @param  lba                 Logical Block Address of the sector.
+ *  @param  dma_addr            Where the sector goes.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 for an
+ *                              unrecoverable error.
+ *
+ *  @note
+ *      A sector past the end of the image reads as freshly formatted.
+ *
+ ****************************************************************************/
+
+uint8_t
+disk_read(
+    struct  disk_t          *   disk,
+    uint32_t                    lba,
+    uint16_t                    dma_addr
+    )
+{
+    /**
+     *  @param  offset          Offset of the sector in the image           */
+    size_t                      offset;
+    /**
+     *  @param  data            The sector when it is not mapped            */
+    uint8_t                     data[ DISK_SECTOR_SIZE ];
+    /**
+     *  @param  sector_p        The mapped sector                           */
+    const
+    uint8_t                 *   sector_p;
+
+    offset = (size_t)lba * DISK_SECTOR_SIZE;
+
+    //  Is the sector mapped ?
+    if ( ( offset + DISK_SECTOR_SIZE ) <= disk->size )
+    {
+        //  YES:    Straight into CPU memory ( an overlay's may be its base's )
+        sector_p = ( disk->overlay == NULL )
+                 ? &disk->map[ offset ] : disk_overlay_sector( disk, offset );
+        if ( sector_p != NULL )
+        {
+            disk_dma_load( dma_addr, sector_p );
+            return( 0x00 );
+        }
+    }
+
+    //  Read what there is
+    if ( disk_read_data( disk, offset, data, DISK_SECTOR_SIZE ) != 0x00 )
+    {
+        return( 0x01 );
+    }
+    disk_dma_load( dma_addr, data );
+
+    //  DONE!
+    return( 0x00 );
+}
+
+/****************************************************************************/
+/**
+ *  Write a sector from CPU memory.
+ *
+ *  @param  disk                The disk.
+ *  @param  lba                 Logical Block Address of the sector.
+ *  @param  dma_addr            Where the sector is.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 for an
+ *                              unrecoverable error.
+ *
+ *  @note
+ *      The write reaches the file when the disk is flushed.
+ *
+ ****************************************************************************/
+
+uint8_t
+disk_write(
+    struct  disk_t          *   disk,
+    uint32_t                    lba,
+    uint16_t                    dma_addr
+    )
+{
+    /**
+     *  @param  offset          Offset of the sector in the image           */
+    size_t                      offset;
+    /**
+     *  @param  data            The sector when it is not mapped            */
+    uint8_t                     data[ DISK_SECTOR_SIZE ];
+
+    offset = (size_t)lba * DISK_SECTOR_SIZE;
+
+    //  Is the sector mapped ?
+    if ( ( offset + DISK_SECTOR_SIZE ) <= disk->size )
+    {
+        //  An overlay takes the sector from its base
+        if (    ( disk->overlay != NULL )
+             && ( disk_overlay_claim( disk, offset, DISK_SECTOR_SIZE ) != 0x00 ) )
+        {
+            return( 0x01 );
+        }
+
+        //  YES:    Straight out of CPU memory
+        disk_dma_store( &disk->map[ offset ], dma_addr );
+
+        //  Remember what has to be flushed
+        disk_dirty( disk, offset, DISK_SECTOR_SIZE );
+        return( 0x00 );
+    }
+
+    //  The image grows
+    disk_dma_store( data, dma_addr );
+
+    //  DONE!
+    return( disk_write_data( disk, offset, data, DISK_SECTOR_SIZE ) );
+}
+
+/****************************************************************************/
+/**
+ *  Read bytes of the image into a buffer.
+ *
+ *  @param  disk                The disk.
+ *  @param  offset              Offset in the image.
+ *  @param  data_p              Where the bytes go.
+ *  @param  length              Number of bytes.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 for an
+ *                              unrecoverable error.
+ *
+ *  @note
+ *      Bytes past the end of the image read as freshly formatted.
+ *
+ ****************************************************************************/
+
+uint8_t
+disk_read_data(
+    struct  disk_t          *   disk,
+    size_t                      offset,
+    uint8_t                 *   data_p,
+    size_t                      length
+    )
+{
+    /**
+     *  @param  done            Bytes read so far                           */
+    size_t                      done;
+    /**
+     *  @param  count           Bytes read by pread( )                      */
+    ssize_t                     count;
+
+    //  Is it an overlay ?
+    if ( disk->overlay != NULL )
+    {
+        //  YES:    Sector by sector from the overlay or its base
+        return( disk_overlay_read( disk, offset, data_p, length ) );
+    }
+
+    done = 0;
+
+    //  The mapped part
+    if ( offset < disk->size )
+    {
+        done = disk->size - offset;
+        if ( done > length )
+        {
+            done = length;
+        }
+        memcpy( data_p, &disk->map[ offset ], done );
+    }
+
+    //  Anything after it
+    while ( done < length )
+    {
+        count = pread( disk->fd, &data_p[ done ], length - done, (off_t)( offset + done ) );
+        if ( count < 0 )
+        {
+            return( 0x01 );
+        }
+        if ( count == 0 )
+        {
+            //  The end of the image
+            memset( &data_p[ done ], DISK_EMPTY, length - done );
+            break;
+        }
+        done += (size_t)count;
+    }
+
+    //  DONE!
+    return( 0x00 );
+}
+
+/****************************************************************************/
+/**
+ *  Write bytes of a buffer to the image.
+ *
+ *  @param  disk                The disk.
+ *  @param  offset              Offset in the image.
+ *  @param  data_p              The bytes.
+ *  @param  length              Number of bytes.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 for an
+ *                              unrecoverable error.
+ *
+ *  @note
+ *      The write reaches the file when the disk is flushed.
+ *
+ ****************************************************************************/
+
+uint8_t
+disk_write_data(
+    struct  disk_t          *   disk,
+    size_t                      offset,
+    const
+    uint8_t                 *   data_p,
+    size_t                      length
+    )
+{
+    //  Is it an overlay ?
+    if (    ( disk->overlay != NULL )
+         && ( disk_overlay_claim( disk, offset, length ) != 0x00 ) )
+    {
+        //  YES:    And it can't grow
+        return( 0x01 );
+    }
+
+    //  Is all of it mapped ?
+    if ( ( offset + length ) <= disk->size )
+    {
+        //  YES:    Copy it and remember what has to be flushed
+        memcpy( &disk->map[ offset ], data_p, length );
+        disk_dirty( disk, offset, length );
+        return( 0x00 );
+    }
+
+    //  The image grows
+    if ( pwrite( disk->fd, data_p, length, (off_t)offset ) != (ssize_t)length )
+    {
+        return( 0x01 );
+    }
+    disk_map( disk );
+
+    //  DONE!
+    return( 0x00 );
+}
+
+/****************************************************************************/
+/**
+ *  Write the sectors written since the last flush back to the image.
+ *
+ *  @param  disk                The disk.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+disk_flush(
+    struct  disk_t          *   disk
+    )
+{
+    /**
+     *  @param  page            Bytes in a host page                        */
+    size_t                      page;
+    /**
+     *  @param  start           The dirty range, rounded down to a page     */
+    size_t                      start;
+
+    //  Was anything written ?
+    if ( ( disk->map == NULL ) || ( disk->dirty_hi == 0 ) )
+    {
+        //  NO:     Only an overlay's bitmap might be
+        if ( disk->overlay != NULL )
+        {
+            disk_overlay_flush( disk );
+        }
+        return;
+    }
+
+    page  = (size_t)sysconf( _SC_PAGESIZE );
+    start = disk->dirty_lo & ~( page - 1 );
+
+    if ( msync( &disk->map[ start ], disk->dirty_hi - start, MS_SYNC ) != 0 )
+    {
+        perror( "DISK: msync" );
+    }
+
+    disk->dirty_lo = 0;
+    disk->dirty_hi = 0;
+
+    //  The sectors are out, now the bitmap that says they are there
+    if ( disk->overlay != NULL )
+    {
+        disk_overlay_flush( disk );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Flush and close the image.
+ *
+ *  @param  disk                The disk.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Nothing happens when no image is open.
+ *
+ ****************************************************************************/
+
+void
+disk_close(
+    struct  disk_t          *   disk
+    )
+{
+    //  Is an image open ?
+    if ( disk->fd < 0 )
+    {
+        //  NO:     Nothing to do
+        return;
+    }
+
+    if ( disk->overlay != NULL )
+    {
+        //  The map is part of the overlay's
+        disk_flush( disk );
+        disk_overlay_close( disk );
+    }
+    else if ( disk->map != NULL )
+    {
+        disk_flush( disk );
+        munmap( disk->map, disk->size );
+    }
+    close( disk->fd );
+
+    disk_init( disk );
+}
+
+/****************************************************************************/
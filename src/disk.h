@@ -0,0 +1,193 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+#ifndef DISK_H
+#define DISK_H
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Disk images behind the CP/M drives.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * System APIs
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stddef.h>             //  size_t
+                                //*******************************************
+
+/****************************************************************************
+ * Application APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  DISK_SECTOR_SIZE    Bytes in a CP/M sector                      */
+#define DISK_SECTOR_SIZE        ( 0x0080 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  disk_t              One open disk image                         */
+struct  disk_t
+{
+    /**
+     *  @param  fd              File Descriptor, -1 when nothing is open    */
+    int                         fd;
+    /**
+     *  @param  map             The image mapped shared, NULL when it could
+     *                          not be mapped                               */
+    uint8_t                 *   map;
+    /**
+     *  @param  size            Bytes mapped                                */
+    size_t                      size;
+    /**
+     *  @param  dirty_lo        First byte written since the last flush     */
+    size_t                      dirty_lo;
+    /**
+     *  @param  dirty_hi        Byte after the last one written, 0 when
+     *                          nothing was written                         */
+    size_t                      dirty_hi;
+    /**
+     *  @param  origin          Offset of sector 0 in the file              */
+    size_t                      origin;
+    /**
+     *  @param  overlay         Copy-on-write overlay, NULL for a plain
+     *                          image                                       */
+    struct  disk_overlay_t  *   overlay;
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Prototypes
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+void
+disk_init(
+    struct  disk_t          *   disk
+    );
+//----------------------------------------------------------------------------
+int
+disk_open(
+    struct  disk_t          *   disk,
+    const
+    char                    *   file_name
+    );
+//----------------------------------------------------------------------------
+int
+disk_attach(
+    struct  disk_t          *   disk,
+    int                         fd
+    );
+//----------------------------------------------------------------------------
+bool
+disk_mounted(
+    const
+    struct  disk_t          *   disk
+    );
+//----------------------------------------------------------------------------
+uint8_t
+disk_read(
+    struct  disk_t          *   disk,
+    uint32_t                    lba,
+    uint16_t                    dma_addr
+    );
+//----------------------------------------------------------------------------
+uint8_t
+disk_write(
+    struct  disk_t          *   disk,
+    uint32_t                    lba,
+    uint16_t                    dma_addr
+    );
+//----------------------------------------------------------------------------
+uint8_t
+disk_read_data(
+    struct  disk_t          *   disk,
+    size_t                      offset,
+    uint8_t                 *   data_p,
+    size_t                      length
+    );
+//----------------------------------------------------------------------------
+uint8_t
+disk_write_data(
+    struct  disk_t          *   disk,
+    size_t                      offset,
+    const
+    uint8_t                 *   data_p,
+    size_t                      length
+    );
+//----------------------------------------------------------------------------
+void
+disk_dma_load(
+    uint16_t                    dma_addr,
+    const
+    uint8_t                 *   data_p
+    );
+//----------------------------------------------------------------------------
+void
+disk_dma_store(
+    uint8_t                 *   data_p,
+    uint16_t                    dma_addr
+    );
+//----------------------------------------------------------------------------
+void
+disk_flush(
+    struct  disk_t          *   disk
+    );
+//----------------------------------------------------------------------------
+void
+disk_close(
+    struct  disk_t          *   disk
+    );
+//----------------------------------------------------------------------------
+int
+disk_post(
+    void
+    );
+//----------------------------------------------------------------------------
+
+/****************************************************************************/
+
+#endif                      //    DISK_H
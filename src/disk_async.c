@@ -0,0 +1,861 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Write-behind I/O thread for the disk images.
+ *
+ *  The track cache hands its write-backs and flushes to a thread of the
+ *  guest through a ring of requests.  The guest is the only producer and
+ *  the thread the only consumer, so the ring needs no lock: the guest
+ *  owns head, the thread owns tail.  The mutex and the conditions are only
+ *  used to sleep when there is nothing to do.  The thread is started by
+ *  the first request.
+ *
+ *  The thread only uses pwrite( ) and the DISK_SYNC_xxx call on the file
+ *  descriptor, never the mapping, so the guest can keep reading the image
+ *  while writes are pending.  A read copies the requests that were not
+ *  done when it started over what it read, the guest sees its own writes.
+ *
+ *  disk_async_barrier( ) waits until every request has run.  The BIOS
+ *  calls it at WBOOT, EJECT and shutdown, and before an image is closed.
+ *
+ *  With DISK_URING the thread hands everything that is pending to the
+ *  kernel as one io_uring batch, writing straight from the ring slots,
+ *  which are its registered buffers.  A batch ends before a write that
+ *  overlaps an earlier one, the writes of a batch run in any order.  A
+ *  sync waits for the writes queued before it.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+#define _DEFAULT_SOURCE         //  pwrite( ), fdatasync( )
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <unistd.h>             //  UNIX standard library.
+#include <stdio.h>              //  Standard I/O definitions
+#include <string.h>             //  Functions for managing strings
+#include <errno.h>              //  EINTR
+#include <signal.h>             //  pthread_sigmask( )
+#include <sys/uio.h>            //  struct iovec
+                                //*******************************************
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "disk.h"               //  Disk images
+#include "disk_overlay.h"       //  Copy-on-write overlays
+#include "disk_async.h"         //  Write-behind I/O thread
+#include "disk_uring.h"         //  io_uring for the disk images
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  RING_MASK           Index of a request in the ring              */
+#define RING_MASK               ( DISK_ASYNC_RING - 1 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Run one request.
+ *
+ *  @param  async               The I/O thread.
+ *  @param  req                 The request.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Failures are counted for the next barrier.
+ *
+ ****************************************************************************/
+
+static
+void
+disk_async_run(
+    struct  disk_async_t    *   async,
+    const
+    struct  disk_async_req_t *  req
+    )
+{
+    /**
+     *  @param  done            Bytes written so far                        */
+    size_t                      done;
+    /**
+     *  @param  count           Bytes written by pwrite( )                  */
+    ssize_t                     count;
+    /**
+     *  @param  rc              System call return code                     */
+    int                         rc;
+
+    switch( req->op )
+    {
+        case ASYNC_OP_WRITE:
+            for( done = 0; done < req->length; done += (size_t)count )
+            {
+                count = pwrite( req->fd, &req->data[ done ], req->length - done,
+                                (off_t)( req->offset + done ) );
+                if ( count <= 0 )
+                {
+                    if ( ( count < 0 ) && ( errno == EINTR ) )
+                    {
+                        count = 0;
+                        continue;
+                    }
+                    atomic_fetch_add( &async->errors, 1 );
+                    break;
+                }
+            }
+            break;
+
+        case ASYNC_OP_SYNC:
+            rc = ( async->sync == DISK_SYNC_FULL ) ? fsync( req->fd )
+                                                   : fdatasync( req->fd );
+            if ( rc != 0 )
+            {
+                atomic_fetch_add( &async->errors, 1 );
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Run the pending requests as one io_uring batch.
+ *
+ *  @param  async               The I/O thread.
+ *  @param  tail                First pending request.
+ *  @param  head                Request after the last pending one.
+ *
+ *  @return                     Number of requests that were run.
+ *
+ *  @note
+ *      ASYNC_OP_STOP ends a batch, it is counted as run.  When the io_uring
+ *      fails it is destroyed and the batch is run again with pwrite( ),
+ *      which writes the same bytes from the same slots.
+ *
+ ****************************************************************************/
+
+static
+uint32_t
+disk_async_batch(
+    struct  disk_async_t    *   async,
+    uint32_t                    tail,
+    uint32_t                    head
+    )
+{
+    /**
+     *  @param  ndx             Request being queued                        */
+    uint32_t                    ndx;
+    /**
+     *  @param  prev            Request queued before it                    */
+    uint32_t                    prev;
+    /**
+     *  @param  req             The request                                 */
+    struct  disk_async_req_t *  req;
+    /**
+     *  @param  old             An earlier request                          */
+    struct  disk_async_req_t *  old;
+    /**
+     *  @param  queued          Was the request queued ?                    */
+    bool                        queued;
+    /**
+     *  @param  failed          Requests that failed                        */
+    int                         failed;
+
+    for( ndx = tail; ndx != head; ndx += 1 )
+    {
+        req = &async->ring[ ndx & RING_MASK ];
+
+        //  Is it the last one ?
+        if ( req->op == ASYNC_OP_STOP )
+        {
+            //  YES:    It ends the batch
+            ndx += 1;
+            break;
+        }
+
+        //  Does a write overlap an earlier write of the batch ?
+        for( prev = tail; prev != ndx; prev += 1 )
+        {
+            old = &async->ring[ prev & RING_MASK ];
+            if (    ( req->op == ASYNC_OP_WRITE ) && ( old->op == ASYNC_OP_WRITE )
+                 && ( req->fd == old->fd )
+                 && ( req->offset < ( old->offset + old->length ) )
+                 && ( old->offset < ( req->offset + req->length ) ) )
+            {
+                break;
+            }
+        }
+        if ( prev != ndx )
+        {
+            //  YES:    It goes in the next batch
+            break;
+        }
+
+        if ( req->op == ASYNC_OP_WRITE )
+        {
+            queued = disk_uring_write( async->uring, req->fd, req->data, req->length,
+                                       req->offset, (int)( ndx & RING_MASK ) );
+        }
+        else
+        {
+            queued = disk_uring_sync( async->uring, req->fd,
+                                      ( async->sync != DISK_SYNC_FULL ) );
+        }
+        if ( queued == false )
+        {
+            break;
+        }
+    }
+
+    //  Submit and wait for all of it
+    failed = disk_uring_wait( async->uring );
+    if ( failed < 0 )
+    {
+        //  The ring is broken, what is left of it must not be submitted
+        disk_uring_destroy( async->uring );
+        async->uring = NULL;
+
+        //  One request at a time from here on
+        for( prev = tail; prev != ndx; prev += 1 )
+        {
+            disk_async_run( async, &async->ring[ prev & RING_MASK ] );
+        }
+    }
+    else
+    if ( failed != 0 )
+    {
+        atomic_fetch_add( &async->errors, (uint32_t)failed );
+    }
+    atomic_fetch_add( &async->batches, 1 );
+
+    //  DONE!
+    return( ndx - tail );
+}
+
+/****************************************************************************/
+/**
+ *  The I/O thread.
+ *
+ *  @param  arg                 The disk_async_t it serves.
+ *
+ *  @return                     NULL
+ *
+ *  @note
+ *      Runs requests in order until ASYNC_OP_STOP.
+ *
+ ****************************************************************************/
+
+static
+void *
+disk_async_thread(
+    void                    *   arg
+    )
+{
+    /**
+     *  @param  async           The I/O thread                              */
+    struct  disk_async_t    *   async;
+    /**
+     *  @param  tail            Next request                                */
+    uint32_t                    tail;
+    /**
+     *  @param  count           Requests run                                */
+    uint32_t                    count;
+    /**
+     *  @param  stop            Was ASYNC_OP_STOP run ?                     */
+    bool                        stop;
+    /**
+     *  @param  req             The request                                 */
+    struct  disk_async_req_t *  req;
+#if DISK_URING
+    /**
+     *  @param  buffers         The ring slots, registered with io_uring    */
+    struct  iovec               buffers[ DISK_ASYNC_RING ];
+    /**
+     *  @param  ndx             Slot being registered                       */
+    int                         ndx;
+#endif
+
+    async = arg;
+    tail = atomic_load( &async->tail );
+    stop = false;
+
+#if DISK_URING
+    //  Is there an io_uring ?
+    for( ndx = 0; ndx < DISK_ASYNC_RING; ndx += 1 )
+    {
+        buffers[ ndx ].iov_base = async->ring[ ndx ].data;
+        buffers[ ndx ].iov_len  = DISK_ASYNC_DATA;
+    }
+    async->uring = disk_uring_create( DISK_ASYNC_RING, buffers, DISK_ASYNC_RING );
+#endif
+
+    //  Loop until told to stop
+    for( ; ; )
+    {
+        //  Is there a request ?
+        if ( atomic_load( &async->head ) == tail )
+        {
+            //  NO:     Sleep until there is one
+            pthread_mutex_lock( &async->lock );
+            atomic_store( &async->sleeping, true );
+            while ( atomic_load( &async->head ) == tail )
+            {
+                pthread_cond_wait( &async->work, &async->lock );
+            }
+            atomic_store( &async->sleeping, false );
+            pthread_mutex_unlock( &async->lock );
+        }
+
+        //  Is there an io_uring ?
+        if ( async->uring != NULL )
+        {
+            //  YES:    Everything pending in one batch
+            count = disk_async_batch( async, tail, atomic_load( &async->head ) );
+            stop  = ( async->ring[ ( tail + count - 1 ) & RING_MASK ].op == ASYNC_OP_STOP );
+        }
+        else
+        {
+            //  NO:     One at a time
+            req = &async->ring[ tail & RING_MASK ];
+            disk_async_run( async, req );
+            count = 1;
+            stop  = ( req->op == ASYNC_OP_STOP );
+        }
+
+        //  The slots can be used again
+        tail += count;
+        atomic_store( &async->tail, tail );
+
+        //  Is the guest waiting for it ?
+        if ( atomic_load( &async->waiting ) == true )
+        {
+            //  YES:    Wake it up
+            pthread_mutex_lock( &async->lock );
+            pthread_cond_broadcast( &async->done );
+            pthread_mutex_unlock( &async->lock );
+        }
+
+        if ( stop == true )
+        {
+            break;
+        }
+    }
+
+    disk_uring_destroy( async->uring );
+    async->uring = NULL;
+
+    //  DONE!
+    return( NULL );
+}
+
+/****************************************************************************/
+/**
+ *  Wait until no more than a number of requests are pending.
+ *
+ *  @param  async               The I/O thread.
+ *  @param  pending             Requests that may still be pending.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+disk_async_wait(
+    struct  disk_async_t    *   async,
+    uint32_t                    pending
+    )
+{
+    //  Has the thread done enough ?
+    if ( ( atomic_load( &async->head ) - atomic_load( &async->tail ) ) <= pending )
+    {
+        //  YES:    No need to wait
+        return;
+    }
+
+    pthread_mutex_lock( &async->lock );
+    atomic_store( &async->waiting, true );
+    while ( ( atomic_load( &async->head ) - atomic_load( &async->tail ) ) > pending )
+    {
+        pthread_cond_wait( &async->done, &async->lock );
+    }
+    atomic_store( &async->waiting, false );
+    pthread_mutex_unlock( &async->lock );
+}
+
+/****************************************************************************/
+/**
+ *  Get the next free request of the ring.
+ *
+ *  @param  async               The I/O thread.
+ *
+ *  @return                     The request, it is queued by disk_async_push( ).
+ *
+ *  @note
+ *      Waits when the ring is full.
+ *
+ ****************************************************************************/
+
+static
+struct  disk_async_req_t *
+disk_async_slot(
+    struct  disk_async_t    *   async
+    )
+{
+    //  Is the ring full ?
+    if ( ( atomic_load( &async->head ) - atomic_load( &async->tail ) ) >= DISK_ASYNC_RING )
+    {
+        //  YES:    Wait for a free slot
+        async->stalls += 1;
+        disk_async_wait( async, DISK_ASYNC_RING - 1 );
+    }
+
+    //  DONE!
+    return( &async->ring[ atomic_load( &async->head ) & RING_MASK ] );
+}
+
+/****************************************************************************/
+/**
+ *  Queue the request filled in by disk_async_slot( ).
+ *
+ *  @param  async               The I/O thread.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Starts the thread the first time.  When it can not be started the
+ *      request is run right away.  Signals are always taken by a guest
+ *      thread, never by this one.
+ *
+ ****************************************************************************/
+
+static
+void
+disk_async_push(
+    struct  disk_async_t    *   async
+    )
+{
+    /**
+     *  @param  all             Every signal                                */
+    sigset_t                    all;
+    /**
+     *  @param  old             Signals blocked by the guest thread         */
+    sigset_t                    old;
+    /**
+     *  @param  rc              pthread_create( ) return code               */
+    int                         rc;
+
+    //  Is the thread running ?
+    if ( async->running == false )
+    {
+        //  NO:     Start it with every signal blocked, the handlers need a
+        //          bound guest and this thread has none
+        sigfillset( &all );
+        pthread_sigmask( SIG_SETMASK, &all, &old );
+        rc = pthread_create( &async->thread, NULL, disk_async_thread, async );
+        pthread_sigmask( SIG_SETMASK, &old, NULL );
+        if ( rc != 0 )
+        {
+            //  Do it the old way
+            disk_async_run( async, &async->ring[ atomic_load( &async->head ) & RING_MASK ] );
+            return;
+        }
+        async->running = true;
+    }
+
+    async->queued += 1;
+    atomic_fetch_add( &async->head, 1 );
+
+    //  Is the thread asleep ?
+    if ( atomic_load( &async->sleeping ) == true )
+    {
+        //  YES:    Wake it up
+        pthread_mutex_lock( &async->lock );
+        pthread_cond_signal( &async->work );
+        pthread_mutex_unlock( &async->lock );
+    }
+}
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Allocate an I/O thread.
+ *
+ *  @param  sync                DISK_SYNC_xxx for flushes.
+ *
+ *  @return                     The I/O thread, NULL when out of memory.
+ *
+ *  @note
+ *      The thread itself is started by the first request.
+ *
+ ****************************************************************************/
+
+struct  disk_async_t *
+disk_async_create(
+    int                         sync
+    )
+{
+    /**
+     *  @param  async           The new I/O thread                          */
+    struct  disk_async_t    *   async;
+
+    async = calloc( 1, sizeof( struct disk_async_t ) );
+    if ( async != NULL )
+    {
+        atomic_init( &async->head, 0 );
+        atomic_init( &async->tail, 0 );
+        atomic_init( &async->sleeping, false );
+        atomic_init( &async->waiting, false );
+        atomic_init( &async->errors, 0 );
+        pthread_mutex_init( &async->lock, NULL );
+        pthread_cond_init( &async->work, NULL );
+        pthread_cond_init( &async->done, NULL );
+        async->sync = sync;
+    }
+
+    //  DONE!
+    return( async );
+}
+
+/****************************************************************************/
+/**
+ *  Run what is pending, stop the thread and free it.
+ *
+ *  @param  async               The I/O thread, may be NULL.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+disk_async_destroy(
+    struct  disk_async_t    *   async
+    )
+{
+    //  Was it created ?
+    if ( async == NULL )
+    {
+        //  NO:     Nothing to do
+        return;
+    }
+
+    //  Is the thread running ?
+    if ( async->running == true )
+    {
+        //  YES:    Stop it after the last request
+        disk_async_slot( async )->op = ASYNC_OP_STOP;
+        disk_async_push( async );
+        pthread_join( async->thread, NULL );
+    }
+
+    pthread_cond_destroy( &async->done );
+    pthread_cond_destroy( &async->work );
+    pthread_mutex_destroy( &async->lock );
+    free( async );
+}
+
+/****************************************************************************/
+/**
+ *  Read bytes of an image as the guest wrote them.
+ *
+ *  @param  async               The I/O thread.
+ *  @param  disk                The disk.
+ *  @param  offset              Offset in the image.
+ *  @param  data_p              Where the bytes go.
+ *  @param  length              Number of bytes.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 for an
+ *                              unrecoverable error.
+ *
+ *  @note
+ *      Every request not done before the read started is copied over what
+ *      was read, oldest first.  The guest is the only producer, so none
+ *      of them is replaced while this runs.
+ *
+ ****************************************************************************/
+
+uint8_t
+disk_async_read(
+    struct  disk_async_t    *   async,
+    struct  disk_t          *   disk,
+    size_t                      offset,
+    uint8_t                 *   data_p,
+    size_t                      length
+    )
+{
+    /**
+     *  @param  ndx             Request being looked at                     */
+    uint32_t                    ndx;
+    /**
+     *  @param  head            Requests queued                             */
+    uint32_t                    head;
+    /**
+     *  @param  req             The request                                 */
+    const
+    struct  disk_async_req_t *  req;
+    /**
+     *  @param  first           First byte both have                        */
+    size_t                      first;
+    /**
+     *  @param  last            Byte after the last one both have           */
+    size_t                      last;
+
+    ndx  = atomic_load( &async->tail );
+    head = atomic_load( &async->head );
+
+    if ( disk_read_data( disk, offset, data_p, length ) != 0x00 )
+    {
+        return( 0x01 );
+    }
+
+    //  The requests hold offsets in the file
+    offset += disk->origin;
+
+    for( ; ndx != head; ndx += 1 )
+    {
+        req = &async->ring[ ndx & RING_MASK ];
+
+        //  Does it write what was read ?
+        if (    ( req->op != ASYNC_OP_WRITE )
+             || ( req->fd != disk->fd )
+             || ( req->offset >= ( offset + length ) )
+             || ( ( req->offset + req->length ) <= offset ) )
+        {
+            //  NO:     Next
+            continue;
+        }
+
+        first = ( req->offset > offset ) ? req->offset : offset;
+        last  = ( ( req->offset + req->length ) < ( offset + length ) )
+              ? ( req->offset + req->length ) : ( offset + length );
+        memcpy( &data_p[ first - offset ], &req->data[ first - req->offset ], last - first );
+    }
+
+    //  DONE!
+    return( 0x00 );
+}
+
+/****************************************************************************/
+/**
+ *  Queue a write to an image.
+ *
+ *  @param  async               The I/O thread.
+ *  @param  disk                The disk.
+ *  @param  offset              Offset in the image.
+ *  @param  data_p              The bytes, they are copied.
+ *  @param  length              Number of bytes.
+ *
+ *  @return                     0, a failure is reported by the next barrier;
+ *                              1 when an overlay would have to grow.
+ *
+ *  @note
+ *      Only waits when the ring is full.  The sectors of an overlay are
+ *      claimed here, before the bytes reach the file.
+ *
+ ****************************************************************************/
+
+uint8_t
+disk_async_write(
+    struct  disk_async_t    *   async,
+    struct  disk_t          *   disk,
+    size_t                      offset,
+    const
+    uint8_t                 *   data_p,
+    size_t                      length
+    )
+{
+    /**
+     *  @param  req             The request                                 */
+    struct  disk_async_req_t *  req;
+    /**
+     *  @param  count           Bytes in this request                       */
+    size_t                      count;
+
+    //  Does an overlay have room for it ?
+    if (    ( disk->overlay != NULL )
+         && ( disk_overlay_claim( disk, offset, length ) != 0x00 ) )
+    {
+        //  NO:     It can't grow
+        return( 0x01 );
+    }
+
+    //  The requests hold offsets in the file
+    offset += disk->origin;
+
+    while ( length > 0 )
+    {
+        count = ( length > DISK_ASYNC_DATA ) ? DISK_ASYNC_DATA : length;
+
+        req = disk_async_slot( async );
+        req->op     = ASYNC_OP_WRITE;
+        req->fd     = disk->fd;
+        req->offset = offset;
+        req->length = count;
+        memcpy( req->data, data_p, count );
+        disk_async_push( async );
+
+        offset += count;
+        data_p += count;
+        length -= count;
+    }
+
+    //  DONE!
+    return( 0x00 );
+}
+
+/****************************************************************************/
+/**
+ *  Queue a flush of an image.
+ *
+ *  @param  async               The I/O thread.
+ *  @param  disk                The disk.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Nothing is queued for DISK_SYNC_NONE.
+ *
+ ****************************************************************************/
+
+void
+disk_async_sync(
+    struct  disk_async_t    *   async,
+    struct  disk_t          *   disk
+    )
+{
+    /**
+     *  @param  req             The request                                 */
+    struct  disk_async_req_t *  req;
+
+    //  Is there anything to do ?
+    if ( async->sync == DISK_SYNC_NONE )
+    {
+        //  NO:     The kernel writes it back
+        return;
+    }
+
+    req = disk_async_slot( async );
+    req->op     = ASYNC_OP_SYNC;
+    req->fd     = disk->fd;
+    req->length = 0;
+    disk_async_push( async );
+}
+
+/****************************************************************************/
+/**
+ *  Wait until every request has run.
+ *
+ *  @param  async               The I/O thread.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 when a
+ *                              request failed since the last barrier.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+uint8_t
+disk_async_barrier(
+    struct  disk_async_t    *   async
+    )
+{
+    async->barriers += 1;
+    disk_async_wait( async, 0 );
+
+    //  DONE!
+    return( ( atomic_exchange( &async->errors, 0 ) == 0 ) ? 0x00 : 0x01 );
+}
+
+/****************************************************************************/
+/**
+ *  Forget the thread in a child process.
+ *
+ *  @param  async               The I/O thread.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      fork( ) only copies the calling thread.  The parent must have
+ *      passed a barrier before it forked; the child starts its own thread
+ *      with its first request.
+ *
+ ****************************************************************************/
+
+void
+disk_async_forked(
+    struct  disk_async_t    *   async
+    )
+{
+    //  The io_uring of the parent's thread is not used here
+    disk_uring_destroy( async->uring );
+    async->uring = NULL;
+
+    async->running = false;
+    atomic_store( &async->head, 0 );
+    atomic_store( &async->tail, 0 );
+    atomic_store( &async->sleeping, false );
+    atomic_store( &async->waiting, false );
+    pthread_mutex_init( &async->lock, NULL );
+    pthread_cond_init( &async->work, NULL );
+    pthread_cond_init( &async->done, NULL );
+}
+
+/****************************************************************************/
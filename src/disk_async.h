@@ -0,0 +1,220 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+#ifndef DISK_ASYNC_H
+#define DISK_ASYNC_H
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Write-behind I/O thread for the disk images.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * System APIs
+ ****************************************************************************/
+
+                                //*******************************************
+#include <pthread.h>            //  Host threads
+#include <stdatomic.h>          //  Lock-free ring indexes
+                                //*******************************************
+
+/****************************************************************************
+ * Application APIs
+ ****************************************************************************/
+
+                                //*******************************************
+#include "disk.h"               //  Disk images
+                                //*******************************************
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  DISK_ASYNC_RING     Requests the ring holds, a power of two
+ *  @param  DISK_ASYNC_DATA     Most bytes one WRITE request carries        */
+#define DISK_ASYNC_RING         ( 32 )
+#define DISK_ASYNC_DATA         ( 64 * DISK_SECTOR_SIZE )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  disk_async_op_e     What a request asks for                     */
+enum    disk_async_op_e
+{
+    ASYNC_OP_WRITE              =   0,      //  pwrite( ) the data
+    ASYNC_OP_SYNC               =   1,      //  The DISK_SYNC_xxx policy
+    ASYNC_OP_STOP               =   2       //  End the thread
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  disk_uring_t        io_uring of the thread ( disk_uring.h )     */
+struct  disk_uring_t;
+//----------------------------------------------------------------------------
+/**
+ *  @param  disk_async_req_t    One request in the ring                     */
+struct  disk_async_req_t
+{
+    /**
+     *  @param  op              ASYNC_OP_xxx                                  */
+    enum    disk_async_op_e     op;
+    /**
+     *  @param  fd              The image                                   */
+    int                         fd;
+    /**
+     *  @param  offset          Offset in the image                         */
+    size_t                      offset;
+    /**
+     *  @param  length          Bytes in data                               */
+    size_t                      length;
+    /**
+     *  @param  data            What is written                             */
+    uint8_t                     data[ DISK_ASYNC_DATA ];
+};
+//----------------------------------------------------------------------------
+/**
+ *  @param  disk_async_t        The I/O thread of one guest                 */
+struct  disk_async_t
+{
+    /**
+     *  @param  ring            The requests                                */
+    struct  disk_async_req_t    ring[ DISK_ASYNC_RING ];
+    /**
+     *  @param  head            Next request the guest fills ( producer )   */
+    _Atomic uint32_t            head;
+    /**
+     *  @param  tail            Next request the thread runs ( consumer )   */
+    _Atomic uint32_t            tail;
+    /**
+     *  @param  sleeping        The thread waits for a request              */
+    _Atomic bool                sleeping;
+    /**
+     *  @param  waiting         The guest waits for the thread              */
+    _Atomic bool                waiting;
+    /**
+     *  @param  errors          Requests that failed since the last barrier */
+    _Atomic uint32_t            errors;
+    /**
+     *  @param  lock            Only used to sleep and wake up              */
+    pthread_mutex_t             lock;
+    /**
+     *  @param  work            Signalled when a request is queued          */
+    pthread_cond_t              work;
+    /**
+     *  @param  done            Signalled when a request has run            */
+    pthread_cond_t              done;
+    /**
+     *  @param  thread          The I/O thread                              */
+    pthread_t                   thread;
+    /**
+     *  @param  uring           Batches of the thread, NULL for pwrite( )   */
+    struct  disk_uring_t    *   uring;
+    /**
+     *  @param  running         The thread exists in this process           */
+    bool                        running;
+    /**
+     *  @param  sync            DISK_SYNC_xxx                               */
+    int                         sync;
+    /*      Statistics                                                      */
+    /**
+     *  @param  queued          Requests queued                             */
+    uint64_t                    queued;
+    /**
+     *  @param  stalls          Times the guest waited for a full ring      */
+    uint64_t                    stalls;
+    /**
+     *  @param  barriers        Times the guest waited for an empty ring    */
+    uint64_t                    barriers;
+    /**
+     *  @param  batches         io_uring submissions by the thread          */
+    _Atomic uint64_t            batches;
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Prototypes
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+struct  disk_async_t *
+disk_async_create(
+    int                         sync
+    );
+//----------------------------------------------------------------------------
+void
+disk_async_destroy(
+    struct  disk_async_t    *   async
+    );
+//----------------------------------------------------------------------------
+uint8_t
+disk_async_read(
+    struct  disk_async_t    *   async,
+    struct  disk_t          *   disk,
+    size_t                      offset,
+    uint8_t                 *   data_p,
+    size_t                      length
+    );
+//----------------------------------------------------------------------------
+uint8_t
+disk_async_write(
+    struct  disk_async_t    *   async,
+    struct  disk_t          *   disk,
+    size_t                      offset,
+    const
+    uint8_t                 *   data_p,
+    size_t                      length
+    );
+//----------------------------------------------------------------------------
+void
+disk_async_sync(
+    struct  disk_async_t    *   async,
+    struct  disk_t          *   disk
+    );
+//----------------------------------------------------------------------------
+uint8_t
+disk_async_barrier(
+    struct  disk_async_t    *   async
+    );
+//----------------------------------------------------------------------------
+void
+disk_async_forked(
+    struct  disk_async_t    *   async
+    );
+//----------------------------------------------------------------------------
+
+/****************************************************************************/
+
+#endif                      //    DISK_ASYNC_H
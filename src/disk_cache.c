@@ -0,0 +1,1052 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Track cache between the CP/M BIOS and the disk images.
+ *
+ *  The BDOS reads and rewrites the same directory sectors over and over
+ *  during searches and file closes.  The cache holds whole tracks, the
+ *  sectors per track come from the DPB of the drive, so those become
+ *  memory operations.  Tracks are found by ( disk, track ) and the one
+ *  used longest ago makes room for a new one.
+ *
+ *  A WRITE only changes the cached track.  The dirty sectors of a track
+ *  are written back together, as runs of adjacent sectors, when the track
+ *  is replaced or the cache is flushed.  When the flushes happen is the
+ *  DISK_FLUSH_xxx policy: at WBOOT, when the guest waits for a key, after
+ *  DISK_CACHE_TIMER_MS, or only at EJECT and shutdown.
+ *
+ *  The CP/M deblocking code of a WRITE is used on a miss: a write to an
+ *  unallocated block ( code 2 ) does not read the rest of the track first.
+ *
+ *  With DISK_ASYNC the write-backs and flushes are queued for the I/O
+ *  thread of disk_async.c and only disk_cache_barrier( ) waits for them.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+#define _DEFAULT_SOURCE         //  clock_gettime( ), strcasecmp( )
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <stdio.h>              //  Standard I/O definitions
+#include <string.h>             //  Functions for managing strings
+#include <strings.h>            //  strcasecmp( )
+#include <inttypes.h>           //  PRIu64
+#include <time.h>               //  clock_gettime( )
+                                //*******************************************
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "disk.h"               //  Disk images
+#include "disk_async.h"         //  Write-behind I/O thread
+#include "disk_cache.h"         //  Track cache
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  DEBLOCK_UNALLOC     WRITE code: first sector of a new block     */
+#define DEBLOCK_UNALLOC         ( 2 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  policy_names        Names of the DISK_FLUSH_xxx policies        */
+static
+const
+char                        *   policy_names[ ] =
+{
+    "WBOOT", "IDLE", "TIMER", "SHUTDOWN"
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Host time.
+ *
+ *  @param
+ *
+ *  @return                     Nanoseconds of the monotonic clock, never 0.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+uint64_t
+disk_cache_now(
+    void
+    )
+{
+    /**
+     *  @param  now             The clock                                   */
+    struct  timespec            now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    //  DONE!
+    return( ( (uint64_t)now.tv_sec * 1000000000ull ) + (uint64_t)now.tv_nsec + 1 );
+}
+
+/****************************************************************************/
+/**
+ *  Offset of a sector of a cached track in the image.
+ *
+ *  @param  slot                The track.
+ *  @param  sector              Sector in the track.
+ *
+ *  @return                     Offset in bytes.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+size_t
+disk_cache_offset(
+    const
+    struct  disk_track_t    *   slot,
+    int                         sector
+    )
+{
+    //  DONE!
+    return( ( ( (size_t)slot->track * slot->sec_track ) + (size_t)sector )
+            * DISK_SECTOR_SIZE );
+}
+
+/****************************************************************************/
+/**
+ *  Length of a run of set bits.
+ *
+ *  @param  mask                One bit per sector.
+ *  @param  first               First sector of the run, its bit is set.
+ *  @param  sec_track           Sectors in the track.
+ *
+ *  @return                     Sectors in the run.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+int
+disk_cache_run(
+    uint64_t                    mask,
+    int                         first,
+    int                         sec_track
+    )
+{
+    /**
+     *  @param  last            Sector after the run                        */
+    int                         last;
+
+    for( last = first; last < sec_track; last += 1 )
+    {
+        if ( ( mask & ( 1ull << last ) ) == 0 )
+        {
+            break;
+        }
+    }
+
+    //  DONE!
+    return( last - first );
+}
+
+/****************************************************************************/
+/**
+ *  Read bytes of an image, directly or past the I/O thread.
+ *
+ *  @param  cache               The cache.
+ *  @param  disk                The disk.
+ *  @param  offset              Offset in the image.
+ *  @param  data_p              Where the bytes go.
+ *  @param  length              Number of bytes.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 for an
+ *                              unrecoverable error.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+uint8_t
+disk_cache_get(
+    struct  disk_cache_t    *   cache,
+    struct  disk_t          *   disk,
+    size_t                      offset,
+    uint8_t                 *   data_p,
+    size_t                      length
+    )
+{
+    //  Are writes pending in the I/O thread ?
+    if ( cache->async != NULL )
+    {
+        //  YES:    Read them too
+        return( disk_async_read( cache->async, disk, offset, data_p, length ) );
+    }
+
+    //  DONE!
+    return( disk_read_data( disk, offset, data_p, length ) );
+}
+
+/****************************************************************************/
+/**
+ *  Write bytes of an image, directly or through the I/O thread.
+ *
+ *  @param  cache               The cache.
+ *  @param  disk                The disk.
+ *  @param  offset              Offset in the image.
+ *  @param  data_p              The bytes.
+ *  @param  length              Number of bytes.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 for an
+ *                              unrecoverable error.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+uint8_t
+disk_cache_put(
+    struct  disk_cache_t    *   cache,
+    struct  disk_t          *   disk,
+    size_t                      offset,
+    const
+    uint8_t                 *   data_p,
+    size_t                      length
+    )
+{
+    //  Is there an I/O thread ?
+    if ( cache->async != NULL )
+    {
+        //  YES:    It does the writing
+        return( disk_async_write( cache->async, disk, offset, data_p, length ) );
+    }
+
+    //  DONE!
+    return( disk_write_data( disk, offset, data_p, length ) );
+}
+
+/****************************************************************************/
+/**
+ *  Write the dirty sectors of a track back to its image.
+ *
+ *  @param  cache               The cache.
+ *  @param  slot                The track.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 for an
+ *                              unrecoverable error.
+ *
+ *  @note
+ *      Adjacent dirty sectors are written with one call.  The image is not
+ *      flushed.  The sectors that could not be written stay dirty.
+ *
+ ****************************************************************************/
+
+static
+uint8_t
+disk_cache_write_back(
+    struct  disk_cache_t    *   cache,
+    struct  disk_track_t    *   slot
+    )
+{
+    /**
+     *  @param  sector          First sector of a run                       */
+    int                         sector;
+    /**
+     *  @param  count           Sectors in the run                          */
+    int                         count;
+    /**
+     *  @param  rc              Return code                                 */
+    uint8_t                     rc;
+
+    //  Is there anything to write ?
+    if ( slot->dirty == 0 )
+    {
+        //  NO:     Nothing to do
+        return( 0x00 );
+    }
+
+    rc = 0x00;
+    for( sector = 0; sector < slot->sec_track; sector += 1 )
+    {
+        if ( ( slot->dirty & ( 1ull << sector ) ) == 0 )
+        {
+            continue;
+        }
+        count = disk_cache_run( slot->dirty, sector, slot->sec_track );
+        if ( disk_cache_put( cache, slot->disk, disk_cache_offset( slot, sector ),
+                             &slot->data[ sector * DISK_SECTOR_SIZE ],
+                             (size_t)count * DISK_SECTOR_SIZE ) == 0x00 )
+        {
+            //  Written, the run is clean
+            slot->dirty &= ~( ( ~0ull >> ( 64 - count ) ) << sector );
+        }
+        else
+        {
+            //  The run stays dirty for the next try
+            rc = 0x01;
+        }
+        sector += count;
+    }
+
+    //  Was everything written ?
+    if ( rc == 0x00 )
+    {
+        //  YES:    Count it
+        cache->write_backs += 1;
+    }
+
+    //  DONE!
+    return( rc );
+}
+
+/****************************************************************************/
+/**
+ *  Read the sectors of a track that are not in the cache.
+ *
+ *  @param  cache               The cache.
+ *  @param  slot                The track.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 for an
+ *                              unrecoverable error.
+ *
+ *  @note
+ *      Sectors already cached, written ones included, are kept.
+ *
+ ****************************************************************************/
+
+static
+uint8_t
+disk_cache_fill(
+    struct  disk_cache_t    *   cache,
+    struct  disk_track_t    *   slot
+    )
+{
+    /**
+     *  @param  missing         One bit per sector to read                  */
+    uint64_t                    missing;
+    /**
+     *  @param  sector          First sector of a run                       */
+    int                         sector;
+    /**
+     *  @param  count           Sectors in the run                          */
+    int                         count;
+
+    missing = ~slot->valid;
+    for( sector = 0; sector < slot->sec_track; sector += 1 )
+    {
+        if ( ( missing & ( 1ull << sector ) ) == 0 )
+        {
+            continue;
+        }
+        count = disk_cache_run( missing, sector, slot->sec_track );
+        if ( disk_cache_get( cache, slot->disk, disk_cache_offset( slot, sector ),
+                             &slot->data[ sector * DISK_SECTOR_SIZE ],
+                             (size_t)count * DISK_SECTOR_SIZE ) != 0x00 )
+        {
+            return( 0x01 );
+        }
+        sector += count;
+    }
+
+    //  Every sector is there now
+    slot->valid = ( slot->sec_track == 64 )
+                ? ~0ull : ( ( 1ull << slot->sec_track ) - 1 );
+
+    //  DONE!
+    return( 0x00 );
+}
+
+/****************************************************************************/
+/**
+ *  Find a track, or make room for it.
+ *
+ *  @param  cache               The cache.
+ *  @param  disk                The disk.
+ *  @param  track               Track number.
+ *  @param  sec_track           Sectors in the track.
+ *  @param  slot_p              Where the track is returned.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 when no
+ *                              track could be made available.
+ *
+ *  @note
+ *      A new track has no valid sectors.  A track is only replaced after
+ *      its dirty sectors were written, when that fails the clean track used
+ *      longest ago is replaced instead.
+ *
+ ****************************************************************************/
+
+static
+uint8_t
+disk_cache_slot(
+    struct  disk_cache_t    *   cache,
+    struct  disk_t          *   disk,
+    uint32_t                    track,
+    uint16_t                    sec_track,
+    struct  disk_track_t    **  slot_p
+    )
+{
+    /**
+     *  @param  slot            Track being looked at                       */
+    struct  disk_track_t    *   slot;
+    /**
+     *  @param  oldest          The free track or the one used longest ago  */
+    struct  disk_track_t    *   oldest;
+
+    cache->clock += 1;
+    oldest = &cache->track[ 0 ];
+
+    for( slot = &cache->track[ 0 ];
+         slot < &cache->track[ DISK_CACHE_TRACKS ];
+         slot += 1 )
+    {
+        //  Is this the track ?
+        if ( ( slot->disk == disk ) && ( slot->track == track ) )
+        {
+            //  YES:    Did the DPB change under it ?
+            if ( slot->sec_track != sec_track )
+            {
+                //  YES:    Start over once the sectors are written
+                if ( disk_cache_write_back( cache, slot ) != 0x00 )
+                {
+                    return( 0x01 );
+                }
+                slot->sec_track = sec_track;
+                slot->valid = 0;
+            }
+            slot->last_use = cache->clock;
+            *slot_p = slot;
+            return( 0x00 );
+        }
+
+        //  Is it a better one to replace ?
+        if (    ( oldest->disk != NULL )
+             && ( ( slot->disk == NULL ) || ( slot->last_use < oldest->last_use ) ) )
+        {
+            oldest = slot;
+        }
+    }
+
+    //  Make room
+    if ( oldest->disk != NULL )
+    {
+        //  Could its dirty sectors be written ?
+        if ( disk_cache_write_back( cache, oldest ) != 0x00 )
+        {
+            //  NO:     Keep them and replace the clean track used longest ago
+            oldest = NULL;
+            for( slot = &cache->track[ 0 ];
+                 slot < &cache->track[ DISK_CACHE_TRACKS ];
+                 slot += 1 )
+            {
+                if (    ( slot->dirty == 0 )
+                     && ( ( oldest == NULL ) || ( slot->last_use < oldest->last_use ) ) )
+                {
+                    oldest = slot;
+                }
+            }
+
+            //  Is every track dirty ?
+            if ( oldest == NULL )
+            {
+                //  YES:    Nothing can be replaced
+                return( 0x01 );
+            }
+        }
+        cache->evictions += 1;
+    }
+
+    oldest->disk      = disk;
+    oldest->track     = track;
+    oldest->sec_track = sec_track;
+    oldest->valid     = 0;
+    oldest->dirty     = 0;
+    oldest->last_use  = cache->clock;
+
+    *slot_p = oldest;
+
+    //  DONE!
+    return( 0x00 );
+}
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Allocate an empty cache.
+ *
+ *  @param
+ *
+ *  @return                     The cache, NULL when out of memory.
+ *
+ *  @note
+ *      The policy starts as DISK_CACHE_FLUSH.
+ *
+ ****************************************************************************/
+
+struct  disk_cache_t *
+disk_cache_create(
+    void
+    )
+{
+    /**
+     *  @param  cache           The new cache                               */
+    struct  disk_cache_t    *   cache;
+
+    cache = calloc( 1, sizeof( struct disk_cache_t ) );
+    if ( cache != NULL )
+    {
+        cache->policy = DISK_CACHE_FLUSH;
+
+#if DISK_ASYNC
+        //  The I/O thread
+        cache->async = disk_async_create( DISK_ASYNC_SYNC );
+        if ( cache->async == NULL )
+        {
+            free( cache );
+            return( NULL );
+        }
+#endif
+    }
+
+    //  DONE!
+    return( cache );
+}
+
+/****************************************************************************/
+/**
+ *  Free a cache.
+ *
+ *  @param  cache               The cache, may be NULL.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Dirty tracks are lost, flush the disks first.  The I/O thread runs
+ *      what is queued before it stops.
+ *
+ ****************************************************************************/
+
+void
+disk_cache_destroy(
+    struct  disk_cache_t    *   cache
+    )
+{
+    //  Was it created ?
+    if ( cache == NULL )
+    {
+        //  NO:     Nothing to do
+        return;
+    }
+
+    disk_async_destroy( cache->async );
+    free( cache );
+}
+
+/****************************************************************************/
+/**
+ *  Read a sector into CPU memory.
+ *
+ *  @param  cache               The cache.
+ *  @param  disk                The disk.
+ *  @param  lba                 Logical Block Address of the sector.
+ *  @param  sec_track           Sectors per track of the drive.
+ *  @param  dma_addr            Where the sector goes.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 for an
+ *                              unrecoverable error.
+ *
+ *  @note
+ *      A miss reads the whole track.
+ *
+ ****************************************************************************/
+
+uint8_t
+disk_cache_read(
+    struct  disk_cache_t    *   cache,
+    struct  disk_t          *   disk,
+    uint32_t                    lba,
+    uint16_t                    sec_track,
+    uint16_t                    dma_addr
+    )
+{
+    /**
+     *  @param  slot            The track                                   */
+    struct  disk_track_t    *   slot;
+    /**
+     *  @param  sector          Sector in the track                         */
+    int                         sector;
+    /**
+     *  @param  data            A sector that is not cached                 */
+    uint8_t                     data[ DISK_SECTOR_SIZE ];
+
+    //  Can the track be cached ?
+    if ( ( sec_track == 0 ) || ( sec_track > DISK_CACHE_SECTORS ) )
+    {
+        //  NO:     Straight from the image
+        cache->bypass += 1;
+        if ( cache->async == NULL )
+        {
+            return( disk_read( disk, lba, dma_addr ) );
+        }
+        if ( disk_async_read( cache->async, disk, (size_t)lba * DISK_SECTOR_SIZE,
+                              data, DISK_SECTOR_SIZE ) != 0x00 )
+        {
+            return( 0x01 );
+        }
+        disk_dma_load( dma_addr, data );
+        return( 0x00 );
+    }
+
+    sector = (int)( lba % sec_track );
+    if ( disk_cache_slot( cache, disk, lba / sec_track, sec_track, &slot ) != 0x00 )
+    {
+        return( 0x01 );
+    }
+
+    //  Is the sector there ?
+    if ( ( slot->valid & ( 1ull << sector ) ) != 0 )
+    {
+        //  YES:    A hit
+        cache->hits += 1;
+    }
+    else
+    {
+        //  NO:     Read the track
+        cache->misses += 1;
+        if ( disk_cache_fill( cache, slot ) != 0x00 )
+        {
+            return( 0x01 );
+        }
+    }
+
+    disk_dma_load( dma_addr, &slot->data[ sector * DISK_SECTOR_SIZE ] );
+
+    //  DONE!
+    return( 0x00 );
+}
+
+/****************************************************************************/
+/**
+ *  Write a sector from CPU memory.
+ *
+ *  @param  cache               The cache.
+ *  @param  disk                The disk.
+ *  @param  lba                 Logical Block Address of the sector.
+ *  @param  sec_track           Sectors per track of the drive.
+ *  @param  dma_addr            Where the sector is.
+ *  @param  deblock             The CP/M deblocking code in C: 0 normal,
+ *                              1 directory, 2 first sector of a new block.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 for an
+ *                              unrecoverable error.
+ *
+ *  @note
+ *      The sector reaches the image when its track is written back.
+ *
+ ****************************************************************************/
+
+uint8_t
+disk_cache_write(
+    struct  disk_cache_t    *   cache,
+    struct  disk_t          *   disk,
+    uint32_t                    lba,
+    uint16_t                    sec_track,
+    uint16_t                    dma_addr,
+    uint8_t                     deblock
+    )
+{
+    /**
+     *  @param  slot            The track                                   */
+    struct  disk_track_t    *   slot;
+    /**
+     *  @param  sector          Sector in the track                         */
+    int                         sector;
+    /**
+     *  @param  data            A sector that is not cached                 */
+    uint8_t                     data[ DISK_SECTOR_SIZE ];
+
+    //  Can the track be cached ?
+    if ( ( sec_track == 0 ) || ( sec_track > DISK_CACHE_SECTORS ) )
+    {
+        //  NO:     Straight to the image
+        cache->bypass += 1;
+        if ( cache->async == NULL )
+        {
+            return( disk_write( disk, lba, dma_addr ) );
+        }
+        disk_dma_store( data, dma_addr );
+        return( disk_async_write( cache->async, disk, (size_t)lba * DISK_SECTOR_SIZE,
+                                  data, DISK_SECTOR_SIZE ) );
+    }
+
+    sector = (int)( lba % sec_track );
+    if ( disk_cache_slot( cache, disk, lba / sec_track, sec_track, &slot ) != 0x00 )
+    {
+        return( 0x01 );
+    }
+
+    //  Is the track there ?
+    if ( slot->valid != 0 )
+    {
+        //  YES:    A hit
+        cache->hits += 1;
+    }
+    else
+    {
+        //  NO:     The rest of a new block is not worth reading
+        cache->misses += 1;
+        if (    ( deblock != DEBLOCK_UNALLOC )
+             && ( disk_cache_fill( cache, slot ) != 0x00 ) )
+        {
+            return( 0x01 );
+        }
+    }
+
+    disk_dma_store( &slot->data[ sector * DISK_SECTOR_SIZE ], dma_addr );
+    slot->valid |= 1ull << sector;
+    slot->dirty |= 1ull << sector;
+
+    //  Start the clock for DISK_FLUSH_TIMER
+    if ( cache->dirty_ns == 0 )
+    {
+        cache->dirty_ns = disk_cache_now( );
+    }
+
+    //  DONE!
+    return( 0x00 );
+}
+
+/****************************************************************************/
+/**
+ *  Write back the dirty tracks of a disk and flush its image.
+ *
+ *  @param  cache               The cache.
+ *  @param  disk                The disk.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 for an
+ *                              unrecoverable error.
+ *
+ *  @note
+ *      The tracks stay in the cache.  With an I/O thread the write-backs
+ *      and the flush are only queued.
+ *
+ ****************************************************************************/
+
+uint8_t
+disk_cache_flush(
+    struct  disk_cache_t    *   cache,
+    struct  disk_t          *   disk
+    )
+{
+    /**
+     *  @param  slot            Track being looked at                       */
+    struct  disk_track_t    *   slot;
+    /**
+     *  @param  dirty           Is a track still dirty ?                    */
+    bool                        dirty;
+    /**
+     *  @param  rc              Return code                                 */
+    uint8_t                     rc;
+
+    dirty = false;
+    rc = 0x00;
+
+    for( slot = &cache->track[ 0 ];
+         slot < &cache->track[ DISK_CACHE_TRACKS ];
+         slot += 1 )
+    {
+        if ( slot->disk == disk )
+        {
+            rc |= disk_cache_write_back( cache, slot );
+        }
+
+        //  Is it still dirty ?
+        if ( slot->dirty != 0 )
+        {
+            dirty = true;
+        }
+    }
+
+    //  Nothing left dirty stops the clock
+    if ( dirty == false )
+    {
+        cache->dirty_ns = 0;
+    }
+
+    //  Is there an I/O thread ?
+    if ( cache->async != NULL )
+    {
+        //  YES:    It flushes after the write-backs
+        disk_async_sync( cache->async, disk );
+    }
+    else
+    {
+        disk_flush( disk );
+    }
+    cache->flushes += 1;
+
+    //  DONE!
+    return( rc );
+}
+
+/****************************************************************************/
+/**
+ *  Wait until the I/O thread has written everything back.
+ *
+ *  @param  cache               The cache.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 when a
+ *                              write-back failed since the last barrier.
+ *
+ *  @note
+ *      Returns at once without an I/O thread.
+ *
+ ****************************************************************************/
+
+uint8_t
+disk_cache_barrier(
+    struct  disk_cache_t    *   cache
+    )
+{
+    //  Is there an I/O thread ?
+    if ( cache->async == NULL )
+    {
+        //  NO:     Everything is written already
+        return( 0x00 );
+    }
+
+    //  DONE!
+    return( disk_async_barrier( cache->async ) );
+}
+
+/****************************************************************************/
+/**
+ *  Forget the tracks of a disk.
+ *
+ *  @param  cache               The cache.
+ *  @param  disk                The disk.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Dirty tracks are lost, flush the disk first.  Called before a
+ *      different image is used for the disk.
+ *
+ ****************************************************************************/
+
+void
+disk_cache_drop(
+    struct  disk_cache_t    *   cache,
+    struct  disk_t          *   disk
+    )
+{
+    /**
+     *  @param  slot            Track being looked at                       */
+    struct  disk_track_t    *   slot;
+
+    for( slot = &cache->track[ 0 ];
+         slot < &cache->track[ DISK_CACHE_TRACKS ];
+         slot += 1 )
+    {
+        if ( slot->disk == disk )
+        {
+            slot->disk  = NULL;
+            slot->valid = 0;
+            slot->dirty = 0;
+        }
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Is it time to flush ?
+ *
+ *  @param  cache               The cache.
+ *  @param  idle                TRUE when the guest is waiting for a key.
+ *
+ *  @return                     TRUE when the policy wants a flush now.
+ *
+ *  @note
+ *      DISK_FLUSH_WBOOT and DISK_FLUSH_SHUTDOWN never want one here, the
+ *      BIOS flushes for them.
+ *
+ ****************************************************************************/
+
+bool
+disk_cache_due(
+    struct  disk_cache_t    *   cache,
+    bool                        idle
+    )
+{
+    //  Is anything dirty ?
+    if ( cache->dirty_ns == 0 )
+    {
+        //  NO:     Nothing to flush
+        return( false );
+    }
+
+    switch( cache->policy )
+    {
+        case DISK_FLUSH_IDLE:
+            return( idle );
+
+        case DISK_FLUSH_TIMER:
+            return( ( disk_cache_now( ) - cache->dirty_ns )
+                    >= ( DISK_CACHE_TIMER_MS * 1000000ull ) );
+
+        default:
+            return( false );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Look up a flush policy by name.
+ *
+ *  @param  name                WBOOT, IDLE, TIMER or SHUTDOWN, in any case.
+ *
+ *  @return                     The DISK_FLUSH_xxx value, -1 when unknown.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+int
+disk_cache_policy(
+    const
+    char                    *   name
+    )
+{
+    /**
+     *  @param  policy          Policy being looked at                      */
+    int                         policy;
+
+    for( policy = 0;
+         policy < (int)( sizeof( policy_names ) / sizeof( policy_names[ 0 ] ) );
+         policy += 1 )
+    {
+        if ( strcasecmp( name, policy_names[ policy ] ) == 0 )
+        {
+            return( policy );
+        }
+    }
+
+    //  DONE!
+    return( -1 );
+}
+
+/****************************************************************************/
+/**
+ *  Display the policy and the statistics.
+ *
+ *  @param  cache               The cache.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called from the CP, the terminal is in curses mode.
+ *
+ ****************************************************************************/
+
+void
+disk_cache_report(
+    const
+    struct  disk_cache_t    *   cache
+    )
+{
+    /**
+     *  @param  slot            Track being looked at                       */
+    const
+    struct  disk_track_t    *   slot;
+    /**
+     *  @param  used            Tracks in use                               */
+    int                         used;
+    /**
+     *  @param  dirty           Tracks not written back                     */
+    int                         dirty;
+
+    used  = 0;
+    dirty = 0;
+    for( slot = &cache->track[ 0 ];
+         slot < &cache->track[ DISK_CACHE_TRACKS ];
+         slot += 1 )
+    {
+        if ( slot->disk != NULL )   used  += 1;
+        if ( slot->dirty != 0 )     dirty += 1;
+    }
+
+    printf( "\r\nFlush policy:     %s\r\n", policy_names[ cache->policy ] );
+    printf( "Tracks:           %d of %d, %d dirty\r\n",
+            used, DISK_CACHE_TRACKS, dirty );
+    printf( "Hits:             %" PRIu64 "\r\n", cache->hits );
+    printf( "Misses:           %" PRIu64 "\r\n", cache->misses );
+    printf( "Not cached:       %" PRIu64 "\r\n", cache->bypass );
+    printf( "Evictions:        %" PRIu64 "\r\n", cache->evictions );
+    printf( "Write-backs:      %" PRIu64 "\r\n", cache->write_backs );
+    printf( "Flushes:          %" PRIu64 "\r\n", cache->flushes );
+
+    //  Is there an I/O thread ?
+    if ( cache->async != NULL )
+    {
+        //  YES:    Its counters too
+        printf( "I/O requests:     %" PRIu64 "\r\n", cache->async->queued );
+        printf( "Ring full waits:  %" PRIu64 "\r\n", cache->async->stalls );
+        printf( "Barriers:         %" PRIu64 "\r\n", cache->async->barriers );
+        printf( "io_uring batches: %" PRIu64 "\r\n",
+                (uint64_t)atomic_load( &cache->async->batches ) );
+    }
+}
+
+/****************************************************************************/
@@ -0,0 +1,219 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+#ifndef DISK_CACHE_H
+#define DISK_CACHE_H
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Track cache between the CP/M BIOS and the disk images.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * System APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Application APIs
+ ****************************************************************************/
+
+                                //*******************************************
+#include "disk.h"               //  Disk images
+#include "disk_async.h"         //  Write-behind I/O thread
+                                //*******************************************
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  DISK_CACHE_TRACKS   Tracks held by the cache of one guest
+ *  @param  DISK_CACHE_SECTORS  Most sectors a cached track can have, longer
+ *                              tracks are not cached
+ *  @param  DISK_CACHE_TIMER_MS Age of the oldest write-back for
+ *                              DISK_FLUSH_TIMER                            */
+#define DISK_CACHE_TRACKS       ( 16 )
+#define DISK_CACHE_SECTORS      ( 64 )
+#define DISK_CACHE_TIMER_MS     ( 1000 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  disk_track_t        One cached track                            */
+struct  disk_track_t
+{
+    /**
+     *  @param  disk            Disk the track belongs to, NULL when free   */
+    struct  disk_t          *   disk;
+    /**
+     *  @param  track           Track number                                */
+    uint32_t                    track;
+    /**
+     *  @param  sec_track       Sectors in the track                        */
+    uint16_t                    sec_track;
+    /**
+     *  @param  valid           One bit per sector that holds data          */
+    uint64_t                    valid;
+    /**
+     *  @param  dirty           One bit per sector not written back yet     */
+    uint64_t                    dirty;
+    /**
+     *  @param  last_use        Cache clock of the last access              */
+    uint64_t                    last_use;
+    /**
+     *  @param  data            The sectors                                 */
+    uint8_t                     data[ DISK_CACHE_SECTORS * DISK_SECTOR_SIZE ];
+};
+//----------------------------------------------------------------------------
+/**
+ *  @param  disk_cache_t        The track cache of one guest                */
+struct  disk_cache_t
+{
+    /**
+     *  @param  track           The cached tracks                           */
+    struct  disk_track_t        track[ DISK_CACHE_TRACKS ];
+    /**
+     *  @param  clock           Counts accesses, orders the tracks by use   */
+    uint64_t                    clock;
+    /**
+     *  @param  async           Writes the tracks back, NULL to do it here  */
+    struct  disk_async_t    *   async;
+    /**
+     *  @param  policy          DISK_FLUSH_xxx                              */
+    int                         policy;
+    /**
+     *  @param  dirty_ns        Host time of the first write since the last
+     *                          flush, 0 when nothing is dirty              */
+    uint64_t                    dirty_ns;
+    /*      Statistics                                                      */
+    /**
+     *  @param  hits            Sectors found in the cache                  */
+    uint64_t                    hits;
+    /**
+     *  @param  misses          Sectors that had to be read first           */
+    uint64_t                    misses;
+    /**
+     *  @param  bypass          Sectors of tracks too long to cache         */
+    uint64_t                    bypass;
+    /**
+     *  @param  evictions       Tracks replaced to make room                */
+    uint64_t                    evictions;
+    /**
+     *  @param  write_backs     Dirty tracks written back                   */
+    uint64_t                    write_backs;
+    /**
+     *  @param  flushes         Flushes of the whole cache                  */
+    uint64_t                    flushes;
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Prototypes
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+struct  disk_cache_t *
+disk_cache_create(
+    void
+    );
+//----------------------------------------------------------------------------
+void
+disk_cache_destroy(
+    struct  disk_cache_t    *   cache
+    );
+//----------------------------------------------------------------------------
+uint8_t
+disk_cache_read(
+    struct  disk_cache_t    *   cache,
+    struct  disk_t          *   disk,
+    uint32_t                    lba,
+    uint16_t                    sec_track,
+    uint16_t                    dma_addr
+    );
+//----------------------------------------------------------------------------
+uint8_t
+disk_cache_write(
+    struct  disk_cache_t    *   cache,
+    struct  disk_t          *   disk,
+    uint32_t                    lba,
+    uint16_t                    sec_track,
+    uint16_t                    dma_addr,
+    uint8_t                     deblock
+    );
+//----------------------------------------------------------------------------
+uint8_t
+disk_cache_flush(
+    struct  disk_cache_t    *   cache,
+    struct  disk_t          *   disk
+    );
+//----------------------------------------------------------------------------
+uint8_t
+disk_cache_barrier(
+    struct  disk_cache_t    *   cache
+    );
+//----------------------------------------------------------------------------
+void
+disk_cache_drop(
+    struct  disk_cache_t    *   cache,
+    struct  disk_t          *   disk
+    );
+//----------------------------------------------------------------------------
+bool
+disk_cache_due(
+    struct  disk_cache_t    *   cache,
+    bool                        idle
+    );
+//----------------------------------------------------------------------------
+int
+disk_cache_policy(
+    const
+    char                    *   name
+    );
+//----------------------------------------------------------------------------
+void
+disk_cache_report(
+    const
+    struct  disk_cache_t    *   cache
+    );
+//----------------------------------------------------------------------------
+
+/****************************************************************************/
+
+#endif                      //    DISK_CACHE_H
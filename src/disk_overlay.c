@@ -0,0 +1,943 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Copy-on-write overlay disk images.
+ *
+ *  An overlay file stands in for a disk image.  The base image it names
+ *  is only ever opened read only, so any number of guests can share one
+ *  base, each with its own overlay.  The file starts with a header and a
+ *  bitmap of one bit per sector, followed at a 64 KB boundary ( origin )
+ *  by room for every sector of the base.  The file is sparse: only the
+ *  sectors a guest wrote take space.
+ *
+ *      +--------+--------+-----------//-------------------------------+
+ *      | header | bitmap |  sector 0, 1, 2 ...  ( at origin )         |
+ *      +--------+--------+-----------//-------------------------------+
+ *
+ *  A sector whose bit is set is read from the overlay, any other from
+ *  the base.  The first write to a sector sets its bit in a private copy
+ *  of the bitmap, which only reaches the file once the sector is on disk:
+ *  after a crash no bit covers a sector that was never written.  Because
+ *  a sector sits at origin + its offset, disk.c, the track cache and the
+ *  I/O thread only have to add origin; the overlay is found by its magic
+ *  when the file is opened, so MOUNT and snapshots need nothing else.
+ *  Each job of the zygote gets a private overlay in a memory file.
+ *
+ *  COMMIT writes the sectors of the overlay into the base and empties
+ *  the overlay, DISCARD only empties it.  Other guests on the same base
+ *  see a COMMIT wherever their own overlay does not hide it.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+#define _GNU_SOURCE             //  fallocate( ), realpath( )
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <unistd.h>             //  UNIX standard library.
+#include <stdio.h>              //  Standard I/O definitions
+#include <string.h>             //  Functions for managing strings
+#include <errno.h>              //  EINVAL
+#include <limits.h>             //  PATH_MAX
+#include <fcntl.h>              //  open( ), fallocate( )
+#include <sys/stat.h>           //  fstat( )
+#include <sys/mman.h>           //  mmap( ), msync( ), memfd_create( )
+                                //*******************************************
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "disk.h"               //  Disk images
+#include "disk_overlay.h"       //  Copy-on-write overlays
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  OVERLAY_EMPTY       A sector the base does not have             */
+#define OVERLAY_EMPTY           ( 0xE5 )
+/**
+ *  @param  OVERLAY_HAS         Does the overlay hold a sector ?            */
+#define OVERLAY_HAS( O, S )     ( ( (O)->bitmap[ (S) >> 3 ] >> ( (S) & 7 ) ) & 1 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Bytes of the header and the bitmap, rounded up to whole pages.
+ *
+ *  @param  disk                The disk, an overlay.
+ *
+ *  @return                     Bytes to msync( ) for the bitmap.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+size_t
+disk_overlay_head(
+    const
+    struct  disk_t          *   disk
+    )
+{
+    /**
+     *  @param  page            Bytes in a host page                        */
+    size_t                      page;
+    /**
+     *  @param  bytes           Header and bitmap                           */
+    size_t                      bytes;
+
+    page  = (size_t)sysconf( _SC_PAGESIZE );
+    bytes = sizeof( struct overlay_header_t )
+          + ( ( ( disk->size / DISK_SECTOR_SIZE ) + 7 ) / 8 );
+
+    //  DONE!
+    return( ( bytes + page - 1 ) & ~( page - 1 ) );
+}
+
+/****************************************************************************/
+/**
+ *  Header of an empty overlay for a base image.
+ *
+ *  @param  header              Where the header is built.
+ *  @param  base_name           The base image.
+ *
+ *  @return                     TRUE when the base can have an overlay, else
+ *                              FALSE is returned and errno tells why.
+ *
+ *  @note
+ *      The base is recorded by its absolute path.
+ *
+ ****************************************************************************/
+
+static
+int
+disk_overlay_header(
+    struct  overlay_header_t *  header,
+    const
+    char                    *   base_name
+    )
+{
+    /**
+     *  @param  base_path       Absolute path of the base                   */
+    char                        base_path[ PATH_MAX ];
+    /**
+     *  @param  file_stat       Size of the base                            */
+    struct  stat                file_stat;
+
+    //  Is the base an image ?
+    if (    ( realpath( base_name, base_path ) == NULL )
+         || ( stat( base_path, &file_stat ) != 0 ) )
+    {
+        return( false );
+    }
+    if (    ( file_stat.st_size < DISK_SECTOR_SIZE )
+         || ( strlen( base_path ) >= OVERLAY_NAME_SIZE ) )
+    {
+        errno = EINVAL;
+        return( false );
+    }
+
+    memset( header, 0, sizeof( struct overlay_header_t ) );
+    memcpy( header->magic, OVERLAY_MAGIC, sizeof( OVERLAY_MAGIC ) );
+    header->version = OVERLAY_VERSION;
+    header->sectors = (uint32_t)( file_stat.st_size / DISK_SECTOR_SIZE );
+    header->origin  = ( sizeof( struct overlay_header_t ) + ( ( header->sectors + 7 ) / 8 )
+                        + OVERLAY_ALIGN - 1 ) & ~( (uint64_t)OVERLAY_ALIGN - 1 );
+    strcpy( header->base_name, base_path );
+
+    //  DONE!
+    return( true );
+}
+
+/****************************************************************************/
+/**
+ *  Write an empty overlay.
+ *
+ *  @param  fd                  The overlay file, empty.
+ *  @param  header              Its header.
+ *
+ *  @return                     TRUE when the overlay was written, else
+ *                              FALSE is returned and errno tells why.
+ *
+ *  @note
+ *      Only the header is written, the bitmap and the sectors are a hole.
+ *
+ ****************************************************************************/
+
+static
+int
+disk_overlay_init(
+    int                         fd,
+    const
+    struct  overlay_header_t *  header
+    )
+{
+    //  Write the header and size the file
+    if (    ( pwrite( fd, header, sizeof( struct overlay_header_t ), 0 )
+                != sizeof( struct overlay_header_t ) )
+         || ( ftruncate( fd, (off_t)( header->origin
+                                    + ( (uint64_t)header->sectors * DISK_SECTOR_SIZE ) ) ) != 0 ) )
+    {
+        return( false );
+    }
+
+    //  DONE!
+    return( true );
+}
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Create an empty overlay for a base image.
+ *
+ *  @param  file_name           The new overlay, it must not exist.
+ *  @param  base_name           The base image.
+ *
+ *  @return                     TRUE when the overlay was written, else
+ *                              FALSE is returned and errno tells why.
+ *
+ *  @note
+ *      The base is recorded by its absolute path.
+ *
+ ****************************************************************************/
+
+int
+disk_overlay_create(
+    const
+    char                    *   file_name,
+    const
+    char                    *   base_name
+    )
+{
+    /**
+     *  @param  header          The new header                              */
+    struct  overlay_header_t    header;
+    /**
+     *  @param  fd              The overlay                                 */
+    int                         fd;
+
+    //  Is the base an image ?
+    if ( disk_overlay_header( &header, base_name ) == false )
+    {
+        return( false );
+    }
+
+    //  Write the header, the rest is a hole
+    fd = open( file_name, O_RDWR | O_CREAT | O_EXCL, 0644 );
+    if ( fd < 0 )
+    {
+        return( false );
+    }
+    if ( disk_overlay_init( fd, &header ) == false )
+    {
+        close( fd );
+        unlink( file_name );
+        return( false );
+    }
+    close( fd );
+
+    //  DONE!
+    return( true );
+}
+
+/****************************************************************************/
+/**
+ *  Make a private overlay for a disk in an anonymous memory file.
+ *
+ *  @param  disk                The disk.
+ *  @param  file_name           Its image file.
+ *
+ *  @return                     The memory file, -1 when it could not be
+ *                              made ( errno tells why ).
+ *
+ *  @note
+ *      A plain image becomes the base of an empty overlay.  An overlay is
+ *      copied: the new one has the same base and only the sectors the disk
+ *      holds are written to it.  Either way the memory file stays as sparse
+ *      as the overlay and writes to it never reach a file that is shared.
+ *
+ ****************************************************************************/
+
+int
+disk_overlay_private(
+    struct  disk_t          *   disk,
+    const
+    char                    *   file_name
+    )
+{
+    /**
+     *  @param  header          Header of the new overlay                   */
+    struct  overlay_header_t    header;
+    /**
+     *  @param  overlay         The disk's overlay, NULL for a plain image  */
+    struct  disk_overlay_t  *   overlay;
+    /**
+     *  @param  sector          Sector being copied                         */
+    size_t                      sector;
+    /**
+     *  @param  offset          Offset of the sector in the image           */
+    size_t                      offset;
+    /**
+     *  @param  fd              The memory file                             */
+    int                         fd;
+
+    overlay = disk->overlay;
+
+    //  Is it an overlay already ?
+    if ( overlay != NULL )
+    {
+        //  YES:    Same base, same layout
+        memcpy( &header, overlay->file_map, sizeof( header ) );
+    }
+    else
+    if ( disk_overlay_header( &header, file_name ) == false )
+    {
+        //  NO:     And the image can't be a base
+        return( -1 );
+    }
+
+    fd = memfd_create( "i80-emul-disk", 0 );
+    if ( fd < 0 )
+    {
+        return( -1 );
+    }
+    if ( disk_overlay_init( fd, &header ) == false )
+    {
+        close( fd );
+        return( -1 );
+    }
+
+    //  Was anything written to the overlay ?
+    if ( ( overlay != NULL ) && ( disk_overlay_count( disk ) > 0 ) )
+    {
+        //  YES:    Copy those sectors, then the bitmap that claims them
+        for( sector = 0; sector < header.sectors; sector += 1 )
+        {
+            if ( OVERLAY_HAS( overlay, sector ) == 0 )
+            {
+                continue;
+            }
+            offset = sector * DISK_SECTOR_SIZE;
+            if ( pwrite( fd, &disk->map[ offset ], DISK_SECTOR_SIZE,
+                         (off_t)( header.origin + offset ) ) != DISK_SECTOR_SIZE )
+            {
+                close( fd );
+                return( -1 );
+            }
+        }
+        if ( pwrite( fd, overlay->bitmap, overlay->bitmap_size,
+                     sizeof( header ) ) != (ssize_t)overlay->bitmap_size )
+        {
+            close( fd );
+            return( -1 );
+        }
+    }
+
+    //  DONE!
+    return( fd );
+}
+
+/****************************************************************************/
+/**
+ *  Set up a disk whose file is an overlay.
+ *
+ *  @param  disk                The disk, its fd is open and nothing else.
+ *
+ *  @return                     1 when it is an overlay, 0 when the file is
+ *                              a plain image, -1 when it is an overlay that
+ *                              can't be used ( errno tells why ).
+ *
+ *  @note
+ *      Called by disk_attach( ).
+ *
+ ****************************************************************************/
+
+int
+disk_overlay_attach(
+    struct  disk_t          *   disk
+    )
+{
+    /**
+     *  @param  header          Header of the overlay                       */
+    struct  overlay_header_t    header;
+    /**
+     *  @param  overlay         The new overlay                             */
+    struct  disk_overlay_t  *   overlay;
+    /**
+     *  @param  file_stat       Sizes of the files                          */
+    struct  stat                file_stat;
+    /**
+     *  @param  size            Bytes of sector data                        */
+    size_t                      size;
+
+    //  Is it an overlay ?
+    if (    ( pread( disk->fd, &header, sizeof( header ), 0 ) != sizeof( header ) )
+         || ( memcmp( header.magic, OVERLAY_MAGIC, sizeof( OVERLAY_MAGIC ) ) != 0 ) )
+    {
+        //  NO:     A plain image
+        return( 0 );
+    }
+    header.base_name[ OVERLAY_NAME_SIZE - 1 ] = '\0';
+    if (    ( header.version != OVERLAY_VERSION )
+         || ( header.origin  <  sizeof( header ) + ( ( header.sectors + 7 ) / 8 ) ) )
+    {
+        errno = EINVAL;
+        return( -1 );
+    }
+
+    overlay = calloc( 1, sizeof( struct disk_overlay_t ) );
+    if ( overlay == NULL )
+    {
+        return( -1 );
+    }
+    size = (size_t)header.sectors * DISK_SECTOR_SIZE;
+    overlay->origin    = (size_t)header.origin;
+    overlay->file_size = overlay->origin + size;
+    overlay->file_map  = NULL;
+    overlay->base_map  = NULL;
+    overlay->bitmap    = NULL;
+    overlay->bitmap_size = ( header.sectors + 7 ) / 8;
+
+    //  The base, read only
+    overlay->base_fd = open( header.base_name, O_RDONLY );
+    if (    ( overlay->base_fd < 0 )
+         || ( fstat( overlay->base_fd, &file_stat ) != 0 ) )
+    {
+        disk->overlay = overlay;
+        disk_overlay_close( disk );
+        return( -1 );
+    }
+    overlay->base_size = ( (size_t)file_stat.st_size < size ) ? (size_t)file_stat.st_size : size;
+    if ( overlay->base_size > 0 )
+    {
+        overlay->base_map = mmap( NULL, overlay->base_size, PROT_READ, MAP_SHARED,
+                                  overlay->base_fd, 0 );
+        if ( overlay->base_map == MAP_FAILED )
+        {
+            overlay->base_map = NULL;
+        }
+    }
+
+    //  The overlay, all of it ( a copy may have lost the trailing hole )
+    if (    ( fstat( disk->fd, &file_stat ) == 0 )
+         && ( (size_t)file_stat.st_size < overlay->file_size ) )
+    {
+        if ( ftruncate( disk->fd, (off_t)overlay->file_size ) != 0 )
+        {
+            overlay->file_size = 0;
+        }
+    }
+    if ( overlay->file_size > 0 )
+    {
+        overlay->file_map = mmap( NULL, overlay->file_size, PROT_READ | PROT_WRITE,
+                                  MAP_SHARED, disk->fd, 0 );
+        if ( overlay->file_map == MAP_FAILED )
+        {
+            overlay->file_map = NULL;
+        }
+    }
+    if (    ( overlay->file_map == NULL )
+         || ( ( overlay->base_size > 0 ) && ( overlay->base_map == NULL ) ) )
+    {
+        disk->overlay = overlay;
+        disk_overlay_close( disk );
+        return( -1 );
+    }
+    overlay->file_bitmap = overlay->file_map + sizeof( struct overlay_header_t );
+
+    //  Bits are set in a copy until the sectors they cover are written
+    overlay->bitmap = malloc( overlay->bitmap_size );
+    if ( overlay->bitmap == NULL )
+    {
+        disk->overlay = overlay;
+        disk_overlay_close( disk );
+        return( -1 );
+    }
+    memcpy( overlay->bitmap, overlay->file_bitmap, overlay->bitmap_size );
+
+    //  The sectors are at origin, the rest of the disk layer need not care
+    disk->overlay = overlay;
+    disk->origin  = overlay->origin;
+    disk->map     = overlay->file_map + overlay->origin;
+    disk->size    = size;
+
+    //  DONE!
+    return( 1 );
+}
+
+/****************************************************************************/
+/**
+ *  Where a sector is.
+ *
+ *  @param  disk                The disk, an overlay.
+ *  @param  offset              Offset of the sector in the image.
+ *
+ *  @return                     The sector in the overlay or the base, NULL
+ *                              when the base does not have it.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+const
+uint8_t *
+disk_overlay_sector(
+    struct  disk_t          *   disk,
+    size_t                      offset
+    )
+{
+    /**
+     *  @param  overlay         The overlay                                 */
+    struct  disk_overlay_t  *   overlay;
+
+    overlay = disk->overlay;
+
+    //  Does the overlay have it ?
+    if ( OVERLAY_HAS( overlay, offset / DISK_SECTOR_SIZE ) )
+    {
+        //  YES:    The guest wrote it
+        return( &disk->map[ offset ] );
+    }
+
+    //  Does the base have it ?
+    if ( ( offset + DISK_SECTOR_SIZE ) <= overlay->base_size )
+    {
+        //  YES:    Nobody wrote it
+        return( &overlay->base_map[ offset ] );
+    }
+
+    //  DONE!
+    return( NULL );
+}
+
+/****************************************************************************/
+/**
+ *  Read bytes of an overlay disk.
+ *
+ *  @param  disk                The disk, an overlay.
+ *  @param  offset              Offset in the image.
+ *  @param  data_p              Where the bytes go.
+ *  @param  length              Number of bytes.
+ *
+ *  @return                     The BIOS return code: 0 for OK.
+ *
+ *  @note
+ *      Each sector comes from the overlay or the base.  What neither has
+ *      reads as freshly formatted.
+ *
+ ****************************************************************************/
+
+uint8_t
+disk_overlay_read(
+    struct  disk_t          *   disk,
+    size_t                      offset,
+    uint8_t                 *   data_p,
+    size_t                      length
+    )
+{
+    /**
+     *  @param  in_sector       Offset in the sector                        */
+    size_t                      in_sector;
+    /**
+     *  @param  count           Bytes from this sector                      */
+    size_t                      count;
+    /**
+     *  @param  sector_p        The sector                                  */
+    const
+    uint8_t                 *   sector_p;
+
+    while ( length > 0 )
+    {
+        in_sector = offset % DISK_SECTOR_SIZE;
+        count = DISK_SECTOR_SIZE - in_sector;
+        if ( count > length )
+        {
+            count = length;
+        }
+
+        sector_p = ( offset < disk->size )
+                 ? disk_overlay_sector( disk, offset - in_sector ) : NULL;
+        if ( sector_p == NULL )
+        {
+            memset( data_p, OVERLAY_EMPTY, count );
+        }
+        else
+        {
+            memcpy( data_p, &sector_p[ in_sector ], count );
+        }
+
+        offset += count;
+        data_p += count;
+        length -= count;
+    }
+
+    //  DONE!
+    return( 0x00 );
+}
+
+/****************************************************************************/
+/**
+ *  Make the sectors of a write belong to the overlay.
+ *
+ *  @param  disk                The disk, an overlay.
+ *  @param  offset              Offset in the image.
+ *  @param  length              Number of bytes about to be written.
+ *
+ *  @return                     The BIOS return code: 0 for OK, 1 when the
+ *                              write is past the end of the base.
+ *
+ *  @note
+ *      Called before the bytes are written.  A sector the write only
+ *      covers in part is copied from the base first.  The bit is only set
+ *      in the private bitmap, disk_overlay_flush( ) writes it out.
+ *
+ ****************************************************************************/
+
+uint8_t
+disk_overlay_claim(
+    struct  disk_t          *   disk,
+    size_t                      offset,
+    size_t                      length
+    )
+{
+    /**
+     *  @param  overlay         The overlay                                 */
+    struct  disk_overlay_t  *   overlay;
+    /**
+     *  @param  sector          Sector being claimed                        */
+    size_t                      sector;
+    /**
+     *  @param  start           First byte of the sector                    */
+    size_t                      start;
+
+    overlay = disk->overlay;
+
+    //  An overlay can't grow
+    if ( ( offset + length ) > disk->size )
+    {
+        return( 0x01 );
+    }
+
+    for( sector = offset / DISK_SECTOR_SIZE;
+         ( sector * DISK_SECTOR_SIZE ) < ( offset + length );
+         sector += 1 )
+    {
+        //  Is it claimed already ?
+        if ( OVERLAY_HAS( overlay, sector ) )
+        {
+            //  YES:    Next
+            continue;
+        }
+
+        //  Is it only written in part ?
+        start = sector * DISK_SECTOR_SIZE;
+        if (    ( start < offset )
+             || ( ( start + DISK_SECTOR_SIZE ) > ( offset + length ) ) )
+        {
+            //  YES:    Start from what the base has
+            disk_overlay_read( disk, start, &disk->map[ start ], DISK_SECTOR_SIZE );
+        }
+
+        overlay->bitmap[ sector >> 3 ] |= (uint8_t)( 1 << ( sector & 7 ) );
+        overlay->bitmap_dirty = true;
+    }
+
+    //  DONE!
+    return( 0x00 );
+}
+
+/****************************************************************************/
+/**
+ *  Write the bitmap back to the overlay file.
+ *
+ *  @param  disk                The disk, an overlay.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Every sector the bitmap claims must be on disk already: it is
+ *      called by disk_flush( ) after the sectors were synced, and by the
+ *      BIOS after the I/O thread passed a barrier.
+ *
+ ****************************************************************************/
+
+void
+disk_overlay_flush(
+    struct  disk_t          *   disk
+    )
+{
+    //  Did the bitmap change ?
+    if ( disk->overlay->bitmap_dirty == false )
+    {
+        //  NO:     Nothing to do
+        return;
+    }
+
+    //  Only now can the file say the sectors are there
+    memcpy( disk->overlay->file_bitmap, disk->overlay->bitmap,
+            disk->overlay->bitmap_size );
+
+    if ( msync( disk->overlay->file_map, disk_overlay_head( disk ), MS_SYNC ) != 0 )
+    {
+        perror( "DISK: msync" );
+    }
+    disk->overlay->bitmap_dirty = false;
+}
+
+/****************************************************************************/
+/**
+ *  Write the sectors of an overlay into its base and empty the overlay.
+ *
+ *  @param  disk                The disk, an overlay, flushed.
+ *
+ *  @return                     TRUE when the base was written, else FALSE
+ *                              is returned, errno tells why, and the
+ *                              overlay is kept.
+ *
+ *  @note
+ *      Adjacent sectors are written with one call.
+ *
+ ****************************************************************************/
+
+int
+disk_overlay_commit(
+    struct  disk_t          *   disk
+    )
+{
+    /**
+     *  @param  header          Header of the overlay                       */
+    const
+    struct  overlay_header_t *  header;
+    /**
+     *  @param  base_fd         The base, opened for writing                */
+    int                         base_fd;
+    /**
+     *  @param  sectors         Sectors of the disk                         */
+    size_t                      sectors;
+    /**
+     *  @param  first           First sector of a run                       */
+    size_t                      first;
+    /**
+     *  @param  last            Sector after the run                        */
+    size_t                      last;
+    /**
+     *  @param  ok              TRUE while every write worked               */
+    bool                        ok;
+
+    header  = (const struct overlay_header_t *)disk->overlay->file_map;
+    sectors = disk->size / DISK_SECTOR_SIZE;
+
+    base_fd = open( header->base_name, O_WRONLY );
+    if ( base_fd < 0 )
+    {
+        return( false );
+    }
+
+    ok = true;
+    for( first = 0; ( first < sectors ) && ( ok == true ); first = last )
+    {
+        //  Find the next run
+        if ( ! OVERLAY_HAS( disk->overlay, first ) )
+        {
+            last = first + 1;
+            continue;
+        }
+        for( last = first + 1;
+             ( last < sectors ) && OVERLAY_HAS( disk->overlay, last );
+             last += 1 )
+        {
+        }
+
+        ok = ( pwrite( base_fd, &disk->map[ first * DISK_SECTOR_SIZE ],
+                       ( last - first ) * DISK_SECTOR_SIZE,
+                       (off_t)( first * DISK_SECTOR_SIZE ) )
+               == (ssize_t)( ( last - first ) * DISK_SECTOR_SIZE ) );
+    }
+    ok = ok && ( fdatasync( base_fd ) == 0 );
+    close( base_fd );
+
+    //  Was all of it written ?
+    if ( ok == false )
+    {
+        //  NO:     Keep the overlay
+        return( false );
+    }
+
+    disk_overlay_discard( disk );
+
+    //  DONE!
+    return( true );
+}
+
+/****************************************************************************/
+/**
+ *  Empty an overlay, the disk reads as its base again.
+ *
+ *  @param  disk                The disk, an overlay.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The space the sectors took is given back to the file system.
+ *
+ ****************************************************************************/
+
+void
+disk_overlay_discard(
+    struct  disk_t          *   disk
+    )
+{
+    memset( disk->overlay->bitmap, 0, disk->overlay->bitmap_size );
+    disk->overlay->bitmap_dirty = true;
+    disk_overlay_flush( disk );
+
+    //  Nothing written is left to flush
+    disk->dirty_lo = 0;
+    disk->dirty_hi = 0;
+
+    //  Punch the sectors out, a file system that can't keeps them
+    fallocate( disk->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+               (off_t)disk->origin, (off_t)disk->size );
+}
+
+/****************************************************************************/
+/**
+ *  Count the sectors an overlay holds.
+ *
+ *  @param  disk                The disk.
+ *
+ *  @return                     Sectors written since the overlay was
+ *                              created or emptied, 0 for a plain image.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+uint32_t
+disk_overlay_count(
+    const
+    struct  disk_t          *   disk
+    )
+{
+    /**
+     *  @param  ndx             Byte of the bitmap                          */
+    size_t                      ndx;
+    /**
+     *  @param  count           Sectors counted                             */
+    uint32_t                    count;
+
+    //  Is it an overlay ?
+    if ( disk->overlay == NULL )
+    {
+        //  NO:     Nothing to count
+        return( 0 );
+    }
+
+    count = 0;
+    for( ndx = 0; ndx < disk->overlay->bitmap_size; ndx += 1 )
+    {
+        count += (uint32_t)__builtin_popcount( disk->overlay->bitmap[ ndx ] );
+    }
+
+    //  DONE!
+    return( count );
+}
+
+/****************************************************************************/
+/**
+ *  Unmap and close what the overlay of a disk added.
+ *
+ *  @param  disk                The disk, an overlay.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called by disk_close( ) after the disk was flushed.  The disk's map
+ *      is part of the overlay mapping and is gone afterwards.
+ *
+ ****************************************************************************/
+
+void
+disk_overlay_close(
+    struct  disk_t          *   disk
+    )
+{
+    /**
+     *  @param  overlay         The overlay                                 */
+    struct  disk_overlay_t  *   overlay;
+
+    overlay = disk->overlay;
+
+    if ( overlay->file_map != NULL )
+    {
+        munmap( overlay->file_map, overlay->file_size );
+    }
+    if ( overlay->base_map != NULL )
+    {
+        munmap( overlay->base_map, overlay->base_size );
+    }
+    if ( overlay->base_fd >= 0 )
+    {
+        close( overlay->base_fd );
+    }
+    free( overlay->bitmap );
+    free( overlay );
+
+    disk->overlay = NULL;
+    disk->origin  = 0;
+    disk->map     = NULL;
+    disk->size    = 0;
+}
+
+/****************************************************************************/
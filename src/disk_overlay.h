@@ -0,0 +1,213 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+#ifndef DISK_OVERLAY_H
+#define DISK_OVERLAY_H
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Copy-on-write overlay disk images.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * System APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Application APIs
+ ****************************************************************************/
+
+                                //*******************************************
+#include "disk.h"               //  Disk images
+                                //*******************************************
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  OVERLAY_MAGIC       First bytes of an overlay file
+ *  @param  OVERLAY_VERSION     Layout of the overlay file
+ *  @param  OVERLAY_NAME_SIZE   Longest base image name ( with NUL )
+ *  @param  OVERLAY_ALIGN       Sector data starts on a multiple of this    */
+#define OVERLAY_MAGIC           "I80OVLY"
+#define OVERLAY_VERSION         ( 1 )
+#define OVERLAY_NAME_SIZE       ( 4096 )
+#define OVERLAY_ALIGN           ( 0x10000 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  overlay_header_t    Start of an overlay file, the sector bitmap
+ *                              follows it and the sectors start at origin  */
+struct  overlay_header_t
+{
+    /**
+     *  @param  magic           OVERLAY_MAGIC                               */
+    char                        magic[ 8 ];
+    /**
+     *  @param  version         OVERLAY_VERSION                             */
+    uint32_t                    version;
+    /**
+     *  @param  sectors         Sectors of the base image                   */
+    uint32_t                    sectors;
+    /**
+     *  @param  origin          Offset of sector 0 in the overlay file      */
+    uint64_t                    origin;
+    /**
+     *  @param  base_name       Absolute path of the base image             */
+    char                        base_name[ OVERLAY_NAME_SIZE ];
+};
+//----------------------------------------------------------------------------
+/**
+ *  @param  disk_overlay_t      What an open overlay adds to its disk       */
+struct  disk_overlay_t
+{
+    /**
+     *  @param  base_fd         The base image, opened read only            */
+    int                         base_fd;
+    /**
+     *  @param  base_map        The base image mapped, NULL when empty      */
+    uint8_t                 *   base_map;
+    /**
+     *  @param  base_size       Bytes of the base image that are mapped     */
+    size_t                      base_size;
+    /**
+     *  @param  file_map        The whole overlay file mapped               */
+    uint8_t                 *   file_map;
+    /**
+     *  @param  file_size       Bytes of the overlay file                   */
+    size_t                      file_size;
+    /**
+     *  @param  bitmap          One bit per sector held by the overlay, a
+     *                          private copy that is ahead of the file's    */
+    uint8_t                 *   bitmap;
+    /**
+     *  @param  file_bitmap     The bitmap in the mapped overlay file       */
+    uint8_t                 *   file_bitmap;
+    /**
+     *  @param  bitmap_size     Bytes of the bitmap                         */
+    size_t                      bitmap_size;
+    /**
+     *  @param  bitmap_dirty    The bitmap changed since the last flush     */
+    bool                        bitmap_dirty;
+    /**
+     *  @param  origin          Offset of sector 0 in the overlay file      */
+    size_t                      origin;
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Prototypes
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+int
+disk_overlay_create(
+    const
+    char                    *   file_name,
+    const
+    char                    *   base_name
+    );
+//----------------------------------------------------------------------------
+int
+disk_overlay_private(
+    struct  disk_t          *   disk,
+    const
+    char                    *   file_name
+    );
+//----------------------------------------------------------------------------
+int
+disk_overlay_attach(
+    struct  disk_t          *   disk
+    );
+//----------------------------------------------------------------------------
+uint8_t
+disk_overlay_read(
+    struct  disk_t          *   disk,
+    size_t                      offset,
+    uint8_t                 *   data_p,
+    size_t                      length
+    );
+//----------------------------------------------------------------------------
+const
+uint8_t *
+disk_overlay_sector(
+    struct  disk_t          *   disk,
+    size_t                      offset
+    );
+//----------------------------------------------------------------------------
+uint8_t
+disk_overlay_claim(
+    struct  disk_t          *   disk,
+    size_t                      offset,
+    size_t                      length
+    );
+//----------------------------------------------------------------------------
+void
+disk_overlay_flush(
+    struct  disk_t          *   disk
+    );
+//----------------------------------------------------------------------------
+int
+disk_overlay_commit(
+    struct  disk_t          *   disk
+    );
+//----------------------------------------------------------------------------
+void
+disk_overlay_discard(
+    struct  disk_t          *   disk
+    );
+//----------------------------------------------------------------------------
+uint32_t
+disk_overlay_count(
+    const
+    struct  disk_t          *   disk
+    );
+//----------------------------------------------------------------------------
+void
+disk_overlay_close(
+    struct  disk_t          *   disk
+    );
+//----------------------------------------------------------------------------
+
+/****************************************************************************/
+
+#endif                      //    DISK_OVERLAY_H
@@ -0,0 +1,809 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Disk image Power On Self Test.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+#define _DEFAULT_SOURCE         //  mkstemp( ), pread( )
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <unistd.h>             //  UNIX standard library.
+#include <stdio.h>              //  Standard I/O definitions
+#include <string.h>             //  Functions for managing strings
+#include <fcntl.h>              //  open( )
+#include <sys/stat.h>           //  fstat( )
+                                //*******************************************
+
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "disk.h"               //  Disk images
+#include "disk_async.h"         //  Write-behind I/O thread
+#include "disk_cache.h"         //  Track cache
+#include "disk_overlay.h"       //  Copy-on-write overlays
+#include "disk_uring.h"         //  io_uring for the disk images
+#include "machine.h"            //  Guest machine context
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  POST_SECTORS        Sectors in the test image                   */
+#define POST_SECTORS            ( 64 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Create a test image, every byte of a sector holds the sector number.
+ *
+ *  @param  file_name           Template for mkstemp( ), the name is
+ *                              returned in it.
+ *
+ *  @return                     File Descriptor of the image or -1.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+int
+post_image(
+    char                    *   file_name
+    )
+{
+    /**
+     *  @param  fd              File Descriptor                             */
+    int                         fd;
+    /**
+     *  @param  lba             Sector being written                        */
+    int                         lba;
+    /**
+     *  @param  data            One sector                                  */
+    uint8_t                     data[ DISK_SECTOR_SIZE ];
+
+    fd = mkstemp( file_name );
+    if ( fd < 0 )
+    {
+        return( -1 );
+    }
+
+    for( lba = 0; lba < POST_SECTORS; lba += 1 )
+    {
+        memset( data, lba, sizeof( data ) );
+        if ( write( fd, data, sizeof( data ) ) != sizeof( data ) )
+        {
+            close( fd );
+            unlink( file_name );
+            return( -1 );
+        }
+    }
+
+    //  DONE!
+    return( fd );
+}
+
+/****************************************************************************/
+/**
+ *  Sector READ and WRITE through the mapping.
+ *
+ *  @param
+ *
+ *  @return                     TRUE when the test passes, else FALSE.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+int
+tc_disk_00(
+    void
+    )
+{
+    /**
+     *  @param  file_name       The test image                              */
+    char                        file_name[ 64 ] = "/tmp/i80-emul-post-XXXXXX";
+    /**
+     *  @param  disk            The disk under test                         */
+    struct  disk_t              disk;
+    /**
+     *  @param  check_fd        Reads the file behind the disk's back       */
+    int                         check_fd;
+    /**
+     *  @param  data            One sector read from the file               */
+    uint8_t                     data[ DISK_SECTOR_SIZE ];
+    /**
+     *  @param  post_rc         TRUE while the test passes                  */
+    int                         post_rc;
+    /**
+     *  @param  file_stat       Size of the image                           */
+    struct  stat                file_stat;
+
+    check_fd = post_image( file_name );
+    if ( check_fd < 0 )
+    {
+        printf( "POST: DISK could not create a test image\n" );
+        return( false );
+    }
+
+    disk_init( &disk );
+    post_rc = disk_open( &disk, file_name );
+    post_rc &= ( disk.map != NULL );
+
+    //  READ sector 5 to x'1000
+    post_rc &= ( disk_read( &disk, 5, 0x1000 ) == 0 );
+    post_rc &= ( memory_get_8( 0x1000 ) == 5 );
+    post_rc &= ( memory_get_8( 0x107F ) == 5 );
+
+    //  WRITE it back as sector 7 and flush
+    memory_put_8( 0x1000, 0xAA );
+    post_rc &= ( disk_write( &disk, 7, 0x1000 ) == 0 );
+    post_rc &= ( disk.dirty_hi == 8 * DISK_SECTOR_SIZE );
+    disk_flush( &disk );
+    post_rc &= ( disk.dirty_hi == 0 );
+    post_rc &= ( pread( check_fd, data, sizeof( data ), 7 * DISK_SECTOR_SIZE ) == sizeof( data ) );
+    post_rc &= ( data[ 0 ] == 0xAA ) && ( data[ 1 ] == 5 );
+
+    //  A DMA buffer that wraps past x'FFFF
+    post_rc &= ( disk_read( &disk, 9, 0xFFC0 ) == 0 );
+    post_rc &= ( memory_get_8( 0xFFFF ) == 9 ) && ( memory_get_8( 0x003F ) == 9 );
+
+    //  Past the end of the image: reads as formatted, writes grow it
+    post_rc &= ( disk_read( &disk, POST_SECTORS, 0x1000 ) == 0 );
+    post_rc &= ( memory_get_8( 0x1000 ) == 0xE5 );
+    post_rc &= ( disk_write( &disk, POST_SECTORS, 0x2000 ) == 0 );
+    post_rc &= ( disk.size == ( POST_SECTORS + 1 ) * DISK_SECTOR_SIZE );
+    post_rc &= (    ( fstat( check_fd, &file_stat ) == 0 )
+                 && ( file_stat.st_size == ( POST_SECTORS + 1 ) * DISK_SECTOR_SIZE ) );
+
+    disk_close( &disk );
+    post_rc &= ( disk_mounted( &disk ) == false );
+
+    close( check_fd );
+    unlink( file_name );
+
+    //  Did it pass ?
+    if ( post_rc == false )
+    {
+        //  NO:     Write an error message
+        printf( "POST: DISK mapped sector READ / WRITE failed\n" );
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
+/****************************************************************************/
+/**
+ *  The track cache: hits, write-back of dirty sectors and replacement.
+ *
+ *  @param
+ *
+ *  @return                     TRUE when the test passes, else FALSE.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+int
+tc_disk_01(
+    void
+    )
+{
+    /**
+     *  @param  file_name       The test image                              */
+    char                        file_name[ 64 ] = "/tmp/i80-emul-post-XXXXXX";
+    /**
+     *  @param  disk            The disk under test                         */
+    struct  disk_t              disk;
+    /**
+     *  @param  cache           The cache under test                        */
+    struct  disk_cache_t    *   cache;
+    /**
+     *  @param  check_fd        Reads the file behind the cache's back      */
+    int                         check_fd;
+    /**
+     *  @param  data            One sector read from the file               */
+    uint8_t                     data[ DISK_SECTOR_SIZE ];
+    /**
+     *  @param  track           Track being read                            */
+    uint32_t                    track;
+    /**
+     *  @param  ro_fd           The image opened read only                  */
+    int                         ro_fd;
+    /**
+     *  @param  rw_fd           The disk's own descriptor while it is       */
+    int                         rw_fd;
+    /**
+     *  @param  post_rc         TRUE while the test passes                  */
+    int                         post_rc;
+
+    check_fd = post_image( file_name );
+    cache = disk_cache_create( );
+    if ( ( check_fd < 0 ) || ( cache == NULL ) )
+    {
+        printf( "POST: DISK could not create a test image\n" );
+        return( false );
+    }
+
+    disk_init( &disk );
+    post_rc = disk_open( &disk, file_name );
+
+    //  The first sector of a track misses, the next one hits
+    post_rc &= ( disk_cache_read( cache, &disk, 3, 8, 0x1000 ) == 0 );
+    post_rc &= ( disk_cache_read( cache, &disk, 4, 8, 0x1080 ) == 0 );
+    post_rc &= ( memory_get_8( 0x1000 ) == 3 ) && ( memory_get_8( 0x10FF ) == 4 );
+    post_rc &= ( cache->misses == 1 ) && ( cache->hits == 1 );
+
+    //  Writes stay in the cache until it is flushed
+    memory_put_8( 0x1000, 0xAA );
+    post_rc &= ( disk_cache_write( cache, &disk, 5, 8, 0x1000, 0 ) == 0 );
+    post_rc &= ( disk_cache_write( cache, &disk, 6, 8, 0x1000, 1 ) == 0 );
+    post_rc &= ( pread( check_fd, data, sizeof( data ), 5 * DISK_SECTOR_SIZE ) == sizeof( data ) );
+    post_rc &= ( data[ 0 ] == 5 );
+    post_rc &= ( disk_cache_due( cache, true ) == false );
+    cache->policy = DISK_FLUSH_IDLE;
+    post_rc &= ( disk_cache_due( cache, false ) == false );
+    post_rc &= ( disk_cache_due( cache, true ) == true );
+    post_rc &= ( disk_cache_flush( cache, &disk ) == 0 );
+    post_rc &= ( disk_cache_barrier( cache ) == 0 );
+    post_rc &= ( cache->write_backs == 1 ) && ( cache->dirty_ns == 0 );
+    post_rc &= ( pread( check_fd, data, sizeof( data ), 6 * DISK_SECTOR_SIZE ) == sizeof( data ) );
+    post_rc &= ( data[ 0 ] == 0xAA ) && ( data[ 1 ] == 3 );
+
+    //  A write to a new block does not read the track
+    post_rc &= ( disk_cache_write( cache, &disk, 41, 8, 0x1000, 2 ) == 0 );
+    post_rc &= ( cache->track[ 1 ].valid == ( 1ull << 1 ) );
+
+    //  Replacing a dirty track writes it back
+    for( track = 8; track < 8 + DISK_CACHE_TRACKS; track += 1 )
+    {
+        post_rc &= ( disk_cache_read( cache, &disk, track * 8, 8, 0x2000 ) == 0 );
+    }
+    post_rc &= ( memory_get_8( 0x2000 ) == 0xE5 );
+    post_rc &= ( cache->evictions >= 2 );
+    post_rc &= ( disk_cache_barrier( cache ) == 0 );
+    post_rc &= ( pread( check_fd, data, sizeof( data ), 41 * DISK_SECTOR_SIZE ) == sizeof( data ) );
+    post_rc &= ( data[ 0 ] == 0xAA );
+
+    //  A track that can't be written back stays dirty, clean ones make room
+    if ( cache->async == NULL )
+    {
+        post_rc &= ( disk_cache_write( cache, &disk, 40 * 8, 8, 0x1000, 2 ) == 0 );
+        ro_fd = open( file_name, O_RDONLY );
+        rw_fd = dup( disk.fd );
+        dup2( ro_fd, disk.fd );
+        for( track = 48; track < 48 + DISK_CACHE_TRACKS; track += 1 )
+        {
+            post_rc &= ( disk_cache_read( cache, &disk, track * 8, 8, 0x2000 ) == 0 );
+        }
+        post_rc &= ( disk_cache_flush( cache, &disk ) != 0 );
+        post_rc &= ( cache->dirty_ns != 0 );
+        dup2( rw_fd, disk.fd );
+        close( rw_fd );
+        close( ro_fd );
+        post_rc &= ( disk_cache_flush( cache, &disk ) == 0 );
+        post_rc &= ( pread( check_fd, data, sizeof( data ), 40 * 8 * DISK_SECTOR_SIZE ) == sizeof( data ) );
+        post_rc &= ( data[ 0 ] == 0xAA );
+    }
+
+    //  Tracks too long for the cache go straight to the image
+    post_rc &= ( disk_cache_read( cache, &disk, 7, 0, 0x1000 ) == 0 );
+    post_rc &= ( memory_get_8( 0x1000 ) == 7 ) && ( cache->bypass == 1 );
+
+    //  A dropped disk has nothing cached
+    disk_cache_drop( cache, &disk );
+    for( track = 0; track < DISK_CACHE_TRACKS; track += 1 )
+    {
+        post_rc &= ( cache->track[ track ].disk == NULL );
+    }
+
+    disk_cache_destroy( cache );
+    disk_close( &disk );
+    close( check_fd );
+    unlink( file_name );
+
+    //  Did it pass ?
+    if ( post_rc == false )
+    {
+        //  NO:     Write an error message
+        printf( "POST: DISK track cache failed\n" );
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
+/****************************************************************************/
+/**
+ *  The write-behind I/O thread: reads see pending writes, barriers.
+ *
+ *  @param
+ *
+ *  @return                     TRUE when the test passes, else FALSE.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+int
+tc_disk_02(
+    void
+    )
+{
+    /**
+     *  @param  file_name       The test image                              */
+    char                        file_name[ 64 ] = "/tmp/i80-emul-post-XXXXXX";
+    /**
+     *  @param  disk            The disk under test                         */
+    struct  disk_t              disk;
+    /**
+     *  @param  async           The I/O thread under test                   */
+    struct  disk_async_t    *   async;
+    /**
+     *  @param  check_fd        Reads the file behind the disk's back       */
+    int                         check_fd;
+    /**
+     *  @param  image_fd        The image while the disk pretends to fail   */
+    int                         image_fd;
+    /**
+     *  @param  ring_fd         The io_uring while it pretends to fail      */
+    int                         ring_fd;
+    /**
+     *  @param  data            Sectors written and read                    */
+    uint8_t                     data[ 2 * DISK_SECTOR_SIZE ];
+    /**
+     *  @param  lba             Sector being written                        */
+    int                         lba;
+    /**
+     *  @param  post_rc         TRUE while the test passes                  */
+    int                         post_rc;
+
+    check_fd = post_image( file_name );
+    async = disk_async_create( DISK_SYNC_DATA );
+    if ( ( check_fd < 0 ) || ( async == NULL ) )
+    {
+        printf( "POST: DISK could not create a test image\n" );
+        return( false );
+    }
+
+    disk_init( &disk );
+    post_rc = disk_open( &disk, file_name );
+
+    //  More writes than the ring holds, each is read back at once
+    for( lba = 0; lba < 2 * DISK_ASYNC_RING; lba += 1 )
+    {
+        memset( data, 0x80 | lba, DISK_SECTOR_SIZE );
+        post_rc &= ( disk_async_write( async, &disk, (size_t)lba * DISK_SECTOR_SIZE,
+                                       data, DISK_SECTOR_SIZE ) == 0 );
+        post_rc &= ( disk_async_read( async, &disk, (size_t)lba * DISK_SECTOR_SIZE,
+                                      data, 2 * DISK_SECTOR_SIZE ) == 0 );
+        post_rc &= ( data[ 0 ] == ( 0x80 | lba ) );
+        post_rc &= (    ( data[ DISK_SECTOR_SIZE ] == lba + 1 )
+                     || ( lba + 1 >= POST_SECTORS ) );
+    }
+    disk_async_sync( async, &disk );
+    post_rc &= ( async->queued == ( 2 * DISK_ASYNC_RING ) + 1 );
+
+    //  After a barrier it is all in the file
+    post_rc &= ( disk_async_barrier( async ) == 0 );
+    post_rc &= ( atomic_load( &async->head ) == atomic_load( &async->tail ) );
+    post_rc &= ( pread( check_fd, data, DISK_SECTOR_SIZE, 3 * DISK_SECTOR_SIZE ) == DISK_SECTOR_SIZE );
+    post_rc &= ( data[ 0 ] == 0x83 );
+    post_rc &= ( pread( check_fd, data, DISK_SECTOR_SIZE,
+                        ( ( 2 * DISK_ASYNC_RING ) - 1 ) * DISK_SECTOR_SIZE ) == DISK_SECTOR_SIZE );
+    post_rc &= ( data[ 0 ] == ( 0x80 | ( ( 2 * DISK_ASYNC_RING ) - 1 ) ) );
+
+    //  A failed write is reported by the next barrier
+    image_fd = disk.fd;
+    disk.fd = -1;
+    post_rc &= ( disk_async_write( async, &disk, 0, data, DISK_SECTOR_SIZE ) == 0 );
+    post_rc &= ( disk_async_barrier( async ) == 1 );
+    post_rc &= ( disk_async_barrier( async ) == 0 );
+    disk.fd = image_fd;
+
+    //  A broken io_uring is dropped and the batch written with pwrite( )
+    if ( async->uring != NULL )
+    {
+        ring_fd = async->uring->fd;
+        async->uring->fd = dup( check_fd );
+        memset( data, 0x5A, DISK_SECTOR_SIZE );
+        post_rc &= ( disk_async_write( async, &disk, 5 * DISK_SECTOR_SIZE,
+                                       data, DISK_SECTOR_SIZE ) == 0 );
+        post_rc &= ( disk_async_barrier( async ) == 0 );
+        post_rc &= ( async->uring == NULL );
+        post_rc &= ( pread( check_fd, data, DISK_SECTOR_SIZE, 5 * DISK_SECTOR_SIZE ) == DISK_SECTOR_SIZE );
+        post_rc &= ( data[ 0 ] == 0x5A );
+        close( ring_fd );
+    }
+
+    disk_async_destroy( async );
+    disk_close( &disk );
+    close( check_fd );
+    unlink( file_name );
+
+    //  Did it pass ?
+    if ( post_rc == false )
+    {
+        //  NO:     Write an error message
+        printf( "POST: DISK write-behind I/O thread failed\n" );
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
+/****************************************************************************/
+/**
+ *  io_uring batches: registered and plain buffers, sync, failures.
+ *
+ *  @param
+ *
+ *  @return                     TRUE when the test passes, else FALSE.
+ *
+ *  @note
+ *      Passes without testing anything when the kernel has no io_uring.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_disk_03(
+    void
+    )
+{
+    /**
+     *  @param  file_name       The test image                              */
+    char                        file_name[ 64 ] = "/tmp/i80-emul-post-XXXXXX";
+    /**
+     *  @param  uring           The io_uring under test                     */
+    struct  disk_uring_t    *   uring;
+    /**
+     *  @param  fd              The test image                              */
+    int                         fd;
+    /**
+     *  @param  ring_fd         The io_uring while it pretends to fail      */
+    int                         ring_fd;
+    /**
+     *  @param  fixed           The registered buffer                       */
+    uint8_t                     fixed[ 2 * DISK_SECTOR_SIZE ];
+    /**
+     *  @param  data            A plain buffer                              */
+    uint8_t                     data[ DISK_SECTOR_SIZE ];
+    /**
+     *  @param  buffer          Describes the registered buffer             */
+    struct  iovec               buffer;
+    /**
+     *  @param  post_rc         TRUE while the test passes                  */
+    int                         post_rc;
+
+    buffer.iov_base = fixed;
+    buffer.iov_len  = sizeof( fixed );
+    uring = disk_uring_create( 8, &buffer, 1 );
+    if ( uring == NULL )
+    {
+        //  The I/O thread uses pwrite( ) here
+        return( true );
+    }
+
+    fd = post_image( file_name );
+    if ( fd < 0 )
+    {
+        disk_uring_destroy( uring );
+        printf( "POST: DISK could not create a test image\n" );
+        return( false );
+    }
+
+    //  Two sectors from the registered buffer, one not, then a sync
+    memset( fixed, 0xA1, sizeof( fixed ) );
+    memset( data,  0xB2, sizeof( data ) );
+    post_rc  = disk_uring_write( uring, fd, fixed, sizeof( fixed ), 10 * DISK_SECTOR_SIZE, 0 );
+    post_rc &= disk_uring_write( uring, fd, data, sizeof( data ), 20 * DISK_SECTOR_SIZE, -1 );
+    post_rc &= disk_uring_sync( uring, fd, true );
+    post_rc &= ( disk_uring_wait( uring ) == 0 );
+
+    post_rc &= ( pread( fd, data, sizeof( data ), 11 * DISK_SECTOR_SIZE ) == sizeof( data ) );
+    post_rc &= ( data[ 0 ] == 0xA1 ) && ( data[ DISK_SECTOR_SIZE - 1 ] == 0xA1 );
+    post_rc &= ( pread( fd, data, sizeof( data ), 20 * DISK_SECTOR_SIZE ) == sizeof( data ) );
+    post_rc &= ( data[ 0 ] == 0xB2 );
+    post_rc &= ( pread( fd, data, sizeof( data ), 12 * DISK_SECTOR_SIZE ) == sizeof( data ) );
+    post_rc &= ( data[ 0 ] == 12 );
+
+    //  A write that fails is counted
+    post_rc &= disk_uring_write( uring, -1, data, sizeof( data ), 0, -1 );
+    post_rc &= disk_uring_write( uring, fd, data, sizeof( data ), 0, -1 );
+    post_rc &= ( disk_uring_wait( uring ) == 1 );
+
+    //  A ring that io_uring_enter( ) refuses can't be used anymore
+    post_rc &= disk_uring_write( uring, fd, data, sizeof( data ), 0, -1 );
+    ring_fd = uring->fd;
+    uring->fd = fd;
+    post_rc &= ( disk_uring_wait( uring ) == -1 );
+    uring->fd = ring_fd;
+
+    disk_uring_destroy( uring );
+    close( fd );
+    unlink( file_name );
+
+    //  Did it pass ?
+    if ( post_rc == false )
+    {
+        //  NO:     Write an error message
+        printf( "POST: DISK io_uring batch failed\n" );
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
+/****************************************************************************/
+/**
+ *  Copy-on-write overlays: the base is only read, COMMIT and DISCARD.
+ *
+ *  @param
+ *
+ *  @return                     TRUE when the test passes, else FALSE.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+int
+tc_disk_04(
+    void
+    )
+{
+    /**
+     *  @param  base_name       The base image                              */
+    char                        base_name[ 64 ] = "/tmp/i80-emul-post-XXXXXX";
+    /**
+     *  @param  file_name       The overlay                                 */
+    char                        file_name[ 72 ];
+    /**
+     *  @param  disk            The disk under test                         */
+    struct  disk_t              disk;
+    /**
+     *  @param  copy            A private overlay                           */
+    struct  disk_t              copy;
+    /**
+     *  @param  copy_fd         Its memory file                             */
+    int                         copy_fd;
+    /**
+     *  @param  async           The I/O thread                              */
+    struct  disk_async_t    *   async;
+    /**
+     *  @param  base_fd         Reads the base behind the disk's back       */
+    int                         base_fd;
+    /**
+     *  @param  data            One sector                                  */
+    uint8_t                     data[ DISK_SECTOR_SIZE ];
+    /**
+     *  @param  post_rc         TRUE while the test passes                  */
+    int                         post_rc;
+
+    base_fd = post_image( base_name );
+    if ( base_fd < 0 )
+    {
+        printf( "POST: DISK could not create a test image\n" );
+        return( false );
+    }
+    snprintf( file_name, sizeof( file_name ), "%s.ovl", base_name );
+
+    post_rc = disk_overlay_create( file_name, base_name );
+    disk_init( &disk );
+    post_rc &= disk_open( &disk, file_name );
+    post_rc &= ( disk.overlay != NULL );
+    post_rc &= ( disk.size == POST_SECTORS * DISK_SECTOR_SIZE );
+
+    //  Nothing written: the base
+    post_rc &= ( disk_read( &disk, 5, 0x1000 ) == 0 );
+    post_rc &= ( memory_get_8( 0x1000 ) == 5 ) && ( memory_get_8( 0x107F ) == 5 );
+
+    //  A sector and one byte of another go to the overlay only
+    memory_put_8( 0x1000, 0xAA );
+    post_rc &= ( disk_write( &disk, 7, 0x1000 ) == 0 );
+    data[ 0 ] = 0x77;
+    post_rc &= ( disk_write_data( &disk, 9 * DISK_SECTOR_SIZE + 4, data, 1 ) == 0 );
+    post_rc &= ( disk_read_data( &disk, 9 * DISK_SECTOR_SIZE, data, sizeof( data ) ) == 0 );
+    post_rc &= ( data[ 0 ] == 9 ) && ( data[ 4 ] == 0x77 );
+    post_rc &= ( disk_overlay_count( &disk ) == 2 );
+    post_rc &= ( pread( base_fd, data, sizeof( data ), 7 * DISK_SECTOR_SIZE ) == sizeof( data ) );
+    post_rc &= ( data[ 0 ] == 7 );
+
+    //  The file's bitmap only claims the sectors once they are flushed
+    post_rc &= ( ( disk.overlay->file_bitmap[ 0 ] & 0x80 ) == 0 );
+    disk_flush( &disk );
+    post_rc &= ( ( disk.overlay->file_bitmap[ 0 ] & 0x80 ) != 0 );
+    post_rc &= ( ( disk.overlay->file_bitmap[ 1 ] & 0x02 ) != 0 );
+
+    //  An overlay does not grow
+    post_rc &= ( disk_write( &disk, POST_SECTORS, 0x1000 ) == 1 );
+
+    //  It is all there when opened again
+    disk_close( &disk );
+    post_rc &= disk_open( &disk, file_name );
+    post_rc &= ( disk_overlay_count( &disk ) == 2 );
+    post_rc &= ( disk_read( &disk, 7, 0x2000 ) == 0 );
+    post_rc &= ( memory_get_8( 0x2000 ) == 0xAA ) && ( memory_get_8( 0x2001 ) == 5 );
+
+    //  The I/O thread writes at the overlay's origin
+    async = disk_async_create( DISK_SYNC_DATA );
+    memset( data, 0x3C, sizeof( data ) );
+    post_rc &= ( disk_async_write( async, &disk, 3 * DISK_SECTOR_SIZE, data, sizeof( data ) ) == 0 );
+    memset( data, 0, sizeof( data ) );
+    post_rc &= ( disk_async_read( async, &disk, 3 * DISK_SECTOR_SIZE, data, sizeof( data ) ) == 0 );
+    post_rc &= ( data[ 0 ] == 0x3C );
+    post_rc &= ( disk_async_barrier( async ) == 0 );
+    disk_async_destroy( async );
+    post_rc &= ( disk_read( &disk, 3, 0x2000 ) == 0 );
+    post_rc &= ( memory_get_8( 0x2000 ) == 0x3C );
+
+    //  A private overlay has the same sectors, its writes stay in memory
+    copy_fd = disk_overlay_private( &disk, file_name );
+    disk_init( &copy );
+    post_rc &= ( copy_fd >= 0 ) && disk_attach( &copy, copy_fd );
+    post_rc &= ( disk_overlay_count( &copy ) == disk_overlay_count( &disk ) );
+    post_rc &= ( disk_read( &copy, 3, 0x2000 ) == 0 );
+    post_rc &= ( memory_get_8( 0x2000 ) == 0x3C );
+    memory_put_8( 0x2000, 0x5A );
+    post_rc &= ( disk_write( &copy, 3, 0x2000 ) == 0 );
+    disk_close( &copy );
+    post_rc &= ( disk_read( &disk, 3, 0x2000 ) == 0 );
+    post_rc &= ( memory_get_8( 0x2000 ) == 0x3C );
+
+    //  A plain image becomes the base of an empty private overlay
+    disk_init( &copy );
+    post_rc &= disk_open( &copy, base_name );
+    copy_fd = disk_overlay_private( &copy, base_name );
+    disk_close( &copy );
+    post_rc &= ( copy_fd >= 0 ) && disk_attach( &copy, copy_fd );
+    post_rc &= ( disk_overlay_count( &copy ) == 0 );
+    post_rc &= ( disk_write( &copy, 5, 0x2000 ) == 0 );
+    disk_close( &copy );
+    post_rc &= ( pread( base_fd, data, sizeof( data ), 5 * DISK_SECTOR_SIZE ) == sizeof( data ) );
+    post_rc &= ( data[ 0 ] == 5 );
+
+    //  DISCARD: the base again
+    disk_overlay_discard( &disk );
+    post_rc &= ( disk_overlay_count( &disk ) == 0 );
+    post_rc &= ( disk_read( &disk, 7, 0x2000 ) == 0 );
+    post_rc &= ( memory_get_8( 0x2000 ) == 7 );
+
+    //  COMMIT: into the base
+    post_rc &= ( disk_write( &disk, 7, 0x1000 ) == 0 );
+    disk_flush( &disk );
+    post_rc &= disk_overlay_commit( &disk );
+    post_rc &= ( disk_overlay_count( &disk ) == 0 );
+    post_rc &= ( pread( base_fd, data, sizeof( data ), 7 * DISK_SECTOR_SIZE ) == sizeof( data ) );
+    post_rc &= ( data[ 0 ] == 0xAA ) && ( data[ 1 ] == 5 );
+    post_rc &= ( pread( base_fd, data, sizeof( data ), 9 * DISK_SECTOR_SIZE ) == sizeof( data ) );
+    post_rc &= ( data[ 4 ] == 9 );
+
+    disk_close( &disk );
+    close( base_fd );
+    unlink( file_name );
+    unlink( base_name );
+
+    //  Did it pass ?
+    if ( post_rc == false )
+    {
+        //  NO:     Write an error message
+        printf( "POST: DISK copy-on-write overlay failed\n" );
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Disk image Power On Self Test
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+int
+disk_post(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                 */
+    int                         post_rc;
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    //  Assume the test is going to pass
+    post_rc = true;
+
+    /************************************************************************
+     *  POST Code
+     ************************************************************************/
+
+    if ( post_rc == true )      post_rc = tc_disk_00( );        //  Mapped sectors
+    if ( post_rc == true )      post_rc = tc_disk_01( );        //  Track cache
+    if ( post_rc == true )      post_rc = tc_disk_02( );        //  Write-behind
+    if ( post_rc == true )      post_rc = tc_disk_03( );        //  io_uring
+    if ( post_rc == true )      post_rc = tc_disk_04( );        //  Overlays
+
+    //  Was the test suite successfully complete :
+    if( post_rc == true )
+    {
+        //  YES:    Write a completion message
+        printf( "POST: DISK    complete\n" );
+    }
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    //  DONE!
+    return( post_rc );
+}
+/****************************************************************************/
@@ -0,0 +1,659 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  A minimal io_uring for the disk images.
+ *
+ *  Only what the write-behind I/O thread needs: writes from registered
+ *  buffers, an ordered fsync( ), and one system call that submits a batch
+ *  and waits for all of it.  The rings are set up with the raw system
+ *  calls, there is no liburing.
+ *
+ *  The user data of an entry is its index in ops, which keeps what was
+ *  asked for.  A short write is legal: like the pwrite( ) loop the rest
+ *  is submitted again at the advanced offset, and the syncs of the batch
+ *  run again after it.  Only an error, or a write of nothing, fails.
+ *
+ *  disk_uring_create( ) returns NULL when the kernel has no io_uring, or
+ *  a sandbox does not allow it, and the caller uses pwrite( ) instead.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+#define _DEFAULT_SOURCE         //  syscall( ), MAP_POPULATE
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <unistd.h>             //  UNIX standard library.
+#include <string.h>             //  Functions for managing strings
+#include <errno.h>              //  EINTR
+#include <stdatomic.h>          //  Ring head and tail
+#include <sys/mman.h>           //  mmap( )
+#include <sys/syscall.h>        //  __NR_io_uring_xxx
+                                //*******************************************
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "disk_uring.h"         //  io_uring for the disk images
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  RING_LOAD           Read an index the kernel writes
+ *  @param  RING_STORE          Write an index the kernel reads             */
+#define RING_LOAD( P )          atomic_load_explicit( (_Atomic unsigned *)( P ),     \
+                                                      memory_order_acquire )
+#define RING_STORE( P, V )      atomic_store_explicit( (_Atomic unsigned *)( P ), ( V ), \
+                                                       memory_order_release )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Get the next free submission queue entry.
+ *
+ *  @param  uring               The io_uring.
+ *
+ *  @return                     The cleared entry, NULL when the queue is
+ *                              full.
+ *
+ *  @note
+ *      The entry is queued by disk_uring_queue( ).
+ *
+ ****************************************************************************/
+
+static
+struct  io_uring_sqe *
+disk_uring_sqe(
+    struct  disk_uring_t    *   uring
+    )
+{
+    /**
+     *  @param  tail            Next entry                                  */
+    unsigned                    tail;
+    /**
+     *  @param  sqe             The entry                                   */
+    struct  io_uring_sqe    *   sqe;
+
+    tail = *uring->sq_tail;
+
+    //  Is the queue full ?
+    if ( ( tail - RING_LOAD( uring->sq_head ) ) >= uring->entries )
+    {
+        //  YES:    Submit first
+        return( NULL );
+    }
+
+    sqe = &uring->sqes[ tail & *uring->sq_mask ];
+    memset( sqe, 0, sizeof( struct io_uring_sqe ) );
+
+    //  DONE!
+    return( sqe );
+}
+
+/****************************************************************************/
+/**
+ *  Queue the entry filled in after disk_uring_sqe( ).
+ *
+ *  @param  uring               The io_uring.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+disk_uring_queue(
+    struct  disk_uring_t    *   uring
+    )
+{
+    /**
+     *  @param  tail            The entry                                   */
+    unsigned                    tail;
+
+    tail = *uring->sq_tail;
+    uring->sq_array[ tail & *uring->sq_mask ] = tail & *uring->sq_mask;
+    RING_STORE( uring->sq_tail, tail + 1 );
+}
+
+/****************************************************************************/
+/**
+ *  Queue an entry of the batch.
+ *
+ *  @param  uring               The io_uring.
+ *  @param  ndx                 Index of the entry in ops.
+ *
+ *  @return                     FALSE when the queue is full.
+ *
+ *  @note
+ *      A sync starts after everything queued before it has completed.
+ *
+ ****************************************************************************/
+
+static
+bool
+disk_uring_start(
+    struct  disk_uring_t    *   uring,
+    unsigned                    ndx
+    )
+{
+    /**
+     *  @param  op              The entry                                   */
+    struct  disk_uring_op_t *   op;
+    /**
+     *  @param  sqe             Where it is queued                          */
+    struct  io_uring_sqe    *   sqe;
+
+    sqe = disk_uring_sqe( uring );
+    if ( sqe == NULL )
+    {
+        return( false );
+    }
+
+    op = &uring->ops[ ndx ];
+    sqe->opcode    = op->opcode;
+    sqe->fd        = op->fd;
+    sqe->user_data = ndx;
+
+    //  Is it a sync ?
+    if ( op->opcode == IORING_OP_FSYNC )
+    {
+        //  YES:    After the writes
+        sqe->flags       = IOSQE_IO_DRAIN;
+        sqe->fsync_flags = op->fsync_flags;
+    }
+    else
+    {
+        //  NO:     A write
+        sqe->addr      = op->addr;
+        sqe->len       = op->len;
+        sqe->off       = op->off;
+        sqe->buf_index = ( op->buffer >= 0 ) ? (uint16_t)op->buffer : 0;
+    }
+    disk_uring_queue( uring );
+
+    //  DONE!
+    return( true );
+}
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Set up an io_uring and register its buffers.
+ *
+ *  @param  entries             Entries in the submission queue.
+ *  @param  buffers             Buffers to register, writes name them by
+ *                              their index.
+ *  @param  count               Number of buffers.
+ *
+ *  @return                     The io_uring, NULL when there is none.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+struct  disk_uring_t *
+disk_uring_create(
+    unsigned                    entries,
+    const
+    struct  iovec           *   buffers,
+    unsigned                    count
+    )
+{
+    /**
+     *  @param  uring           The new io_uring                            */
+    struct  disk_uring_t    *   uring;
+    /**
+     *  @param  params          What the kernel set up                      */
+    struct  io_uring_params     params;
+    /**
+     *  @param  sq              Start of the submission ring                */
+    uint8_t                 *   sq;
+    /**
+     *  @param  cq              Start of the completion ring                */
+    uint8_t                 *   cq;
+
+    uring = calloc( 1, sizeof( struct disk_uring_t ) );
+    if ( uring == NULL )
+    {
+        return( NULL );
+    }
+
+    memset( &params, 0, sizeof( params ) );
+    uring->fd = (int)syscall( __NR_io_uring_setup, entries, &params );
+    if ( uring->fd < 0 )
+    {
+        //  No io_uring here
+        free( uring );
+        return( NULL );
+    }
+    uring->entries = params.sq_entries;
+
+    //  One record per entry of a batch
+    uring->ops = calloc( uring->entries, sizeof( struct disk_uring_op_t ) );
+    if ( uring->ops == NULL )
+    {
+        close( uring->fd );
+        free( uring );
+        return( NULL );
+    }
+
+    //  Map the rings, one mapping when the kernel allows it
+    uring->sq_ring_size = params.sq_off.array + ( params.sq_entries * sizeof( unsigned ) );
+    uring->cq_ring_size = params.cq_off.cqes  + ( params.cq_entries * sizeof( struct io_uring_cqe ) );
+    if ( ( params.features & IORING_FEAT_SINGLE_MMAP ) != 0 )
+    {
+        if ( uring->cq_ring_size > uring->sq_ring_size )
+            uring->sq_ring_size = uring->cq_ring_size;
+        uring->cq_ring_size = 0;
+    }
+    uring->sq_ring = mmap( NULL, uring->sq_ring_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING );
+    uring->cq_ring = uring->sq_ring;
+    if ( ( uring->sq_ring != MAP_FAILED ) && ( uring->cq_ring_size != 0 ) )
+    {
+        uring->cq_ring = mmap( NULL, uring->cq_ring_size, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_CQ_RING );
+    }
+    uring->sqes_size = params.sq_entries * sizeof( struct io_uring_sqe );
+    uring->sqes = mmap( NULL, uring->sqes_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES );
+    if (    ( uring->sq_ring == MAP_FAILED )
+         || ( uring->cq_ring == MAP_FAILED )
+         || ( uring->sqes    == MAP_FAILED ) )
+    {
+        disk_uring_destroy( uring );
+        return( NULL );
+    }
+
+    sq = uring->sq_ring;
+    uring->sq_head  = (unsigned *)( sq + params.sq_off.head );
+    uring->sq_tail  = (unsigned *)( sq + params.sq_off.tail );
+    uring->sq_mask  = (unsigned *)( sq + params.sq_off.ring_mask );
+    uring->sq_array = (unsigned *)( sq + params.sq_off.array );
+
+    cq = uring->cq_ring;
+    uring->cq_head  = (unsigned *)( cq + params.cq_off.head );
+    uring->cq_tail  = (unsigned *)( cq + params.cq_off.tail );
+    uring->cq_mask  = (unsigned *)( cq + params.cq_off.ring_mask );
+    uring->cqes     = (struct io_uring_cqe *)( cq + params.cq_off.cqes );
+
+    //  Register the buffers, was it allowed ?
+    if (    ( count > 0 )
+         && ( syscall( __NR_io_uring_register, uring->fd,
+                       IORING_REGISTER_BUFFERS, buffers, count ) != 0 ) )
+    {
+        //  NO:     Locked memory is limited, use pwrite( )
+        disk_uring_destroy( uring );
+        return( NULL );
+    }
+    uring->fixed = ( count > 0 );
+
+    //  DONE!
+    return( uring );
+}
+
+/****************************************************************************/
+/**
+ *  Tear down an io_uring.
+ *
+ *  @param  uring               The io_uring, may be NULL.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Nothing may be in flight.
+ *
+ ****************************************************************************/
+
+void
+disk_uring_destroy(
+    struct  disk_uring_t    *   uring
+    )
+{
+    //  Was it created ?
+    if ( uring == NULL )
+    {
+        //  NO:     Nothing to do
+        return;
+    }
+
+    if ( ( uring->sqes != NULL ) && ( uring->sqes != MAP_FAILED ) )
+        munmap( uring->sqes, uring->sqes_size );
+    if (    ( uring->cq_ring != NULL ) && ( uring->cq_ring != MAP_FAILED )
+         && ( uring->cq_ring != uring->sq_ring ) )
+        munmap( uring->cq_ring, uring->cq_ring_size );
+    if ( ( uring->sq_ring != NULL ) && ( uring->sq_ring != MAP_FAILED ) )
+        munmap( uring->sq_ring, uring->sq_ring_size );
+    close( uring->fd );
+    free( uring->ops );
+    free( uring );
+}
+
+/****************************************************************************/
+/**
+ *  Queue a write.
+ *
+ *  @param  uring               The io_uring.
+ *  @param  fd                  The image.
+ *  @param  data_p              The bytes.
+ *  @param  length              Number of bytes.
+ *  @param  offset              Offset in the image.
+ *  @param  buffer              Index of the registered buffer holding the
+ *                              bytes, -1 when they are not in one.
+ *
+ *  @return                     FALSE when the queue is full.
+ *
+ *  @note
+ *      Writes of one batch may run in any order.
+ *
+ ****************************************************************************/
+
+bool
+disk_uring_write(
+    struct  disk_uring_t    *   uring,
+    int                         fd,
+    const
+    void                    *   data_p,
+    size_t                      length,
+    size_t                      offset,
+    int                         buffer
+    )
+{
+    /**
+     *  @param  op              The entry                                   */
+    struct  disk_uring_op_t *   op;
+
+    //  Is the batch full ?
+    if ( uring->prepared >= uring->entries )
+    {
+        //  YES:    Submit first
+        return( false );
+    }
+
+    op = &uring->ops[ uring->prepared ];
+
+    //  Is it in a registered buffer ?
+    if ( ( uring->fixed == true ) && ( buffer >= 0 ) )
+    {
+        //  YES:    The kernel need not map it
+        op->opcode = IORING_OP_WRITE_FIXED;
+        op->buffer = buffer;
+    }
+    else
+    {
+        op->opcode = IORING_OP_WRITE;
+        op->buffer = -1;
+    }
+    op->fd   = fd;
+    op->addr = (uint64_t)(uintptr_t)data_p;
+    op->len  = (uint32_t)length;
+    op->off  = (uint64_t)offset;
+    if ( disk_uring_start( uring, uring->prepared ) == false )
+    {
+        return( false );
+    }
+    uring->prepared += 1;
+
+    //  DONE!
+    return( true );
+}
+
+/****************************************************************************/
+/**
+ *  Queue a sync of an image.
+ *
+ *  @param  uring               The io_uring.
+ *  @param  fd                  The image.
+ *  @param  data_only           TRUE for fdatasync( ), FALSE for fsync( ).
+ *
+ *  @return                     FALSE when the queue is full.
+ *
+ *  @note
+ *      Starts after everything queued before it has completed.
+ *
+ ****************************************************************************/
+
+bool
+disk_uring_sync(
+    struct  disk_uring_t    *   uring,
+    int                         fd,
+    bool                        data_only
+    )
+{
+    /**
+     *  @param  op              The entry                                   */
+    struct  disk_uring_op_t *   op;
+
+    //  Is the batch full ?
+    if ( uring->prepared >= uring->entries )
+    {
+        //  YES:    Submit first
+        return( false );
+    }
+
+    op = &uring->ops[ uring->prepared ];
+    op->opcode      = IORING_OP_FSYNC;
+    op->fd          = fd;
+    op->buffer      = -1;
+    op->fsync_flags = ( data_only == true ) ? IORING_FSYNC_DATASYNC : 0;
+    if ( disk_uring_start( uring, uring->prepared ) == false )
+    {
+        return( false );
+    }
+    uring->prepared += 1;
+
+    //  DONE!
+    return( true );
+}
+
+/****************************************************************************/
+/**
+ *  Submit what is queued and wait until all of it has completed.
+ *
+ *  @param  uring               The io_uring.
+ *
+ *  @return                     Number of entries that failed, -1 when the
+ *                              ring can't be used anymore.
+ *
+ *  @note
+ *      One system call for the whole batch unless a signal interrupts it
+ *      or a write is short.  The rest of a short write is submitted again
+ *      and, once it is written, every sync of the batch.  When
+ *      io_uring_enter( ) fails what was submitted is waited for, the rest
+ *      is left in the queue.  The caller must destroy the ring then and
+ *      run the batch again without it.
+ *
+ ****************************************************************************/
+
+int
+disk_uring_wait(
+    struct  disk_uring_t    *   uring
+    )
+{
+    /**
+     *  @param  batch           Entries of the batch                        */
+    unsigned                    batch;
+    /**
+     *  @param  submit          Entries not submitted yet                   */
+    unsigned                    submit;
+    /**
+     *  @param  waiting         Entries not completed yet                   */
+    unsigned                    waiting;
+    /**
+     *  @param  head            Next completion                             */
+    unsigned                    head;
+    /**
+     *  @param  ndx             Entry of the batch                          */
+    unsigned                    ndx;
+    /**
+     *  @param  cqe             The completion                              */
+    struct  io_uring_cqe    *   cqe;
+    /**
+     *  @param  op              The entry that completed                    */
+    struct  disk_uring_op_t *   op;
+    /**
+     *  @param  failed          Entries that failed                         */
+    int                         failed;
+    /**
+     *  @param  rc              System call return code                     */
+    long                        rc;
+    /**
+     *  @param  broken          io_uring_enter( ) failed                    */
+    bool                        broken;
+    /**
+     *  @param  short_write     A write was short, its sync may be early    */
+    bool                        short_write;
+
+    batch   = uring->prepared;
+    submit  = uring->prepared;
+    waiting = uring->prepared;
+    uring->prepared = 0;
+    failed  = 0;
+    broken  = false;
+    short_write = false;
+
+    while ( waiting > 0 )
+    {
+        //  Submit the rest and wait for the rest
+        rc = syscall( __NR_io_uring_enter, uring->fd, submit, waiting,
+                      IORING_ENTER_GETEVENTS, NULL, 0 );
+        if ( rc < 0 )
+        {
+            if ( errno == EINTR )
+            {
+                continue;
+            }
+
+            //  Was everything submitted already ?
+            if ( ( broken == true ) || ( waiting == submit ) )
+            {
+                //  YES:    Nothing more will complete
+                return( -1 );
+            }
+
+            //  NO:     Only wait for what the kernel has, it still uses the
+            //          buffers
+            broken   = true;
+            waiting -= submit;
+            submit   = 0;
+            continue;
+        }
+        submit -= ( (unsigned)rc < submit ) ? (unsigned)rc : submit;
+
+        //  Reap what completed
+        for( head = *uring->cq_head;
+             head != RING_LOAD( uring->cq_tail );
+             head += 1 )
+        {
+            cqe = &uring->cqes[ head & *uring->cq_mask ];
+            op  = &uring->ops[ cqe->user_data ];
+
+            //  Is it a write that is not done yet ?
+            if (    ( op->opcode != IORING_OP_FSYNC )
+                 && (    ( ( cqe->res > 0 ) && ( (uint32_t)cqe->res < op->len ) )
+                      || ( cqe->res == -EINTR ) || ( cqe->res == -EAGAIN ) ) )
+            {
+                //  YES:    Submit the rest again
+                if ( cqe->res > 0 )
+                {
+                    op->addr += (uint32_t)cqe->res;
+                    op->off  += (uint32_t)cqe->res;
+                    op->len  -= (uint32_t)cqe->res;
+                    short_write = true;
+                }
+                if (    ( broken == false )
+                     && ( disk_uring_start( uring, (unsigned)cqe->user_data ) == true ) )
+                {
+                    submit += 1;
+                    continue;
+                }
+                failed += 1;
+            }
+            else
+            if ( cqe->res != ( ( op->opcode == IORING_OP_FSYNC ) ? 0 : (int32_t)op->len ) )
+            {
+                //  An error, or nothing was written
+                failed += 1;
+            }
+            if ( waiting > 0 )
+            {
+                waiting -= 1;
+            }
+        }
+        RING_STORE( uring->cq_head, head );
+
+        //  Are the rests of short writes written ?
+        if ( ( waiting == 0 ) && ( short_write == true ) && ( broken == false ) )
+        {
+            //  YES:    A sync that ran before them has to run again
+            short_write = false;
+            for( ndx = 0; ndx < batch; ndx += 1 )
+            {
+                if (    ( uring->ops[ ndx ].opcode == IORING_OP_FSYNC )
+                     && ( disk_uring_start( uring, ndx ) == true ) )
+                {
+                    submit  += 1;
+                    waiting += 1;
+                }
+            }
+        }
+    }
+
+    //  DONE!
+    return( ( broken == true ) ? -1 : failed );
+}
+
+/****************************************************************************/
@@ -0,0 +1,190 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+#ifndef DISK_URING_H
+#define DISK_URING_H
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  A minimal io_uring for the disk images.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * System APIs
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdint.h>             //  Alternative storage types
+#include <sys/uio.h>            //  struct iovec
+#include <linux/io_uring.h>     //  The io_uring ABI
+                                //*******************************************
+
+/****************************************************************************
+ * Application APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  disk_uring_op_t     An entry of the batch, kept until it has
+ *                              completed so the rest of a short write can
+ *                              be submitted again                          */
+struct  disk_uring_op_t
+{
+    /**
+     *  @param  opcode          IORING_OP_xxx                               */
+    uint8_t                     opcode;
+    /**
+     *  @param  fd              The image                                   */
+    int                         fd;
+    /**
+     *  @param  buffer          Registered buffer, -1 when there is none    */
+    int                         buffer;
+    /**
+     *  @param  fsync_flags     IORING_FSYNC_xxx of a sync                  */
+    uint32_t                    fsync_flags;
+    /**
+     *  @param  addr            Bytes not written yet                       */
+    uint64_t                    addr;
+    /**
+     *  @param  len             Number of them                              */
+    uint32_t                    len;
+    /**
+     *  @param  off             Where they go in the image                  */
+    uint64_t                    off;
+};
+//----------------------------------------------------------------------------
+/**
+ *  @param  disk_uring_t        An io_uring and its mapped rings            */
+struct  disk_uring_t
+{
+    /**
+     *  @param  fd              The io_uring                                */
+    int                         fd;
+    /**
+     *  @param  entries         Submission queue entries                    */
+    unsigned                    entries;
+    /**
+     *  @param  sq_ring         Mapped submission ring                      */
+    void                    *   sq_ring;
+    size_t                      sq_ring_size;
+    /**
+     *  @param  cq_ring         Mapped completion ring, may be sq_ring      */
+    void                    *   cq_ring;
+    size_t                      cq_ring_size;
+    /**
+     *  @param  sqes            Mapped submission queue entries             */
+    struct  io_uring_sqe    *   sqes;
+    size_t                      sqes_size;
+    /**
+     *  @param  sq_xxx          Fields of the submission ring               */
+    unsigned                *   sq_head;
+    unsigned                *   sq_tail;
+    unsigned                *   sq_mask;
+    unsigned                *   sq_array;
+    /**
+     *  @param  cq_xxx          Fields of the completion ring               */
+    unsigned                *   cq_head;
+    unsigned                *   cq_tail;
+    unsigned                *   cq_mask;
+    struct  io_uring_cqe    *   cqes;
+    /**
+     *  @param  ops             The entries of the batch, user data of an
+     *                          entry is its index                          */
+    struct  disk_uring_op_t *   ops;
+    /**
+     *  @param  prepared        Entries not submitted yet                   */
+    unsigned                    prepared;
+    /**
+     *  @param  fixed           Buffers are registered                      */
+    bool                        fixed;
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Prototypes
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+struct  disk_uring_t *
+disk_uring_create(
+    unsigned                    entries,
+    const
+    struct  iovec           *   buffers,
+    unsigned                    count
+    );
+//----------------------------------------------------------------------------
+void
+disk_uring_destroy(
+    struct  disk_uring_t    *   uring
+    );
+//----------------------------------------------------------------------------
+bool
+disk_uring_write(
+    struct  disk_uring_t    *   uring,
+    int                         fd,
+    const
+    void                    *   data_p,
+    size_t                      length,
+    size_t                      offset,
+    int                         buffer
+    );
+//----------------------------------------------------------------------------
+bool
+disk_uring_sync(
+    struct  disk_uring_t    *   uring,
+    int                         fd,
+    bool                        data_only
+    );
+//----------------------------------------------------------------------------
+int
+disk_uring_wait(
+    struct  disk_uring_t    *   uring
+    );
+//----------------------------------------------------------------------------
+
+/****************************************************************************/
+
+#endif                      //    DISK_URING_H
@@ -39,6 +39,7 @@
 #include "memory.h"             //  Memory management and access
 #include "registers.h"          //  All things CPU registers.
 #include "exchange.h"           //  EX   *,*
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -115,7 +116,7 @@ ex_dehl_i80(
     CPU_REG_DE = tmp;
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -161,7 +162,7 @@ ex_sphl_i80(
     memory_put_8( ( CPU_REG_SP + 1 ), ( tmp & 0xFF00 ) >> 8 );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  19;
+    machine->operation_rc.states =  19;
 }
 
 /****************************************************************************/
@@ -189,6 +190,9 @@ ex_afaf_z80(
      *  @param  tmp                 Temporary register holding buffers      */
     uint16_t                    tmp_AF;
 
+    //  Bring F up to date before it is swapped out
+    FLAGS_SYNC( );
+
     //  Temporary register holding place
     tmp_AF = CPU_REG_AF;
 
@@ -197,7 +201,7 @@ ex_afaf_z80(
     CPU_REG_AF_ = tmp_AF;
 
     //  Set the number of states for this instruction
-    operation_rc.states =  4;
+    machine->operation_rc.states =  4;
 }
 
 /****************************************************************************/
@@ -241,6 +245,6 @@ ex_exx_z80(
     CPU_REG_HL_ = tmp_HL;
 
     //  Set the number of states for this instruction
-    operation_rc.states =  4;
+    machine->operation_rc.states =  4;
 }
 /****************************************************************************/
\ No newline at end of file
@@ -0,0 +1,505 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Precomputed condition flag tables.
+ *
+ *  Every flag an 8 bit ALU operation can produce depends only on its
+ *  operands, the incoming carry and the CPU mode, so the flags are worked
+ *  out once by flags_init( ) and looked up afterwards:
+ *
+ *      flags_szp   S, Z and P/V ( even parity ) of a result
+ *      flags_add   ADD and ADC, indexed by carry and both operands
+ *      flags_sub   SUB, SBC and CP, indexed the same way
+ *      flags_inc   INC by operand, C is not affected
+ *      flags_dec   DEC by operand, C is not affected
+ *      flags_daa   The adjusted Accumulator and flags of DAA by A, N, C, H
+ *
+ *  The 8080 row of the arithmetic tables sets P/V from the parity of the
+ *  result, the Z80 row from the overflow.  The tables reproduce exactly
+ *  what the helpers in math.c and logic.c set when they computed the flags
+ *  bit by bit.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <stdio.h>              //  Standard I/O definitions
+                                //*******************************************
+
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "registers.h"          //  All things CPU registers.
+#include "flags.h"              //  Precomputed condition flag tables
+#include "machine.h"            //  Guest machine context
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  DAA_RULES           Number of Z80 DAA adjustment rules          */
+#define DAA_RULES               ( 13 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  daa_rule_t          One line of the Z80 DAA table               */
+struct  daa_rule_t
+{
+    /**
+     *  @param  n               N flag                                      */
+    uint8_t                     n;
+    /**
+     *  @param  c               Carry flag (in)                             */
+    uint8_t                     c;
+    /**
+     *  @param  high_min        Lowest value of bits 7-4                    */
+    uint8_t                     high_min;
+    /**
+     *  @param  high_max        Highest value of bits 7-4                   */
+    uint8_t                     high_max;
+    /**
+     *  @param  h               Half carry flag                             */
+    uint8_t                     h;
+    /**
+     *  @param  low_min         Lowest value of bits 3-0                    */
+    uint8_t                     low_min;
+    /**
+     *  @param  low_max         Highest value of bits 3-0                   */
+    uint8_t                     low_max;
+    /**
+     *  @param  add             Value added to A                            */
+    uint8_t                     add;
+    /**
+     *  @param  carry           Carry flag (out)                            */
+    uint8_t                     carry;
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  flags_szp           S, Z and even parity of a result            */
+uint8_t                         flags_szp[ 0x100 ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  flags_add           ADD / ADC flags by FLAGS_INDEX( )           */
+uint8_t                         flags_add[ 2 ][ 0x20000 ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  flags_sub           SUB / SBC / CP flags by FLAGS_INDEX( )      */
+uint8_t                         flags_sub[ 2 ][ 0x20000 ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  flags_inc           INC flags ( except C ) by operand           */
+uint8_t                         flags_inc[ 2 ][ 0x100 ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  flags_dec           DEC flags ( except C ) by operand           */
+uint8_t                         flags_dec[ 2 ][ 0x100 ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  flags_daa           DAA by FLAGS_DAA_INDEX( )                   */
+struct  flags_daa_t             flags_daa[ 2 ][ 0x800 ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  daa_rule            The Z80 DAA table ( see math_daa_z80( ) )   */
+static
+const
+struct  daa_rule_t              daa_rule[ DAA_RULES ] =
+{
+    //  N   C   7-4         H   3-0         ADD     C
+    {   0,  0,  0x0, 0x9,   0,  0x0, 0x9,   0x00,   0   },  //  01
+    {   0,  0,  0x0, 0x8,   0,  0xA, 0xF,   0x06,   0   },  //  02
+    {   0,  0,  0x0, 0x9,   1,  0x0, 0x3,   0x06,   0   },  //  03
+    {   0,  0,  0xA, 0xF,   0,  0x0, 0x9,   0x60,   1   },  //  04
+    {   0,  0,  0x9, 0xF,   0,  0xA, 0xF,   0x66,   1   },  //  05
+    {   0,  0,  0xA, 0xF,   1,  0x0, 0x3,   0x66,   1   },  //  06
+    {   0,  1,  0x0, 0x2,   0,  0x0, 0x9,   0x60,   1   },  //  07
+    {   0,  1,  0x0, 0x2,   0,  0xA, 0xF,   0x66,   1   },  //  08
+    {   0,  1,  0x0, 0x3,   1,  0x0, 0x3,   0x66,   1   },  //  09
+    {   1,  0,  0x0, 0x9,   0,  0x0, 0x9,   0x00,   0   },  //  10
+    {   1,  0,  0x0, 0x8,   1,  0x6, 0xF,   0xFA,   0   },  //  11
+    {   1,  1,  0x7, 0xF,   0,  0x0, 0x9,   0xA0,   1   },  //  12
+    {   1,  1,  0x6, 0xF,   1,  0x6, 0xF,   0x9A,   1   }   //  13
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Build the S, Z and parity table.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      P/V is set for an even number of one bits.
+ *
+ ****************************************************************************/
+
+static
+void
+flags_init_szp(
+    void
+    )
+{
+    /**
+     *  @param  value           The result                                  */
+    int                         value;
+    /**
+     *  @param  bits            One bits left in the result                 */
+    int                         bits;
+    /**
+     *  @param  flags           The flags for the result                    */
+    uint8_t                     flags;
+
+    for( value = 0; value < 0x100; value += 1 )
+    {
+        flags = CPU_FLAG_PV;
+        for( bits = value; bits != 0; bits &= bits - 1 )
+            flags ^= CPU_FLAG_PV;
+
+        if ( value == 0x00 )
+            flags |= CPU_FLAG_Z;
+        if ( ( value & 0x80 ) == 0x80 )
+            flags |= CPU_FLAG_S;
+
+        flags_szp[ value ] = flags;
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Build the add and subtract tables.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+flags_init_add_sub(
+    void
+    )
+{
+    /**
+     *  @param  mode            FLAGS_MODE( )                               */
+    int                         mode;
+    /**
+     *  @param  carry           Carry or borrow in                          */
+    uint16_t                    carry;
+    /**
+     *  @param  operand_1       Augend or minuend                           */
+    uint16_t                    operand_1;
+    /**
+     *  @param  operand_2       Addend or subtrahend                        */
+    uint16_t                    operand_2;
+    /**
+     *  @param  result          Sum or difference                           */
+    uint16_t                    result;
+    /**
+     *  @param  flags           The flags for the operation                 */
+    uint8_t                     flags;
+    /**
+     *  @param  half            Half carry sum or difference                */
+    uint8_t                     half;
+
+    for( mode = 0; mode < 2; mode += 1 )
+    for( carry = 0; carry < 2; carry += 1 )
+    for( operand_1 = 0; operand_1 < 0x100; operand_1 += 1 )
+    for( operand_2 = 0; operand_2 < 0x100; operand_2 += 1 )
+    {
+        /********************************************************************
+         *  ADD / ADC
+         ********************************************************************/
+
+        result = operand_1 + operand_2 + carry;
+        flags  = flags_szp[ result & 0x00FF ];
+
+        //  Z80:    PARITY/OVERFLOW
+        if ( mode == 1 )
+        {
+            flags &= ~CPU_FLAG_PV;
+            if (    ( ( operand_1 & 0x80 ) == ( operand_2 & 0x80 ) )
+                 && (      result & 0x80 ) != ( operand_1 & 0x80 ) )
+                flags |= CPU_FLAG_PV;
+        }
+
+        //  HALF CARRY
+        half = ( ( operand_1 & 0x0F ) + ( operand_2 & 0x0F ) + carry );
+        if ( ( half & 0x10 ) == 0x10 )
+            flags |= CPU_FLAG_H;
+
+        //  Carry
+        if ( ( result & 0x0100 ) == 0x0100 )
+            flags |= CPU_FLAG_C;
+
+        flags_add[ mode ][ FLAGS_INDEX( carry, operand_1, operand_2 ) ] = flags;
+
+        /********************************************************************
+         *  SUB / SBC / CP
+         ********************************************************************/
+
+        result = operand_1 - operand_2 - carry;
+        flags  = flags_szp[ result & 0x00FF ] | CPU_FLAG_N;
+
+        //  Z80:    PARITY/OVERFLOW
+        if ( mode == 1 )
+        {
+            flags &= ~CPU_FLAG_PV;
+            if (    ( ( operand_1 & 0x80 ) != ( operand_2 & 0x80 ) )
+                 && (      result & 0x80 ) != ( operand_1 & 0x80 ) )
+                flags |= CPU_FLAG_PV;
+        }
+
+        //  HALF CARRY
+        half = ( ( operand_1 & 0x0F ) - ( operand_2 & 0x0F ) - carry );
+        if ( ( half & 0x10 ) == 0x10 )
+            flags |= CPU_FLAG_H;
+
+        //  Carry
+        if ( ( result & 0x0100 ) == 0x0100 )
+            flags |= CPU_FLAG_C;
+
+        flags_sub[ mode ][ FLAGS_INDEX( carry, operand_1, operand_2 ) ] = flags;
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Build the increment and decrement tables.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      H follows bit 0 of the operand and DEC always clears P/V, the same
+ *      as inc_8( ) and dec_8( ) always did.
+ *
+ ****************************************************************************/
+
+static
+void
+flags_init_inc_dec(
+    void
+    )
+{
+    /**
+     *  @param  mode            FLAGS_MODE( )                               */
+    int                         mode;
+    /**
+     *  @param  operand         The register before the operation           */
+    int                         operand;
+    /**
+     *  @param  flags           The flags for the operation                 */
+    uint8_t                     flags;
+
+    for( mode = 0; mode < 2; mode += 1 )
+    for( operand = 0; operand < 0x100; operand += 1 )
+    {
+        //  INC
+        flags = flags_szp[ ( operand + 1 ) & 0xFF ];
+        if ( mode == 1 )
+        {
+            flags &= ~CPU_FLAG_PV;
+            if ( operand == 0x7F )
+                flags |= CPU_FLAG_PV;
+        }
+        if ( ( operand & 0x01 ) != 0 )
+            flags |= CPU_FLAG_H;
+        flags_inc[ mode ][ operand ] = flags;
+
+        //  DEC
+        flags  = flags_szp[ ( operand - 1 ) & 0xFF ] & ~CPU_FLAG_PV;
+        flags |= CPU_FLAG_N;
+        if ( ( operand & 0x01 ) != 0 )
+            flags |= CPU_FLAG_H;
+        flags_dec[ mode ][ operand ] = flags;
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Build the decimal adjust table.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      8080:   The low nibble is adjusted when it is above 9 or H is set and
+ *              that decides H, the high nibble when it is above 9 or C is
+ *              set and that decides C.  S, Z and P follow the result.
+ *      Z80:    The first matching line of daa_rule[ ] is applied.  C is set
+ *              when the line says so, no other flag is changed.
+ *
+ ****************************************************************************/
+
+static
+void
+flags_init_daa(
+    void
+    )
+{
+    /**
+     *  @param  index           FLAGS_DAA_INDEX( )                          */
+    int                         index;
+    /**
+     *  @param  a               The Accumulator                             */
+    uint16_t                    a;
+    /**
+     *  @param  n, c, h         The incoming flags                          */
+    uint8_t                     n, c, h;
+    /**
+     *  @param  low, high       The nibbles of A                            */
+    uint16_t                    low, high;
+    /**
+     *  @param  flags           The outgoing H and C                        */
+    uint8_t                     flags;
+    /**
+     *  @param  rule            Z80 rule                                    */
+    const
+    struct  daa_rule_t      *   rule;
+
+    for( index = 0; index < 0x800; index += 1 )
+    {
+        a = index & 0xFF;
+        h = ( index >> 8 ) & 1;
+        c = ( index >> 9 ) & 1;
+        n = ( index >> 10 ) & 1;
+
+        /********************************************************************
+         *  8080
+         ********************************************************************/
+
+        low   = a & 0x0F;
+        high  = a & 0xF0;
+        flags = ( h ? CPU_FLAG_H : 0 ) | ( c ? CPU_FLAG_C : 0 );
+
+        if ( ( low > 9 ) || ( h != 0 ) )
+        {
+            low += 6;
+            flags &= ~CPU_FLAG_H;
+            if ( low > 0x0F )
+            {
+                flags |= CPU_FLAG_H;
+                high  += 0x10;
+            }
+        }
+        if ( ( high > 0x90 ) || ( c != 0 ) )
+        {
+            high  += 0x60;
+            flags &= ~CPU_FLAG_C;
+            if ( high > 0xFF )
+                flags |= CPU_FLAG_C;
+        }
+
+        flags_daa[ 0 ][ index ].a    = (uint8_t)( ( low & 0x0F ) | high );
+        flags_daa[ 0 ][ index ].f    = flags_szp[ flags_daa[ 0 ][ index ].a ] | flags;
+        flags_daa[ 0 ][ index ].keep = FLAGS_KEEP;
+
+        /********************************************************************
+         *  Z80
+         ********************************************************************/
+
+        low  = a & 0x0F;
+        high = ( a & 0xF0 ) >> 4;
+
+        flags_daa[ 1 ][ index ].a    = (uint8_t)a;
+        flags_daa[ 1 ][ index ].f    = 0;
+        flags_daa[ 1 ][ index ].keep = 0xFF;
+
+        for( rule = daa_rule; rule < &daa_rule[ DAA_RULES ]; rule += 1 )
+        {
+            if (    ( rule->n == n ) && ( rule->c == c ) && ( rule->h == h )
+                 && ( high >= rule->high_min ) && ( high <= rule->high_max )
+                 && ( low  >= rule->low_min  ) && ( low  <= rule->low_max  ) )
+            {
+                flags_daa[ 1 ][ index ].a = (uint8_t)( a + rule->add );
+                if ( rule->carry != 0 )
+                    flags_daa[ 1 ][ index ].f = CPU_FLAG_C;
+                break;
+            }
+        }
+    }
+}
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Build all flag tables.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called once at start-up before anything executes.
+ *
+ ****************************************************************************/
+
+void
+flags_init(
+    void
+    )
+{
+    //  The others are built from the S, Z and parity table
+    flags_init_szp( );
+    flags_init_add_sub( );
+    flags_init_inc_dec( );
+    flags_init_daa( );
+}
+
+/****************************************************************************/
@@ -0,0 +1,146 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+#ifndef FLAGS_H
+#define FLAGS_H
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Precomputed condition flag tables.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * System APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Application APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  FLAGS_MODE          Table row for a CPU mode ( 0 = 8080 )       */
+#define FLAGS_MODE( CPU )       ( ( ( CPU ) == CPU_Z80 ) ? 1 : 0 )
+//----------------------------------------------------------------------------
+/**
+ *  @param  FLAGS_INDEX         flags_add / flags_sub index                 */
+#define FLAGS_INDEX( CARRY, OPERAND_1, OPERAND_2 )                          \
+                                (   ( ( (uint32_t)( CARRY )     & 0x01 ) << 16 )  \
+                                  | ( ( (uint32_t)( OPERAND_1 ) & 0xFF ) <<  8 )  \
+                                  |   ( (uint32_t)( OPERAND_2 ) & 0xFF ) )
+//----------------------------------------------------------------------------
+/**
+ *  @param  FLAGS_DAA_INDEX     flags_daa index                             */
+#define FLAGS_DAA_INDEX( A, F ) (   ( ( (uint16_t)( F ) & CPU_FLAG_N ) << 9 )  \
+                                  | ( ( (uint16_t)( F ) & CPU_FLAG_C ) << 9 )  \
+                                  | ( ( (uint16_t)( F ) & CPU_FLAG_H ) << 4 )  \
+                                  |   ( (uint16_t)( A ) & 0xFF ) )
+//----------------------------------------------------------------------------
+/**
+ *  @param  FLAGS_KEEP          F bits no instruction changes               */
+#define FLAGS_KEEP              ( CPU_FLAG_X3 | CPU_FLAG_X5 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  flags_daa_t         Result of DAA for one A, N, C and H         */
+struct  flags_daa_t
+{
+    /**
+     *  @param  a               The adjusted Accumulator                    */
+    uint8_t                     a;
+    /**
+     *  @param  f               Flags that are set                          */
+    uint8_t                     f;
+    /**
+     *  @param  keep            Flags that are left alone                   */
+    uint8_t                     keep;
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  flags_szp           S, Z and even parity of a result            */
+extern
+uint8_t                         flags_szp[ 0x100 ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  flags_add           ADD / ADC flags by FLAGS_INDEX( )           */
+extern
+uint8_t                         flags_add[ 2 ][ 0x20000 ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  flags_sub           SUB / SBC / CP flags by FLAGS_INDEX( )      */
+extern
+uint8_t                         flags_sub[ 2 ][ 0x20000 ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  flags_inc           INC flags ( except C ) by operand           */
+extern
+uint8_t                         flags_inc[ 2 ][ 0x100 ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  flags_dec           DEC flags ( except C ) by operand           */
+extern
+uint8_t                         flags_dec[ 2 ][ 0x100 ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  flags_daa           DAA by FLAGS_DAA_INDEX( )                   */
+extern
+struct  flags_daa_t             flags_daa[ 2 ][ 0x800 ];
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Prototypes
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+void
+flags_init(
+    void
+    );
+//----------------------------------------------------------------------------
+
+/****************************************************************************/
+
+#endif                      //    FLAGS_H
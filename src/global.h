@@ -22,6 +22,113 @@
  ****************************************************************************/
 
 //----------------------------------------------------------------------------
+/**
+ *  @param  PROFILE_ENABLE      Guest hot-spot profiler.  Every instruction
+ *                              is counted by address and op-code, so it
+ *                              needs the table engine.  -DPROFILE_ENABLE=1
+ *                              turns it on.                                */
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE          ( 0 )
+#endif
+//----------------------------------------------------------------------------
+/**
+ *  @param  INST_ENGINE         Instruction dispatch engine used by
+ *                              inst_fetch( ).  Override on the compiler
+ *                              command line (-DINST_ENGINE=0) to fall back
+ *                              to the function pointer table loop.        */
+#define INST_ENGINE_TABLE       ( 0 )   //  op_code_xxx_table[ ] call loop
+#define INST_ENGINE_THREADED    ( 1 )   //  Threaded code interpreter
+#define INST_ENGINE_BLOCK       ( 2 )   //  Threaded code over decoded blocks
+#ifndef INST_ENGINE
+#if PROFILE_ENABLE
+#define INST_ENGINE             ( INST_ENGINE_TABLE )
+#else
+#define INST_ENGINE             ( INST_ENGINE_BLOCK )
+#endif
+#endif
+#if PROFILE_ENABLE && ( INST_ENGINE != INST_ENGINE_TABLE )
+#error  "PROFILE_ENABLE needs INST_ENGINE_TABLE"
+#endif
+//----------------------------------------------------------------------------
+/**
+ *  @param  FLAGS_LAZY          The ALU helpers record their operands and F
+ *                              is only computed when it is read.
+ *                              -DFLAGS_LAZY=0 computes F on every
+ *                              operation.                                  */
+#ifndef FLAGS_LAZY
+#define FLAGS_LAZY              ( 1 )
+#endif
+//----------------------------------------------------------------------------
+/**
+ *  @param  JIT_ENABLE          Translate hot blocks to native x86-64 code.
+ *                              Only available with INST_ENGINE_BLOCK on an
+ *                              x86-64 host.  -DJIT_ENABLE=0 turns it off. */
+#ifndef JIT_ENABLE
+#if defined( __x86_64__ ) && ( INST_ENGINE == INST_ENGINE_BLOCK )
+#define JIT_ENABLE              ( 1 )
+#else
+#define JIT_ENABLE              ( 0 )
+#endif
+#endif
+//----------------------------------------------------------------------------
+/**
+ *  @param  MEMORY_CHECKED      Every guest memory access is checked against
+ *                              the page tables, the watchpoints and the
+ *                              access log.  -DMEMORY_CHECKED=1 turns it on,
+ *                              otherwise the checks compile to nothing.   */
+#ifndef MEMORY_CHECKED
+#define MEMORY_CHECKED          ( 0 )
+#endif
+//----------------------------------------------------------------------------
+/**
+ *  @param  PACE_CLOCK          Guest clock ( Hz ) the emulator is held to.
+ *                              PACE_CLOCK_CPU follows the CPU mode ( 2 MHz
+ *                              8080, 4 MHz Z80 ).  -DPACE_CLOCK=0 runs as
+ *                              fast as the host allows.                    */
+#define PACE_CLOCK_UNLIMITED    ( 0 )       //  No pacing
+#define PACE_CLOCK_CPU          ( 1 )       //  Follow the CPU mode
+#define PACE_CLOCK_I80          ( 2000000 ) //  Intel 8080 at 2 MHz
+#define PACE_CLOCK_Z80          ( 4000000 ) //  Zilog Z80 at 4 MHz
+#ifndef PACE_CLOCK
+#define PACE_CLOCK              ( PACE_CLOCK_UNLIMITED )
+#endif
+//----------------------------------------------------------------------------
+/**
+ *  @param  DISK_CACHE_FLUSH    When the track cache writes dirty tracks
+ *                              back and flushes the images.  EJECT and
+ *                              shutdown always do.  The CP command CACHE
+ *                              changes it at run time.                     */
+#define DISK_FLUSH_WBOOT        ( 0 )       //  Every warm boot
+#define DISK_FLUSH_IDLE         ( 1 )       //  The guest waits for a key
+#define DISK_FLUSH_TIMER        ( 2 )       //  DISK_CACHE_TIMER_MS passed
+#define DISK_FLUSH_SHUTDOWN     ( 3 )       //  Only EJECT and shutdown
+#ifndef DISK_CACHE_FLUSH
+#define DISK_CACHE_FLUSH        ( DISK_FLUSH_WBOOT )
+#endif
+//----------------------------------------------------------------------------
+/**
+ *  @param  DISK_ASYNC          1 = Dirty tracks are written back by an I/O
+ *                              thread, the guest never waits for the host
+ *                              file system except at WBOOT, EJECT and
+ *                              shutdown.
+ *  @param  DISK_ASYNC_SYNC     What the I/O thread does when a disk is
+ *                              flushed.                                    */
+#ifndef DISK_ASYNC
+#define DISK_ASYNC              ( 0 )
+#endif
+#define DISK_SYNC_NONE          ( 0 )       //  Leave it to the kernel
+#define DISK_SYNC_DATA          ( 1 )       //  fdatasync( )
+#define DISK_SYNC_FULL          ( 2 )       //  fsync( )
+#ifndef DISK_ASYNC_SYNC
+#define DISK_ASYNC_SYNC         ( DISK_SYNC_DATA )
+#endif
+/**
+ *  @param  DISK_URING          1 = The I/O thread submits what is queued as
+ *                              one io_uring batch, it uses pwrite( ) when
+ *                              the kernel has no io_uring.                 */
+#ifndef DISK_URING
+#define DISK_URING              ( 1 )
+#endif
 //----------------------------------------------------------------------------
 
 /****************************************************************************
@@ -72,7 +179,7 @@ struct  operation_rc_t
     /**
      *  @param  states        Number of clock states                        */
     int                         states;
-}   operation_rc;
+};
 //----------------------------------------------------------------------------
 
 /****************************************************************************
@@ -80,10 +187,6 @@ struct  operation_rc_t
  ****************************************************************************/
 
 //----------------------------------------------------------------------------
-//      Runtime Mode
-/**
- *  @param  RTM                                                             */
-enum    CPU_e               CPU;
 //----------------------------------------------------------------------------
 
 /****************************************************************************
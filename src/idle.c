@@ -0,0 +1,203 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Console idle detection.
+ *
+ *  A program waiting for a key calls CONST over and over, and every call
+ *  traps out to bios_const( ), so a waiting guest keeps a host core busy.
+ *  bios_const( ) reports every poll that found no input to idle_poll( ).
+ *  When IDLE_POLLS of them arrive in a row with fewer than IDLE_SPAN
+ *  instructions between them, the guest is doing nothing but polling. The
+ *  emulator then blocks in poll( ) on stdin. poll( ) returns as soon as a
+ *  key arrives, so typing is not slowed down. The timeout doubles from
+ *  IDLE_WAIT_MIN_MS up to IDLE_WAIT_MAX_MS while the guest stays idle, so
+ *  a program that polls between real work only waits a little.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+#define _POSIX_C_SOURCE 200112L //  poll( )
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <stdio.h>              //  Standard I/O definitions
+#include <poll.h>               //  Wait for input
+                                //*******************************************
+
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "stats.h"              //  Performance counters
+#include "idle.h"               //  Console idle detection
+#include "machine.h"            //  Guest machine context
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  IDLE_SPAN           Most instructions between two empty polls
+ *                              of a guest that is only waiting             */
+#define IDLE_SPAN               ( 2000 )
+//----------------------------------------------------------------------------
+/**
+ *  @param  IDLE_POLLS          Empty polls in a row before waiting         */
+#define IDLE_POLLS              ( 16 )
+//----------------------------------------------------------------------------
+/**
+ *  @param  IDLE_WAIT_MIN_MS    First wait once the guest is idle           */
+#define IDLE_WAIT_MIN_MS        ( 1 )
+//----------------------------------------------------------------------------
+/**
+ *  @param  IDLE_WAIT_MAX_MS    Longest wait                                */
+#define IDLE_WAIT_MAX_MS        ( 100 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  The console has input, the guest is not idle.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+idle_input(
+    void
+    )
+{
+    //  Start over
+    machine->idle_polls = 0;
+    machine->idle_wait_ms = IDLE_WAIT_MIN_MS;
+}
+
+/****************************************************************************/
+/**
+ *  A console status poll found no input.
+ *
+ *  @param  fd                  The console input, stdin unless the console
+ *                              was routed elsewhere.
+ *
+ *  @return                     true when input arrived while waiting.
+ *
+ *  @note
+ *      Called by bios_const( ).
+ *
+ ****************************************************************************/
+
+bool
+idle_poll(
+    int                         fd
+    )
+{
+    /**
+     *  @param  console         The console input                           */
+    struct  pollfd              console;
+    /**
+     *  @param  ready           Input arrived                               */
+    bool                        ready;
+
+    //  Did the guest do anything but poll since the last empty poll ?
+    if ( ( machine->stats.instructions - machine->idle_last ) > IDLE_SPAN )
+    {
+        //  YES:    It is busy
+        idle_input( );
+    }
+    else
+    {
+        //  NO:     One more empty poll in a row
+        machine->idle_polls += 1;
+    }
+
+    //  The next poll is measured from here
+    machine->idle_last = machine->stats.instructions;
+
+    //  Has the guest been idle long enough to wait ?
+    if ( machine->idle_polls < IDLE_POLLS )
+    {
+        //  NO:     Let it poll again
+        return( false );
+    }
+
+    //  Wait for input
+    console.fd = fd;
+    console.events = POLLIN;
+    console.revents = 0;
+    ready = ( poll( &console, 1, machine->idle_wait_ms ) > 0 );
+
+    //  Did input arrive ?
+    if ( ready == true )
+    {
+        //  YES:    Start over
+        idle_input( );
+    }
+    else
+    {
+        //  NO:     Wait longer next time
+        machine->idle_wait_ms *= 2;
+        if ( machine->idle_wait_ms > IDLE_WAIT_MAX_MS )
+        {
+            machine->idle_wait_ms = IDLE_WAIT_MAX_MS;
+        }
+    }
+
+    //  DONE!
+    return( ready );
+}
+
+/****************************************************************************/
@@ -42,7 +42,12 @@
 #include "memory.h"             //  Memory management and access
 #include "registers.h"          //  All things CPU registers.
 #include "op_code.h"            //  OP-Code instruction maps
+#include "pace.h"               //  Real-time pacing
+#include "interrupt.h"          //  Maskable interrupts
+#include "stats.h"              //  Performance counters
+#include "profile.h"            //  Guest hot-spot profiler
 #include "disassemble.h"        //  For debug
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -64,6 +69,17 @@
  ****************************************************************************/
 
 //----------------------------------------------------------------------------
+/**
+ *  @param  fetch_state_t       Counters carried between the per-mode loops */
+struct  fetch_state_t
+{
+    /**
+     *  @param  t_states        Clock states executed since entry           */
+    uint64_t                    t_states;
+    /**
+     *  @param  t_inst          Instructions retired since entry            */
+    uint64_t                    t_inst;
+};
 //----------------------------------------------------------------------------
 
 /****************************************************************************
@@ -78,63 +94,12 @@
  ****************************************************************************/
 
 //---------------------------------------------------------------------------
-/**
- *  @param  PC              Program Counter (PC)                            */
-uint16_t                    PC;
 //---------------------------------------------------------------------------
 
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
-/****************************************************************************/
-/**
- *  Fetch a new instruction from main memory
- *
- *  @param
- *
- *  @return op_code             The opcode pointed to by the program counter (PC).
- *
- *  @note
- *
- ****************************************************************************/
-
-static
-uint8_t
-instruction_fetch(
-    )
-{
-    /**
-     *  @param  op_code             Contents of main memory (PC).           */
-    uint8_t                     op_code;
-    /**
-     *  @param  r_7                 Refresh register bit 7                  */
-    uint8_t                     r_7;
-
-    /************************************************************************
-     *  Function Initialization
-     ************************************************************************/
-
-
-    /************************************************************************
-     *  Function code
-     ************************************************************************/
-
-    //  Fetch a new CPU instruction operation code
-    op_code = memory_get_8( CPU_REG_PC++ );
-
-    //  Increment the refresh register
-    r_7 = CPU_REG_R & 0x80;
-    CPU_REG_R = ( ( CPU_REG_R + 1 ) & 0x7F ) | r_7;
-
-    /************************************************************************
-     *  Function Exit
-     ************************************************************************/
-
-    //  DONE!
-    return( op_code );
-}
-
 /****************************************************************************/
 /**
  *  RESET.
@@ -169,20 +134,21 @@ cpu_reset(
     //  Clear CPU registers
     //  Clear everything from all CPU registers
     CPU_REG_AF = 0;
+    machine->flags_lazy.op = FLAGS_OP_NONE;
     CPU_REG_BC = 0;
     CPU_REG_DE = 0;
     CPU_REG_HL = 0;
     CPU_REG_PC = 0;
     CPU_REG_I  = 0;
     CPU_REG_R  = 0;
+    machine->refresh_m1 = 0;
 
     //  Not needed but makes testing easier when all flags start in a
     //  known state.
     PUT_F( 0 );
 
-    //  @ToDo   Reset the interrupt enable flag
-
-    //  @ToDo   Set interrupt status to 'Mode-0'
+    //  Reset the interrupt enable flags and set interrupt status to 'Mode-0'
+    interrupt_reset( );
 
     /************************************************************************
      *  Function code
@@ -220,8 +186,12 @@ inst_fetch_CB(
     //  Set Extended Instruction Set = CB
     EIS = EIS_CB;
 
+    //  Count the prefix table dispatch
+    machine->stats.prefix[ STATS_PREFIX_CB ] += 1;
+
     //  Read the next instruction from main memory
     CB_op_code = memory_get_8( CPU_REG_PC++ );
+    PROFILE_OP( PROFILE_CB, CB_op_code );
 
     (*op_code_CB_table[ CB_op_code ])( CB_op_code);
 }
@@ -250,8 +220,12 @@ inst_fetch_DD(
     //  Set Extended Instruction Set = DD
     EIS = EIS_DD;
 
+    //  Count the prefix table dispatch
+    machine->stats.prefix[ STATS_PREFIX_DD ] += 1;
+
     //  Read the next instruction from main memory
     DD_op_code = memory_get_8( CPU_REG_PC++ );
+    PROFILE_OP( PROFILE_DD, DD_op_code );
 
     (*op_code_DD_table[ DD_op_code ])( DD_op_code);
 }
@@ -282,6 +256,7 @@ inst_fetch_DDCB(
 
     //  Read the next instruction from main memory
     DDCB_op_code = memory_get_8( CPU_REG_PC++ );
+    PROFILE_OP( PROFILE_DDCB, DDCB_op_code );
 
     (*op_code_DDCB_table[ DDCB_op_code ])( DDCB_op_code);
 }
@@ -310,13 +285,17 @@ inst_fetch_ED(
     //  Set Extended Instruction Set = ED
     EIS = EIS_ED;
 
+    //  Count the prefix table dispatch
+    machine->stats.prefix[ STATS_PREFIX_ED ] += 1;
+
     //  Read the next instruction from main memory
     ED_op_code = memory_get_8( CPU_REG_PC++ );
+    PROFILE_OP( PROFILE_ED, ED_op_code );
 
     (*op_code_ED_table[ ED_op_code ])( ED_op_code);
 
 #if DEBUG_MODE
-        disassemble( PC, ED_op_code );
+        disassemble( machine->pc, ED_op_code );
 #endif
 }
 
@@ -344,8 +323,12 @@ inst_fetch_FD(
     //  Set Extended Instruction Set = FD
     EIS = EIS_FD;
 
+    //  Count the prefix table dispatch
+    machine->stats.prefix[ STATS_PREFIX_FD ] += 1;
+
     //  Read the next instruction from main memory
     FD_op_code = memory_get_8( CPU_REG_PC++ );
+    PROFILE_OP( PROFILE_FD, FD_op_code );
 
     (*op_code_FD_table[ FD_op_code ])( FD_op_code);
 }
@@ -376,131 +359,260 @@ inst_fetch_FDCB(
 
     //  Read the next instruction from main memory
     FDCB_op_code = memory_get_8( CPU_REG_PC++ );
+    PROFILE_OP( PROFILE_FDCB, FDCB_op_code );
 
     (*op_code_FDCB_table[ FDCB_op_code ])( FDCB_op_code);
 }
 
-/****************************************************************************
- * MAIN
- ****************************************************************************/
-
-
 /****************************************************************************/
 /**
- *  Run the program in memory starting at address x'0000.
+ *  Run instructions for as long as the CPU stays in one mode.
  *
- *  @param
+ *  @param  state               Counters carried between the loops.
+ *  @param  mode                CPU mode the loop is built for.
  *
- *  @return                     No information is returned from this function.
+ *  @return                     false when an op-code asked to terminate,
+ *                              true when OUT x'FE changed the CPU mode.
  *
  *  @note
+ *      Always inlined into inst_fetch_i80( ) and inst_fetch_z80( ) with a
+ *      constant mode, so each copy calls one table.  The counters stay in
+ *      locals until the loop returns.
  *
  ****************************************************************************/
 
-void
-inst_fetch(
-    void
+static
+inline
+__attribute__( ( always_inline ) )
+bool
+inst_fetch_loop(
+    struct  fetch_state_t   *   state,
+    enum    CPU_e               mode
     )
 {
     /**
      *  @param  op_code         Current instruction code                    */
     uint8_t                     op_code;
     /**
-     *  @param  refresh         Refresh count tracker                       */
-    uint8_t                     refresh;
+     *  @param  t_states        Clock states executed since entry           */
+    uint64_t                    t_states;
     /**
-     *  @param  rb7             Save refresh register bit 7                 */
-    uint8_t                     rb7;
-
-    //  Reset the CPU for a normalized start
-    cpu_reset( );
+     *  @param  t_inst          Instructions retired since entry            */
+    uint64_t                    t_inst;
+    /**
+     *  @param  running         false once an op-code terminates the run    */
+    bool                        running;
 
-    //  Initialize the refresh tracker
-    refresh = 0;
+    //  Pick up the counters
+    t_states = state->t_states;
+    t_inst = state->t_inst;
+    running = true;
 
-    /************************************************************************
-     *  Main instruction fetch loop
-     ************************************************************************/
-
-    // Start executing instructions
-    while( 1 )
+    //  Run until the mode changes
+    while( CPU == mode )
     {
         //  Set the instruction set to 'BASIC'
         EIS = EIS_BASE;
 
         //  Save the current Program Counter
-        PC = CPU_REG_PC;
+        machine->pc = CPU_REG_PC;
 
         //  Read the next instruction from main memory
         op_code = memory_get_8( CPU_REG_PC++ );
 
         //  Are we running in Intel 8080 mode ?
-        if ( CPU == CPU_I80 )
+        if ( mode == CPU_I80 )
         {
             //  YES:    Use the 8080 instruction set
+            PROFILE_OP( PROFILE_I80, op_code );
             (*op_code_i80_table[ op_code ])( op_code);
         }
         else
         {
             //  NO:     Use the Zilog Z80 instruction set
+            PROFILE_OP( PROFILE_Z80, op_code );
             (*op_code_z80_table[ op_code ])( op_code);
         }
 
         //  Was the op-code execution successful ?
-        if ( operation_rc.states == 0 )
+        if ( machine->operation_rc.states == 0 )
         {
             //  Terminate
+            running = false;
             break;
         }
 
-        //  Update the refresh register
-        refresh += operation_rc.states;
-        rb7 = ( CPU_REG_R & 0x80 );
-        CPU_REG_R = ( ( CPU_REG_R + ( refresh / 4 ) ) & 0x7F );
-        CPU_REG_R |= rb7;
-        refresh %= 4;
-
 #if DEBUG_MODE
         if( EIS == EIS_BASE )
-            disassemble( PC, op_code );
+            disassemble( machine->pc, op_code );
+#endif
+
+        //  Profile the instruction
+        PROFILE_INST( machine->pc, op_code, machine->operation_rc.states );
+
+        //  Count the instruction and hold the guest to its real-time clock
+        t_states += machine->operation_rc.states;
+        t_inst += 1;
+        STATS_SYNC( t_inst, t_states );
+        PACE( t_states );
+
+        //  Take an interrupt between instructions
+        INTERRUPT( t_states );
+    }
+
+    //  Hand the counters back
+    state->t_states = t_states;
+    state->t_inst = t_inst;
+
+    //  DONE!
+    return( running );
+}
+
+#if INST_ENGINE == INST_ENGINE_TABLE
+/****************************************************************************/
+/**
+ *  Run instructions while the CPU is in Intel 8080 mode.
+ *
+ *  @param  state               Counters carried between the loops.
+ *
+ *  @return                     false when an op-code asked to terminate.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+bool
+inst_fetch_i80(
+    struct  fetch_state_t   *   state
+    )
+{
+    return( inst_fetch_loop( state, CPU_I80 ) );
+}
+
+/****************************************************************************/
+/**
+ *  Run instructions while the CPU is in Zilog Z80 mode.
+ *
+ *  @param  state               Counters carried between the loops.
+ *
+ *  @return                     false when an op-code asked to terminate.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+bool
+inst_fetch_z80(
+    struct  fetch_state_t   *   state
+    )
+{
+    return( inst_fetch_loop( state, CPU_Z80 ) );
+}
 #endif
 
-#if 0   //  This implementation is just wrong.  I need something that will
-        //  emulate the real world instruction time not the emulation time
-        //  plus the real world instruction time.
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+
+/****************************************************************************/
+/**
+ *  Run the program in memory starting at address x'0000.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+inst_fetch(
+    void
+    )
 {
-#define STEP_STATE_FACTOR       250
-        /**
-         *  @param  remaing_steps                                            */
-        static
-        int                         remaing_steps;
-        /**
-         *  @param  tim                                                      */
-        struct timespec             tim;
-        /**
-         *  @param  tim                                                      */
-        struct timespec             tim2;
-
-        remaing_steps += operation_rc.states;
-
-        tim.tv_sec = 0;
-        tim.tv_nsec = ( remaing_steps / STEP_STATE_FACTOR );
-
-        if( tim.tv_nsec >= 1 )
-        {
-            //  Subtract the used steps from the total
-            remaing_steps -= ( tim.tv_nsec * STEP_STATE_FACTOR );
+    //  Reset the CPU for a normalized start
+    cpu_reset( );
 
-            //  Continue until the time has expired
-            nanosleep( &tim , &tim2 );
-        }
+    //  And run from there
+    inst_resume( );
 }
+
+/****************************************************************************/
+/**
+ *  Run the program in memory from the current state of the CPU.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Used to continue a guest restored by machine_load( ).
+ *
+ ****************************************************************************/
+
+void
+inst_resume(
+    void
+    )
+{
+#if INST_ENGINE == INST_ENGINE_TABLE
+    /**
+     *  @param  state           Counters carried between the per-mode loops */
+    struct  fetch_state_t       state;
+    /**
+     *  @param  running         false once an op-code terminates the run    */
+    bool                        running;
+#endif
+
+    //  Start counting
+    stats_start( );
+#if PROFILE_ENABLE
+    profile_start( );
+#endif
+
+#if INST_ENGINE != INST_ENGINE_TABLE
+    //  Run the threaded code interpreter
+    inst_threaded( );
+#else
+    //  Start the guest clock
+    state.t_states = 0;
+    state.t_inst = 0;
+    pace_start( state.t_states );
+
+    /************************************************************************
+     *  Main instruction fetch loop
+     ************************************************************************/
+
+    //  Run the loop for the current mode until the program terminates.
+    //  OUT x'FE changes the mode between two instructions.
+    do
+    {
+        //  Are we running in Intel 8080 mode ?
+        if ( CPU == CPU_I80 )
+        {
+            //  YES:    Use the 8080 loop
+            running = inst_fetch_i80( &state );
+        }
+        else
+        {
+            //  NO:     Use the Zilog Z80 loop
+            running = inst_fetch_z80( &state );
+        }
+    }   while( running == true );
+
+    //  Leave the refresh register up to date
+    refresh_sync( );
 #endif
-    }
 
     /************************************************************************
      *  Function Exit
      ************************************************************************/
 
+    //  Stop counting
+    stats_stop( );
 }
 /****************************************************************************/
\ No newline at end of file
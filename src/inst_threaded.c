@@ -0,0 +1,1101 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Threaded code instruction interpreter.
+ *
+ *  The table driven loop in inst_fetch( ) pays for an indirect call, a
+ *  prologue/epilogue and a trip through operation_rc for every instruction.
+ *  This engine inlines the bodies of the frequently executed instructions
+ *  into a single function and jumps directly from the end of one
+ *  instruction to the start of the next one.  With GCC (or clang) the jump
+ *  is a computed goto through a per CPU mode label table, otherwise a
+ *  switch statement is used.
+ *
+ *  Every op-code that is not inlined here (prefixes, I/O, HALT, DAA,
+ *  rotates, etc.) still dispatches through op_code_i80_table[ ] or
+ *  op_code_z80_table[ ] so the two engines always execute the same code.
+ *
+ *  When built for INST_ENGINE_BLOCK the same bodies run from the decoded
+ *  entries of block_cache.c instead of fetching and decoding the op-code
+ *  and its operands from main memory every time.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+#define     DEBUG_MODE      ( 0 )
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <unistd.h>             //  UNIX standard library.
+#include <stdio.h>              //  Standard I/O definitions
+                                //*******************************************
+
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "memory.h"             //  Memory management and access
+#include "registers.h"          //  All things CPU registers.
+#include "op_code.h"            //  OP-Code instruction maps
+#include "control.h"            //  Control (NOP, HLT, etc.) instrucions.
+#include "load.h"               //  LD   *,*
+#include "exchange.h"           //  EX   *,*
+#include "math.h"               //  8 bit instrucions.
+#include "logic.h"              //  Logic (AND, OR, XOR, CMP) instrucions.
+#include "math_16.h"            //  16 bit Arithmatic instrucions.
+#include "jump.h"               //  Jump instructions
+#include "call.h"               //  Call instructions
+#include "inst_threaded.h"      //  Threaded code interpreter
+#include "block_cache.h"        //  Decoded basic block cache
+#include "jit.h"                //  x86-64 translator
+#include "pace.h"               //  Real-time pacing
+#include "interrupt.h"          //  Maskable interrupts
+#include "stats.h"              //  Performance counters
+#include "disassemble.h"        //  For debug
+#include "machine.h"            //  Guest machine context
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  THREADED_GOTO       Use GCC "labels as values" for dispatch     */
+#if defined( __GNUC__ )
+#define THREADED_GOTO           ( 1 )
+#else
+#define THREADED_GOTO           ( 0 )
+#endif
+//----------------------------------------------------------------------------
+/**
+ *  @param  FETCH               Read the next op-code and advance PC        */
+#if DEBUG_MODE
+#define FETCH( )                ( EIS = EIS_BASE, machine->pc = CPU_REG_PC, \
+                                  memory_get_8( CPU_REG_PC++ ) )
+#else
+#define FETCH( )                ( memory_get_8( CPU_REG_PC++ ) )
+#endif
+//----------------------------------------------------------------------------
+#if INST_ENGINE == INST_ENGINE_BLOCK
+/**
+ *  @param  TH_OP               Entry point of an inlined instruction body.
+ *                              The Program Counter is set past the whole
+ *                              instruction and the operands come from the
+ *                              decoded block entry.
+ *  @param  DISPATCH            Continue with the next decoded instruction  */
+#if THREADED_GOTO
+#define TH_OP( NAME )           th_##NAME:                                  \
+                                CPU_REG_PC = entry->pc_next;                \
+                                op_code = entry->op_code;
+#define DISPATCH( )             entry += 1; goto *th_label[ entry->th_op ]
+#else
+#define TH_OP( NAME )           case TH_##NAME:                             \
+                                CPU_REG_PC = entry->pc_next;                \
+                                op_code = entry->op_code;
+#define DISPATCH( )             entry += 1; continue
+#endif
+#define IMM_8( )                ( (uint8_t)entry->operand )
+#define IMM_16( )               ( entry->operand )
+#define IMM_E( )                ( entry->operand )
+#else
+/**
+ *  @param  TH_OP               Entry point of an inlined instruction body
+ *  @param  DISPATCH            Continue with the next instruction          */
+#if THREADED_GOTO
+#define TH_OP( NAME )           th_##NAME:
+#define DISPATCH( )             op_code = FETCH( ); goto *dispatch[ op_code ]
+#else
+#define TH_OP( NAME )           case TH_##NAME:
+#define DISPATCH( )             continue
+#endif
+#define IMM_8( )                memory_get_8( CPU_REG_PC++ )
+#define IMM_16( )               memory_get_16_pc_p( )
+#define IMM_E( )                ( (uint16_t)(int8_t)memory_get_8( CPU_REG_PC++ ) )
+#endif
+//----------------------------------------------------------------------------
+/**
+ *  @param  RETIRE_SYNC         Count the instruction, publish the counters,
+ *                              pace the guest clock and take interrupts.
+ *                              The block engine does it once per block at
+ *                              block_lookup, without blocks it is done for
+ *                              every instruction.
+ *  @param  COUNT_RETIRED       Add the block entries run since block_entry
+ *                              to the instructions retired.                */
+#if INST_ENGINE == INST_ENGINE_BLOCK
+#define RETIRE_SYNC( )
+#define COUNT_RETIRED( )        t_inst += (uint64_t)( entry - block_entry ); \
+                                block_entry = entry
+#else
+#define RETIRE_SYNC( )          t_inst += 1;                                \
+                                STATS_SYNC( t_inst, t_states );             \
+                                PACE( t_states );                           \
+                                INTERRUPT( t_states )
+#define COUNT_RETIRED( )
+#endif
+//----------------------------------------------------------------------------
+/**
+ *  @param  RETIRE              Account for the clock states of the current
+ *                              instruction and dispatch the next one.
+ *  @param  RETIRE_W            Same as RETIRE( ) for instructions that write
+ *                              to memory.  When the write invalidated a
+ *                              cached block the rest of the current block
+ *                              may be stale so it is looked up again.
+ *  @note   Kept as small as possible so the compiler gives every inlined
+ *          body its own indirect jump.  Not wrapped in do { } while( 0 )
+ *          because DISPATCH( ) may be a 'continue' statement.              */
+#if DEBUG_MODE
+#define RETIRE( STATES )                                                    \
+{                                                                           \
+    t_states += ( STATES );                                                 \
+    if( EIS == EIS_BASE ) disassemble( machine->pc, op_code );              \
+    RETIRE_SYNC( );                                                         \
+    DISPATCH( );                                                            \
+}
+#else
+#define RETIRE( STATES )                                                    \
+{                                                                           \
+    t_states += ( STATES );                                                 \
+    RETIRE_SYNC( );                                                         \
+    DISPATCH( );                                                            \
+}
+#endif
+#if INST_ENGINE == INST_ENGINE_BLOCK
+#define RETIRE_W( STATES )                                                  \
+{                                                                           \
+    t_states += ( STATES );                                                 \
+    if( machine->block_stale ) { entry += 1; goto block_lookup; }           \
+    DISPATCH( );                                                            \
+}
+#else
+#define RETIRE_W( STATES )      RETIRE( STATES )
+#endif
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  threaded_map_t      Table handler to inlined body map           */
+struct  threaded_map_t
+{
+    /**
+     *  @param  handler         Function in op_code_xxx_table[ ]            */
+    void                        (*handler)( uint8_t );
+    /**
+     *  @param  th_op           Inlined equivalent                          */
+    enum    threaded_op_e       th_op;
+};
+//----------------------------------------------------------------------------
+/**
+ *  @param  threaded_family_t   Per op-code handlers to inlined body map    */
+struct  threaded_family_t
+{
+    /**
+     *  @param  handler         Handler of each register field value        */
+    void            (* const *  handler)( uint8_t );
+    /**
+     *  @param  shift           Position of the register field              */
+    uint8_t                     shift;
+    /**
+     *  @param  mask            Size of the register field                  */
+    uint8_t                     mask;
+    /**
+     *  @param  th_op           Inlined equivalent                          */
+    enum    threaded_op_e       th_op;
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  threaded_map        Every handler that has an inlined body      */
+static
+const
+struct  threaded_map_t          threaded_map[ ] =
+{
+    {   control_nop_i80,        TH_NOP          },
+    {   ld_rr_i80,              TH_LD_RR        },
+    {   ld_rn_i80,              TH_LD_RN        },
+    {   ld_rhl_i80,             TH_LD_RHL       },
+    {   ld_hlr_i80,             TH_LD_HLR       },
+    {   ld_hln_i80,             TH_LD_HLN       },
+    {   ld_ass_i80,             TH_LD_ASS       },
+    {   ld_ann_i80,             TH_LD_ANN       },
+    {   ld_ssa_i80,             TH_LD_SSA       },
+    {   ld_nna_i80,             TH_LD_NNA       },
+    {   ld_ssNN_i80,            TH_LD_SSNN      },
+    {   ld_hlnn_i80,            TH_LD_HLNN      },
+    {   ld_nnhl_i80,            TH_LD_NNHL      },
+    {   ld_sphl_i80,            TH_LD_SPHL      },
+    {   ld_pushqq_i80,          TH_PUSH         },
+    {   ld_popqq_i80,           TH_POP          },
+    {   ex_dehl_i80,            TH_EX_DEHL      },
+    {   ex_sphl_i80,            TH_EX_SPHL      },
+    {   ex_afaf_z80,            TH_EX_AFAF      },
+    {   ex_exx_z80,             TH_EXX          },
+    {   math_addr_i80,          TH_ADD_R        },
+    {   math_addn_i80,          TH_ADD_N        },
+    {   math_addhl_i80,         TH_ADD_HL       },
+    {   math_adcr_i80,          TH_ADC_R        },
+    {   math_adcn_i80,          TH_ADC_N        },
+    {   math_adchl_i80,         TH_ADC_HL       },
+    {   math_subr_i80,          TH_SUB_R        },
+    {   math_subn_i80,          TH_SUB_N        },
+    {   math_subhl_i80,         TH_SUB_HL       },
+    {   math_sbcr_i80,          TH_SBC_R        },
+    {   math_sbcn_i80,          TH_SBC_N        },
+    {   math_sbchl_i80,         TH_SBC_HL       },
+    {   math_incr_i80,          TH_INC_R        },
+    {   math_inchl_i80,         TH_INC_HL       },
+    {   math_decr_r80,          TH_DEC_R        },
+    {   math_dechl_i80,         TH_DEC_HL       },
+    {   logic_andr_i80,         TH_AND_R        },
+    {   logic_andn_i80,         TH_AND_N        },
+    {   logic_andhl_i80,        TH_AND_HL       },
+    {   logic_orr_i80,          TH_OR_R         },
+    {   logic_orn_i80,          TH_OR_N         },
+    {   logic_orhl_i80,         TH_OR_HL        },
+    {   logic_xorr_i80,         TH_XOR_R        },
+    {   logic_xorn_i80,         TH_XOR_N        },
+    {   logic_xorhl_i80,        TH_XOR_HL       },
+    {   logic_cpr_i80,          TH_CP_R         },
+    {   logic_cpn_i80,          TH_CP_N         },
+    {   logic_cphl_i80,         TH_CP_HL        },
+    {   math_incss_i80,         TH_INC_SS       },
+    {   math_decss_i80,         TH_DEC_SS       },
+    {   math_cpl_i80,           TH_CPL          },
+    {   math_scf_i80,           TH_SCF          },
+    {   math_ccf_i80,           TH_CCF          },
+    {   jump_jpnn_i80,          TH_JP           },
+    {   jump_jpccnn_i80,        TH_JP_CC        },
+    {   jump_jphl_i80,          TH_JP_HL        },
+    {   jump_jr_z80,            TH_JR           },
+    {   jump_jrcc_z80,          TH_JR_CC        },
+    {   jump_djnz_z80,          TH_DJNZ         },
+    {   call_nn_i80,            TH_CALL_NN      },
+    {   call_ccnn_i80,          TH_CALL_CC      },
+    {   ret_i80,                TH_RET          },
+    {   ret_cc_i80,             TH_RET_CC       },
+    {   rst_t_i80,              TH_RST          }
+};
+//----------------------------------------------------------------------------
+/**
+ *  @param  threaded_family     Handlers generated for each register        */
+static
+const
+struct  threaded_family_t       threaded_family[ ] =
+{
+    {   ld_rr_i80_op,           0,  0x3F,   TH_LD_RR        },
+    {   math_addr_i80_op,       0,  0x07,   TH_ADD_R        },
+    {   math_adcr_i80_op,       0,  0x07,   TH_ADC_R        },
+    {   math_subr_i80_op,       0,  0x07,   TH_SUB_R        },
+    {   math_sbcr_i80_op,       0,  0x07,   TH_SBC_R        },
+    {   math_incr_i80_op,       3,  0x07,   TH_INC_R        },
+    {   math_decr_r80_op,       3,  0x07,   TH_DEC_R        },
+    {   logic_andr_i80_op,      0,  0x07,   TH_AND_R        },
+    {   logic_orr_i80_op,       0,  0x07,   TH_OR_R         },
+    {   logic_xorr_i80_op,      0,  0x07,   TH_XOR_R        },
+    {   logic_cpr_i80_op,       0,  0x07,   TH_CP_R         }
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Build the op-code to inlined body map for one instruction table.
+ *
+ *  @param  table               op_code_i80_table or op_code_z80_table
+ *  @param  th_table            Where the result is stored
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The map is rebuilt every time the engine is started so that changes
+ *      made to the op-code tables are always honored.
+ *
+ ****************************************************************************/
+
+static
+void
+threaded_classify(
+    void                        (**table)( uint8_t ),
+    uint8_t                     *th_table
+    )
+{
+    /**
+     *  @param  op_code         Op-code being classified                    */
+    int                         op_code;
+    /**
+     *  @param  map_ndx         Index into threaded_map[ ]                  */
+    int                         map_ndx;
+    /**
+     *  @param  family          Entry of threaded_family[ ]                 */
+    const
+    struct  threaded_family_t   *family;
+
+    /************************************************************************
+     *  Function Code
+     ************************************************************************/
+
+    //  Loop through all op-codes
+    for( op_code = 0; op_code < 256; op_code += 1 )
+    {
+        //  Default to calling the table handler
+        th_table[ op_code ] = TH_CALL;
+
+        //  Is there an inlined body for this handler ?
+        for( map_ndx = 0;
+             map_ndx < (int)( sizeof( threaded_map ) / sizeof( threaded_map[ 0 ] ) );
+             map_ndx += 1 )
+        {
+            if( threaded_map[ map_ndx ].handler == table[ op_code ] )
+            {
+                //  YES:    Use it.
+                th_table[ op_code ] = threaded_map[ map_ndx ].th_op;
+                break;
+            }
+        }
+
+        //  Is it the generated handler for this op-code's register ?
+        for( family = threaded_family;
+             family < &threaded_family[ sizeof( threaded_family ) / sizeof( threaded_family[ 0 ] ) ];
+             family += 1 )
+        {
+            if( family->handler[ ( op_code >> family->shift ) & family->mask ] == table[ op_code ] )
+            {
+                //  YES:    Use it.
+                th_table[ op_code ] = family->th_op;
+                break;
+            }
+        }
+    }
+}
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Run the program in memory from the current Program Counter until an
+ *  instruction reports zero states (HALT or an invalid op-code).
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The caller is responsible for resetting the CPU.
+ *
+ ****************************************************************************/
+
+void
+inst_threaded(
+    void
+    )
+{
+    /**
+     *  @param  op_code         Current instruction code                    */
+    uint8_t                     op_code;
+    /**
+     *  @param  t_states        Clock states executed since entry           */
+    uint64_t                    t_states;
+    /**
+     *  @param  t_inst          Instructions retired since entry            */
+    uint64_t                    t_inst;
+    /**
+     *  @param  cpu_mode        CPU mode the dispatch tables are built for  */
+    enum    CPU_e               cpu_mode;
+    /**
+     *  @param  threaded_i80    Inlined body for each Intel 8080 op-code
+     *  @param  threaded_z80    Inlined body for each Zilog Z80 op-code     */
+    uint8_t                     threaded_i80[ 256 ];
+    uint8_t                     threaded_z80[ 256 ];
+    /**
+     *  @param  th_table        Inlined body for each op-code               */
+    const
+    uint8_t                     *th_table;
+    /**
+     *  @param  op_table        Handler table for the current CPU mode      */
+    void                        (**op_table)( uint8_t );
+    /**
+     *  @param  tmp             Temporary data buffer                       */
+    uint16_t                    tmp;
+#if INST_ENGINE == INST_ENGINE_BLOCK
+    /**
+     *  @param  entry           Decoded instruction being executed          */
+    const
+    struct  block_entry_t       *entry;
+    /**
+     *  @param  block_entry     First entry not yet counted as retired      */
+    const
+    struct  block_entry_t       *block_entry;
+#endif
+#if JIT_ENABLE
+    /**
+     *  @param  block           Block being executed                        */
+    struct  block_t             *block;
+    /**
+     *  @param  jit_rc          Program Counter and states from native code */
+    uint32_t                    jit_rc;
+#endif
+#if THREADED_GOTO
+#if INST_ENGINE != INST_ENGINE_BLOCK
+    /**
+     *  @param  op_ndx          Index into the dispatch table               */
+    int                         op_ndx;
+    /**
+     *  @param  dispatch        Label for each op-code                      */
+    const
+    void                        *dispatch[ 256 ];
+#endif
+    /**
+     *  @param  th_label        Label for each inlined body                 */
+    static
+    const
+    void                * const th_label[ TH_COUNT ] =
+    {
+        [ TH_CALL       ] = &&th_CALL,
+        [ TH_NOP        ] = &&th_NOP,
+        [ TH_LD_RR      ] = &&th_LD_RR,
+        [ TH_LD_RN      ] = &&th_LD_RN,
+        [ TH_LD_RHL     ] = &&th_LD_RHL,
+        [ TH_LD_HLR     ] = &&th_LD_HLR,
+        [ TH_LD_HLN     ] = &&th_LD_HLN,
+        [ TH_LD_ASS     ] = &&th_LD_ASS,
+        [ TH_LD_ANN     ] = &&th_LD_ANN,
+        [ TH_LD_SSA     ] = &&th_LD_SSA,
+        [ TH_LD_NNA     ] = &&th_LD_NNA,
+        [ TH_LD_SSNN    ] = &&th_LD_SSNN,
+        [ TH_LD_HLNN    ] = &&th_LD_HLNN,
+        [ TH_LD_NNHL    ] = &&th_LD_NNHL,
+        [ TH_LD_SPHL    ] = &&th_LD_SPHL,
+        [ TH_PUSH       ] = &&th_PUSH,
+        [ TH_POP        ] = &&th_POP,
+        [ TH_EX_DEHL    ] = &&th_EX_DEHL,
+        [ TH_EX_SPHL    ] = &&th_EX_SPHL,
+        [ TH_EX_AFAF    ] = &&th_EX_AFAF,
+        [ TH_EXX        ] = &&th_EXX,
+        [ TH_ADD_R      ] = &&th_ADD_R,
+        [ TH_ADD_N      ] = &&th_ADD_N,
+        [ TH_ADD_HL     ] = &&th_ADD_HL,
+        [ TH_ADC_R      ] = &&th_ADC_R,
+        [ TH_ADC_N      ] = &&th_ADC_N,
+        [ TH_ADC_HL     ] = &&th_ADC_HL,
+        [ TH_SUB_R      ] = &&th_SUB_R,
+        [ TH_SUB_N      ] = &&th_SUB_N,
+        [ TH_SUB_HL     ] = &&th_SUB_HL,
+        [ TH_SBC_R      ] = &&th_SBC_R,
+        [ TH_SBC_N      ] = &&th_SBC_N,
+        [ TH_SBC_HL     ] = &&th_SBC_HL,
+        [ TH_INC_R      ] = &&th_INC_R,
+        [ TH_INC_HL     ] = &&th_INC_HL,
+        [ TH_DEC_R      ] = &&th_DEC_R,
+        [ TH_DEC_HL     ] = &&th_DEC_HL,
+        [ TH_AND_R      ] = &&th_AND_R,
+        [ TH_AND_N      ] = &&th_AND_N,
+        [ TH_AND_HL     ] = &&th_AND_HL,
+        [ TH_OR_R       ] = &&th_OR_R,
+        [ TH_OR_N       ] = &&th_OR_N,
+        [ TH_OR_HL      ] = &&th_OR_HL,
+        [ TH_XOR_R      ] = &&th_XOR_R,
+        [ TH_XOR_N      ] = &&th_XOR_N,
+        [ TH_XOR_HL     ] = &&th_XOR_HL,
+        [ TH_CP_R       ] = &&th_CP_R,
+        [ TH_CP_N       ] = &&th_CP_N,
+        [ TH_CP_HL      ] = &&th_CP_HL,
+        [ TH_INC_SS     ] = &&th_INC_SS,
+        [ TH_DEC_SS     ] = &&th_DEC_SS,
+        [ TH_CPL        ] = &&th_CPL,
+        [ TH_SCF        ] = &&th_SCF,
+        [ TH_CCF        ] = &&th_CCF,
+        [ TH_JP         ] = &&th_JP,
+        [ TH_JP_CC      ] = &&th_JP_CC,
+        [ TH_JP_HL      ] = &&th_JP_HL,
+        [ TH_JR         ] = &&th_JR,
+        [ TH_JR_CC      ] = &&th_JR_CC,
+        [ TH_DJNZ       ] = &&th_DJNZ,
+        [ TH_CALL_NN    ] = &&th_CALL_NN,
+        [ TH_CALL_CC    ] = &&th_CALL_CC,
+        [ TH_RET        ] = &&th_RET,
+        [ TH_RET_CC     ] = &&th_RET_CC,
+        [ TH_RST        ] = &&th_RST,
+        [ TH_BLOCK_END  ] = &&th_BLOCK_END
+    };
+#endif
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    //  Map every op-code to its inlined body
+    threaded_classify( op_code_i80_table, threaded_i80 );
+    threaded_classify( op_code_z80_table, threaded_z80 );
+
+    //  No states have been executed yet
+    t_states = 0;
+    t_inst = 0;
+
+    //  Start the guest clock
+    pace_start( t_states );
+
+    /************************************************************************
+     *  Main instruction loop
+     ************************************************************************/
+
+select_mode:
+
+    //  Select the tables for the current CPU mode
+    cpu_mode = CPU;
+    if ( cpu_mode == CPU_I80 )
+    {
+        //  YES:    Use the 8080 instruction set
+        th_table = threaded_i80;
+        op_table = op_code_i80_table;
+    }
+    else
+    {
+        //  NO:     Use the Zilog Z80 instruction set
+        th_table = threaded_z80;
+        op_table = op_code_z80_table;
+    }
+
+#if INST_ENGINE == INST_ENGINE_BLOCK
+    //  Blocks decoded for another CPU mode are of no use
+    block_cache_select( cpu_mode );
+
+    //  Find (or decode) the block at the Program Counter
+    entry = block_cache_lookup( CPU_REG_PC, th_table )->entry;
+    block_entry = entry;
+
+#if THREADED_GOTO
+    //  Start executing instructions
+    goto *th_label[ entry->th_op ];
+#else
+    //  Start executing instructions
+    while( 1 )
+    {
+        switch( entry->th_op )
+        {
+#endif
+#else
+#if THREADED_GOTO
+    //  Build the label dispatch table
+    for( op_ndx = 0; op_ndx < 256; op_ndx += 1 )
+    {
+        dispatch[ op_ndx ] = th_label[ th_table[ op_ndx ] ];
+    }
+
+    //  Start executing instructions
+    DISPATCH( );
+#else
+    //  Start executing instructions
+    while( 1 )
+    {
+        op_code = FETCH( );
+
+        switch( th_table[ op_code ] )
+        {
+#endif
+#endif
+
+    /************************************************************************
+     *  End of a decoded block
+     ************************************************************************/
+
+#if THREADED_GOTO
+th_BLOCK_END:
+#else
+        case TH_BLOCK_END:
+#endif
+#if INST_ENGINE == INST_ENGINE_BLOCK
+block_lookup:
+
+    //  Count the block, publish the counters and hold the guest to its
+    //  real-time clock
+    COUNT_RETIRED( );
+    STATS_SYNC( t_inst, t_states );
+    PACE( t_states );
+
+    //  Take an interrupt between blocks
+    INTERRUPT( t_states );
+
+#if JIT_ENABLE
+    //  Continue with the block at the Program Counter
+    block = block_cache_lookup( CPU_REG_PC, th_table );
+
+    //  Has the block become hot ?
+    if (    ( block->jit_code == NULL )
+         && ( ++block->hits == JIT_THRESHOLD ) )
+    {
+        //  YES:    Translate it
+        if ( jit_translate( block ) == JIT_RC_FULL )
+        {
+            //  Out of room, start over with an empty cache
+            block_cache_flush( );
+            goto block_lookup;
+        }
+    }
+
+    //  Is there native code for the block that can run in this bank ?
+    if (    ( block->jit_code != NULL )
+         && ( machine->mem_bank == 0 ) )
+    {
+        //  YES:    Run it
+        jit_rc = jit_run( block );
+        CPU_REG_PC = (uint16_t)jit_rc;
+        t_states += ( jit_rc >> 16 );
+        t_inst += jit_retired( block, CPU_REG_PC );
+
+        //  Did it modify any cached code ?
+        if ( machine->block_stale )
+            goto block_lookup;
+
+        //  Interpret whatever wasn't translated
+        entry = &block->entry[ block->jit_count ];
+    }
+    else
+    {
+        entry = block->entry;
+    }
+#else
+    //  Continue with the block at the Program Counter
+    entry = block_cache_lookup( CPU_REG_PC, th_table )->entry;
+#endif
+    block_entry = entry;
+#if THREADED_GOTO
+    goto *th_label[ entry->th_op ];
+#else
+    continue;
+#endif
+#else
+    //  Never decoded when running from main memory
+    goto engine_exit;
+#endif
+
+    /************************************************************************
+     *  Everything that is not inlined
+     ************************************************************************/
+
+    TH_OP( CALL )
+    {
+        //  Set the instruction set to 'BASIC'
+        EIS = EIS_BASE;
+
+        //  Save the Program Counter of this instruction
+        machine->pc = CPU_REG_PC - 1;
+
+        //  The handler may report the counters
+        COUNT_RETIRED( );
+        STATS_SYNC( t_inst, t_states );
+
+        //  Execute the op-code
+        (*op_table[ op_code ])( op_code );
+
+        //  Was the op-code execution successful ?
+        if ( machine->operation_rc.states == 0 )
+        {
+            //  NO:     Terminate
+            goto engine_exit;
+        }
+
+        //  Did the instruction change the CPU mode ?
+        if ( cpu_mode != CPU )
+        {
+            //  YES:    Account for the states and switch tables
+            t_states += machine->operation_rc.states;
+            t_inst += 1;
+            goto select_mode;
+        }
+    }
+    RETIRE( machine->operation_rc.states );
+
+    /************************************************************************
+     *  Control
+     ************************************************************************/
+
+    TH_OP( NOP )
+    RETIRE( 4 );
+
+    /************************************************************************
+     *  Load
+     ************************************************************************/
+
+    TH_OP( LD_RR )
+    REG_R( op_code >> 3 ) = REG_R( op_code );
+    RETIRE( 4 );
+
+    TH_OP( LD_RN )
+    reg_put_dr( op_code, IMM_8( ) );
+    RETIRE( 7 );
+
+    TH_OP( LD_RHL )
+    reg_put_dr( op_code, memory_get_8( CPU_REG_HL ) );
+    RETIRE( 7 );
+
+    TH_OP( LD_HLR )
+    memory_put_8( CPU_REG_HL, reg_get_sr( op_code ) );
+    RETIRE_W( 7 );
+
+    TH_OP( LD_HLN )
+    memory_put_8( CPU_REG_HL, IMM_8( ) );
+    RETIRE_W( 10 );
+
+    TH_OP( LD_ASS )
+    PUT_A( memory_get_8( reg_get_ss( op_code ) ) );
+    RETIRE( 7 );
+
+    TH_OP( LD_ANN )
+    PUT_A( memory_get_8( IMM_16( ) ) );
+    RETIRE( 13 );
+
+    TH_OP( LD_SSA )
+    memory_put_8( reg_get_ss( op_code ), GET_A( ) );
+    RETIRE_W( 7 );
+
+    TH_OP( LD_NNA )
+    memory_put_8( IMM_16( ), GET_A( ) );
+    RETIRE_W( 13 );
+
+    TH_OP( LD_SSNN )
+    reg_put_ss( op_code, IMM_16( ) );
+    RETIRE( 10 );
+
+    TH_OP( LD_HLNN )
+    CPU_REG_HL = memory_get_16_p( IMM_16( ) );
+    RETIRE( 16 );
+
+    TH_OP( LD_NNHL )
+    memory_put_16_p( IMM_16( ), CPU_REG_HL );
+    RETIRE_W( 16 );
+
+    TH_OP( LD_SPHL )
+    CPU_REG_SP = CPU_REG_HL;
+    RETIRE( 6 );
+
+    TH_OP( PUSH )
+    push( reg_get_qq( op_code ) );
+    RETIRE_W( 11 );
+
+    TH_OP( POP )
+    reg_put_qq( op_code, pop( ) );
+    RETIRE( 11 );
+
+    /************************************************************************
+     *  Exchange
+     ************************************************************************/
+
+    TH_OP( EX_DEHL )
+    tmp = CPU_REG_HL;
+    CPU_REG_HL = CPU_REG_DE;
+    CPU_REG_DE = tmp;
+    RETIRE( 4 );
+
+    TH_OP( EX_SPHL )
+    tmp = CPU_REG_HL;
+    PUT_L( memory_get_8( CPU_REG_SP     ) );
+    PUT_H( memory_get_8( CPU_REG_SP + 1 ) );
+    memory_put_8( ( CPU_REG_SP     ), ( tmp & 0x00FF )      );
+    memory_put_8( ( CPU_REG_SP + 1 ), ( tmp & 0xFF00 ) >> 8 );
+    RETIRE_W( 19 );
+
+    TH_OP( EX_AFAF )
+    FLAGS_SYNC( );
+    tmp = CPU_REG_AF;
+    CPU_REG_AF = CPU_REG_AF_;
+    CPU_REG_AF_ = tmp;
+    RETIRE( 4 );
+
+    TH_OP( EXX )
+    tmp = CPU_REG_BC;   CPU_REG_BC = CPU_REG_BC_;   CPU_REG_BC_ = tmp;
+    tmp = CPU_REG_DE;   CPU_REG_DE = CPU_REG_DE_;   CPU_REG_DE_ = tmp;
+    tmp = CPU_REG_HL;   CPU_REG_HL = CPU_REG_HL_;   CPU_REG_HL_ = tmp;
+    RETIRE( 4 );
+
+    /************************************************************************
+     *  8 bit arithmetic
+     ************************************************************************/
+
+    TH_OP( ADD_R )
+    PUT_A( add_8( reg_get_sr( op_code ), GET_A( ), 0 ) );
+    RETIRE( 4 );
+
+    TH_OP( ADD_N )
+    PUT_A( add_8( IMM_8( ), GET_A( ), 0 ) );
+    RETIRE( 7 );
+
+    TH_OP( ADD_HL )
+    PUT_A( add_8( memory_get_8( CPU_REG_HL ), GET_A( ), 0 ) );
+    RETIRE( 7 );
+
+    TH_OP( ADC_R )
+    PUT_A( add_8( reg_get_sr( op_code ), GET_A( ), GET_FLAG_C( ) ) );
+    RETIRE( 4 );
+
+    TH_OP( ADC_N )
+    PUT_A( add_8( IMM_8( ), GET_A( ), GET_FLAG_C( ) ) );
+    RETIRE( 7 );
+
+    TH_OP( ADC_HL )
+    PUT_A( add_8( memory_get_8( CPU_REG_HL ), GET_A( ), GET_FLAG_C( ) ) );
+    RETIRE( 7 );
+
+    TH_OP( SUB_R )
+    PUT_A( sub_8( GET_A( ), reg_get_sr( op_code ), 0 ) );
+    RETIRE( 4 );
+
+    TH_OP( SUB_N )
+    PUT_A( sub_8( GET_A( ), IMM_8( ), 0 ) );
+    RETIRE( 7 );
+
+    TH_OP( SUB_HL )
+    PUT_A( sub_8( GET_A( ), memory_get_8( CPU_REG_HL ), 0 ) );
+    RETIRE( 7 );
+
+    TH_OP( SBC_R )
+    PUT_A( sub_8( GET_A( ), reg_get_sr( op_code ), GET_FLAG_C( ) ) );
+    RETIRE( 4 );
+
+    TH_OP( SBC_N )
+    PUT_A( sub_8( GET_A( ), IMM_8( ), GET_FLAG_C( ) ) );
+    RETIRE( 7 );
+
+    TH_OP( SBC_HL )
+    PUT_A( sub_8( GET_A( ), memory_get_8( CPU_REG_HL ), GET_FLAG_C( ) ) );
+    RETIRE( 7 );
+
+    TH_OP( INC_R )
+    reg_put_dr( op_code, inc_8( reg_get_dr( op_code ) ) );
+    RETIRE( 4 );
+
+    TH_OP( INC_HL )
+    memory_put_8( CPU_REG_HL, ( inc_8( memory_get_8( CPU_REG_HL ) ) ) );
+    RETIRE_W( 11 );
+
+    TH_OP( DEC_R )
+    reg_put_dr( op_code, dec_8( reg_get_dr( op_code ) ) );
+    RETIRE( 4 );
+
+    TH_OP( DEC_HL )
+    memory_put_8( CPU_REG_HL, ( dec_8( memory_get_8( CPU_REG_HL ) ) ) );
+    RETIRE_W( 11 );
+
+    TH_OP( CPL )
+    PUT_A( ( GET_A( ) ^ 0xFF ) );
+    SET_FLAG_N( );
+    SET_FLAG_H( );
+    RETIRE( 4 );
+
+    TH_OP( SCF )
+    SET_FLAG_C( );
+    CLEAR_FLAG_N( );
+    CLEAR_FLAG_H( );
+    RETIRE( 4 );
+
+    TH_OP( CCF )
+    PUT_F( ( GET_F( ) ^ CPU_FLAG_C ) );
+    CLEAR_FLAG_N( );
+    if ( ( GET_F( ) & CPU_FLAG_C ) ) CLEAR_FLAG_H( ); else SET_FLAG_H( );
+    RETIRE( 4 );
+
+    /************************************************************************
+     *  Logic
+     ************************************************************************/
+
+    TH_OP( AND_R )
+    PUT_A( and_8( reg_get_sr( op_code ), GET_A( ) ) );
+    RETIRE( 4 );
+
+    TH_OP( AND_N )
+    PUT_A( and_8( IMM_8( ), GET_A( ) ) );
+    RETIRE( 7 );
+
+    TH_OP( AND_HL )
+    PUT_A( and_8( memory_get_8( CPU_REG_HL ), GET_A( ) ) );
+    RETIRE( 7 );
+
+    TH_OP( OR_R )
+    PUT_A( or_8( reg_get_sr( op_code ), GET_A( ) ) );
+    RETIRE( 4 );
+
+    TH_OP( OR_N )
+    PUT_A( or_8( IMM_8( ), GET_A( ) ) );
+    RETIRE( 7 );
+
+    TH_OP( OR_HL )
+    PUT_A( or_8( memory_get_8( CPU_REG_HL ), GET_A( ) ) );
+    RETIRE( 7 );
+
+    TH_OP( XOR_R )
+    PUT_A( xor_8( reg_get_sr( op_code ), GET_A( ) ) );
+    RETIRE( 4 );
+
+    TH_OP( XOR_N )
+    PUT_A( xor_8( IMM_8( ), GET_A( ) ) );
+    RETIRE( 7 );
+
+    TH_OP( XOR_HL )
+    PUT_A( xor_8( memory_get_8( CPU_REG_HL ), GET_A( ) ) );
+    RETIRE( 7 );
+
+    TH_OP( CP_R )
+    compare_8( GET_A( ), reg_get_sr( op_code ) );
+    RETIRE( 4 );
+
+    TH_OP( CP_N )
+    compare_8( GET_A( ), IMM_8( ) );
+    RETIRE( 7 );
+
+    TH_OP( CP_HL )
+    compare_8( GET_A( ), memory_get_8( CPU_REG_HL ) );
+    RETIRE( 7 );
+
+    /************************************************************************
+     *  16 bit arithmetic
+     ************************************************************************/
+
+    TH_OP( INC_SS )
+    reg_put_ss( op_code, ( reg_get_ss( op_code ) + 1 ) );
+    RETIRE( 6 );
+
+    TH_OP( DEC_SS )
+    reg_put_ss( op_code, ( reg_get_ss( op_code ) - 1 ) );
+    RETIRE( 6 );
+
+    /************************************************************************
+     *  Jump
+     ************************************************************************/
+
+    TH_OP( JP )
+    CPU_REG_PC = IMM_16( );
+    RETIRE( 10 );
+
+    TH_OP( JP_CC )
+    tmp = IMM_16( );
+    if ( is_ccc( op_code ) == true )
+        CPU_REG_PC = tmp;
+    RETIRE( 10 );
+
+    TH_OP( JP_HL )
+    CPU_REG_PC = CPU_REG_HL;
+    RETIRE( 4 );
+
+    TH_OP( JR )
+    tmp = IMM_E( );
+    CPU_REG_PC += tmp;
+    RETIRE( 12 );
+
+    TH_OP( JR_CC )
+    tmp = IMM_E( );
+    if ( is_cc( op_code ) == true )
+    {
+        CPU_REG_PC += tmp;
+        RETIRE( 12 );
+    }
+    RETIRE( 7 );
+
+    TH_OP( DJNZ )
+    PUT_B( ( GET_B( ) - 1 ) );
+    tmp = IMM_E( );
+    if( GET_B( ) != 0 )
+    {
+        CPU_REG_PC += tmp;
+        RETIRE( 13 );
+    }
+    RETIRE( 8 );
+
+    /************************************************************************
+     *  Call and Return
+     ************************************************************************/
+
+    TH_OP( CALL_NN )
+    tmp = IMM_16( );
+    push( CPU_REG_PC );
+    CPU_REG_PC = tmp;
+    RETIRE_W( 17 );
+
+    TH_OP( CALL_CC )
+    tmp = IMM_16( );
+    if ( is_ccc( op_code ) == true )
+    {
+        push( CPU_REG_PC );
+        CPU_REG_PC = tmp;
+        RETIRE_W( 17 );
+    }
+    RETIRE( 10 );
+
+    TH_OP( RET )
+    CPU_REG_PC = pop( );
+    RETIRE( 10 );
+
+    TH_OP( RET_CC )
+    if ( is_ccc( op_code ) == true )
+    {
+        CPU_REG_PC = pop( );
+        RETIRE( 11 );
+    }
+    RETIRE( 5 );
+
+    TH_OP( RST )
+    push( CPU_REG_PC );
+    CPU_REG_PC = ( op_code & 0x38 );
+    RETIRE_W( 11 );
+
+#if !THREADED_GOTO
+        }
+    }
+#endif
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+engine_exit:
+
+    //  Leave the counters up to date
+    COUNT_RETIRED( );
+    STATS_SYNC( t_inst, t_states );
+
+    //  Leave the refresh register up to date
+    refresh_sync( );
+
+    //  DONE!
+    return;
+}
+
+/****************************************************************************/
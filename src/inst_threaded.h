@@ -0,0 +1,151 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+#ifndef INST_THREADED_H
+#define INST_THREADED_H
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Shared definitions for the threaded code interpreter and the decoded
+ *  block cache.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * System APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Application APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  threaded_op_e       Inlined instruction bodies                  */
+enum    threaded_op_e
+{
+    TH_CALL                 =  0,               //  Call the table handler
+    TH_NOP,                                     //  NOP
+    TH_LD_RR,                                   //  LD   r, r'
+    TH_LD_RN,                                   //  LD   r, n
+    TH_LD_RHL,                                  //  LD   r, (HL)
+    TH_LD_HLR,                                  //  LD   (HL), r
+    TH_LD_HLN,                                  //  LD   (HL), n
+    TH_LD_ASS,                                  //  LD   A, (ss)
+    TH_LD_ANN,                                  //  LD   A, (nn)
+    TH_LD_SSA,                                  //  LD   (ss), A
+    TH_LD_NNA,                                  //  LD   (nn), A
+    TH_LD_SSNN,                                 //  LD   ss, nn
+    TH_LD_HLNN,                                 //  LD   HL, (nn)
+    TH_LD_NNHL,                                 //  LD   (nn), HL
+    TH_LD_SPHL,                                 //  LD   SP, HL
+    TH_PUSH,                                    //  PUSH qq
+    TH_POP,                                     //  POP  qq
+    TH_EX_DEHL,                                 //  EX   DE, HL
+    TH_EX_SPHL,                                 //  EX   (SP), HL
+    TH_EX_AFAF,                                 //  EX   AF, AF'
+    TH_EXX,                                     //  EXX
+    TH_ADD_R,                                   //  ADD  A, r
+    TH_ADD_N,                                   //  ADD  A, n
+    TH_ADD_HL,                                  //  ADD  A, (HL)
+    TH_ADC_R,                                   //  ADC  A, r
+    TH_ADC_N,                                   //  ADC  A, n
+    TH_ADC_HL,                                  //  ADC  A, (HL)
+    TH_SUB_R,                                   //  SUB  r
+    TH_SUB_N,                                   //  SUB  n
+    TH_SUB_HL,                                  //  SUB  (HL)
+    TH_SBC_R,                                   //  SBC  A, r
+    TH_SBC_N,                                   //  SBC  A, n
+    TH_SBC_HL,                                  //  SBC  A, (HL)
+    TH_INC_R,                                   //  INC  r
+    TH_INC_HL,                                  //  INC  (HL)
+    TH_DEC_R,                                   //  DEC  r
+    TH_DEC_HL,                                  //  DEC  (HL)
+    TH_AND_R,                                   //  AND  r
+    TH_AND_N,                                   //  AND  n
+    TH_AND_HL,                                  //  AND  (HL)
+    TH_OR_R,                                    //  OR   r
+    TH_OR_N,                                    //  OR   n
+    TH_OR_HL,                                   //  OR   (HL)
+    TH_XOR_R,                                   //  XOR  r
+    TH_XOR_N,                                   //  XOR  n
+    TH_XOR_HL,                                  //  XOR  (HL)
+    TH_CP_R,                                    //  CP   r
+    TH_CP_N,                                    //  CP   n
+    TH_CP_HL,                                   //  CP   (HL)
+    TH_INC_SS,                                  //  INC  ss
+    TH_DEC_SS,                                  //  DEC  ss
+    TH_CPL,                                     //  CPL
+    TH_SCF,                                     //  SCF
+    TH_CCF,                                     //  CCF
+    TH_JP,                                      //  JP   nn
+    TH_JP_CC,                                   //  JP   cc, nn
+    TH_JP_HL,                                   //  JP   (HL)
+    TH_JR,                                      //  JR   e
+    TH_JR_CC,                                   //  JR   cc, e
+    TH_DJNZ,                                    //  DJNZ e
+    TH_CALL_NN,                                 //  CALL nn
+    TH_CALL_CC,                                 //  CALL cc, nn
+    TH_RET,                                     //  RET
+    TH_RET_CC,                                  //  RET  cc
+    TH_RST,                                     //  RST  p
+    TH_BLOCK_END,                               //  End of a decoded block
+    TH_COUNT                                    //  Number of entries
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Prototypes
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************/
+
+#endif                      //    INST_THREADED_H
@@ -0,0 +1,483 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Maskable interrupts.
+ *
+ *  A host side device requests an interrupt with interrupt_raise( ), from
+ *  the guest thread or from its own, and hands over the byte it puts on
+ *  the data bus.  The instruction loops test a single flag with
+ *  INTERRUPT( ) after every instruction, or every block for the block
+ *  engine, and only call interrupt_accept( ) when it is set.  Only the
+ *  guest knows IFF1, a device sets interrupt_pending whenever it raises
+ *  the line and interrupt_accept( ) clears it again while interrupts are
+ *  disabled.  EI sets it for a request that is still waiting.
+ *
+ *      IM 0            The data bus byte is executed, only RST n is
+ *                      supported.  The Intel 8080 always works this way.
+ *      IM 1            RST 38h
+ *      IM 2            Indirect call through the word at I * 256 + data
+ *
+ *  An interrupt is not taken before the instruction that follows EI has
+ *  finished.  HALT waits for an interrupt when IFF1 is set and a device
+ *  registered with interrupt_source( ) can raise one, raising the line
+ *  wakes it up.  Otherwise nothing could end the wait so HALT ends the
+ *  run, the way every POST program stops.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <stdio.h>              //  Standard I/O definitions
+#include <pthread.h>            //  Host threads
+#include <stdatomic.h>          //  Requests from other host threads
+                                //*******************************************
+
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "memory.h"             //  Memory management and access
+#include "registers.h"          //  All things CPU registers.
+#include "stats.h"              //  Performance counters
+#include "profile.h"            //  Guest hot-spot profiler
+#include "interrupt.h"          //  Maskable interrupts
+#include "machine.h"            //  Guest machine context
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Have the instruction loop look at a request that can be taken.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Never clears interrupt_pending, a device may have set it since the
+ *      line was read.  interrupt_accept( ) is the only one that clears it.
+ *
+ ****************************************************************************/
+
+static
+void
+interrupt_update(
+    void
+    )
+{
+    //  Is a request waiting while interrupts are enabled ?
+    if (    ( machine->interrupt.iff1 == true )
+         && ( atomic_load( &machine->interrupt.line ) != 0 ) )
+    {
+        //  YES:    Take it between instructions
+        atomic_store( &machine->interrupt_pending, 1 );
+    }
+}
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Set up the wait of a new guest.
+ *
+ *  @param  guest               The guest, zero filled by machine_create( ).
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      No device is registered.
+ *
+ ****************************************************************************/
+
+void
+interrupt_create(
+    struct  machine_t       *   guest
+    )
+{
+    pthread_mutex_init( &guest->interrupt_wait.lock, NULL );
+    pthread_cond_init( &guest->interrupt_wait.wake, NULL );
+}
+
+/****************************************************************************/
+/**
+ *  Release the wait of a guest.
+ *
+ *  @param  guest               The guest, it must not be running.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+interrupt_destroy(
+    struct  machine_t       *   guest
+    )
+{
+    pthread_cond_destroy( &guest->interrupt_wait.wake );
+    pthread_mutex_destroy( &guest->interrupt_wait.lock );
+}
+
+/****************************************************************************/
+/**
+ *  RESET disables interrupts and selects interrupt mode 0.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      A request that is already raised stays raised, it belongs to the
+ *      device.
+ *
+ ****************************************************************************/
+
+void
+interrupt_reset(
+    void
+    )
+{
+    machine->interrupt.iff1 = false;
+    machine->interrupt.iff2 = false;
+    machine->interrupt.mode = 0;
+    machine->interrupt.ei_inst = 0;
+    atomic_store( &machine->interrupt_pending, 0 );
+}
+
+/****************************************************************************/
+/**
+ *  Register or remove a device that can raise an interrupt.
+ *
+ *  @param  guest               The guest the device is attached to.
+ *  @param  attach              true when the device is added, false when it
+ *                              is removed.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      HALT only waits while a device is registered.  Removing the last
+ *      one wakes a halted guest so its run ends.
+ *
+ ****************************************************************************/
+
+void
+interrupt_source(
+    struct  machine_t       *   guest,
+    bool                        attach
+    )
+{
+    //  Is a device added ?
+    if ( attach == true )
+    {
+        //  YES:    Count it
+        atomic_fetch_add( &guest->interrupt_wait.sources, 1 );
+    }
+    else
+    {
+        //  NO:     Count it and let a halted guest check again
+        atomic_fetch_sub( &guest->interrupt_wait.sources, 1 );
+
+        if ( atomic_load( &guest->interrupt_wait.halted ) == true )
+        {
+            pthread_mutex_lock( &guest->interrupt_wait.lock );
+            pthread_cond_signal( &guest->interrupt_wait.wake );
+            pthread_mutex_unlock( &guest->interrupt_wait.lock );
+        }
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Request an interrupt.
+ *
+ *  @param  guest               The guest the device is attached to.
+ *  @param  data                Byte the device puts on the data bus, the
+ *                              instruction for IM 0 or the vector for IM 2.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The request is held until the CPU accepts it.  Safe from any host
+ *      thread, the data bus byte is published before the line.
+ *
+ ****************************************************************************/
+
+void
+interrupt_raise(
+    struct  machine_t       *   guest,
+    uint8_t                     data
+    )
+{
+    //  Put the byte on the data bus and raise the line
+    atomic_store_explicit( &guest->interrupt.data, data, memory_order_release );
+    atomic_store( &guest->interrupt.line, 1 );
+
+    //  The guest checks IFF1 when it looks at it
+    atomic_store( &guest->interrupt_pending, 1 );
+
+    //  Is the guest halted ?
+    if ( atomic_load( &guest->interrupt_wait.halted ) == true )
+    {
+        //  YES:    Wake it up
+        pthread_mutex_lock( &guest->interrupt_wait.lock );
+        pthread_cond_signal( &guest->interrupt_wait.wake );
+        pthread_mutex_unlock( &guest->interrupt_wait.lock );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  EI and DI.
+ *
+ *  @param  enable              true for EI, false for DI.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Must be called from an op-code handler, EI remembers where it was
+ *      executed so the next instruction can finish first.
+ *
+ ****************************************************************************/
+
+void
+interrupt_enable(
+    bool                        enable
+    )
+{
+    machine->interrupt.iff1 = enable;
+    machine->interrupt.iff2 = enable;
+    machine->interrupt.ei_inst = machine->stats.instructions;
+    interrupt_update( );
+}
+
+/****************************************************************************/
+/**
+ *  RETN copies IFF2 back to IFF1.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+interrupt_restore(
+    void
+    )
+{
+    machine->interrupt.iff1 = machine->interrupt.iff2;
+    interrupt_update( );
+}
+
+/****************************************************************************/
+/**
+ *  Take a pending interrupt.
+ *
+ *  @param
+ *
+ *  @return                     Clock states used, 0 when interrupts are
+ *                              disabled or it has to wait for the
+ *                              instruction that follows EI.
+ *
+ *  @note
+ *      Called through INTERRUPT( ) when interrupt_pending is set.  The
+ *      instruction loops publish the instructions retired first.
+ *
+ ****************************************************************************/
+
+int
+interrupt_accept(
+    void
+    )
+{
+    /**
+     *  @param  states          Clock states of the acknowledge cycle       */
+    int                         states;
+    /**
+     *  @param  vector          IM 2 vector table entry                     */
+    uint16_t                    vector;
+    /**
+     *  @param  data            Byte the device put on the data bus         */
+    uint8_t                     data;
+
+    //  Are interrupts enabled ?
+    if ( machine->interrupt.iff1 == false )
+    {
+        //  NO:     A device raised the line, EI looks at it again
+        atomic_store( &machine->interrupt_pending, 0 );
+        return( 0 );
+    }
+
+    //  Has the instruction after EI finished ?
+    if ( machine->stats.instructions < ( machine->interrupt.ei_inst + 2 ) )
+    {
+        //  NO:     Try again after the next one
+        return( 0 );
+    }
+
+    //  Acknowledge the request, a request raised after this is the next one
+    atomic_store( &machine->interrupt_pending, 0 );
+    if ( atomic_exchange( &machine->interrupt.line, 0 ) == 0 )
+    {
+        //  It was already taken
+        return( 0 );
+    }
+    data = atomic_load_explicit( &machine->interrupt.data, memory_order_acquire );
+
+    //  Disable interrupts
+    machine->interrupt.iff1 = false;
+    machine->interrupt.iff2 = false;
+
+    //  The acknowledge cycle is an M1 cycle
+    refresh_acknowledge( );
+
+    //  Which interrupt mode ?
+    switch( ( CPU == CPU_I80 ) ? 0 : machine->interrupt.mode )
+    {
+        case    0:              //  Execute the data bus byte
+        default:
+        {
+            //  Is it an RST n ?
+            if ( ( data & 0xC7 ) == 0xC7 )
+            {
+                //  YES:    Call the restart address
+                push( CPU_REG_PC );
+                CPU_REG_PC = data & 0x38;
+                states = ( CPU == CPU_I80 ) ? 11 : 13;
+            }
+            else
+            {
+                //  NO:     Anything else runs as a NOP
+                states = 6;
+            }
+        }   break;
+        case    1:              //  RST 38h
+        {
+            push( CPU_REG_PC );
+            CPU_REG_PC = 0x0038;
+            states = 13;
+        }   break;
+        case    2:              //  Call through the vector table
+        {
+            push( CPU_REG_PC );
+            vector = ( CPU_REG_I << 8 ) | ( data & 0xFE );
+            CPU_REG_PC = memory_get_16_p( vector );
+            states = 19;
+        }   break;
+    }
+
+    //  The service routine is a subroutine
+    PROFILE_CALL( CPU_REG_PC );
+
+    //  DONE!
+    return( states );
+}
+
+/****************************************************************************/
+/**
+ *  HALT waits for an interrupt.
+ *
+ *  @param
+ *
+ *  @return                     true when a request was raised, false when
+ *                              no registered device is left to raise one.
+ *
+ *  @note
+ *      Only called with IFF1 set.  Sleeps until interrupt_raise( ) or
+ *      interrupt_source( ) wakes it up, no time is spent while halted.
+ *
+ ****************************************************************************/
+
+bool
+interrupt_halt(
+    void
+    )
+{
+    /**
+     *  @param  wait            Where the guest sleeps                      */
+    struct  interrupt_wait_t *  wait;
+
+    wait = &machine->interrupt_wait;
+
+    //  Wait for a device
+    pthread_mutex_lock( &wait->lock );
+    atomic_store( &wait->halted, true );
+    while (    ( atomic_load( &machine->interrupt.line ) == 0 )
+            && ( atomic_load( &wait->sources ) > 0 ) )
+    {
+        pthread_cond_wait( &wait->wake, &wait->lock );
+    }
+    atomic_store( &wait->halted, false );
+    pthread_mutex_unlock( &wait->lock );
+
+    //  Was a request raised ?
+    if ( atomic_load( &machine->interrupt.line ) == 0 )
+    {
+        //  NO:     Nothing can end the wait anymore
+        return( false );
+    }
+
+    //  Take it after HALT
+    interrupt_update( );
+
+    //  DONE!
+    return( true );
+}
+
+/****************************************************************************/
@@ -0,0 +1,177 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+#ifndef INTERRUPT_H
+#define INTERRUPT_H
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Maskable interrupts.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * System APIs
+ ****************************************************************************/
+
+                                //*******************************************
+#include <pthread.h>            //  Host threads
+#include <stdatomic.h>          //  Requests from other host threads
+                                //*******************************************
+
+/****************************************************************************
+ * Application APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  INTERRUPT           Called with the running clock state count
+ *                              between instructions ( or blocks ).  Only a
+ *                              flag test unless an interrupt can be taken. */
+#define INTERRUPT( T_STATES )   if ( atomic_load_explicit(                  \
+                                        &machine->interrupt_pending,        \
+                                        memory_order_relaxed ) )            \
+                                    ( T_STATES ) += interrupt_accept( )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  interrupt_t         Interrupt state of the CPU                  */
+struct  interrupt_t
+{
+    /**
+     *  @param  iff1            Interrupts are accepted                     */
+    bool                        iff1;
+    /**
+     *  @param  iff2            Copy of IFF1 ( LD A,I / RETN )              */
+    bool                        iff2;
+    /**
+     *  @param  mode            Interrupt mode ( IM 0, 1 or 2 )             */
+    uint8_t                     mode;
+    /**
+     *  @param  data            Byte the device puts on the data bus        */
+    _Atomic uint8_t             data;
+    /**
+     *  @param  ei_inst         Instructions retired before the last EI     */
+    uint64_t                    ei_inst;
+    /**
+     *  @param  line            A device is requesting an interrupt         */
+    _Atomic int                 line;
+};
+//----------------------------------------------------------------------------
+/**
+ *  @param  interrupt_wait_t    A halted CPU waiting for a device           */
+struct  interrupt_wait_t
+{
+    /**
+     *  @param  sources         Devices that can raise an interrupt         */
+    _Atomic int                 sources;
+    /**
+     *  @param  halted          The CPU waits in HALT                       */
+    _Atomic bool                halted;
+    /**
+     *  @param  lock            Only used to sleep and wake up              */
+    pthread_mutex_t             lock;
+    /**
+     *  @param  wake            Signalled when a request is raised          */
+    pthread_cond_t              wake;
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Prototypes
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+struct  machine_t;
+//----------------------------------------------------------------------------
+void
+interrupt_create(
+    struct  machine_t       *   guest
+    );
+//----------------------------------------------------------------------------
+void
+interrupt_destroy(
+    struct  machine_t       *   guest
+    );
+//----------------------------------------------------------------------------
+void
+interrupt_reset(
+    void
+    );
+//----------------------------------------------------------------------------
+void
+interrupt_source(
+    struct  machine_t       *   guest,
+    bool                        attach
+    );
+//----------------------------------------------------------------------------
+void
+interrupt_raise(
+    struct  machine_t       *   guest,
+    uint8_t                     data
+    );
+//----------------------------------------------------------------------------
+void
+interrupt_enable(
+    bool                        enable
+    );
+//----------------------------------------------------------------------------
+void
+interrupt_restore(
+    void
+    );
+//----------------------------------------------------------------------------
+int
+interrupt_accept(
+    void
+    );
+//----------------------------------------------------------------------------
+bool
+interrupt_halt(
+    void
+    );
+//----------------------------------------------------------------------------
+
+/****************************************************************************/
+
+#endif                      //    INTERRUPT_H
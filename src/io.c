@@ -40,6 +40,7 @@
 #include "registers.h"          //  All things CPU registers.
 #include "io.h"                 //  Input & Output instructions
 #include "bios.h"           //  CP/M BIOS
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -106,6 +107,8 @@
  *      We are running in a simulator and there isn't any hardware and
  *      thus no place to put the data.
  *
+ *      Port x'FD returns the memory bank that is visible.
+ *
  ****************************************************************************/
 
 void
@@ -120,8 +123,15 @@ in_n_i80(
     //  Read the port number to input from
     port = memory_get_8( CPU_REG_PC++ );
 
+    //  Which bank is visible ?
+    if ( port == MEMORY_BANK_PORT )
+    {
+        //  Report it
+        PUT_A( memory_bank_get( ) );
+    }
+
     //  Set the number of states for this instruction
-    operation_rc.states   =  11;
+    machine->operation_rc.states   =  11;
 }
 
 /****************************************************************************/
@@ -149,6 +159,8 @@ in_n_i80(
  *            x'FF             x'FF             Intel   I80
  *            x'FF             x'FE             Zilog   Z80
  *
+ *      Port x'FD selects the memory bank in A, see memory_bank_select( ).
+ *
  ****************************************************************************/
 
 void
@@ -170,6 +182,9 @@ out_n_i80(
     //  Are we changing the CPU type ?
     if( port == 0xFE )
     {
+        //  The pending flags belong to the current mode
+        FLAGS_SYNC( );
+
         //  Intel 8080 ?
         if( GET_A( ) == 0xFF )
         {
@@ -198,9 +213,21 @@ out_n_i80(
         //  YES:    Go perform the BIOS function
         cpm_bios( );
     }
+
+    /************************************************************************
+     *  x'FD    Memory bank
+     ************************************************************************/
+
+    //  Is this a bank switch ?
+    else
+    if ( port == MEMORY_BANK_PORT )
+    {
+        //  YES:    Make the bank in A visible below MEMORY_COMMON
+        memory_bank_select( GET_A( ) );
+    }
     //  @ToDo   Add the Z80 mode when it is ready to go.
 
     //  Set the number of states for this instruction
-    operation_rc.states   =  11;
+    machine->operation_rc.states   =  11;
 }
 /****************************************************************************/
\ No newline at end of file
@@ -40,6 +40,7 @@
 #include "registers.h"          //  All things CPU registers.
 #include "op_code.h"            //  OP-Code instruction maps
 #include "io.h"                 //  Input & Output instructions
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
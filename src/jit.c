@@ -0,0 +1,2102 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  x86-64 translator for hot decoded blocks.
+ *
+ *  A block from block_cache.c that has been entered JIT_THRESHOLD times is
+ *  translated into native code in an executable arena.  While translated
+ *  code runs the guest registers live in host registers:
+ *
+ *      rbx = BC    rbp = DE    r12 = HL    r13 = AF    r14 = SP
+ *      r15 = &machine->memory[ 0 ]
+ *
+ *  Memory reads are done inline from main memory, so translated code only
+ *  runs while bank 0 is visible.  Memory writes go through memory_put_8( )
+ *  and memory_put_16_p( ) so the cached blocks are still invalidated; when
+ *  a write hits cached code the translated block exits right after the
+ *  instruction that did it.
+ *
+ *  Flags are only produced when something can read them.  An arithmetic or
+ *  logic instruction whose flags are all overwritten before the next
+ *  conditional instruction, ADC/SBC, PUSH AF or the end of the block is
+ *  executed natively without them.  Otherwise the flag setting helper in
+ *  math.c or logic.c is called so both engines always agree.
+ *
+ *  Translation stops at the first instruction that has no native version
+ *  (I/O including the OUT 0xFF BIOS trap, HALT, prefixes, rotates, DAA,
+ *  etc.).  The interpreter continues the block from that instruction.
+ *
+ *  No page of the arena is ever writable and executable at the same time.
+ *  The pages a block is translated into are made writable for as long as
+ *  the translation takes and read / execute only afterwards.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+#define _DEFAULT_SOURCE         //  MAP_ANONYMOUS
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <unistd.h>             //  UNIX standard library.
+#include <stdio.h>              //  Standard I/O definitions
+#include <string.h>             //  Functions for managing strings
+#include <sys/mman.h>           //  Memory mapping
+                                //*******************************************
+
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "memory.h"             //  Memory management and access
+#include "registers.h"          //  All things CPU registers.
+#include "math.h"               //  8 bit instrucions.
+#include "logic.h"              //  Logic (AND, OR, XOR, CMP) instrucions.
+#include "inst_threaded.h"      //  Threaded code interpreter
+#include "block_cache.h"        //  Decoded basic block cache
+#include "jit.h"                //  x86-64 translator
+#include "machine.h"            //  Guest machine context
+                                //*******************************************
+
+#if JIT_ENABLE
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  host_reg_e          x86-64 register numbers                     */
+enum    host_reg_e
+{
+    H_RAX                   =  0,
+    H_RCX                   =  1,
+    H_RDX                   =  2,
+    H_RBX                   =  3,
+    H_RSP                   =  4,
+    H_RBP                   =  5,
+    H_RSI                   =  6,
+    H_RDI                   =  7,
+    H_R12                   = 12,
+    H_R13                   = 13,
+    H_R14                   = 14,
+    H_R15                   = 15
+};
+//----------------------------------------------------------------------------
+/**
+ *  @param  host_alu_e          Group 1 operation ( /digit of 0x81 )        */
+enum    host_alu_e
+{
+    ALU_ADD                 = 0,
+    ALU_OR                  = 1,
+    ALU_AND                 = 4,
+    ALU_SUB                 = 5,
+    ALU_XOR                 = 6,
+    ALU_CMP                 = 7
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  JIT_ARENA_SIZE      Size of the executable code arena           */
+#define JIT_ARENA_SIZE          ( 8 * 1024 * 1024 )
+//----------------------------------------------------------------------------
+/**
+ *  @param  JIT_BLOCK_MAX       Largest translation of one block            */
+#define JIT_BLOCK_MAX           ( 16 * 1024 )
+//----------------------------------------------------------------------------
+/**
+ *  @param  H_BC .. H_SP        Host register holding each guest pair       */
+#define H_BC                    ( H_RBX )
+#define H_DE                    ( H_RBP )
+#define H_HL                    ( H_R12 )
+#define H_AF                    ( H_R13 )
+#define H_SP                    ( H_R14 )
+#define H_MEM                   ( H_R15 )
+//----------------------------------------------------------------------------
+/**
+ *  @param  FLAGS_ALL           Every flag an instruction can set           */
+#define FLAGS_ALL               ( CPU_FLAG_S | CPU_FLAG_Z | CPU_FLAG_H      \
+                                | CPU_FLAG_PV | CPU_FLAG_N | CPU_FLAG_C )
+//----------------------------------------------------------------------------
+/**
+ *  @param  EXIT                eax value when leaving translated code      */
+#define EXIT( PC, STATES )      ( (uint32_t)( (uint16_t)( PC ) )            \
+                                | ( (uint32_t)( STATES ) << 16 ) )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  jit_emit_t          Code generation state for one block         */
+struct  jit_emit_t
+{
+    /**
+     *  @param  code            Next free byte                              */
+    uint8_t                 *   code;
+    /**
+     *  @param  epilogue        Shared exit of the block                    */
+    uint8_t                 *   epilogue;
+    /**
+     *  @param  pending         F in r13 may be behind flags_lazy           */
+    bool                        pending;
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Emit code bytes.
+ *
+ *  @param  emit                Code generation state
+ *  @param  byte                Byte to emit
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+emit_8(
+    struct  jit_emit_t      *   emit,
+    uint8_t                     byte
+    )
+{
+    *emit->code++ = byte;
+}
+
+static
+void
+emit_16(
+    struct  jit_emit_t      *   emit,
+    uint16_t                    data
+    )
+{
+    memcpy( emit->code, &data, sizeof( data ) );
+    emit->code += sizeof( data );
+}
+
+static
+void
+emit_32(
+    struct  jit_emit_t      *   emit,
+    uint32_t                    data
+    )
+{
+    memcpy( emit->code, &data, sizeof( data ) );
+    emit->code += sizeof( data );
+}
+
+static
+void
+emit_64(
+    struct  jit_emit_t      *   emit,
+    uint64_t                    data
+    )
+{
+    memcpy( emit->code, &data, sizeof( data ) );
+    emit->code += sizeof( data );
+}
+
+/****************************************************************************/
+/**
+ *  Emit a REX prefix when one is needed.
+ *
+ *  @param  emit                Code generation state
+ *  @param  w                   64 bit operand size
+ *  @param  reg                 Register in the ModRM reg field
+ *  @param  index               Register in the SIB index field
+ *  @param  base                Register in the ModRM r/m or SIB base field
+ *  @param  force               Always emit it (byte access to spl..dil)
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+emit_rex(
+    struct  jit_emit_t      *   emit,
+    int                         w,
+    int                         reg,
+    int                         index,
+    int                         base,
+    bool                        force
+    )
+{
+    /**
+     *  @param  rex             The prefix                                  */
+    uint8_t                     rex;
+
+    rex = 0x40 | ( w ? 0x08 : 0 )
+               | ( ( reg   & 0x08 ) >> 1 )
+               | ( ( index & 0x08 ) >> 2 )
+               | ( ( base  & 0x08 ) >> 3 );
+
+    if ( ( rex != 0x40 ) || ( force == true ) )
+        emit_8( emit, rex );
+}
+
+/****************************************************************************/
+/**
+ *  Register to register operations.
+ *
+ *  @param  emit                Code generation state
+ *  @param  op                  Op-code ( 0x89 mov, 0x01 add, etc. )
+ *  @param  dst                 Destination register
+ *  @param  src                 Source register
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+emit_rr_32(
+    struct  jit_emit_t      *   emit,
+    uint8_t                     op,
+    int                         dst,
+    int                         src
+    )
+{
+    emit_rex( emit, 0, src, 0, dst, false );
+    emit_8( emit, op );
+    emit_8( emit, 0xC0 | ( ( src & 7 ) << 3 ) | ( dst & 7 ) );
+}
+
+static
+void
+emit_rr_16(
+    struct  jit_emit_t      *   emit,
+    uint8_t                     op,
+    int                         dst,
+    int                         src
+    )
+{
+    emit_8( emit, 0x66 );
+    emit_rr_32( emit, op, dst, src );
+}
+
+/****************************************************************************/
+/**
+ *  Register and immediate operations.
+ *
+ *  @param  emit                Code generation state
+ *  @param  alu                 Group 1 operation
+ *  @param  dst                 Destination register
+ *  @param  imm                 Immediate data
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+emit_ri_32(
+    struct  jit_emit_t      *   emit,
+    enum    host_alu_e          alu,
+    int                         dst,
+    uint32_t                    imm
+    )
+{
+    emit_rex( emit, 0, 0, 0, dst, false );
+    emit_8( emit, 0x81 );
+    emit_8( emit, 0xC0 | ( alu << 3 ) | ( dst & 7 ) );
+    emit_32( emit, imm );
+}
+
+static
+void
+emit_ri_16(
+    struct  jit_emit_t      *   emit,
+    enum    host_alu_e          alu,
+    int                         dst,
+    uint16_t                    imm
+    )
+{
+    emit_8( emit, 0x66 );
+    emit_rex( emit, 0, 0, 0, dst, false );
+    emit_8( emit, 0x81 );
+    emit_8( emit, 0xC0 | ( alu << 3 ) | ( dst & 7 ) );
+    emit_16( emit, imm );
+}
+
+static
+void
+emit_mov_ri(
+    struct  jit_emit_t      *   emit,
+    int                         dst,
+    uint32_t                    imm
+    )
+{
+    emit_rex( emit, 0, 0, 0, dst, false );
+    emit_8( emit, 0xB8 | ( dst & 7 ) );
+    emit_32( emit, imm );
+}
+
+static
+void
+emit_mov_ri_64(
+    struct  jit_emit_t      *   emit,
+    int                         dst,
+    const
+    void                    *   ptr
+    )
+{
+    emit_rex( emit, 1, 0, 0, dst, false );
+    emit_8( emit, 0xB8 | ( dst & 7 ) );
+    emit_64( emit, (uint64_t)(uintptr_t)ptr );
+}
+
+static
+void
+emit_test_ri(
+    struct  jit_emit_t      *   emit,
+    int                         dst,
+    uint32_t                    imm
+    )
+{
+    emit_rex( emit, 0, 0, 0, dst, false );
+    emit_8( emit, 0xF7 );
+    emit_8( emit, 0xC0 | ( dst & 7 ) );
+    emit_32( emit, imm );
+}
+
+/****************************************************************************/
+/**
+ *  Shift a register.
+ *
+ *  @param  emit                Code generation state
+ *  @param  left                Shift left, otherwise logical shift right
+ *  @param  dst                 Register
+ *  @param  count               Number of bits
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+emit_shift(
+    struct  jit_emit_t      *   emit,
+    bool                        left,
+    int                         dst,
+    uint8_t                     count
+    )
+{
+    emit_rex( emit, 0, 0, 0, dst, false );
+    emit_8( emit, 0xC1 );
+    emit_8( emit, 0xC0 | ( left ? 0x20 : 0x28 ) | ( dst & 7 ) );
+    emit_8( emit, count );
+}
+
+/****************************************************************************/
+/**
+ *  Zero extend the low byte or word of a register.
+ *
+ *  @param  emit                Code generation state
+ *  @param  op                  0xB6 byte, 0xB7 word
+ *  @param  dst                 Destination register
+ *  @param  src                 Source register
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+emit_movzx_rr(
+    struct  jit_emit_t      *   emit,
+    uint8_t                     op,
+    int                         dst,
+    int                         src
+    )
+{
+    emit_rex( emit, 0, dst, 0, src, ( op == 0xB6 ) );
+    emit_8( emit, 0x0F );
+    emit_8( emit, op );
+    emit_8( emit, 0xC0 | ( ( dst & 7 ) << 3 ) | ( src & 7 ) );
+}
+
+/****************************************************************************/
+/**
+ *  Read a byte of main memory, either CPU_MEM[ index ] or CPU_MEM[ disp ].
+ *
+ *  @param  emit                Code generation state
+ *  @param  dst                 Destination register
+ *  @param  index               Register holding the address or -1
+ *  @param  disp                Address when 'index' is -1
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Every register holding a guest address is zero extended.
+ *
+ ****************************************************************************/
+
+static
+void
+emit_load_mem(
+    struct  jit_emit_t      *   emit,
+    int                         dst,
+    int                         index,
+    uint16_t                    disp
+    )
+{
+    if ( index >= 0 )
+    {
+        //  movzx dst, byte [ r15 + index ]
+        emit_rex( emit, 0, dst, index, H_MEM, false );
+        emit_8( emit, 0x0F );
+        emit_8( emit, 0xB6 );
+        emit_8( emit, 0x04 | ( ( dst & 7 ) << 3 ) );
+        emit_8( emit, ( ( index & 7 ) << 3 ) | ( H_MEM & 7 ) );
+    }
+    else
+    {
+        //  movzx dst, byte [ r15 + disp32 ]
+        emit_rex( emit, 0, dst, 0, H_MEM, false );
+        emit_8( emit, 0x0F );
+        emit_8( emit, 0xB6 );
+        emit_8( emit, 0x80 | ( ( dst & 7 ) << 3 ) | ( H_MEM & 7 ) );
+        emit_32( emit, disp );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Copy a guest pair between its host register and its global variable.
+ *
+ *  @param  emit                Code generation state
+ *  @param  reg                 Host register
+ *  @param  global              CPU_REG_xx
+ *  @param  store               Store the register, otherwise load it
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      rcx is used for the address.
+ *
+ ****************************************************************************/
+
+static
+void
+emit_sync(
+    struct  jit_emit_t      *   emit,
+    int                         reg,
+    uint16_t                *   global,
+    bool                        store
+    )
+{
+    emit_mov_ri_64( emit, H_RCX, global );
+    if ( store == true )
+    {
+        //  mov word [ rcx ], reg
+        emit_8( emit, 0x66 );
+        emit_rex( emit, 0, reg, 0, H_RCX, false );
+        emit_8( emit, 0x89 );
+    }
+    else
+    {
+        //  movzx reg, word [ rcx ]
+        emit_rex( emit, 0, reg, 0, H_RCX, false );
+        emit_8( emit, 0x0F );
+        emit_8( emit, 0xB7 );
+    }
+    emit_8( emit, ( ( reg & 7 ) << 3 ) | ( H_RCX & 7 ) );
+}
+
+/****************************************************************************/
+/**
+ *  Call a C function.
+ *
+ *  @param  emit                Code generation state
+ *  @param  function            The function
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+emit_call(
+    struct  jit_emit_t      *   emit,
+    const
+    void                    *   function
+    )
+{
+    emit_mov_ri_64( emit, H_RAX, function );
+    emit_8( emit, 0xFF );
+    emit_8( emit, 0xD0 );
+}
+
+/****************************************************************************/
+/**
+ *  Call a flag setting helper from math.c or logic.c.
+ *
+ *  @param  emit                Code generation state
+ *  @param  function            The helper
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The helper only records the operation in flags_lazy, F is worked out
+ *      when something reads it ( see emit_flags_sync( ) ).
+ *
+ ****************************************************************************/
+
+static
+void
+emit_call_flags(
+    struct  jit_emit_t      *   emit,
+    const
+    void                    *   function
+    )
+{
+    emit_sync( emit, H_AF, &CPU_REG_AF, true );
+    emit_call( emit, function );
+    emit_sync( emit, H_AF, &CPU_REG_AF, false );
+    emit->pending = true;
+}
+
+/****************************************************************************/
+/**
+ *  Bring F in r13 up to date before it is read or changed natively.
+ *
+ *  @param  emit                Code generation state
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      rax is preserved.
+ *
+ ****************************************************************************/
+
+static
+void
+emit_flags_sync(
+    struct  jit_emit_t      *   emit
+    )
+{
+    if ( emit->pending == true )
+    {
+        emit_sync( emit, H_AF, &CPU_REG_AF, true );
+        emit_8( emit, 0x50 );               //  push rax
+        emit_8( emit, 0x50 );               //  push rax
+        emit_call( emit, (const void *)flags_sync );
+        emit_8( emit, 0x58 );               //  pop rax
+        emit_8( emit, 0x58 );               //  pop rax
+        emit_sync( emit, H_AF, &CPU_REG_AF, false );
+        emit->pending = false;
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Drop a recorded operation whose flags are all replaced natively.
+ *
+ *  @param  emit                Code generation state
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+emit_flags_drop(
+    struct  jit_emit_t      *   emit
+    )
+{
+    if ( emit->pending == true )
+    {
+        //  mov byte [ rcx ], FLAGS_OP_NONE
+        emit_mov_ri_64( emit, H_RCX, &machine->flags_lazy.op );
+        emit_8( emit, 0xC6 );
+        emit_8( emit, 0x01 );
+        emit_8( emit, FLAGS_OP_NONE );
+        emit->pending = false;
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Copy S, Z and C from the host flags of the last instruction into F.
+ *
+ *  @param  emit                Code generation state
+ *  @param  mask                The flags that are copied
+ *  @param  save                Save the host flags in edx, otherwise merge
+ *                              the saved ones into F
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      S, Z and C sit in the same bits of the x86 flags as they do in F and
+ *      mean the same thing for ADD, ADC, SUB, SBC, AND, OR, XOR, CP, INC and
+ *      DEC.  Conditional branches only ever test one of them, so the flag
+ *      helpers don't have to be called when nothing else is live.
+ *
+ ****************************************************************************/
+
+static
+void
+emit_host_flags(
+    struct  jit_emit_t      *   emit,
+    uint8_t                     mask,
+    bool                        save
+    )
+{
+    if ( save == true )
+    {
+        emit_8( emit, 0x9C );               //  pushfq
+        emit_8( emit, 0x5A );               //  pop rdx
+    }
+    else
+    {
+        emit_ri_32( emit, ALU_AND, H_RDX, mask );
+        emit_ri_32( emit, ALU_AND, H_AF, 0xFFFF & ~mask );
+        emit_rr_32( emit, 0x09, H_AF, H_RDX );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Jumps.
+ *
+ *  @param  emit                Code generation state
+ *  @param  cc                  x86 condition ( 0x4 e, 0x5 ne ) or -1
+ *
+ *  @return                     Where the rel32 has to be patched
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+uint8_t *
+emit_jump(
+    struct  jit_emit_t      *   emit,
+    int                         cc
+    )
+{
+    if ( cc < 0 )
+    {
+        emit_8( emit, 0xE9 );
+    }
+    else
+    {
+        emit_8( emit, 0x0F );
+        emit_8( emit, 0x80 | cc );
+    }
+    emit_32( emit, 0 );
+
+    //  DONE!
+    return( emit->code - 4 );
+}
+
+static
+void
+emit_patch(
+    uint8_t                 *   patch,
+    uint8_t                 *   target
+    )
+{
+    /**
+     *  @param  rel             Displacement from the end of the jump       */
+    int32_t                     rel;
+
+    rel = (int32_t)( target - ( patch + 4 ) );
+    memcpy( patch, &rel, sizeof( rel ) );
+}
+
+/****************************************************************************/
+/**
+ *  Leave the translated code with eax = EXIT( pc, states ).
+ *
+ *  @param  emit                Code generation state
+ *  @param  value               EXIT( ) value
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+emit_exit(
+    struct  jit_emit_t      *   emit,
+    uint32_t                    value
+    )
+{
+    emit_mov_ri( emit, H_RAX, value );
+    emit_patch( emit_jump( emit, -1 ), emit->epilogue );
+}
+
+/****************************************************************************/
+/**
+ *  Leave the translated code when the last write invalidated a block.
+ *
+ *  @param  emit                Code generation state
+ *  @param  value               EXIT( ) value
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+emit_stale_check(
+    struct  jit_emit_t      *   emit,
+    uint32_t                    value
+    )
+{
+    /**
+     *  @param  patch           Jump over the exit                          */
+    uint8_t                 *   patch;
+
+    //  cmp byte [ rax ], 0
+    emit_mov_ri_64( emit, H_RAX, &machine->block_stale );
+    emit_8( emit, 0x80 );
+    emit_8( emit, 0x38 );
+    emit_8( emit, 0x00 );
+
+    patch = emit_jump( emit, 0x4 );
+    emit_exit( emit, value );
+    emit_patch( patch, emit->code );
+}
+
+/****************************************************************************/
+/**
+ *  Jump when a condition is false.
+ *
+ *  @param  emit                Code generation state
+ *  @param  ccc                 Condition ( CCC_NZ .. CCC_M )
+ *
+ *  @return                     Where the rel32 has to be patched
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+uint8_t *
+emit_jump_false(
+    struct  jit_emit_t      *   emit,
+    int                         ccc
+    )
+{
+    /**
+     *  @param  flag            The flag that is tested                     */
+    static
+    const
+    uint8_t                     flag[ 4 ] =
+    {
+        CPU_FLAG_Z, CPU_FLAG_C, CPU_FLAG_PV, CPU_FLAG_S
+    };
+
+    if ( ( emit->pending == true ) && ( flag[ ccc >> 1 ] != CPU_FLAG_PV ) )
+    {
+        //  Z, C and S come straight from the recorded operation
+        emit_sync( emit, H_AF, &CPU_REG_AF, true );
+        emit_mov_ri( emit, H_RDI, flag[ ccc >> 1 ] );
+        emit_call( emit, (const void *)flags_get );
+        emit_8( emit, 0x84 );               //  test al, al
+        emit_8( emit, 0xC0 );
+    }
+    else
+    {
+        emit_flags_sync( emit );
+        emit_test_ri( emit, H_AF, flag[ ccc >> 1 ] );
+    }
+
+    //  The condition is the flag being set for odd values
+    return( emit_jump( emit, ( ccc & 1 ) ? 0x4 : 0x5 ) );
+}
+
+/****************************************************************************/
+/**
+ *  Host register and byte lane of an 8 bit guest register.
+ *
+ *  @param  r                   Register code ( R_B .. R_A, not R_HL_p )
+ *  @param  high                Set when the register is the upper byte
+ *
+ *  @return                     The host register
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+int
+host_r(
+    int                         r,
+    bool                    *   high
+    )
+{
+    /**
+     *  @param  pair            Host register for each register code        */
+    static
+    const
+    int                         pair[ 8 ] =
+    {
+        H_BC, H_BC, H_DE, H_DE, H_HL, H_HL, -1, H_AF
+    };
+
+    *high = ( ( r & 1 ) == 0 ) || ( r == R_A );
+
+    //  DONE!
+    return( pair[ r ] );
+}
+
+/****************************************************************************/
+/**
+ *  Host register of a register pair.
+ *
+ *  @param  op_code             The operation code
+ *  @param  af                  Code 3 is AF ( qq ) rather than SP ( ss )
+ *
+ *  @return                     The host register
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+int
+host_pair(
+    uint8_t                     op_code,
+    bool                        af
+    )
+{
+    /**
+     *  @param  pair            Host register for each pair code            */
+    static
+    const
+    int                         pair[ 4 ] =
+    {
+        H_BC, H_DE, H_HL, H_SP
+    };
+
+    if ( ( ( op_code & 0x30 ) == 0x30 ) && ( af == true ) )
+        return( H_AF );
+
+    //  DONE!
+    return( pair[ ( op_code & 0x30 ) >> 4 ] );
+}
+
+/****************************************************************************/
+/**
+ *  Copy an 8 bit guest register to the low byte of a zeroed host register.
+ *
+ *  @param  emit                Code generation state
+ *  @param  dst                 Host register
+ *  @param  r                   Register code
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+emit_get_r(
+    struct  jit_emit_t      *   emit,
+    int                         dst,
+    int                         r
+    )
+{
+    /**
+     *  @param  high            Upper byte of the pair                      */
+    bool                        high;
+    /**
+     *  @param  src             Host register of the pair                   */
+    int                         src;
+
+    src = host_r( r, &high );
+    if ( high == true )
+    {
+        emit_rr_32( emit, 0x89, dst, src );
+        emit_shift( emit, false, dst, 8 );
+    }
+    else
+    {
+        emit_movzx_rr( emit, 0xB6, dst, src );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Copy the low byte of eax to an 8 bit guest register.
+ *
+ *  @param  emit                Code generation state
+ *  @param  r                   Register code
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      eax is destroyed.
+ *
+ ****************************************************************************/
+
+static
+void
+emit_put_r(
+    struct  jit_emit_t      *   emit,
+    int                         r
+    )
+{
+    /**
+     *  @param  high            Upper byte of the pair                      */
+    bool                        high;
+    /**
+     *  @param  dst             Host register of the pair                   */
+    int                         dst;
+
+    dst = host_r( r, &high );
+    if ( high == true )
+    {
+        emit_movzx_rr( emit, 0xB6, H_RAX, H_RAX );
+        emit_shift( emit, true, H_RAX, 8 );
+        emit_ri_32( emit, ALU_AND, dst, 0x00FF );
+        emit_rr_32( emit, 0x09, dst, H_RAX );
+    }
+    else
+    {
+        //  mov dst8, al
+        emit_rex( emit, 0, H_RAX, 0, dst, true );
+        emit_8( emit, 0x88 );
+        emit_8( emit, 0xC0 | ( dst & 7 ) );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Write the low byte of esi to main memory at edi.
+ *
+ *  @param  emit                Code generation state
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+emit_put_mem(
+    struct  jit_emit_t      *   emit
+    )
+{
+    emit_call( emit, (const void *)memory_put_8 );
+}
+
+/****************************************************************************/
+/**
+ *  Push a host register or a constant onto the guest stack.
+ *
+ *  @param  emit                Code generation state
+ *  @param  src                 Host register or -1
+ *  @param  data                Data when 'src' is -1
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+emit_push(
+    struct  jit_emit_t      *   emit,
+    int                         src,
+    uint16_t                    data
+    )
+{
+    //  High byte
+    emit_ri_16( emit, ALU_SUB, H_SP, 1 );
+    emit_rr_32( emit, 0x89, H_RDI, H_SP );
+    if ( src >= 0 )
+    {
+        emit_rr_32( emit, 0x89, H_RSI, src );
+        emit_shift( emit, false, H_RSI, 8 );
+    }
+    else
+    {
+        emit_mov_ri( emit, H_RSI, data >> 8 );
+    }
+    emit_put_mem( emit );
+
+    //  Low byte
+    emit_ri_16( emit, ALU_SUB, H_SP, 1 );
+    emit_rr_32( emit, 0x89, H_RDI, H_SP );
+    if ( src >= 0 )
+        emit_movzx_rr( emit, 0xB6, H_RSI, src );
+    else
+        emit_mov_ri( emit, H_RSI, data & 0xFF );
+    emit_put_mem( emit );
+}
+
+/****************************************************************************/
+/**
+ *  Pop the guest stack into eax.
+ *
+ *  @param  emit                Code generation state
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+emit_pop(
+    struct  jit_emit_t      *   emit
+    )
+{
+    emit_load_mem( emit, H_RAX, H_SP, 0 );
+    emit_rr_32( emit, 0x89, H_RCX, H_SP );
+    emit_ri_32( emit, ALU_ADD, H_RCX, 1 );
+    emit_movzx_rr( emit, 0xB7, H_RCX, H_RCX );
+    emit_load_mem( emit, H_RCX, H_RCX, 0 );
+    emit_shift( emit, true, H_RCX, 8 );
+    emit_rr_32( emit, 0x09, H_RAX, H_RCX );
+    emit_ri_16( emit, ALU_ADD, H_SP, 2 );
+}
+
+/****************************************************************************/
+/**
+ *  Flags read and written by an instruction.
+ *
+ *  @param  entry               Decoded instruction
+ *  @param  use                 Flags it reads
+ *  @param  def                 Flags it always writes
+ *
+ *  @return                     true when it may leave the block early, so
+ *                              every flag has to be exact before it.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+bool
+jit_flags(
+    const
+    struct  block_entry_t   *   entry,
+    uint8_t                 *   use,
+    uint8_t                 *   def
+    )
+{
+    /**
+     *  @param  barrier         All flags are live before the instruction   */
+    bool                        barrier;
+
+    *use = 0;
+    *def = 0;
+    barrier = false;
+
+    switch( entry->th_op )
+    {
+        case    TH_ADD_R:   case    TH_ADD_N:   case    TH_ADD_HL:
+        case    TH_SUB_R:   case    TH_SUB_N:   case    TH_SUB_HL:
+        case    TH_AND_R:   case    TH_AND_N:   case    TH_AND_HL:
+        case    TH_OR_R:    case    TH_OR_N:    case    TH_OR_HL:
+        case    TH_XOR_R:   case    TH_XOR_N:   case    TH_XOR_HL:
+        case    TH_CP_R:    case    TH_CP_N:    case    TH_CP_HL:
+            *def = FLAGS_ALL;
+            break;
+
+        case    TH_ADC_R:   case    TH_ADC_N:   case    TH_ADC_HL:
+        case    TH_SBC_R:   case    TH_SBC_N:   case    TH_SBC_HL:
+            *use = CPU_FLAG_C;
+            *def = FLAGS_ALL;
+            break;
+
+        case    TH_INC_R:   case    TH_DEC_R:
+            *def = FLAGS_ALL & ~CPU_FLAG_C;
+            break;
+
+        case    TH_SCF:
+            *def = CPU_FLAG_C | CPU_FLAG_N | CPU_FLAG_H;
+            break;
+
+        case    TH_CCF:
+            *use = CPU_FLAG_C;
+            *def = CPU_FLAG_C | CPU_FLAG_N | CPU_FLAG_H;
+            break;
+
+        case    TH_CPL:
+            *def = CPU_FLAG_N | CPU_FLAG_H;
+            break;
+
+        case    TH_NOP:     case    TH_LD_RR:   case    TH_LD_RN:
+        case    TH_LD_RHL:  case    TH_LD_ASS:  case    TH_LD_ANN:
+        case    TH_LD_SSNN: case    TH_LD_HLNN: case    TH_LD_SPHL:
+        case    TH_EX_DEHL: case    TH_INC_SS:  case    TH_DEC_SS:
+            break;
+
+        case    TH_POP:
+            //  POP AF replaces every flag
+            if ( ( entry->op_code & 0x30 ) == 0x30 )
+                *def = FLAGS_ALL;
+            break;
+
+        default:
+            //  Writes memory, branches, pushes AF or isn't translated
+            barrier = true;
+    }
+
+    //  DONE!
+    return( barrier );
+}
+
+/****************************************************************************/
+/**
+ *  Load the source operand of an 8 bit arithmetic or logic instruction.
+ *
+ *  @param  emit                Code generation state
+ *  @param  entry               Decoded instruction
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The operand ends up in ecx.  emit_flags_sync( ) and
+ *      emit_flags_drop( ) destroy rcx, rdi and rsi, so they have to come
+ *      first.
+ *
+ ****************************************************************************/
+
+static
+void
+jit_alu_operand(
+    struct  jit_emit_t      *   emit,
+    const
+    struct  block_entry_t   *   entry
+    )
+{
+    /**
+     *  @param  src             Source operand ( r, n or (HL) )             */
+    int                         src;
+
+    src = entry->op_code & 0x07;
+
+    //  Operand to ecx
+    if ( ( entry->op_code & 0xC0 ) == 0xC0 )
+        emit_mov_ri( emit, H_RCX, (uint8_t)entry->operand );
+    else if ( src == R_HL_p )
+        emit_load_mem( emit, H_RCX, H_HL, 0 );
+    else
+        emit_get_r( emit, H_RCX, src );
+}
+
+/****************************************************************************/
+/**
+ *  Emit an 8 bit arithmetic or logic instruction.
+ *
+ *  @param  emit                Code generation state
+ *  @param  entry               Decoded instruction
+ *  @param  live                Flags that are read later
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+jit_alu(
+    struct  jit_emit_t      *   emit,
+    const
+    struct  block_entry_t   *   entry,
+    uint8_t                     live
+    )
+{
+    /**
+     *  @param  group           ADD .. CP                                   */
+    int                         group;
+    /**
+     *  @param  function        Flag setting helper                         */
+    const
+    void                    *   function;
+    /**
+     *  @param  host_op         x86 'op r/m8, r8' for each group            */
+    static
+    const
+    uint8_t                     host_op[ 8 ] =
+    {
+        0x00, 0x10, 0x28, 0x18, 0x20, 0x30, 0x08, 0x38
+    };
+
+    //  Operation ( 10ggg sss for r and (HL), 11ggg 110 for n )
+    group = ( entry->op_code & 0x38 ) >> 3;
+
+    //  Are the flags needed ?
+    if ( ( live == 0 ) && ( group != 1 ) && ( group != 3 ) )
+    {
+        //  NO:     Operate on the upper byte of AF directly
+        jit_alu_operand( emit, entry );
+        emit_shift( emit, true, H_RCX, 8 );
+        switch( group )
+        {
+            case    0:  emit_rr_16( emit, 0x01, H_AF, H_RCX );          break;
+            case    2:  emit_rr_16( emit, 0x29, H_AF, H_RCX );          break;
+            case    4:  emit_ri_32( emit, ALU_OR, H_RCX, 0x00FF );
+                        emit_rr_16( emit, 0x21, H_AF, H_RCX );          break;
+            case    5:  emit_rr_16( emit, 0x31, H_AF, H_RCX );          break;
+            case    6:  emit_rr_16( emit, 0x09, H_AF, H_RCX );          break;
+            default:    break;
+        }
+        return;
+    }
+
+    //  Are only S, Z and C needed ?
+    if ( ( live & ~( CPU_FLAG_S | CPU_FLAG_Z | CPU_FLAG_C ) ) == 0 )
+    {
+        //  YES:    Use the host flags ( op al, cl )
+        if ( ( group == 1 ) || ( group == 3 ) )
+            emit_flags_sync( emit );
+        else
+            emit_flags_drop( emit );
+        jit_alu_operand( emit, entry );
+        emit_get_r( emit, H_RAX, R_A );
+        if ( ( group == 1 ) || ( group == 3 ) )
+        {
+            //  bt r13d, 0
+            emit_rex( emit, 0, 0, 0, H_AF, false );
+            emit_8( emit, 0x0F );
+            emit_8( emit, 0xBA );
+            emit_8( emit, 0xE0 | ( H_AF & 7 ) );
+            emit_8( emit, 0 );
+        }
+        emit_8( emit, host_op[ group ] );
+        emit_8( emit, 0xC8 );
+        emit_host_flags( emit, 0, true );
+        if ( group != 7 )
+            emit_put_r( emit, R_A );
+        emit_host_flags( emit, CPU_FLAG_S | CPU_FLAG_Z | CPU_FLAG_C, false );
+        return;
+    }
+
+    //  ADC and SBC need C before the arguments are loaded
+    if ( ( group == 1 ) || ( group == 3 ) )
+        emit_flags_sync( emit );
+    jit_alu_operand( emit, entry );
+
+    //  Arguments
+    switch( group )
+    {
+        case    0:      //  add_8( src, A, 0 )
+        case    1:      //  add_8( src, A, C )
+            emit_rr_32( emit, 0x89, H_RDI, H_RCX );
+            emit_get_r( emit, H_RSI, R_A );
+            function = (const void *)add_8;
+            break;
+        case    2:      //  sub_8( A, src, 0 )
+        case    3:      //  sub_8( A, src, C )
+        case    7:      //  compare_8( A, src )
+            emit_get_r( emit, H_RDI, R_A );
+            emit_rr_32( emit, 0x89, H_RSI, H_RCX );
+            function = ( group == 7 ) ? (const void *)compare_8
+                                      : (const void *)sub_8;
+            break;
+        default:        //  xxx_8( src, A )
+            emit_rr_32( emit, 0x89, H_RDI, H_RCX );
+            emit_get_r( emit, H_RSI, R_A );
+            function = ( group == 4 ) ? (const void *)and_8
+                     : ( group == 5 ) ? (const void *)xor_8
+                                      : (const void *)or_8;
+    }
+    if ( ( group == 1 ) || ( group == 3 ) )
+    {
+        emit_rr_32( emit, 0x89, H_RDX, H_AF );
+        emit_ri_32( emit, ALU_AND, H_RDX, CPU_FLAG_C );
+    }
+    else
+    {
+        emit_mov_ri( emit, H_RDX, 0 );
+    }
+
+    //  The helper works on CPU_REG_AF
+    emit_call_flags( emit, function );
+
+    //  CP only sets the flags
+    if ( group != 7 )
+        emit_put_r( emit, R_A );
+}
+
+/****************************************************************************/
+/**
+ *  Emit one instruction.
+ *
+ *  @param  emit                Code generation state
+ *  @param  entry               Decoded instruction
+ *  @param  live                Flags that are read later
+ *  @param  states              Clock states before the instruction
+ *
+ *  @return                     Clock states of the instruction, 0 when it
+ *                              left the block (states are in the exit).
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+int
+jit_inst(
+    struct  jit_emit_t      *   emit,
+    const
+    struct  block_entry_t   *   entry,
+    uint8_t                     live,
+    int                         states
+    )
+{
+    /**
+     *  @param  op_code         The operation code                          */
+    uint8_t                     op_code;
+    /**
+     *  @param  next            Program Counter after the instruction       */
+    uint16_t                    next;
+    /**
+     *  @param  target          Relative jump destination                   */
+    uint16_t                    target;
+    /**
+     *  @param  high            Upper byte of a pair                        */
+    bool                        high;
+    /**
+     *  @param  reg             Host register                               */
+    int                         reg;
+    /**
+     *  @param  patch           Forward jump                                */
+    uint8_t                 *   patch;
+
+    op_code = entry->op_code;
+    next    = entry->pc_next;
+    target  = (uint16_t)( next + entry->operand );
+
+    switch( entry->th_op )
+    {
+        case    TH_NOP:
+            return( 4 );
+
+        /********************************************************************
+         *  Load
+         ********************************************************************/
+
+        case    TH_LD_RR:
+            emit_get_r( emit, H_RAX, op_code & 0x07 );
+            emit_put_r( emit, ( op_code & 0x38 ) >> 3 );
+            return( 4 );
+
+        case    TH_LD_RN:
+            emit_mov_ri( emit, H_RAX, (uint8_t)entry->operand );
+            emit_put_r( emit, ( op_code & 0x38 ) >> 3 );
+            return( 7 );
+
+        case    TH_LD_RHL:
+            emit_load_mem( emit, H_RAX, H_HL, 0 );
+            emit_put_r( emit, ( op_code & 0x38 ) >> 3 );
+            return( 7 );
+
+        case    TH_LD_HLR:
+            emit_rr_32( emit, 0x89, H_RDI, H_HL );
+            emit_get_r( emit, H_RSI, op_code & 0x07 );
+            emit_put_mem( emit );
+            emit_stale_check( emit, EXIT( next, states + 7 ) );
+            return( 7 );
+
+        case    TH_LD_HLN:
+            emit_rr_32( emit, 0x89, H_RDI, H_HL );
+            emit_mov_ri( emit, H_RSI, (uint8_t)entry->operand );
+            emit_put_mem( emit );
+            emit_stale_check( emit, EXIT( next, states + 10 ) );
+            return( 10 );
+
+        case    TH_LD_ASS:
+            emit_load_mem( emit, H_RAX, host_pair( op_code, false ), 0 );
+            emit_put_r( emit, R_A );
+            return( 7 );
+
+        case    TH_LD_ANN:
+            emit_load_mem( emit, H_RAX, -1, entry->operand );
+            emit_put_r( emit, R_A );
+            return( 13 );
+
+        case    TH_LD_SSA:
+            emit_rr_32( emit, 0x89, H_RDI, host_pair( op_code, false ) );
+            emit_get_r( emit, H_RSI, R_A );
+            emit_put_mem( emit );
+            emit_stale_check( emit, EXIT( next, states + 7 ) );
+            return( 7 );
+
+        case    TH_LD_NNA:
+            emit_mov_ri( emit, H_RDI, entry->operand );
+            emit_get_r( emit, H_RSI, R_A );
+            emit_put_mem( emit );
+            emit_stale_check( emit, EXIT( next, states + 13 ) );
+            return( 13 );
+
+        case    TH_LD_SSNN:
+            emit_mov_ri( emit, host_pair( op_code, false ), entry->operand );
+            return( 10 );
+
+        case    TH_LD_HLNN:
+            emit_load_mem( emit, H_HL, -1, entry->operand );
+            emit_load_mem( emit, H_RCX, -1, (uint16_t)( entry->operand + 1 ) );
+            emit_shift( emit, true, H_RCX, 8 );
+            emit_rr_32( emit, 0x09, H_HL, H_RCX );
+            return( 16 );
+
+        case    TH_LD_NNHL:
+            emit_mov_ri( emit, H_RDI, entry->operand );
+            emit_rr_32( emit, 0x89, H_RSI, H_HL );
+            emit_call( emit, (const void *)memory_put_16_p );
+            emit_stale_check( emit, EXIT( next, states + 16 ) );
+            return( 16 );
+
+        case    TH_LD_SPHL:
+            emit_rr_32( emit, 0x89, H_SP, H_HL );
+            return( 6 );
+
+        case    TH_PUSH:
+            if ( ( op_code & 0x30 ) == 0x30 )
+                emit_flags_sync( emit );
+            emit_push( emit, host_pair( op_code, true ), 0 );
+            emit_stale_check( emit, EXIT( next, states + 11 ) );
+            return( 11 );
+
+        case    TH_POP:
+            if ( ( op_code & 0x30 ) == 0x30 )
+                emit_flags_drop( emit );
+            emit_pop( emit );
+            emit_rr_32( emit, 0x89, host_pair( op_code, true ), H_RAX );
+            return( 11 );
+
+        case    TH_EX_DEHL:
+            emit_rr_32( emit, 0x89, H_RAX, H_HL );
+            emit_rr_32( emit, 0x89, H_HL, H_DE );
+            emit_rr_32( emit, 0x89, H_DE, H_RAX );
+            return( 4 );
+
+        /********************************************************************
+         *  8 bit arithmetic and logic
+         ********************************************************************/
+
+        case    TH_ADD_R:   case    TH_ADC_R:   case    TH_SUB_R:
+        case    TH_SBC_R:   case    TH_AND_R:   case    TH_XOR_R:
+        case    TH_OR_R:    case    TH_CP_R:
+            jit_alu( emit, entry, live );
+            return( 4 );
+
+        case    TH_ADD_N:   case    TH_ADC_N:   case    TH_SUB_N:
+        case    TH_SBC_N:   case    TH_AND_N:   case    TH_XOR_N:
+        case    TH_OR_N:    case    TH_CP_N:
+        case    TH_ADD_HL:  case    TH_ADC_HL:  case    TH_SUB_HL:
+        case    TH_SBC_HL:  case    TH_AND_HL:  case    TH_XOR_HL:
+        case    TH_OR_HL:   case    TH_CP_HL:
+            jit_alu( emit, entry, live );
+            return( 7 );
+
+        case    TH_INC_R:
+        case    TH_DEC_R:
+            reg = host_r( ( op_code & 0x38 ) >> 3, &high );
+            if ( ( live & ~CPU_FLAG_C ) == 0 )
+            {
+                if ( high == true )
+                {
+                    emit_ri_16( emit, ( entry->th_op == TH_INC_R )
+                                      ? ALU_ADD : ALU_SUB, reg, 0x0100 );
+                }
+                else
+                {
+                    //  inc/dec reg8
+                    emit_rex( emit, 0, 0, 0, reg, true );
+                    emit_8( emit, 0xFE );
+                    emit_8( emit, ( entry->th_op == TH_INC_R ? 0xC0 : 0xC8 )
+                                  | ( reg & 7 ) );
+                }
+                return( 4 );
+            }
+            if ( ( live & ~( CPU_FLAG_S | CPU_FLAG_Z | CPU_FLAG_C ) ) == 0 )
+            {
+                //  inc/dec al, C is left alone like on the 8080
+                emit_flags_sync( emit );
+                emit_get_r( emit, H_RAX, ( op_code & 0x38 ) >> 3 );
+                emit_8( emit, 0xFE );
+                emit_8( emit, ( entry->th_op == TH_INC_R ) ? 0xC0 : 0xC8 );
+                emit_host_flags( emit, 0, true );
+                emit_put_r( emit, ( op_code & 0x38 ) >> 3 );
+                emit_host_flags( emit, CPU_FLAG_S | CPU_FLAG_Z, false );
+                return( 4 );
+            }
+            emit_get_r( emit, H_RDI, ( op_code & 0x38 ) >> 3 );
+            emit_call_flags( emit, ( entry->th_op == TH_INC_R ) ? (const void *)inc_8
+                                                                : (const void *)dec_8 );
+            emit_put_r( emit, ( op_code & 0x38 ) >> 3 );
+            return( 4 );
+
+        case    TH_INC_HL:
+        case    TH_DEC_HL:
+            emit_load_mem( emit, H_RDI, H_HL, 0 );
+            emit_call_flags( emit, ( entry->th_op == TH_INC_HL ) ? (const void *)inc_8
+                                                                 : (const void *)dec_8 );
+            emit_rr_32( emit, 0x89, H_RDI, H_HL );
+            emit_movzx_rr( emit, 0xB6, H_RSI, H_RAX );
+            emit_put_mem( emit );
+            emit_stale_check( emit, EXIT( next, states + 11 ) );
+            return( 11 );
+
+        case    TH_CPL:
+            emit_flags_sync( emit );
+            emit_ri_32( emit, ALU_XOR, H_AF, 0xFF00 );
+            emit_ri_32( emit, ALU_OR,  H_AF, CPU_FLAG_N | CPU_FLAG_H );
+            return( 4 );
+
+        case    TH_SCF:
+            emit_flags_sync( emit );
+            emit_ri_32( emit, ALU_OR,  H_AF, CPU_FLAG_C );
+            emit_ri_32( emit, ALU_AND, H_AF, 0xFFFF & ~( CPU_FLAG_N | CPU_FLAG_H ) );
+            return( 4 );
+
+        case    TH_CCF:
+            //  H is the inverse of the new carry
+            emit_flags_sync( emit );
+            emit_ri_32( emit, ALU_XOR, H_AF, CPU_FLAG_C );
+            emit_ri_32( emit, ALU_AND, H_AF, 0xFFFF & ~( CPU_FLAG_N | CPU_FLAG_H ) );
+            emit_rr_32( emit, 0x89, H_RAX, H_AF );
+            emit_ri_32( emit, ALU_XOR, H_RAX, CPU_FLAG_C );
+            emit_ri_32( emit, ALU_AND, H_RAX, CPU_FLAG_C );
+            emit_shift( emit, true, H_RAX, 4 );
+            emit_rr_32( emit, 0x09, H_AF, H_RAX );
+            return( 4 );
+
+        /********************************************************************
+         *  16 bit arithmetic
+         ********************************************************************/
+
+        case    TH_INC_SS:
+            emit_ri_16( emit, ALU_ADD, host_pair( op_code, false ), 1 );
+            return( 6 );
+
+        case    TH_DEC_SS:
+            emit_ri_16( emit, ALU_SUB, host_pair( op_code, false ), 1 );
+            return( 6 );
+
+        /********************************************************************
+         *  Jump
+         ********************************************************************/
+
+        case    TH_JP:
+            emit_exit( emit, EXIT( entry->operand, states + 10 ) );
+            return( 0 );
+
+        case    TH_JP_CC:
+            patch = emit_jump_false( emit, ( op_code & 0x38 ) >> 3 );
+            emit_exit( emit, EXIT( entry->operand, states + 10 ) );
+            emit_patch( patch, emit->code );
+            emit_exit( emit, EXIT( next, states + 10 ) );
+            return( 0 );
+
+        case    TH_JP_HL:
+            emit_rr_32( emit, 0x89, H_RAX, H_HL );
+            emit_ri_32( emit, ALU_OR, H_RAX, EXIT( 0, states + 4 ) );
+            emit_patch( emit_jump( emit, -1 ), emit->epilogue );
+            return( 0 );
+
+        case    TH_JR:
+            emit_exit( emit, EXIT( target, states + 12 ) );
+            return( 0 );
+
+        case    TH_JR_CC:
+            patch = emit_jump_false( emit, ( op_code & 0x18 ) >> 3 );
+            emit_exit( emit, EXIT( target, states + 12 ) );
+            emit_patch( patch, emit->code );
+            emit_exit( emit, EXIT( next, states + 7 ) );
+            return( 0 );
+
+        case    TH_DJNZ:
+            emit_ri_16( emit, ALU_SUB, H_BC, 0x0100 );
+            emit_test_ri( emit, H_BC, 0xFF00 );
+            patch = emit_jump( emit, 0x4 );
+            emit_exit( emit, EXIT( target, states + 13 ) );
+            emit_patch( patch, emit->code );
+            emit_exit( emit, EXIT( next, states + 8 ) );
+            return( 0 );
+
+        /********************************************************************
+         *  Call and Return
+         ********************************************************************/
+
+        case    TH_CALL_NN:
+            emit_push( emit, -1, next );
+            emit_exit( emit, EXIT( entry->operand, states + 17 ) );
+            return( 0 );
+
+        case    TH_CALL_CC:
+            patch = emit_jump_false( emit, ( op_code & 0x38 ) >> 3 );
+            emit_push( emit, -1, next );
+            emit_exit( emit, EXIT( entry->operand, states + 17 ) );
+            emit_patch( patch, emit->code );
+            emit_exit( emit, EXIT( next, states + 10 ) );
+            return( 0 );
+
+        case    TH_RET:
+            emit_pop( emit );
+            emit_ri_32( emit, ALU_OR, H_RAX, EXIT( 0, states + 10 ) );
+            emit_patch( emit_jump( emit, -1 ), emit->epilogue );
+            return( 0 );
+
+        case    TH_RET_CC:
+            patch = emit_jump_false( emit, ( op_code & 0x38 ) >> 3 );
+            emit_pop( emit );
+            emit_ri_32( emit, ALU_OR, H_RAX, EXIT( 0, states + 11 ) );
+            emit_patch( emit_jump( emit, -1 ), emit->epilogue );
+            emit_patch( patch, emit->code );
+            emit_exit( emit, EXIT( next, states + 5 ) );
+            return( 0 );
+
+        case    TH_RST:
+            emit_push( emit, -1, next );
+            emit_exit( emit, EXIT( op_code & 0x38, states + 11 ) );
+            return( 0 );
+
+        default:
+            break;
+    }
+
+    //  Not translated
+    return( -1 );
+}
+
+/****************************************************************************/
+/**
+ *  Is there a native version of an instruction ?
+ *
+ *  @param  th_op               The inlined body
+ *
+ *  @return                     true when it can be translated
+ *
+ *  @note
+ *      EX (SP),HL, EX AF,AF' and EXX are rare enough in hot code that they
+ *      are left to the interpreter.
+ *
+ ****************************************************************************/
+
+static
+bool
+jit_supported(
+    uint8_t                     th_op
+    )
+{
+    switch( th_op )
+    {
+        case    TH_CALL:
+        case    TH_EX_SPHL:
+        case    TH_EX_AFAF:
+        case    TH_EXX:
+        case    TH_BLOCK_END:
+            return( false );
+        default:
+            return( true );
+    }
+}
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Translate a block to native code.
+ *
+ *  @param  block               The block
+ *
+ *  @return                     JIT_RC_OK when block->jit_code can be run
+ *
+ *  @note
+ *      Only the instructions in front of the first one that can't be
+ *      translated are translated.  block->jit_count tells the interpreter
+ *      where to continue.
+ *
+ ****************************************************************************/
+
+enum    jit_rc_e
+jit_translate(
+    struct  block_t         *   block
+    )
+{
+    /**
+     *  @param  emit            Code generation state                       */
+    struct  jit_emit_t          emit;
+    /**
+     *  @param  count           Number of instructions translated           */
+    int                         count;
+    /**
+     *  @param  ndx             Instruction index                           */
+    int                         ndx;
+    /**
+     *  @param  live            Flags read after each instruction           */
+    uint8_t                     live[ BLOCK_MAX_ENTRIES ];
+    /**
+     *  @param  use             Flags read by an instruction                */
+    uint8_t                     use;
+    /**
+     *  @param  def             Flags written by an instruction             */
+    uint8_t                     def;
+    /**
+     *  @param  flags           Flags live in front of an instruction       */
+    uint8_t                     flags;
+    /**
+     *  @param  states          Clock states since the start of the block   */
+    int                         states;
+    /**
+     *  @param  inst            Clock states of one instruction             */
+    int                         inst;
+    /**
+     *  @param  pc              Program Counter of the next instruction     */
+    uint16_t                    pc;
+    /**
+     *  @param  page            Bytes in a host page                        */
+    size_t                      page;
+    /**
+     *  @param  first           First page of the arena written to          */
+    size_t                      first;
+    /**
+     *  @param  saved           Host registers saved by the prologue        */
+    static
+    const
+    uint8_t                     saved[ 6 ] =
+    {
+        H_RBX, H_RBP, H_R12, H_R13, H_R14, H_R15
+    };
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    //  Translated code reads memory directly, bypassing read handlers
+    if ( machine->mem_read_hooks != 0 )
+        return( JIT_RC_UNSUPPORTED );
+
+    //  and banks other than 0, try again once bank 0 is back
+    if ( machine->mem_bank != 0 )
+    {
+        block->hits = 0;
+        return( JIT_RC_UNSUPPORTED );
+    }
+
+    //  Is there an executable arena ?
+    if ( machine->jit_disabled == true )
+        return( JIT_RC_UNSUPPORTED );
+    if ( machine->jit_arena == NULL )
+    {
+        machine->jit_arena = mmap( NULL, JIT_ARENA_SIZE,
+                                   PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        if ( machine->jit_arena == MAP_FAILED )
+        {
+            //  NO:     Stay with the interpreter
+            machine->jit_arena = NULL;
+            machine->jit_disabled = true;
+            return( JIT_RC_UNSUPPORTED );
+        }
+        machine->jit_used = 0;
+    }
+
+    //  Count the instructions that can be translated
+    for( count = 0; count < block->count; count += 1 )
+    {
+        if ( jit_supported( block->entry[ count ].th_op ) == false )
+            break;
+    }
+    if ( count == 0 )
+        return( JIT_RC_UNSUPPORTED );
+
+    //  Is there room for it ?
+    if ( JIT_ARENA_SIZE - machine->jit_used < JIT_BLOCK_MAX )
+        return( JIT_RC_FULL );
+
+    //  Flag liveness, everything is live when the translated code is left
+    flags = FLAGS_ALL;
+    for( ndx = count - 1; ndx >= 0; ndx -= 1 )
+    {
+        live[ ndx ] = flags;
+        if ( jit_flags( &block->entry[ ndx ], &use, &def ) == true )
+            flags = FLAGS_ALL;
+        else
+            flags = use | ( flags & ~def );
+    }
+
+    /************************************************************************
+     *  Function Code
+     ************************************************************************/
+
+    //  Open the pages the block goes to for writing
+    page  = (size_t)sysconf( _SC_PAGESIZE );
+    first = machine->jit_used & ~( page - 1 );
+    if ( mprotect( machine->jit_arena + first,
+                   ( ( machine->jit_used + JIT_BLOCK_MAX + page - 1 ) & ~( page - 1 ) ) - first,
+                   PROT_READ | PROT_WRITE ) != 0 )
+    {
+        return( JIT_RC_UNSUPPORTED );
+    }
+
+    emit.code = machine->jit_arena + machine->jit_used;
+
+    //  The block may be entered with an operation still recorded
+    emit.pending = true;
+
+    //  Epilogue: copy the pairs back and return eax
+    emit.epilogue = emit.code;
+    emit_sync( &emit, H_BC, &CPU_REG_BC, true );
+    emit_sync( &emit, H_DE, &CPU_REG_DE, true );
+    emit_sync( &emit, H_HL, &CPU_REG_HL, true );
+    emit_sync( &emit, H_AF, &CPU_REG_AF, true );
+    emit_sync( &emit, H_SP, &CPU_REG_SP, true );
+    emit_8( &emit, 0x48 );                  //  add rsp, 8
+    emit_8( &emit, 0x83 );
+    emit_8( &emit, 0xC4 );
+    emit_8( &emit, 0x08 );
+    for( ndx = 5; ndx >= 0; ndx -= 1 )      //  pop
+    {
+        emit_rex( &emit, 0, 0, 0, saved[ ndx ], false );
+        emit_8( &emit, 0x58 | ( saved[ ndx ] & 7 ) );
+    }
+    emit_8( &emit, 0xC3 );                  //  ret
+
+    //  Prologue: save the host registers and load the pairs
+    block->jit_code = emit.code;
+    for( ndx = 0; ndx < 6; ndx += 1 )       //  push
+    {
+        emit_rex( &emit, 0, 0, 0, saved[ ndx ], false );
+        emit_8( &emit, 0x50 | ( saved[ ndx ] & 7 ) );
+    }
+    emit_8( &emit, 0x48 );                  //  sub rsp, 8
+    emit_8( &emit, 0x83 );
+    emit_8( &emit, 0xEC );
+    emit_8( &emit, 0x08 );
+    emit_sync( &emit, H_BC, &CPU_REG_BC, false );
+    emit_sync( &emit, H_DE, &CPU_REG_DE, false );
+    emit_sync( &emit, H_HL, &CPU_REG_HL, false );
+    emit_sync( &emit, H_AF, &CPU_REG_AF, false );
+    emit_sync( &emit, H_SP, &CPU_REG_SP, false );
+    emit_mov_ri_64( &emit, H_MEM, machine->memory );
+
+    //  Body
+    states = 0;
+    pc = block->pc;
+    for( ndx = 0; ndx < count; ndx += 1 )
+    {
+        inst = jit_inst( &emit, &block->entry[ ndx ], live[ ndx ], states );
+        if ( inst == 0 )
+            break;
+        states += inst;
+        pc = block->entry[ ndx ].pc_next;
+    }
+
+    //  Fell off the end of the translated instructions ?
+    if ( ndx == count )
+        emit_exit( &emit, EXIT( pc, states ) );
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    machine->jit_used = (size_t)( emit.code - machine->jit_arena );
+    machine->jit_used = ( machine->jit_used + 15 ) & ~(size_t)15;
+
+    //  Make the code executable, was it possible ?
+    if ( mprotect( machine->jit_arena + first,
+                   ( ( machine->jit_used + page - 1 ) & ~( page - 1 ) ) - first,
+                   PROT_READ | PROT_EXEC ) != 0 )
+    {
+        //  NO:     Stay with the interpreter
+        block->jit_code = NULL;
+        machine->jit_disabled = true;
+        return( JIT_RC_UNSUPPORTED );
+    }
+    block->jit_count = (uint8_t)count;
+
+    //  DONE!
+    return( JIT_RC_OK );
+}
+
+/****************************************************************************/
+/**
+ *  Run the translated code of a block.
+ *
+ *  @param  block               The block
+ *
+ *  @return                     The next Program Counter in bits 0-15 and
+ *                              the clock states executed in bits 16-31.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+uint32_t
+jit_run(
+    struct  block_t         *   block
+    )
+{
+    /**
+     *  @param  code            Entry point of the translated code          */
+    uint32_t                    (*code)( void );
+
+    memcpy( &code, &block->jit_code, sizeof( code ) );
+
+    //  DONE!
+    return( (*code)( ) );
+}
+
+/****************************************************************************/
+/**
+ *  Count the translated instructions that ran.
+ *
+ *  @param  block               The block
+ *  @param  pc                  Program Counter the native code left with
+ *
+ *  @return                     Number of instructions retired.
+ *
+ *  @note
+ *      The native code runs all block->jit_count instructions unless a
+ *      write invalidated a block, in which case it leaves right after the
+ *      writing instruction.
+ *
+ ****************************************************************************/
+
+int
+jit_retired(
+    const
+    struct  block_t         *   block,
+    uint16_t                    pc
+    )
+{
+    /**
+     *  @param  entry_ndx       Index into the block entries                */
+    int                         entry_ndx;
+
+    //  Did it leave before the end of the translation ?
+    if ( machine->block_stale )
+    {
+        //  Find the instruction that ends at the Program Counter
+        for( entry_ndx = 0; entry_ndx < block->jit_count; entry_ndx += 1 )
+        {
+            if ( block->entry[ entry_ndx ].pc_next == pc )
+            {
+                return( entry_ndx + 1 );
+            }
+        }
+    }
+
+    //  DONE!
+    return( block->jit_count );
+}
+
+/****************************************************************************/
+/**
+ *  Forget every translation.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called by block_cache_flush( ) after every block was retired.
+ *
+ ****************************************************************************/
+
+void
+jit_flush(
+    void
+    )
+{
+    machine->jit_used = 0;
+}
+
+/****************************************************************************/
+/**
+ *  Release the executable arena of a guest.
+ *
+ *  @param  guest               The guest
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called by machine_destroy( ), the guest need not be bound.
+ *
+ ****************************************************************************/
+
+void
+jit_destroy(
+    struct  machine_t       *   guest
+    )
+{
+    //  Was an arena ever created ?
+    if ( guest->jit_arena != NULL )
+    {
+        //  YES:    Give it back
+        munmap( guest->jit_arena, JIT_ARENA_SIZE );
+        guest->jit_arena = NULL;
+    }
+    guest->jit_used = 0;
+}
+
+/****************************************************************************/
+
+#endif                          //  JIT_ENABLE
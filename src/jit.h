@@ -0,0 +1,115 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+#ifndef JIT_H
+#define JIT_H
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  x86-64 translator for hot decoded blocks.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * System APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Application APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  JIT_THRESHOLD       Executions before a block is translated    */
+#define JIT_THRESHOLD           ( 64 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  jit_rc_e            Translation result                          */
+enum    jit_rc_e
+{
+    JIT_RC_OK               = 0,                //  Block translated
+    JIT_RC_UNSUPPORTED      = 1,                //  First instruction can't be
+    JIT_RC_FULL             = 2                 //  Code arena is full
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Prototypes
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+enum    jit_rc_e
+jit_translate(
+    struct  block_t         *   block
+    );
+//----------------------------------------------------------------------------
+uint32_t
+jit_run(
+    struct  block_t         *   block
+    );
+//----------------------------------------------------------------------------
+int
+jit_retired(
+    const
+    struct  block_t         *   block,
+    uint16_t                    pc
+    );
+//----------------------------------------------------------------------------
+void
+jit_flush(
+    void
+    );
+//----------------------------------------------------------------------------
+void
+jit_destroy(
+    struct  machine_t       *   guest
+    );
+//----------------------------------------------------------------------------
+
+/****************************************************************************/
+
+#endif                      //    JIT_H
@@ -39,6 +39,7 @@
 #include "memory.h"             //  Memory management and access
 #include "registers.h"          //  All things CPU registers.
 #include "jump.h"               //  Jump instructions
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -112,7 +113,7 @@ jump_jpnn_i80(
     CPU_REG_PC = memory_get_16_pc_p(  );
 
     //  Set the number of states for this instruction
-    operation_rc.states   =  10;
+    machine->operation_rc.states   =  10;
 }
 
 /****************************************************************************/
@@ -153,7 +154,7 @@ jump_jpccnn_i80(
     }
 
     //  Set the number of states for this instruction
-    operation_rc.states   =  10;
+    machine->operation_rc.states   =  10;
 }
 
 /****************************************************************************/
@@ -182,7 +183,7 @@ jump_jphl_i80(
     CPU_REG_PC = CPU_REG_HL;
 
     //  Set the number of states for this instruction
-    operation_rc.states   =   4;
+    machine->operation_rc.states   =   4;
 }
 
 /****************************************************************************/
@@ -231,12 +232,12 @@ jump_djnz_z80(
         CPU_REG_PC += (uint16_t)displacement;
 
         //  Set the number of states for this instruction
-        operation_rc.states   =  13;
+        machine->operation_rc.states   =  13;
     }
     else
     {
         //  NO:     Set the number of states for this instruction
-        operation_rc.states   =   8;
+        machine->operation_rc.states   =   8;
     }
 }
 
@@ -276,7 +277,7 @@ jump_jr_z80(
     CPU_REG_PC += displacement;
 
     //  Set the number of states for this instruction
-    operation_rc.states   =  12;
+    machine->operation_rc.states   =  12;
 }
 
 /****************************************************************************/
@@ -321,12 +322,12 @@ jump_jrcc_z80(
         CPU_REG_PC += displacement;
 
         //  Set the number of states for this instruction
-        operation_rc.states   =  12;
+        machine->operation_rc.states   =  12;
     }
     else
     {
         //  Set the number of states for this instruction
-        operation_rc.states   =   7;
+        machine->operation_rc.states   =   7;
     }
 }
 /****************************************************************************/
\ No newline at end of file
@@ -40,6 +40,7 @@
 #include "registers.h"          //  All things CPU registers.
 #include "op_code.h"            //  OP-Code instruction maps
 #include "jump.h"               //  Jump instructions
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -777,6 +778,86 @@ tc_jp_hl_00(
     return( post_rc );
 }
 
+/****************************************************************************/
+/**
+ *  JP      cc, nn      (hot loop)
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      The loop runs often enough for its blocks to be translated to native
+ *      code when the JIT is enabled.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_jp_loop_00(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        0xAF,                   //  0000    XOR     A
+        0x47,                   //  0001    LD      B, A
+        0x0E, 0xC8,             //  0002    LD      C, 200
+        0x16, 0x00,             //  0004    LD      D, 0
+        0x5F,                   //  0006 L1:LD      E, A
+        0xD6, 0x01,             //  0007    SUB     1
+        0xC6, 0x04,             //  0009    ADD     A, 4
+        0xD2, 0x0F, 0x00,       //  000B    JP      NC, L2
+        0x14,                   //  000E    INC     D
+        0x0D,                   //  000F L2:DEC     C
+        0xC2, 0x06, 0x00,       //  0010    JP      NZ, L1
+        0x76      };            //  0013    HALT
+
+    /************************************************************************
+     *  Run the program
+     ************************************************************************/
+
+    //  Assume a successful test run.
+    post_rc = true;
+
+    //  Load the program
+    memory_load( 0x0000, sizeof( program ), program );
+
+    //  Run the program
+    inst_fetch( );
+
+    /************************************************************************
+     *  Verify the results
+     ************************************************************************/
+
+    if (    ( CPU_REG_PC != 0x0014 )
+         || ( GET_A( )   !=   0x58 )
+         || ( GET_C( )   !=   0x00 )
+         || ( GET_D( )   !=   0x03 )
+         || ( GET_E( )   !=   0x55 ) )
+    {
+        //  NO:     Write an error message
+        printf( "POST: tc_jp_loop_00 failed: [jp    cc, nn]\n" );
+        printf( "POST: PC = 0x%04X\n", CPU_REG_PC );
+        printf( "POST: A  = 0x%02X\n", GET_A( )   );
+        printf( "POST: C  = 0x%02X\n", GET_C( )   );
+        printf( "POST: D  = 0x%02X\n", GET_D( )   );
+        printf( "POST: E  = 0x%02X\n", GET_E( )   );
+
+        //  Set the return code to FALSE.
+        post_rc = false;
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
 /****************************************************************************/
 /**
  *  DJNZ    e
@@ -1254,6 +1335,7 @@ jump_post(
         if ( post_rc == true )      post_rc = tc_jp_m_00( );        //  JP   M, nn
 
         if ( post_rc == true )      post_rc = tc_jp_hl_00( );       //  JP   (HL)
+        if ( post_rc == true )      post_rc = tc_jp_loop_00( );     //  JP   cc, nn  (hot loop)
 
         //  Z80 ONLY instructions
         if( CPU == CPU_Z80 )
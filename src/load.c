@@ -39,6 +39,8 @@
 #include "memory.h"             //  Memory management and access
 #include "registers.h"          //  All things CPU registers.
 #include "load.h"               //  LD *,*
+#include "interrupt.h"          //  Maskable interrupts
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -80,6 +82,42 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************/
+/**
+ *  Set the flags for LD A,I and LD A,R.
+ *
+ *  @param  data                The value loaded to the Accumulator.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      S is set if the value is negative; otherwise, it is reset.
+ *      Z is set if the value is 0; otherwise, it is reset.
+ *      H is reset.
+ *      P/V contains contents of IFF2.
+ *      N is reset.
+ *      C is not affected.
+ *
+ ****************************************************************************/
+
+static
+void
+ld_air_flags(
+    uint8_t                     data
+    )
+{
+    /**
+     *  @param  flags           The new flags                               */
+    uint8_t                     flags;
+
+    flags  = GET_F( ) & CPU_FLAG_C;
+    flags |= data & CPU_FLAG_S;
+    flags |= ( data == 0 ) ? CPU_FLAG_Z : 0;
+    flags |= ( machine->interrupt.iff2 == true ) ? CPU_FLAG_PV : 0;
+
+    PUT_F( flags );
+}
+
 /****************************************************************************
  * MAIN
  ****************************************************************************/
@@ -109,8 +147,58 @@ ld_rr_i80(
     reg_put_dr( op_code, reg_get_sr( op_code ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
+}
+
+/****************************************************************************/
+/**
+ *  LD r, r' with both registers resolved at compile time.
+ *
+ *  @parm   op_code             The operation code of the current instruction.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      ld_rr_i80_DS( ) loads register D from register S.  The op-code tables
+ *      point at these instead of ld_rr_i80( ) so the register fields are
+ *      never decoded at run time.
+ *
+ ****************************************************************************/
+
+#define LD_RR_I80( D, S )                                                   \
+void                                                                        \
+ld_rr_i80_##D##S(                                                           \
+    uint8_t                     op_code                                     \
+    )                                                                       \
+{                                                                           \
+    PUT_##D( GET_##S( ) );                                                  \
+    machine->operation_rc.states =   4;                                     \
 }
+REG_R_EACH_2( LD_RR_I80, B )
+REG_R_EACH_2( LD_RR_I80, C )
+REG_R_EACH_2( LD_RR_I80, D )
+REG_R_EACH_2( LD_RR_I80, E )
+REG_R_EACH_2( LD_RR_I80, H )
+REG_R_EACH_2( LD_RR_I80, L )
+REG_R_EACH_2( LD_RR_I80, A )
+#undef  LD_RR_I80
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  ld_rr_i80_op        ld_rr_i80_xx( ) by op-code & 0x3F           */
+#define LD_RR_I80_OP( D, S )    [ ( R_##D << 3 ) | R_##S ] = ld_rr_i80_##D##S,
+void                        (* const ld_rr_i80_op[ 64 ])( uint8_t ) =
+{
+    REG_R_EACH_2( LD_RR_I80_OP, B )
+    REG_R_EACH_2( LD_RR_I80_OP, C )
+    REG_R_EACH_2( LD_RR_I80_OP, D )
+    REG_R_EACH_2( LD_RR_I80_OP, E )
+    REG_R_EACH_2( LD_RR_I80_OP, H )
+    REG_R_EACH_2( LD_RR_I80_OP, L )
+    REG_R_EACH_2( LD_RR_I80_OP, A )
+};
+#undef  LD_RR_I80_OP
+//----------------------------------------------------------------------------
 
 /****************************************************************************/
 /**                     Page        Op-Code
@@ -137,7 +225,7 @@ ld_rn_i80(
     reg_put_dr( op_code, memory_get_8( CPU_REG_PC++ ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states = 7;
+    machine->operation_rc.states = 7;
 }
 
 /****************************************************************************/
@@ -165,7 +253,7 @@ ld_rhl_i80(
     reg_put_dr( op_code, memory_get_8( CPU_REG_HL ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states   =   7;
+    machine->operation_rc.states   =   7;
 }
 
 /****************************************************************************/
@@ -195,7 +283,7 @@ ld_hlr_i80(
     memory_put_8( CPU_REG_HL, reg_get_sr( op_code ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  7;
+    machine->operation_rc.states =  7;
 }
 
 /****************************************************************************/
@@ -223,7 +311,7 @@ ld_hln_i80(
     memory_put_8( CPU_REG_HL, memory_get_8( CPU_REG_PC++ ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states = 10;
+    machine->operation_rc.states = 10;
 }
 
 /****************************************************************************/
@@ -252,7 +340,7 @@ ld_ass_i80(
     PUT_A( memory_get_8( reg_get_ss( op_code ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  7;
+    machine->operation_rc.states =  7;
 }
 
 /****************************************************************************/
@@ -282,7 +370,7 @@ ld_ann_i80(
     PUT_A( memory_get_8( memory_get_16_pc_p( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states = 13;
+    machine->operation_rc.states = 13;
 }
 
 /****************************************************************************/
@@ -311,7 +399,7 @@ ld_ssa_i80(
     memory_put_8( reg_get_ss( op_code ), GET_A( ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  7;
+    machine->operation_rc.states =  7;
 }
 
 /****************************************************************************/
@@ -341,7 +429,7 @@ ld_nna_i80(
     memory_put_8( memory_get_16_pc_p( ), GET_A( ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states = 13;
+    machine->operation_rc.states = 13;
 }
 
 /****************************************************************************/
@@ -369,7 +457,7 @@ ld_ssNN_i80(
     reg_put_ss( op_code, memory_get_16_pc_p(  ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states = 10;
+    machine->operation_rc.states = 10;
 }
 
 /****************************************************************************/
@@ -400,7 +488,7 @@ ld_hlnn_i80(
     CPU_REG_HL = memory_get_16_p( memory_get_16_pc_p( ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  16;
+    machine->operation_rc.states =  16;
 
     //  DONE!
 }
@@ -432,7 +520,7 @@ ld_nnhl_i80(
     memory_put_16_p( memory_get_16_pc_p( ), CPU_REG_HL );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  16;
+    machine->operation_rc.states =  16;
 
     //  DONE!
 }
@@ -461,7 +549,7 @@ ld_sphl_i80(
     CPU_REG_SP = CPU_REG_HL;
 
     //  Set the number of states for this instruction
-    operation_rc.states =   6;
+    machine->operation_rc.states =   6;
 
     //  DONE!
 }
@@ -498,7 +586,7 @@ ld_pushqq_i80(
     push( reg_get_qq( op_code ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  11;
+    machine->operation_rc.states =  11;
 
     //  DONE!
 }
@@ -535,7 +623,7 @@ ld_popqq_i80(
     reg_put_qq( op_code, pop( ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  11;
+    machine->operation_rc.states =  11;
 
     //  DONE!
 }
@@ -570,7 +658,7 @@ ld_nnss_ED(
     memory_put_16_p( memory_get_16_pc_p( ), reg_get_ss( op_code ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states = 16;
+    machine->operation_rc.states = 16;
 }
 
 /****************************************************************************/
@@ -604,7 +692,7 @@ ld_ssnn_ED(
     reg_put_ss( op_code, memory_get_16_p( memory_get_16_pc_p( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states = 20;
+    machine->operation_rc.states = 20;
 }
 
 /****************************************************************************/
@@ -631,7 +719,7 @@ ld_ia_ED(
     CPU_REG_I = GET_A( );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  9;
+    machine->operation_rc.states =  9;
 }
 
 /****************************************************************************/
@@ -656,9 +744,10 @@ ld_ai_ED(
 {
     //  LD   a, i
     PUT_A( CPU_REG_I );
+    ld_air_flags( CPU_REG_I );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  9;
+    machine->operation_rc.states =  9;
 }
 
 /****************************************************************************/
@@ -680,11 +769,11 @@ ld_ra_ED(
     uint8_t                     op_code
     )
 {
-    //  LD   i, a
-    CPU_REG_R = GET_A( );
+    //  LD   r, a
+    refresh_put( GET_A( ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  9;
+    machine->operation_rc.states =  9;
 }
 
 /****************************************************************************/
@@ -706,11 +795,12 @@ ld_ar_ED(
     uint8_t                     op_code
     )
 {
-    //  LD   a, i
-    PUT_A( CPU_REG_R );
+    //  LD   a, r
+    PUT_A( refresh_get( ) );
+    ld_air_flags( GET_A( ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  9;
+    machine->operation_rc.states =  9;
 }
 
 /****************************************************************************/
@@ -763,7 +853,7 @@ ld_ldd_ED(
     CLEAR_FLAG_N( );            //  N is reset.
 
     //  Set the number of states for this instruction
-    operation_rc.states =16;
+    machine->operation_rc.states =16;
 }
 
 /****************************************************************************/
@@ -801,39 +891,41 @@ ld_lddr_ED(
     )
 {
     /**
-     *  @param  count           Number of clock cycles                      */
-    int                         count;
+     *  @param  count           Number of bytes to copy                     */
+    uint32_t                    count;
+    /**
+     *  @param  offset          Offset of the byte being copied             */
+    uint32_t                    offset;
 
-    //  Set the number of clock cycles this instruction will consume.
-    if( CPU_REG_BC == 0 )
-    {
-        count = 0x0080000;
-    }
-    else
-    {
-        count = (int)CPU_REG_BC * 8;
-    }
+    //  A count of zero copies 64 KB
+    count = ( CPU_REG_BC == 0 ) ? 0x10000 : CPU_REG_BC;
 
     //  LDDR
-    do
+    if ( memory_copy_down( CPU_REG_DE, CPU_REG_HL, count ) == false )
     {
-        memory_put_8( CPU_REG_DE, memory_get_8( CPU_REG_HL ) );
-
-        //  Decrement counters and pointers
-        CPU_REG_HL -= 1;
-        CPU_REG_DE -= 1;
-        CPU_REG_BC -= 1;
-
-    }   while( CPU_REG_BC != 0 );
+        //  The block wraps around memory, copy it one byte at a time
+        for( offset = 0; offset < count; offset += 1 )
+        {
+            memory_put_8( (uint16_t)( CPU_REG_DE - offset ),
+                          memory_get_8( (uint16_t)( CPU_REG_HL - offset ) ) );
+        }
+    }
 
+    //  Adjust counters and pointers
+    CPU_REG_HL -= count;
+    CPU_REG_DE -= count;
+    CPU_REG_BC = 0;
 
     //  Adjust the FLAGS as needed
     CLEAR_FLAG_H( );            //  H is reset.
     CLEAR_FLAG_PV( );           //  P/V is reset.
     CLEAR_FLAG_N( );            //  N is reset.
 
-    //  Set the number of states for this instruction
-    operation_rc.states = 16 + count;
+    //  Every repeat fetched ED and the op-code again
+    refresh_advance( ( count - 1 ) * 2 );
+
+    //  Set the number of states for this instruction ( 21 for every repeat )
+    machine->operation_rc.states = ( ( count - 1 ) * 21 ) + 16;
 }
 
 /****************************************************************************/
@@ -889,7 +981,7 @@ ld_ldi_ED(
     CLEAR_FLAG_N( );            //  N is reset.
 
     //  Set the number of states for this instruction
-    operation_rc.states =16;
+    machine->operation_rc.states =16;
 }
 
 /****************************************************************************/
@@ -920,38 +1012,40 @@ ld_ldir_ED(
     )
 {
     /**
-     *  @param  count           Number of clock cycles                      */
-    int                         count;
+     *  @param  count           Number of bytes to copy                     */
+    uint32_t                    count;
+    /**
+     *  @param  offset          Offset of the byte being copied             */
+    uint32_t                    offset;
 
-    //  Set the number of clock cycles this instruction will consume.
-    if( CPU_REG_BC == 0 )
-    {
-        count = 0x0080000;
-    }
-    else
-    {
-        count = (int)CPU_REG_BC * 8;
-    }
+    //  A count of zero copies 64 KB
+    count = ( CPU_REG_BC == 0 ) ? 0x10000 : CPU_REG_BC;
 
-    //  LDDR
-    do
+    //  LDIR
+    if ( memory_copy_up( CPU_REG_DE, CPU_REG_HL, count ) == false )
     {
-        memory_put_8( CPU_REG_DE, memory_get_8( CPU_REG_HL ) );
-
-        //  Decrement counters and pointers
-        CPU_REG_HL += 1;
-        CPU_REG_DE += 1;
-        CPU_REG_BC -= 1;
-
-    }   while( CPU_REG_BC != 0 );
+        //  The block wraps around memory, copy it one byte at a time
+        for( offset = 0; offset < count; offset += 1 )
+        {
+            memory_put_8( (uint16_t)( CPU_REG_DE + offset ),
+                          memory_get_8( (uint16_t)( CPU_REG_HL + offset ) ) );
+        }
+    }
 
+    //  Adjust counters and pointers
+    CPU_REG_HL += count;
+    CPU_REG_DE += count;
+    CPU_REG_BC = 0;
 
     //  Adjust the FLAGS as needed
     CLEAR_FLAG_H( );            //  H is reset.
     CLEAR_FLAG_PV( );           //  P/V is reset.
     CLEAR_FLAG_N( );            //  N is reset.
 
-    //  Set the number of states for this instruction
-    operation_rc.states = 16 + count;
+    //  Every repeat fetched ED and the op-code again
+    refresh_advance( ( count - 1 ) * 2 );
+
+    //  Set the number of states for this instruction ( 21 for every repeat )
+    machine->operation_rc.states = ( ( count - 1 ) * 21 ) + 16;
 }
 /****************************************************************************/
\ No newline at end of file
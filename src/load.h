@@ -74,6 +74,25 @@ void
 ld_rr_i80(
     uint8_t                     op_code
     );
+//----------------------------------------------------------------------------
+/*  ld_rr_i80_BC( ) .. ld_rr_i80_AA( ), one for each LD r, r' op-code       */
+#define LD_RR_I80_PROTO( D, S )                                             \
+void                                                                        \
+ld_rr_i80_##D##S(                                                           \
+    uint8_t                     op_code                                     \
+    );
+REG_R_EACH_2( LD_RR_I80_PROTO, B )
+REG_R_EACH_2( LD_RR_I80_PROTO, C )
+REG_R_EACH_2( LD_RR_I80_PROTO, D )
+REG_R_EACH_2( LD_RR_I80_PROTO, E )
+REG_R_EACH_2( LD_RR_I80_PROTO, H )
+REG_R_EACH_2( LD_RR_I80_PROTO, L )
+REG_R_EACH_2( LD_RR_I80_PROTO, A )
+#undef  LD_RR_I80_PROTO
+//----------------------------------------------------------------------------
+/*  ld_rr_i80_xx( ) by op-code & 0x3F, NULL when (HL) is an operand         */
+extern
+void                        (* const ld_rr_i80_op[ 64 ])( uint8_t );
 //------------------------------------------------------------------------  72
 void
 ld_rn_i80(
@@ -40,6 +40,8 @@
 #include "registers.h"          //  All things CPU registers.
 #include "op_code.h"            //  OP-Code instruction maps
 #include "load.h"               //  LD *,*
+#include "stats.h"              //  Performance counters
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -865,6 +867,71 @@ tc_ld_nna_00(
     return( post_rc );
 }
 
+/****************************************************************************/
+/**
+ *  LD      (nn), A
+ *
+ *  Store into the operand of an instruction that follows in the same
+ *  straight line run of code (self modifying code).
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+int
+tc_ld_nna_01(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        0x3E, 0x99,             //  0000    LD  A, 0x99
+        0x32, 0x06, 0x00,       //  0002    LD  (0x0006), A
+        0x06, 0x00,             //  0005    LD  B, 0x00
+        0x76      };            //  0007    HALT
+
+    /************************************************************************
+     *  Run the program
+     ************************************************************************/
+
+    //  Assume a successful test run.
+    post_rc = true;
+
+    //  Load the program
+    memory_load( 0x0000, sizeof( program ), program );
+
+    //  Run the program
+    inst_fetch( );
+
+    /************************************************************************
+     *  Verify the results
+     ************************************************************************/
+
+    if ( GET_B( ) != 0x99 )
+    {
+        //  NO:     Write an error message
+        printf( "POST: tc_ld_nna_01 failed:     [LD  (nn), A]\n" );
+        printf( "POST: B = 0x%02X\n", GET_B( ) );
+
+        //  Set the return code to FALSE.
+        post_rc = false;
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
 /****************************************************************************/
 /**
  *  LD      (nn), HL
@@ -1483,7 +1550,7 @@ tc_ld_ra_00(
      ************************************************************************/
 
     if (    ( GET_A( )   != 0xAA )
-         || ( CPU_REG_R  != 0xAD ) )
+         || ( CPU_REG_R  != 0xAB ) )
     {
         //  NO:     Write an error message
         printf( "POST: tc_ld_ra_00 failed:     [LD   r, a]\n" );
@@ -1548,8 +1615,8 @@ tc_ld_ar_00(
      *  Verify the results
      ************************************************************************/
 
-    if (    ( GET_A( )   != 0x83 )
-         || ( CPU_REG_R  != 0x86 ) )
+    if (    ( GET_A( )   != 0x82 )
+         || ( CPU_REG_R  != 0x83 ) )
     {
         //  NO:     Write an error message
         printf( "POST: tc_ld_ar_00 failed:     [LD   a, r]\n" );
@@ -1564,6 +1631,73 @@ tc_ld_ar_00(
     return( post_rc );
 }
 
+/****************************************************************************/
+/**
+ *  LD      a, r
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      A prefixed instruction has two M1 cycles and advances R by two.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_ld_ar_01(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        //  Initial register load
+        0x3E, 0x00,             //  0000    LD   A, 00h
+        0xED, 0x4F,             //  0002    LD   R, A
+        0xED, 0x47,             //  0004    LD   I, A
+        0xED, 0x5F,             //  0006    LD   A, R
+        0x76      };            //  0008    HALT
+
+    /************************************************************************
+     *  Run the program
+     ************************************************************************/
+
+    //  Assume a successful test run.
+    post_rc = true;
+
+    //  Load the program
+    memory_load( 0x0000, sizeof( program ), program );
+
+    //  Run the program
+    inst_fetch( );
+
+    /************************************************************************
+     *  Verify the results
+     ************************************************************************/
+
+    if (    ( GET_A( )   != 0x04 )
+         || ( CPU_REG_R  != 0x05 ) )
+    {
+        //  NO:     Write an error message
+        printf( "POST: tc_ld_ar_01 failed:     [LD   a, r]\n" );
+        printf( "POST: A        = 0x%02X\n", GET_A( )   );
+        printf( "POST: R        = 0x%02X\n", CPU_REG_R  );
+
+        //  Set the return code to FALSE.
+        post_rc = false;
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
 /****************************************************************************/
 /**
  *  LDD
@@ -1830,6 +1964,87 @@ tc_ld_lddr_00(
     return( post_rc );
 }
 
+/****************************************************************************/
+/**
+ *  LDDR
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      The destination starts two bytes below the source so the first two
+ *      bytes are repeated through the whole block.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_ld_lddr_01(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        //  Initial register load   PATTERN
+        0x21, 0x51, 0x00,       //  0000    LD   HL, 0051h  ;Pattern
+        0x36, 0xAA,             //  0003    LD   (HL), 0AAh
+        0x2B,                   //  0005    DEC  HL
+        0x36, 0xBB,             //  0006    LD   (HL), 0BBh
+        //  Start the test
+        0x11, 0x4F, 0x00,       //  0008    LD   DE, 004Fh  ;To
+        0x21, 0x51, 0x00,       //  000B    LD   HL, 0051h  ;From
+        0x01, 0x08, 0x00,       //  000E    LD   BC, 0008h  ;Byte Count
+        0xED, 0xB8,             //  0011    LDDR            ;Copy DE<-HL till BC = 0
+        0x76      };            //  0013    HALT            ;THE END
+
+    /************************************************************************
+     *  Run the program
+     ************************************************************************/
+
+    //  Assume a successful test run.
+    post_rc = true;
+
+    //  Load the program
+    memory_load( 0x0000, sizeof( program ), program );
+
+    //  Run the program
+    inst_fetch( );
+
+    /************************************************************************
+     *  Verify the results
+     ************************************************************************/
+
+    if (    ( CPU_REG_BC             != 0x0000 )
+         || ( CPU_REG_DE             != 0x0047 )
+         || ( CPU_REG_HL             != 0x0049 )
+         || ( memory_get_8( 0x0048 ) !=   0xBB )
+         || ( memory_get_8( 0x0049 ) !=   0xAA )
+         || ( memory_get_8( 0x004E ) !=   0xBB )
+         || ( memory_get_8( 0x004F ) !=   0xAA ) )
+    {
+        //  NO:     Write an error message
+        printf( "POST: tc_ld_lddr_01 failed:     [LDDR     ]\n" );
+        printf( "POST: BC       = 0x%04X\n", CPU_REG_BC );
+        printf( "POST: DE       = 0x%04X\n", CPU_REG_DE );
+        printf( "POST: HL       = 0x%04X\n", CPU_REG_HL );
+
+        memory_dump( 0x0040, 32 );
+
+        //  Set the return code to FALSE.
+        post_rc = false;
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
 /****************************************************************************/
 /**
  *  LDI
@@ -2095,6 +2310,84 @@ tc_ld_ldir_00(
     return( post_rc );
 }
 
+/****************************************************************************/
+/**
+ *  LDIR
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      DE = HL + 1 fills the block with its first byte.  Every repeat
+ *      takes 21 clock states and the last one 16.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_ld_ldir_01(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        //  Start the test
+        0x21, 0x40, 0x00,       //  0000    LD   HL, 0040h  ;From       10
+        0x11, 0x41, 0x00,       //  0003    LD   DE, 0041h  ;To         10
+        0x01, 0x0F, 0x00,       //  0006    LD   BC, 000Fh  ;Byte Count 10
+        0x36, 0x55,             //  0009    LD   (HL), 055h ;Fill data  10
+        0xED, 0xB0,             //  000B    LDIR            ;14*21+16  310
+        0x76      };            //  000D    HALT            ;THE END
+
+    /************************************************************************
+     *  Run the program
+     ************************************************************************/
+
+    //  Assume a successful test run.
+    post_rc = true;
+
+    //  Load the program
+    memory_load( 0x0000, sizeof( program ), program );
+
+    //  Run the program
+    inst_fetch( );
+
+    /************************************************************************
+     *  Verify the results
+     ************************************************************************/
+
+    if (    ( CPU_REG_BC             != 0x0000 )
+         || ( CPU_REG_DE             != 0x0050 )
+         || ( CPU_REG_HL             != 0x004F )
+         || ( memory_get_8( 0x0040 ) !=   0x55 )
+         || ( memory_get_8( 0x0047 ) !=   0x55 )
+         || ( memory_get_8( 0x004F ) !=   0x55 )
+         || ( machine->stats.states           !=    350 ) )
+    {
+        //  NO:     Write an error message
+        printf( "POST: tc_ld_ldir_01 failed:     [LDIR     ]\n" );
+        printf( "POST: BC       = 0x%04X\n", CPU_REG_BC );
+        printf( "POST: DE       = 0x%04X\n", CPU_REG_DE );
+        printf( "POST: HL       = 0x%04X\n", CPU_REG_HL );
+        printf( "POST: T-states = %d\n", (int)machine->stats.states );
+
+        memory_dump( 0x0040, 16 );
+
+        //  Set the return code to FALSE.
+        post_rc = false;
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
 /****************************************************************************
  * MAIN
  ****************************************************************************/
@@ -2151,6 +2444,7 @@ ld_post(
         if ( post_rc == true )      post_rc = tc_ld_ann_00( );      //  LD   A, (nn)
         if ( post_rc == true )      post_rc = tc_ld_ssa_00( );      //  LD   (ss), A
         if ( post_rc == true )      post_rc = tc_ld_nna_00( );      //  LD   (nn), A
+        if ( post_rc == true )      post_rc = tc_ld_nna_01( );      //  LD   (nn), A
         if ( post_rc == true )      post_rc = tc_ld_nnhl_00( );     //  LD   (nn), HL
         if ( post_rc == true )      post_rc = tc_ld_sphl_00( );     //  LD   SP, HL
         if ( post_rc == true )      post_rc = tc_push_qq_00( );     //  PUSH qq
@@ -2165,12 +2459,15 @@ ld_post(
             if ( post_rc == true )  post_rc = tc_ld_ai_00( );       //  LD   a, i
             if ( post_rc == true )  post_rc = tc_ld_ra_00( );       //  LD   r, a
             if ( post_rc == true )  post_rc = tc_ld_ar_00( );       //  LD   a, r
+            if ( post_rc == true )  post_rc = tc_ld_ar_01( );       //  LD   a, r
             if ( post_rc == true )  post_rc = tc_ld_ldd_00( );      //  LDD
             if ( post_rc == true )  post_rc = tc_ld_ldd_01( );      //  LDD
             if ( post_rc == true )  post_rc = tc_ld_lddr_00( );     //  LDDR
+            if ( post_rc == true )  post_rc = tc_ld_lddr_01( );     //  LDDR
             if ( post_rc == true )  post_rc = tc_ld_ldi_00( );      //  LDI
             if ( post_rc == true )  post_rc = tc_ld_ldi_01( );      //  LDI
             if ( post_rc == true )  post_rc = tc_ld_ldir_00( );     //  LDIR
+            if ( post_rc == true )  post_rc = tc_ld_ldir_01( );     //  LDIR
         }
 
         //  Was the test suite successfully complete :
@@ -39,6 +39,7 @@
 #include "memory.h"             //  Memory management and access
 #include "registers.h"          //  All things CPU registers.
 #include "logic.h"              //  Logic (AND, OR, XOR, CMP) instrucions.
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -115,36 +116,8 @@ and_8(
     //  result = byte_1 & byte_2
     result = byte_1 & byte_2;
 
-    /************************************************************************
-     *  SET FLAGS
-     ************************************************************************/
-
-    //  Carry
-    CLEAR_FLAG_C( );
-
-    //  SUBTRACT/ADD
-    CLEAR_FLAG_N( );
-
-    //  PARITY/OVERFLOW
-    if ( parity_8( result & 0x00FF ) == 0 )
-        CLEAR_FLAG_PV( );       //  Parity Even
-    else
-        SET_FLAG_PV( );         //  Parity Odd
-
-    //  HALF CARRY
-    CLEAR_FLAG_H( );
-
-    //  ZERO
-    if ( ( result & 0x00FF ) == 0x0000 )
-        SET_FLAG_Z( );
-    else
-        CLEAR_FLAG_Z( );
-
-    //  SIGN
-    if ( ( result & 0x0080 ) == 0x0080 )
-        SET_FLAG_S( );
-    else
-        CLEAR_FLAG_S( );
+    //  Record the operation, the flags are set when they are read
+    FLAGS_RECORD( FLAGS_OP_LOGIC, byte_1, byte_2, 0, result );
 
     /************************************************************************
      *  Function Exit
@@ -188,36 +161,8 @@ or_8(
     //  result = byte_1 & byte_2
     result = byte_1 | byte_2;
 
-    /************************************************************************
-     *  SET FLAGS
-     ************************************************************************/
-
-    //  Carry
-    CLEAR_FLAG_C( );
-
-    //  SUBTRACT/ADD
-    CLEAR_FLAG_N( );
-
-    //  PARITY/OVERFLOW
-    if ( parity_8( result & 0x00FF ) == 0 )
-        CLEAR_FLAG_PV( );       //  Parity Even
-    else
-        SET_FLAG_PV( );         //  Parity Odd
-
-    //  HALF CARRY
-    CLEAR_FLAG_H( );
-
-    //  ZERO
-    if ( ( result & 0x00FF ) == 0x0000 )
-        SET_FLAG_Z( );
-    else
-        CLEAR_FLAG_Z( );
-
-    //  SIGN
-    if ( ( result & 0x0080 ) == 0x0080 )
-        SET_FLAG_S( );
-    else
-        CLEAR_FLAG_S( );
+    //  Record the operation, the flags are set when they are read
+    FLAGS_RECORD( FLAGS_OP_LOGIC, byte_1, byte_2, 0, result );
 
     /************************************************************************
      *  Function Exit
@@ -261,36 +206,8 @@ xor_8(
     //  result = byte_1 & byte_2
     result = byte_1 ^ byte_2;
 
-    /************************************************************************
-     *  SET FLAGS
-     ************************************************************************/
-
-    //  Carry
-    CLEAR_FLAG_C( );
-
-    //  SUBTRACT/ADD
-    CLEAR_FLAG_N( );
-
-    //  PARITY/OVERFLOW
-    if ( parity_8( result & 0x00FF ) == 0 )
-        CLEAR_FLAG_PV( );       //  Parity Even
-    else
-        SET_FLAG_PV( );         //  Parity Odd
-
-    //  HALF CARRY
-    CLEAR_FLAG_H( );
-
-    //  ZERO
-    if ( ( result & 0x00FF ) == 0x0000 )
-        SET_FLAG_Z( );
-    else
-        CLEAR_FLAG_Z( );
-
-    //  SIGN
-    if ( ( result & 0x0080 ) == 0x0080 )
-        SET_FLAG_S( );
-    else
-        CLEAR_FLAG_S( );
+    //  Record the operation, the flags are set when they are read
+    FLAGS_RECORD( FLAGS_OP_LOGIC, byte_1, byte_2, 0, result );
 
     /************************************************************************
      *  Function Exit
@@ -331,59 +248,12 @@ compare_8(
      *  @param  result              The result of the add operation        */
     uint16_t                    result;
 
-    //  Create 16 bit signed numbers
-    if ( byte_1 > 127 ) byte_1 |= 0xFF00;
-    if ( byte_2 > 127 ) byte_2 |= 0xFF00;
-
-    //  result = byte_1 & byte_2
-    result = byte_1 - byte_2;
-
-    /************************************************************************
-     *  SET FLAGS
-     ************************************************************************/
-
-    //  Carry
-    if ( byte_1 < byte_2  ) SET_FLAG_C( ); else CLEAR_FLAG_C( );
-
-    //  SUBTRACT/ADD
-    SET_FLAG_N( );
-
-    //  Are we running Intel 8080 mode ?
-    if ( CPU == CPU_I80 )
-    {
-        //  YES:    Set the 'PARITY' flag
-        if ( parity_8( result & 0x00FF ) == 0 )
-            CLEAR_FLAG_PV( );       //  Parity Even
-        else
-            SET_FLAG_PV( );         //  Parity Odd
-    }
-    else
-    {
-        //  PARITY/OVERFLOW
-        if (    ( ( byte_1  & 0x80 ) != ( byte_2 & 0x80 ) )
-             && ( result & 0x80 ) != ( byte_1    & 0x80 ) )
-            SET_FLAG_PV( );
-        else
-            CLEAR_FLAG_PV( );
-    }
+    //  result = byte_1 - byte_2
+    result = ( byte_1 & 0x00FF ) - ( byte_2 & 0x00FF );
 
-    //  HALF CARRY
-    if ( ( ( ( byte_1 & 0x0000F ) - ( byte_2 & 0x0000F ) ) & 0x0010 ) == 0x0010 )
-        SET_FLAG_H( );
-    else
-        CLEAR_FLAG_H( );
-
-    //  ZERO
-    if ( byte_1 == byte_2 )
-        SET_FLAG_Z( );
-    else
-        CLEAR_FLAG_Z( );
-
-    //  SIGN
-    if ( ( result & 0x0080 ) == 0x0080 )
-        SET_FLAG_S( );
-    else
-        CLEAR_FLAG_S( );
+    //  Record the operation, the flags are set when they are read.  They
+    //  are the same as SUB would set.
+    FLAGS_RECORD( FLAGS_OP_SUB, byte_1 & 0x00FF, byte_2 & 0x00FF, 0, result );
 
     /************************************************************************
      *  Function Exit
@@ -494,7 +364,7 @@ logic_andr_i80(
     PUT_A( and_8( reg_get_sr( op_code ), GET_A( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -522,7 +392,7 @@ logic_andn_i80(
     PUT_A( and_8( memory_get_8( CPU_REG_PC++ ), GET_A( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -551,7 +421,7 @@ logic_andhl_i80(
     PUT_A( and_8( memory_get_8( CPU_REG_HL ), GET_A( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -580,7 +450,7 @@ logic_orr_i80(
     PUT_A( or_8( reg_get_sr( op_code ), GET_A( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -608,7 +478,7 @@ logic_orn_i80(
     PUT_A( or_8( memory_get_8( CPU_REG_PC++ ), GET_A( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -637,7 +507,7 @@ logic_orhl_i80(
     PUT_A( or_8( memory_get_8( CPU_REG_HL ), GET_A( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -666,7 +536,7 @@ logic_xorr_i80(
     PUT_A( xor_8( reg_get_sr( op_code ), GET_A( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -694,7 +564,7 @@ logic_xorn_i80(
     PUT_A( xor_8( memory_get_8( CPU_REG_PC++ ), GET_A( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -723,7 +593,7 @@ logic_xorhl_i80(
     PUT_A( xor_8( memory_get_8( CPU_REG_HL ), GET_A( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -752,9 +622,104 @@ logic_cpr_i80(
     compare_8( GET_A( ), reg_get_sr( op_code ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
+/****************************************************************************/
+/**
+ *  AND, OR, XOR and CP r with the register resolved at compile time.
+ *
+ *  @parm   op_code             The operation code of the current instruction.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      logic_andr_i80_B( ) is AND B and so on.  The op-code tables point
+ *      at these instead of the generic handlers so the register field is
+ *      never decoded at run time.
+ *
+ ****************************************************************************/
+
+#define LOGIC_R( R )                                                        \
+void                                                                        \
+logic_andr_i80_##R(                                                         \
+    uint8_t                     op_code                                     \
+    )                                                                       \
+{                                                                           \
+    PUT_A( and_8( GET_##R( ), GET_A( ) ) );                                 \
+    machine->operation_rc.states =   4;                                     \
+}                                                                           \
+                                                                            \
+void                                                                        \
+logic_orr_i80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    )                                                                       \
+{                                                                           \
+    PUT_A( or_8( GET_##R( ), GET_A( ) ) );                                  \
+    machine->operation_rc.states =   4;                                     \
+}                                                                           \
+                                                                            \
+void                                                                        \
+logic_xorr_i80_##R(                                                         \
+    uint8_t                     op_code                                     \
+    )                                                                       \
+{                                                                           \
+    PUT_A( xor_8( GET_##R( ), GET_A( ) ) );                                 \
+    machine->operation_rc.states =   4;                                     \
+}                                                                           \
+                                                                            \
+void                                                                        \
+logic_cpr_i80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    )                                                                       \
+{                                                                           \
+    compare_8( GET_A( ), GET_##R( ) );                                      \
+    machine->operation_rc.states =   4;                                     \
+}
+REG_R_EACH( LOGIC_R )
+#undef  LOGIC_R
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  logic_andr_i80_op   Handlers by register code                   */
+#define LOGIC_R_OP( R )  [ R_##R ] = logic_andr_i80_##R,
+void                        (* const logic_andr_i80_op[ 8 ])( uint8_t ) =
+{
+    REG_R_EACH( LOGIC_R_OP )
+};
+#undef  LOGIC_R_OP
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  logic_orr_i80_op    Handlers by register code                   */
+#define LOGIC_R_OP( R )  [ R_##R ] = logic_orr_i80_##R,
+void                        (* const logic_orr_i80_op[ 8 ])( uint8_t ) =
+{
+    REG_R_EACH( LOGIC_R_OP )
+};
+#undef  LOGIC_R_OP
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  logic_xorr_i80_op   Handlers by register code                   */
+#define LOGIC_R_OP( R )  [ R_##R ] = logic_xorr_i80_##R,
+void                        (* const logic_xorr_i80_op[ 8 ])( uint8_t ) =
+{
+    REG_R_EACH( LOGIC_R_OP )
+};
+#undef  LOGIC_R_OP
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  logic_cpr_i80_op    Handlers by register code                   */
+#define LOGIC_R_OP( R )  [ R_##R ] = logic_cpr_i80_##R,
+void                        (* const logic_cpr_i80_op[ 8 ])( uint8_t ) =
+{
+    REG_R_EACH( LOGIC_R_OP )
+};
+#undef  LOGIC_R_OP
+//----------------------------------------------------------------------------
+
 /****************************************************************************/
 /**                     Page        Op-Code
  *  CP   n               164        11111110
@@ -780,7 +745,7 @@ logic_cpn_i80(
     compare_8( GET_A( ), memory_get_8( CPU_REG_PC++ ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -809,7 +774,7 @@ logic_cphl_i80(
     compare_8( GET_A( ), memory_get_8( CPU_REG_HL ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -855,7 +820,7 @@ logic_cpd_ED(
 
 
     //  Set the number of states for this instruction
-    operation_rc.states =  16;
+    machine->operation_rc.states =  16;
 }
 
 /****************************************************************************/
@@ -901,7 +866,7 @@ logic_cpi_ED(
 
 
     //  Set the number of states for this instruction
-    operation_rc.states =  16;
+    machine->operation_rc.states =  16;
 }
 
 /****************************************************************************/
@@ -938,38 +903,56 @@ logic_cpdr_ED(
     )
 {
     /**
-     *  @param  count           Number of clock cycles                      */
-    int                         count;
+     *  @param  count           Number of bytes to search                   */
+    uint32_t                    count;
+    /**
+     *  @param  compared        Number of bytes compared                    */
+    uint32_t                    compared;
+    /**
+     *  @param  data            The last byte compared                      */
+    uint8_t                     data;
 
-    //  Set the number of clock cycles this instruction will consume.
-    if( CPU_REG_BC == 0 )
-        count = 0x0080000;
-    else
-        count = (int)CPU_REG_BC * 8;
+    //  A count of zero searches 64 KB
+    count = ( CPU_REG_BC == 0 ) ? 0x10000 : CPU_REG_BC;
 
-    do
+    //  CPDR
+    if ( memory_find_down( CPU_REG_HL, count, GET_A( ), &compared ) == true )
     {
-        //  CPD
-        compare_8_ED( GET_A( ), memory_get_8( CPU_REG_HL ) );
+        //  Plain memory, reading the last byte again changes nothing
+        data = memory_get_8( (uint16_t)( CPU_REG_HL - ( compared - 1 ) ) );
+    }
+    else
+    {
+        //  The block wraps around memory or has a read handler, search it
+        //  one byte at a time and read each byte once
+        for( compared = 1; ; compared += 1 )
+        {
+            data = memory_get_8( (uint16_t)( CPU_REG_HL - ( compared - 1 ) ) );
+            if ( ( data == GET_A( ) ) || ( compared == count ) )
+            {
+                break;
+            }
+        }
+    }
 
-        //  Adjust counter and pointer
-        CPU_REG_HL -= 1;
-        CPU_REG_BC -= 1;
+    //  The flags come from the last byte compared
+    compare_8_ED( GET_A( ), data );
 
-        //  Has the count reached zero ?
-        if( CPU_REG_BC == 0 )
-            CLEAR_FLAG_PV( );       //  BC == 0
-        else
-            SET_FLAG_PV( );         //  BC != 0
+    //  Adjust counter and pointer
+    CPU_REG_HL -= compared;
+    CPU_REG_BC -= compared;
 
-        //  Was the search byte located ?
-        if( GET_FLAG_Z( ) != 0 )
-            break;
+    //  Has the count reached zero ?
+    if( CPU_REG_BC == 0 )
+        CLEAR_FLAG_PV( );       //  BC == 0
+    else
+        SET_FLAG_PV( );         //  BC != 0
 
-    }   while( CPU_REG_BC != 0 );
+    //  Every repeat fetched ED and the op-code again
+    refresh_advance( ( compared - 1 ) * 2 );
 
-    //  Set the number of states for this instruction
-    operation_rc.states =  16 + count;
+    //  Set the number of states for this instruction ( 21 for every repeat )
+    machine->operation_rc.states = ( ( compared - 1 ) * 21 ) + 16;
 }
 
 /****************************************************************************/
@@ -1007,37 +990,55 @@ logic_cpir_ED(
     )
 {
     /**
-     *  @param  count           Number of clock cycles                      */
-    int                         count;
+     *  @param  count           Number of bytes to search                   */
+    uint32_t                    count;
+    /**
+     *  @param  compared        Number of bytes compared                    */
+    uint32_t                    compared;
+    /**
+     *  @param  data            The last byte compared                      */
+    uint8_t                     data;
 
-    //  Set the number of clock cycles this instruction will consume.
-    if( CPU_REG_BC == 0 )
-        count = 0x0080000;
-    else
-        count = (int)CPU_REG_BC * 8;
+    //  A count of zero searches 64 KB
+    count = ( CPU_REG_BC == 0 ) ? 0x10000 : CPU_REG_BC;
 
-    do
+    //  CPIR
+    if ( memory_find_up( CPU_REG_HL, count, GET_A( ), &compared ) == true )
     {
-        //  CPI
-        compare_8_ED( GET_A( ), memory_get_8( CPU_REG_HL ) );
+        //  Plain memory, reading the last byte again changes nothing
+        data = memory_get_8( (uint16_t)( CPU_REG_HL + ( compared - 1 ) ) );
+    }
+    else
+    {
+        //  The block wraps around memory or has a read handler, search it
+        //  one byte at a time and read each byte once
+        for( compared = 1; ; compared += 1 )
+        {
+            data = memory_get_8( (uint16_t)( CPU_REG_HL + ( compared - 1 ) ) );
+            if ( ( data == GET_A( ) ) || ( compared == count ) )
+            {
+                break;
+            }
+        }
+    }
 
-        //  Adjust counter and pointer
-        CPU_REG_HL += 1;
-        CPU_REG_BC -= 1;
+    //  The flags come from the last byte compared
+    compare_8_ED( GET_A( ), data );
 
-        //  Has the count reached zero ?
-        if( CPU_REG_BC == 0 )
-            CLEAR_FLAG_PV( );       //  BC == 0
-        else
-            SET_FLAG_PV( );         //  BC != 0
+    //  Adjust counter and pointer
+    CPU_REG_HL += compared;
+    CPU_REG_BC -= compared;
 
-        //  Was the search byte located ?
-        if( GET_FLAG_Z( ) != 0 )
-            break;
+    //  Has the count reached zero ?
+    if( CPU_REG_BC == 0 )
+        CLEAR_FLAG_PV( );       //  BC == 0
+    else
+        SET_FLAG_PV( );         //  BC != 0
 
-    }   while( CPU_REG_BC != 0 );
+    //  Every repeat fetched ED and the op-code again
+    refresh_advance( ( compared - 1 ) * 2 );
 
-    //  Set the number of states for this instruction
-    operation_rc.states =  16 + count;
+    //  Set the number of states for this instruction ( 21 for every repeat )
+    machine->operation_rc.states = ( ( compared - 1 ) * 21 ) + 16;
 }
 /****************************************************************************/
\ No newline at end of file
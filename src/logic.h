@@ -70,6 +70,30 @@
  * Prototypes
  ****************************************************************************/
 
+//----------------------------------------------------------------------------
+uint8_t
+and_8(
+    uint8_t                     byte_1,
+    uint8_t                     byte_2
+    );
+//----------------------------------------------------------------------------
+uint8_t
+or_8(
+    uint8_t                     byte_1,
+    uint8_t                     byte_2
+    );
+//----------------------------------------------------------------------------
+uint8_t
+xor_8(
+    uint8_t                     byte_1,
+    uint8_t                     byte_2
+    );
+//----------------------------------------------------------------------------
+void
+compare_8(
+    uint16_t                    byte_1,
+    uint16_t                    byte_2
+    );
 //------------------------------------------------------------------------ 157
 void
 logic_andr_i80(
@@ -120,6 +144,37 @@ void
 logic_cpr_i80(
     uint8_t                     op_code
     );
+//----------------------------------------------------------------------------
+/*  AND, OR, XOR and CP r, one handler for each register                    */
+#define LOGIC_R_PROTO( R )                                                  \
+void                                                                        \
+logic_andr_i80_##R(                                                         \
+    uint8_t                     op_code                                     \
+    );                                                                      \
+void                                                                        \
+logic_orr_i80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    );                                                                      \
+void                                                                        \
+logic_xorr_i80_##R(                                                         \
+    uint8_t                     op_code                                     \
+    );                                                                      \
+void                                                                        \
+logic_cpr_i80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    );
+REG_R_EACH( LOGIC_R_PROTO )
+#undef  LOGIC_R_PROTO
+//----------------------------------------------------------------------------
+/*  The same handlers by register code, NULL for (HL)                       */
+extern
+void                        (* const logic_andr_i80_op[ 8 ])( uint8_t );
+extern
+void                        (* const logic_orr_i80_op[ 8 ])( uint8_t );
+extern
+void                        (* const logic_xorr_i80_op[ 8 ])( uint8_t );
+extern
+void                        (* const logic_cpr_i80_op[ 8 ])( uint8_t );
 //------------------------------------------------------------------------ 163
 void
 logic_cpn_i80(
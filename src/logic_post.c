@@ -40,6 +40,7 @@
 #include "registers.h"          //  All things CPU registers.
 #include "op_code.h"            //  OP-Code instruction maps
 #include "logic.h"              //  Logic (AND, OR, XOR, CMP) instrucions.
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -68,6 +69,10 @@
  ****************************************************************************/
 
 //----------------------------------------------------------------------------
+/**
+ *  @param  post_device_reads   Reads of the device page of tc_cpir_01      */
+static
+int                             post_device_reads;
 //----------------------------------------------------------------------------
 
 /****************************************************************************
@@ -81,6 +86,32 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************/
+/**
+ *  Read handler of the device page used by tc_cpir_01( ).
+ *
+ *  @param  address             Memory address
+ *
+ *  @return                     x'33 at offsets x'05 and x'0A, else x'00.
+ *
+ *  @note
+ *      Every read is counted.
+ *
+ ****************************************************************************/
+
+static
+uint8_t
+post_device_read(
+    uint16_t                    address
+    )
+{
+    post_device_reads += 1;
+
+    //  DONE!
+    return( ( ( ( address & 0xFF ) == 0x05 ) || ( ( address & 0xFF ) == 0x0A ) )
+            ? 0x33 : 0x00 );
+}
+
 /****************************************************************************/
 /**
  *  AND     B
@@ -2905,6 +2936,88 @@ tc_cpir_00(
     return( post_rc );
 }
 
+/****************************************************************************/
+/**
+ *  CPIR and CPDR over a device page
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      The byte loops read every byte once, the match included.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_cpir_01(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        0x3E, 0x33,             //  0000    LD   A, 033h    ;Target byte
+        0x21, 0x00, 0x41,       //  0002    LD   HL, 4100h  ;Search up
+        0x01, 0x10, 0x00,       //  0005    LD   BC, 0010h  ;Byte Count
+        0xED, 0xB1,             //  0008    CPIR
+        0x54,                   //  000A    LD   D, H       ;Save HL
+        0x5D,                   //  000B    LD   E, L
+        0x21, 0x0F, 0x41,       //  000C    LD   HL, 410Fh  ;Search down
+        0x01, 0x10, 0x00,       //  000F    LD   BC, 0010h  ;Byte Count
+        0xED, 0xB9,             //  0012    CPDR
+        0x76      };            //  0014    HALT            ;THE END
+
+    /************************************************************************
+     *  Run the program
+     ************************************************************************/
+
+    //  Assume a successful test run.
+    post_rc = true;
+
+    //  Load the program
+    memory_load( 0x0000, sizeof( program ), program );
+    memory_map_device( 0x4100, MEMORY_PAGE_SIZE, post_device_read, NULL );
+    post_device_reads = 0;
+
+    //  Run the program
+    inst_fetch( );
+
+    memory_map_ram( 0x4100, MEMORY_PAGE_SIZE );
+
+    /************************************************************************
+     *  Verify the results
+     ************************************************************************/
+
+    if (    ( CPU_REG_PC != 0x0015 )
+         || ( CPU_REG_DE != 0x4106 )
+         || ( CPU_REG_HL != 0x4109 )
+         || ( CPU_REG_BC != 0x000A )
+         || ( GET_FLAG_Z( ) == 0 )
+         || ( post_device_reads != 12 ) )
+    {
+        //  NO:     Write an error message
+        printf( "POST: tc_cpir_01 failed:    [cpir     ]\n" );
+        printf( "POST: PC = 0x%04X\n", CPU_REG_PC );
+        printf( "POST: DE = 0x%04X\n", CPU_REG_DE );
+        printf( "POST: HL = 0x%04X\n", CPU_REG_HL );
+        printf( "POST: BC = 0x%04X\n", CPU_REG_BC );
+        printf( "POST: Reads = %d\n", post_device_reads );
+
+        //  Set the return code to FALSE.
+        post_rc = false;
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
 /****************************************************************************
  * MAIN
  ****************************************************************************/
@@ -2997,6 +3110,7 @@ logic_post(
             if ( post_rc == true )  post_rc = tc_cpi_00( );         //  CPI
             if ( post_rc == true )  post_rc = tc_cpdr_00( );        //  CPDR
             if ( post_rc == true )  post_rc = tc_cpir_00( );        //  CPIR
+            if ( post_rc == true )  post_rc = tc_cpir_01( );        //  CPIR, CPDR  (device)
         }
 
         //  Was the test suite successfully complete :
@@ -0,0 +1,499 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Guest machine context.
+ *
+ *  Everything that belongs to one emulated computer, its registers, main
+ *  memory, interrupt state, counters, decoded blocks and devices, lives in
+ *  a struct machine_t.  The op-code handlers, the instruction loops and the
+ *  BIOS reach it through the thread local pointer 'machine', the same way
+ *  C library code reaches errno, so none of their signatures changed.
+ *
+ *  A host thread runs a guest by binding it with machine_bind( ) and then
+ *  calling inst_fetch( ).  Any number of guests can be created and each
+ *  host thread can run a different one at the same time.  A guest must
+ *  only be bound to one thread at a time, and may move to another thread
+ *  between runs.
+ *
+ *  Shared by every guest, and only written before the first guest runs:
+ *
+ *      flags_init( )           Condition flag tables
+ *      op_code_xxx_init( )     Op-code tables
+ *
+ *  The console ( stdin/stdout ), the pacing clock setting and the
+ *  hot-spot profiler are process wide.
+ *
+ *  machine_save( ) writes a snapshot of the bound guest to a file and
+ *  machine_load( ) puts it back.  A snapshot holds the registers, memory,
+ *  CPU mode, interrupt state and the BIOS mount table, it is written by
+ *  the same build on the same host and is not meant to be portable.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <unistd.h>             //  UNIX standard library.
+#include <stdio.h>              //  Standard I/O definitions
+#include <string.h>             //  Functions for managing strings
+#include <fcntl.h>              //  open( )
+#include <sys/stat.h>           //  fstat( )
+#include <sys/mman.h>           //  mmap( )
+                                //*******************************************
+
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "memory.h"             //  Memory management and access
+#include "registers.h"          //  All things CPU registers.
+#include "block_cache.h"        //  Decoded basic block cache
+#include "jit.h"                //  x86-64 translator
+#include "bios.h"               //  CP/M BIOS
+#include "idle.h"               //  Console idle detection
+#include "interrupt.h"          //  Maskable interrupts
+#include "machine.h"            //  Guest machine context
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  MACHINE_ALIGN       The register file starts a cache line       */
+#define MACHINE_ALIGN           ( 64 )
+//----------------------------------------------------------------------------
+/**
+ *  @param  IMAGE_MAGIC         First bytes of a snapshot file
+ *  @param  IMAGE_VERSION       Layout of struct machine_image_t            */
+#define IMAGE_MAGIC             "i80SNAP"
+#define IMAGE_VERSION           ( 2 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  machine_image_t     Layout of a snapshot file                   */
+struct  machine_image_t
+{
+    /**
+     *  @param  magic           IMAGE_MAGIC                                 */
+    char                        magic[ 8 ];
+    /**
+     *  @param  version         IMAGE_VERSION                               */
+    uint32_t                    version;
+    /**
+     *  @param  size            sizeof( struct machine_image_t )            */
+    uint32_t                    size;
+    /**
+     *  @param  cpu_regs        The register file, R holds its real value   */
+    struct  cpu_regs_t          cpu_regs;
+    /**
+     *  @param  flags_lazy      ALU operation whose flags are not in F yet  */
+    struct  flags_lazy_t        flags_lazy;
+    /**
+     *  @param  cpu             Runtime mode                                */
+    enum    CPU_e               cpu;
+    /**
+     *  @param  interrupt       Interrupt state of the CPU                  */
+    struct  interrupt_t         interrupt;
+    /**
+     *  @param  bios            Mount table and console state               */
+    struct  bios_image_t        bios;
+    /**
+     *  @param  memory          CPU Main Memory and the banks               */
+    uint8_t                     memory[ MEMORY_IMAGE_SIZE ];
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  machine             The guest bound to this host thread         */
+_Thread_local
+struct  machine_t           *   machine;
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Create a guest.
+ *
+ *  @param
+ *
+ *  @return                     The new guest.  It is powered off: every
+ *                              register and all of memory is zero.
+ *
+ *  @note
+ *      The guest is not bound, see machine_bind( ).
+ *
+ ****************************************************************************/
+
+struct  machine_t *
+machine_create(
+    void
+    )
+{
+    /**
+     *  @param  guest           The new guest                               */
+    struct  machine_t       *   guest;
+    /**
+     *  @param  size            Allocation size, a multiple of the alignment */
+    size_t                      size;
+    /**
+     *  @param  previous        Guest bound before this function was called */
+    struct  machine_t       *   previous;
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    size = ( sizeof( struct machine_t ) + MACHINE_ALIGN - 1 )
+         & ~(size_t)( MACHINE_ALIGN - 1 );
+
+    guest = aligned_alloc( MACHINE_ALIGN, size );
+    if ( guest == NULL )
+    {
+        printf( "machine: out of memory\n" );
+        exit( 1 );
+    }
+    memset( guest, 0, size );
+
+    /************************************************************************
+     *  Function Code
+     ************************************************************************/
+
+    //  Start up in Intel 8080 mode
+    guest->cpu = CPU_I80;
+    guest->pace_due = UINT64_MAX;
+
+    //  Give it its own memory map, blocks and devices
+    memory_create( guest );
+    interrupt_create( guest );
+#if INST_ENGINE == INST_ENGINE_BLOCK
+    block_cache_create( guest );
+#endif
+    bios_create( guest );
+
+    //  Let the modules that only work on the bound guest set it up
+    previous = machine_bind( guest );
+    idle_input( );
+    machine_bind( previous );
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    //  DONE!
+    return( guest );
+}
+
+/****************************************************************************/
+/**
+ *  Destroy a guest.
+ *
+ *  @param  guest               The guest, it must not be running.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Unbinds it when it is bound to the calling thread.
+ *
+ ****************************************************************************/
+
+void
+machine_destroy(
+    struct  machine_t       *   guest
+    )
+{
+    //  Release what the modules own
+    bios_destroy( guest );
+#if INST_ENGINE == INST_ENGINE_BLOCK
+    block_cache_destroy( guest );
+#endif
+#if JIT_ENABLE
+    jit_destroy( guest );
+#endif
+    interrupt_destroy( guest );
+    memory_destroy( guest );
+
+    //  Is it bound to this thread ?
+    if ( machine == guest )
+    {
+        //  YES:    Not anymore
+        machine = NULL;
+    }
+
+    free( guest );
+}
+
+/****************************************************************************/
+/**
+ *  Bind a guest to the calling host thread.
+ *
+ *  @param  guest               The guest that the following calls work on.
+ *
+ *  @return                     The guest that was bound before.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+struct  machine_t *
+machine_bind(
+    struct  machine_t       *   guest
+    )
+{
+    /**
+     *  @param  previous        Guest bound before this call                */
+    struct  machine_t       *   previous;
+
+    previous = machine;
+    machine = guest;
+
+    //  DONE!
+    return( previous );
+}
+
+/****************************************************************************/
+/**
+ *  Write a snapshot of the bound guest.
+ *
+ *  @param  file_name           The snapshot file, it is replaced.
+ *
+ *  @return                     TRUE when the snapshot was written, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      Must be called between two instructions or from an op-code handler.
+ *      The image is built in memory and written with a single write( ) to
+ *      a temporary file that is then renamed, so a reader never sees half
+ *      of a snapshot.
+ *
+ ****************************************************************************/
+
+int
+machine_save(
+    const
+    char                    *   file_name
+    )
+{
+    /**
+     *  @param  image           The snapshot                                */
+    struct  machine_image_t *   image;
+    /**
+     *  @param  temp_name       Name the snapshot is written under          */
+    char                        temp_name[ DISK_NAME_SIZE + 8 ];
+    /**
+     *  @param  fd              File Descriptor                             */
+    int                         fd;
+    /**
+     *  @param  written         Bytes written                               */
+    ssize_t                     written;
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    image = calloc( 1, sizeof( struct machine_image_t ) );
+    if ( image == NULL )
+    {
+        printf( "machine: out of memory\n" );
+        exit( 1 );
+    }
+
+    /************************************************************************
+     *  Function Code
+     ************************************************************************/
+
+    memcpy( image->magic, IMAGE_MAGIC, sizeof( IMAGE_MAGIC ) );
+    image->version = IMAGE_VERSION;
+    image->size = sizeof( struct machine_image_t );
+
+    //  The CPU
+    image->cpu_regs = machine->cpu_regs;
+    image->cpu_regs.r = refresh_get( );
+    image->flags_lazy = machine->flags_lazy;
+    image->cpu = machine->cpu;
+    memcpy( &image->interrupt, &machine->interrupt, sizeof( image->interrupt ) );
+
+    //  The devices and memory
+    bios_save( &image->bios );
+    memory_snapshot( image->memory );
+
+    //  Write it
+    snprintf( temp_name, sizeof( temp_name ), "%s.tmp", file_name );
+    fd = open( temp_name, ( O_CREAT | O_TRUNC | O_WRONLY ), ( S_IRUSR | S_IWUSR ) );
+    if ( fd < 0 )
+    {
+        free( image );
+        return( false );
+    }
+    written = write( fd, image, sizeof( struct machine_image_t ) );
+    close( fd );
+    free( image );
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    //  Was all of it written ?
+    if (    ( written != sizeof( struct machine_image_t ) )
+         || ( rename( temp_name, file_name ) != 0 ) )
+    {
+        //  NO:     Don't leave a partial file behind
+        unlink( temp_name );
+        return( false );
+    }
+
+    //  DONE!
+    return( true );
+}
+
+/****************************************************************************/
+/**
+ *  Restore the bound guest from a snapshot.
+ *
+ *  @param  file_name           The snapshot file.
+ *
+ *  @return                     TRUE when the guest was restored, else FALSE
+ *                              is returned and the guest is unchanged.
+ *
+ *  @note
+ *      The file is mapped rather than read.  The guest continues from the
+ *      restored PC, through inst_resume( ) or, when called from an op-code
+ *      handler, with the next instruction.
+ *
+ ****************************************************************************/
+
+int
+machine_load(
+    const
+    char                    *   file_name
+    )
+{
+    /**
+     *  @param  image           The snapshot                                */
+    const
+    struct  machine_image_t *   image;
+    /**
+     *  @param  fd              File Descriptor                             */
+    int                         fd;
+    /**
+     *  @param  file_stat       Size of the file                            */
+    struct  stat                file_stat;
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    fd = open( file_name, O_RDONLY );
+    if ( fd < 0 )
+    {
+        return( false );
+    }
+
+    //  Is it the size of a snapshot ?
+    if (    ( fstat( fd, &file_stat ) != 0 )
+         || ( file_stat.st_size != sizeof( struct machine_image_t ) ) )
+    {
+        //  NO:     It was not written by this build
+        close( fd );
+        return( false );
+    }
+
+    image = mmap( NULL, sizeof( struct machine_image_t ),
+                  PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if ( image == MAP_FAILED )
+    {
+        return( false );
+    }
+
+    //  Is it a snapshot of this layout ?
+    if (    ( memcmp( image->magic, IMAGE_MAGIC, sizeof( IMAGE_MAGIC ) ) != 0 )
+         || ( image->version != IMAGE_VERSION )
+         || ( image->size    != sizeof( struct machine_image_t ) ) )
+    {
+        //  NO:     Leave the guest alone
+        munmap( (void *)image, sizeof( struct machine_image_t ) );
+        return( false );
+    }
+
+    /************************************************************************
+     *  Function Code
+     ************************************************************************/
+
+    //  The CPU
+    machine->cpu_regs = image->cpu_regs;
+    refresh_put( image->cpu_regs.r );
+    machine->flags_lazy = image->flags_lazy;
+    machine->cpu = image->cpu;
+    machine->interrupt.iff1 = image->interrupt.iff1;
+    machine->interrupt.iff2 = image->interrupt.iff2;
+    machine->interrupt.mode = image->interrupt.mode;
+
+    //  The instruction count of EI belongs to the run that saved it
+    machine->interrupt.ei_inst = 0;
+
+    //  A request belongs to the device that raised it, not to the snapshot
+    atomic_store( &machine->interrupt.line, 0 );
+    atomic_store( &machine->interrupt.data, 0 );
+    atomic_store( &machine->interrupt_pending, 0 );
+
+    //  The memory and devices
+    memory_restore( image->memory );
+    bios_load( &image->bios );
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    munmap( (void *)image, sizeof( struct machine_image_t ) );
+
+    //  DONE!
+    return( true );
+}
+
+/****************************************************************************/
@@ -0,0 +1,256 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+#ifndef MACHINE_H
+#define MACHINE_H
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Guest machine context.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * System APIs
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stddef.h>             //  size_t
+                                //*******************************************
+
+/****************************************************************************
+ * Application APIs
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "memory.h"             //  Memory management and access
+#include "registers.h"          //  All things CPU registers.
+#include "stats.h"              //  Performance counters
+#include "interrupt.h"          //  Maskable interrupts
+                                //*******************************************
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  CPU                 Runtime mode of the bound guest
+ *  @param  EIS                 Extended Instruction Set being decoded
+ *                              (CB), (DD), (DE), (FD)                      */
+#define CPU                     ( machine->cpu )
+#define EIS                     ( machine->eis )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  machine_t           Everything that belongs to one guest        */
+struct  machine_t
+{
+    /*      CPU                                                             */
+    /**
+     *  @param  cpu_regs        The register file                           */
+    struct  cpu_regs_t          cpu_regs;
+    /**
+     *  @param  flags_lazy      ALU operation whose flags are not in F yet  */
+    struct  flags_lazy_t        flags_lazy;
+    /**
+     *  @param  cpu             Runtime mode                                */
+    enum    CPU_e               cpu;
+    /**
+     *  @param  eis             Extended instruction set being decoded      */
+    enum    EIS_e               eis;
+    /**
+     *  @param  operation_rc    Result of the last op-code handler          */
+    struct  operation_rc_t      operation_rc;
+    /**
+     *  @param  pc              Address of the instruction being executed   */
+    uint16_t                    pc;
+    /**
+     *  @param  refresh_m1      M1 cycle count when R was last written      */
+    uint64_t                    refresh_m1;
+    /**
+     *  @param  interrupt       Interrupt state of the CPU                  */
+    struct  interrupt_t         interrupt;
+    /**
+     *  @param  interrupt_pending   interrupt_accept( ) has to look at it   */
+    _Atomic int                 interrupt_pending;
+    /**
+     *  @param  interrupt_wait  Devices and a HALT waiting for them         */
+    struct  interrupt_wait_t    interrupt_wait;
+    /**
+     *  @param  stats           Counters for the current run                */
+    struct  stats_t             stats;
+    /*      Pacing ( pace.c )                                               */
+    /**
+     *  @param  pace_due        State count at which pace_sync( ) is due    */
+    uint64_t                    pace_due;
+    /**
+     *  @param  pace_hz         Guest clock of the current run              */
+    uint32_t                    pace_hz;
+    /**
+     *  @param  pace_origin_ns  Host time the schedule is measured from     */
+    uint64_t                    pace_origin_ns;
+    /**
+     *  @param  pace_origin_states  Clock states at pace_origin_ns          */
+    uint64_t                    pace_origin_states;
+    /*      Console idle detection ( idle.c )                               */
+    /**
+     *  @param  idle_last       Instructions retired at the last poll       */
+    uint64_t                    idle_last;
+    /**
+     *  @param  idle_polls      Back to back polls without input            */
+    int                         idle_polls;
+    /**
+     *  @param  idle_wait_ms    Current wait for input                      */
+    int                         idle_wait_ms;
+    /*      Decoded blocks and their translations                           */
+    /**
+     *  @param  block_stale     A cached block was invalidated              */
+    bool                        block_stale;
+    /**
+     *  @param  block_cache     Cached blocks ( block_cache.c )             */
+    struct  block_cache_t   *   block_cache;
+    /**
+     *  @param  jit_arena       Executable memory for translated code       */
+    uint8_t                 *   jit_arena;
+    /**
+     *  @param  jit_used        Bytes of the arena in use                   */
+    size_t                      jit_used;
+    /**
+     *  @param  jit_disabled    The arena could not be allocated            */
+    bool                        jit_disabled;
+    /*      Devices                                                         */
+    /**
+     *  @param  bios            Disks and character devices ( cpm_bios.c )  */
+    struct  bios_t          *   bios;
+    /*      Memory ( memory.c )                                             */
+    /**
+     *  @param  mem_read        Base of each page for reads, NULL when the
+     *                          page has a read handler                     */
+    uint8_t                 *   mem_read[ MEMORY_PAGES ];
+    /**
+     *  @param  mem_write       Base of each page for writes, mem_sink for
+     *                          ROM, NULL when the page has a write handler */
+    uint8_t                 *   mem_write[ MEMORY_PAGES ];
+    /**
+     *  @param  mem_page        What is mapped at each page                 */
+    struct  memory_page_t       mem_page[ MEMORY_PAGES ];
+    /**
+     *  @param  mem_read_hooks  Pages with a read handler                   */
+    int                         mem_read_hooks;
+    /**
+     *  @param  mem_bank        Bank visible below MEMORY_COMMON            */
+    uint8_t                     mem_bank;
+    /**
+     *  @param  mem_banks       Banks 1 and up, allocated by the first bank
+     *                          switch ( bank 0 is in main memory )         */
+    uint8_t                 *   mem_banks;
+    /**
+     *  @param  mem_sink        Where writes to ROM go                      */
+    uint8_t                     mem_sink[ MEMORY_PAGE_SIZE ];
+#if MEMORY_CHECKED
+    /**
+     *  @param  mem_watch       One bit per address with a watchpoint       */
+    uint8_t                     mem_watch[ MEMORY_SIZE / 8 ];
+    /**
+     *  @param  mem_watch_hits  Accesses that hit a watchpoint              */
+    uint64_t                    mem_watch_hits;
+    /**
+     *  @param  mem_log         Every access is written here when not NULL  */
+    FILE                    *   mem_log;
+#endif
+    /**
+     *  @param  memory          CPU Main Memory                             */
+    uint8_t                     memory[ MEMORY_SIZE ];
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  machine             The guest bound to this host thread         */
+extern
+_Thread_local
+struct  machine_t           *   machine;
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Prototypes
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+struct  machine_t *
+machine_create(
+    void
+    );
+//----------------------------------------------------------------------------
+void
+machine_destroy(
+    struct  machine_t       *   guest
+    );
+//----------------------------------------------------------------------------
+struct  machine_t *
+machine_bind(
+    struct  machine_t       *   guest
+    );
+//----------------------------------------------------------------------------
+int
+machine_save(
+    const
+    char                    *   file_name
+    );
+//----------------------------------------------------------------------------
+int
+machine_load(
+    const
+    char                    *   file_name
+    );
+//----------------------------------------------------------------------------
+int
+machine_post(
+    void
+    );
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Inline Functions
+ ****************************************************************************/
+
+                                //*******************************************
+#define MACHINE_T_COMPLETE      //  struct machine_t can be used from here on
+#include "memory.h"             //  The memory accessors
+                                //*******************************************
+
+/****************************************************************************/
+
+#endif                      //    MACHINE_H
@@ -0,0 +1,544 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Guest machine context Power On Self Test.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <unistd.h>             //  UNIX standard library.
+#include <stdio.h>              //  Standard I/O definitions
+#include <pthread.h>            //  Host threads
+                                //*******************************************
+
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "memory.h"             //  Memory management and access
+#include "registers.h"          //  All things CPU registers.
+#include "op_code.h"            //  OP-Code instruction maps
+#include "machine.h"            //  Guest machine context
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  POST_GUESTS         Guests run side by side by the tests        */
+#define POST_GUESTS             ( 4 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  post_guest_t        One guest of a test                         */
+struct  post_guest_t
+{
+    /**
+     *  @param  guest           The guest                                   */
+    struct  machine_t       *   guest;
+    /**
+     *  @param  id              Value the guest stores at x'2000            */
+    uint8_t                     id;
+    /**
+     *  @param  cpu             CPU mode it runs in                         */
+    enum    CPU_e               cpu;
+    /**
+     *  @param  post_rc         TRUE when the guest ended as expected       */
+    int                         post_rc;
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Load the test program into the bound guest.
+ *
+ *  @param  id                  Value the program stores at x'2000
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The program counts BC up to x'1000 so the block engine translates
+ *      its loop.
+ *
+ ****************************************************************************/
+
+static
+void
+post_guest_load(
+    uint8_t                     id
+    )
+{
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        0x3E, 0x00,             //  0000    LD      A, id
+        0x32, 0x00, 0x20,       //  0002    LD      (x'2000), A
+        0x01, 0x00, 0x00,       //  0005    LD      BC, x'0000
+        0x03,                   //  0008    INC     BC
+        0x78,                   //  0009    LD      A, B
+        0xFE, 0x10,             //  000A    CP      x'10
+        0xC2, 0x08, 0x00,       //  000C    JP      NZ, x'0008
+        0x76      };            //  000F    HALT
+
+    program[ 1 ] = id;
+
+    //  Load the program
+    memory_load( 0x0000, sizeof( program ), program );
+}
+
+/****************************************************************************/
+/**
+ *  Check the bound guest after it ran the test program.
+ *
+ *  @param  id                  Value the program stored at x'2000
+ *
+ *  @return post_rc             TRUE when the guest ended as expected.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+int
+post_guest_check(
+    uint8_t                     id
+    )
+{
+    //  Did the guest end up where it should have ?
+    if (    ( CPU_REG_PC            != 0x0010 )
+         || ( CPU_REG_BC            != 0x1000 )
+         || ( GET_A( )              !=   0x10 )
+         || ( memory_get_8( 0x2000 ) !=    id ) )
+    {
+        //  NO:     Write an error message
+        printf( "POST: guest 0x%02X failed:\n", id );
+        printf( "POST: PC       = 0x%04X\n", CPU_REG_PC );
+        printf( "POST: BC       = 0x%04X\n", CPU_REG_BC );
+        printf( "POST: A        = 0x%02X\n", GET_A( ) );
+        printf( "POST: (x'2000) = 0x%02X\n", memory_get_8( 0x2000 ) );
+
+        return( false );
+    }
+
+    //  DONE!
+    return( true );
+}
+
+#if PROFILE_ENABLE == 0
+/****************************************************************************/
+/**
+ *  Run one guest on a host thread.
+ *
+ *  @param  arg                 The struct post_guest_t of the guest.
+ *
+ *  @return                     NULL
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void *
+post_guest_thread(
+    void                    *   arg
+    )
+{
+    /**
+     *  @param  post_guest          The guest to run                        */
+    struct  post_guest_t    *   post_guest;
+
+    post_guest = arg;
+
+    //  Bind the guest to this thread
+    machine_bind( post_guest->guest );
+    CPU = post_guest->cpu;
+
+    //  Run the program
+    post_guest_load( post_guest->id );
+    inst_fetch( );
+
+    //  Check it
+    post_guest->post_rc = post_guest_check( post_guest->id );
+
+    //  DONE!
+    return( NULL );
+}
+#endif
+
+/****************************************************************************/
+/**
+ *  Guests run one after the other on one thread
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      Every guest is loaded before any of them runs, and they are checked
+ *      after all of them ran.  Nothing one guest does may show in another.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_machine_00(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+    /**
+     *  @param  owner               The guest that runs the POST            */
+    struct  machine_t       *   owner;
+    /**
+     *  @param  guest               The guests of the test                  */
+    struct  machine_t       *   guest[ POST_GUESTS ];
+    /**
+     *  @param  ndx                 Index into guest[ ]                     */
+    int                         ndx;
+    /**
+     *  @param  cpu                 CPU mode of the POST                    */
+    enum    CPU_e               cpu;
+
+    //  Assume a successful test run.
+    post_rc = true;
+    cpu = CPU;
+
+    //  Create and load the guests
+    for( ndx = 0; ndx < POST_GUESTS; ndx += 1 )
+    {
+        guest[ ndx ] = machine_create( );
+        owner = machine_bind( guest[ ndx ] );
+        CPU = cpu;
+        post_guest_load( 0xA0 + ndx );
+        machine_bind( owner );
+    }
+
+    //  Run them
+    for( ndx = 0; ndx < POST_GUESTS; ndx += 1 )
+    {
+        owner = machine_bind( guest[ ndx ] );
+        inst_fetch( );
+        machine_bind( owner );
+    }
+
+    //  Check and destroy them
+    for( ndx = 0; ndx < POST_GUESTS; ndx += 1 )
+    {
+        owner = machine_bind( guest[ ndx ] );
+        if ( post_guest_check( 0xA0 + ndx ) == false )
+        {
+            post_rc = false;
+        }
+        machine_bind( owner );
+        machine_destroy( guest[ ndx ] );
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
+#if PROFILE_ENABLE == 0
+/****************************************************************************/
+/**
+ *  Guests run at the same time on their own threads
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+int
+tc_machine_01(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+    /**
+     *  @param  post_guest          The guests of the test                  */
+    struct  post_guest_t        post_guest[ POST_GUESTS ];
+    /**
+     *  @param  thread              Host thread of each guest               */
+    pthread_t                   thread[ POST_GUESTS ];
+    /**
+     *  @param  ndx                 Index into post_guest[ ]                */
+    int                         ndx;
+
+    //  Assume a successful test run.
+    post_rc = true;
+
+    //  Start a thread for every guest
+    for( ndx = 0; ndx < POST_GUESTS; ndx += 1 )
+    {
+        post_guest[ ndx ].guest = machine_create( );
+        post_guest[ ndx ].id = 0xB0 + ndx;
+        post_guest[ ndx ].cpu = CPU;
+        post_guest[ ndx ].post_rc = false;
+
+        if ( pthread_create( &thread[ ndx ], NULL,
+                             post_guest_thread, &post_guest[ ndx ] ) != 0 )
+        {
+            printf( "POST: tc_machine_01 failed: pthread_create\n" );
+            exit( 1 );
+        }
+    }
+
+    //  Wait for them and collect the results
+    for( ndx = 0; ndx < POST_GUESTS; ndx += 1 )
+    {
+        pthread_join( thread[ ndx ], NULL );
+
+        if ( post_guest[ ndx ].post_rc == false )
+        {
+            post_rc = false;
+        }
+        machine_destroy( post_guest[ ndx ].guest );
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+#endif
+
+/****************************************************************************/
+/**
+ *  A snapshot continues in another guest
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      The snapshot is taken after the test program halted.  The second
+ *      guest gets one more instruction at the restored PC and must run it
+ *      without a CPU reset.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_machine_02(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+    /**
+     *  @param  owner               The guest that runs the POST            */
+    struct  machine_t       *   owner;
+    /**
+     *  @param  guest               The guests of the test                  */
+    struct  machine_t       *   guest[ 2 ];
+    /**
+     *  @param  file_name           The snapshot file                       */
+    char                        file_name[ 64 ];
+    /**
+     *  @param  program             INC BC, HALT                            */
+    uint8_t                     program[ ] = { 0x03, 0x76 };
+    /**
+     *  @param  cpu                 CPU mode of the POST                    */
+    enum    CPU_e               cpu;
+
+    //  Assume a successful test run.
+    post_rc = true;
+    cpu = CPU;
+    snprintf( file_name, sizeof( file_name ),
+              "/tmp/i80-emul-post-%d.snap", (int)getpid( ) );
+
+    //  Run the first guest and save it
+    guest[ 0 ] = machine_create( );
+    owner = machine_bind( guest[ 0 ] );
+    CPU = cpu;
+    post_guest_load( 0xC0 );
+    inst_fetch( );
+
+    //  A device request is not part of the snapshot, the interrupt mode is
+    machine->interrupt.mode = 1;
+    interrupt_raise( guest[ 0 ], 0xD7 );
+
+    if ( machine_save( file_name ) == false )
+    {
+        printf( "POST: tc_machine_02 failed: unable to write %s\n", file_name );
+        post_rc = false;
+    }
+
+    //  A file that is not a snapshot must leave the guest alone
+    guest[ 1 ] = machine_create( );
+    machine_bind( guest[ 1 ] );
+    if (    ( post_rc == true )
+         && ( machine_load( "/dev/null" ) == true ) )
+    {
+        printf( "POST: tc_machine_02 failed: /dev/null was loaded\n" );
+        post_rc = false;
+    }
+
+    //  Restore the snapshot into the second guest
+    if (    ( post_rc == true )
+         && ( machine_load( file_name ) == false ) )
+    {
+        printf( "POST: tc_machine_02 failed: unable to load %s\n", file_name );
+        post_rc = false;
+    }
+    unlink( file_name );
+
+    //  Did everything come back ?
+    if (    ( post_rc == true )
+         && ( CPU == cpu )
+         && ( post_guest_check( 0xC0 ) == true )
+         && ( machine->interrupt.mode == 1 )
+         && ( atomic_load( &machine->interrupt.line ) == 0 )
+         && ( atomic_load( &machine->interrupt_pending ) == 0 ) )
+    {
+        //  YES:    Continue from there
+        memory_load( CPU_REG_PC, sizeof( program ), program );
+        inst_resume( );
+
+        if (    ( CPU_REG_PC != 0x0012 )
+             || ( CPU_REG_BC != 0x1001 ) )
+        {
+            printf( "POST: tc_machine_02 failed: resume\n" );
+            printf( "POST: PC       = 0x%04X\n", CPU_REG_PC );
+            printf( "POST: BC       = 0x%04X\n", CPU_REG_BC );
+            post_rc = false;
+        }
+    }
+    else
+    if ( post_rc == true )
+    {
+        printf( "POST: tc_machine_02 failed: restore\n" );
+        post_rc = false;
+    }
+
+    machine_bind( owner );
+    machine_destroy( guest[ 0 ] );
+    machine_destroy( guest[ 1 ] );
+
+    //  DONE!
+    return( post_rc );
+}
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+
+/****************************************************************************/
+/**
+ *  Guest machine context Power On Self Test
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      The hot-spot profiler is shared by every guest so the threaded test
+ *      is left out when it is built in.
+ *
+ ****************************************************************************/
+
+int
+machine_post(
+    void
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                 */
+    int                         post_rc;
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    //  Assume the test is going to pass
+    post_rc = true;
+
+    /************************************************************************
+     *  POST Code
+     ************************************************************************/
+
+    for( CPU = CPU_I80;
+         CPU <= CPU_Z80;
+         CPU += 1 )
+    {
+        if ( post_rc == true )      post_rc = tc_machine_00( );     //  Guests on one thread
+#if PROFILE_ENABLE == 0
+        if ( post_rc == true )      post_rc = tc_machine_01( );     //  Guests on many threads
+#endif
+        if ( post_rc == true )      post_rc = tc_machine_02( );     //  Snapshot and resume
+
+        //  Was the test suite successfully complete :
+        if( post_rc == true )
+        {
+            //  YES:    Write a completion message
+            printf( "POST: MACHINE complete %s mode.\n",
+                    CPU == CPU_I80 ? "Intel 8080" : "Zilog Z80" );
+        }
+    }
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+    //  DONE!
+    return( post_rc );
+}
+/****************************************************************************/
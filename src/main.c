@@ -31,6 +31,7 @@
 #include <unistd.h>             //  UNIX standard library.
 #include <stdio.h>              //  Standard I/O definitions
 #include <signal.h>             //  Signal processing
+#include <string.h>             //  Functions for managing strings
                                 //*******************************************
 
 /****************************************************************************
@@ -41,6 +42,7 @@
 #include "global.h"             //  Global definitions
 #include "memory.h"             //  Memory management and access
 #include "registers.h"          //  All things CPU registers.
+#include "flags.h"              //  Precomputed condition flag tables
 #include "op_code.h"            //  OP-Code instruction maps
 #include "control.h"            //  Control (NOP, HLT, etc.) instrucions.
 #include "load.h"               //  LD   *,*
@@ -53,6 +55,10 @@
 #include "call.h"               //  Call instructions
 #include "io.h"                 //  Input & Output instructions
 #include "bios.h"               //  CP/M BIOS
+#include "stats.h"              //  Performance counters
+#include "zygote.h"             //  Fork server for batch jobs
+#include "disk.h"               //  Disk images
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -116,7 +122,9 @@ struct  inst_timing_t
  *  @return                     No information is returned from this function.
  *
  *  @note
- *      Causes a memory dump to stdout.
+ *      SIGINT causes a memory dump to stdout, SIGUSR1 asks for the
+ *      performance counters, which the guest thread displays outside the
+ *      handler ( stats_poll( ) ).
  *
  ****************************************************************************/
 
@@ -157,6 +165,12 @@ sig_handler(
         //  We are done
         exit( 0 );
     }
+    else
+    if ( signo == SIGUSR1 )
+    {
+        //  Have the guest thread report the performance counters
+        stats_requested = 1;
+    }
 }
 
 /****************************************************************************/
@@ -168,6 +182,7 @@ sig_handler(
  *  @return parity              0 = ODD, 1 = EVEN
  *
  *  @note
+ *      flags_init( ) must have been called.
  *
  ****************************************************************************/
 
@@ -176,66 +191,8 @@ parity_8(
     uint8_t                     data_byte
     )
 {
-    /**
-     *  @param  bit_count           Return code                             */
-    uint8_t                     bit_count;
-    /**
-     *  @param  bit                 Bit position                            */
-    uint8_t                     bit_position;
-    /**
-     *  @param  byte                Work data byte                          */
-    uint8_t                     byte;
-    /**
-     *  @param  rc                  Return Code                             */
-    uint8_t                     rc;
-
-    /************************************************************************
-     *  Function Initialization
-     ************************************************************************/
-
-    //  Zero out the number of bits in the byte
-    bit_count = 0;
-
-    //  Load the data byte
-    byte = data_byte;
-
-    /************************************************************************
-     *  Function Code
-     ************************************************************************/
-
-    //  Count the number of bits in the byte
-    for ( bit_position = 0;
-          bit_position < 8;
-          bit_position += 1 )
-    {
-        //  Is this bit set ?
-        if ( ( byte & 0x01 ) == 0x01 )
-        {
-            //  YES:    Increment the number of bits
-            bit_count += 1;
-        }
-        //  Right shift one bit
-        byte >>= 1;
-    }
-
-    //  Do we have an odd number of bits ?
-    if ( ( bit_count & 0x01 ) == 0x01 )
-        //  YES:    Odd parity
-        rc = 0x00;
-    else
-        //  NO:     Even parity
-        rc = 0x01;
-
-    if(    ( CPU_REG_PC >= 0x0001 )
-        && ( CPU_REG_PC <= 0x0001 ) )
-        printf( "%04X - %d = parity_8( %02Xh ) [%d bits]\r\n", CPU_REG_PC, rc, data_byte, bit_count );
-
-    /************************************************************************
-     *  Function Exit
-     ************************************************************************/
-
     //  DONE!
-    return( rc );
+    return( ( flags_szp[ data_byte ] & CPU_FLAG_PV ) ? 0x01 : 0x00 );
 }
 
 /****************************************************************************/
@@ -274,35 +231,35 @@ is_ccc(
     switch( ( op_code & 0x38 ) >> 3 )
     {
         case    CCC_NZ:
-            if ( ( CPU_REG_AF & CPU_FLAG_Z ) == 0 )
+            if ( flags_get( CPU_FLAG_Z ) == 0 )
                 rc = true;
             break;
         case    CCC_Z:
-            if ( ( CPU_REG_AF & CPU_FLAG_Z ) != 0 )
+            if ( flags_get( CPU_FLAG_Z ) != 0 )
                 rc = true;
             break;
         case    CCC_NC:
-            if ( ( CPU_REG_AF & CPU_FLAG_C ) == 0 )
+            if ( flags_get( CPU_FLAG_C ) == 0 )
                 rc = true;
             break;
         case    CCC_C:
-            if ( ( CPU_REG_AF & CPU_FLAG_C ) != 0 )
+            if ( flags_get( CPU_FLAG_C ) != 0 )
                 rc = true;
             break;
         case    CCC_PE:         //  P/V = 1
-            if ( ( CPU_REG_AF & CPU_FLAG_PV ) != 0 )
+            if ( flags_get( CPU_FLAG_PV ) != 0 )
                 rc = true;
             break;
         case    CCC_PO:         //  P/V = 0
-            if ( ( CPU_REG_AF & CPU_FLAG_PV ) == 0 )
+            if ( flags_get( CPU_FLAG_PV ) == 0 )
                 rc = true;
             break;
         case    CCC_P:
-            if ( ( CPU_REG_AF & CPU_FLAG_S ) == 0 )
+            if ( flags_get( CPU_FLAG_S ) == 0 )
                 rc = true;
             break;
         case    CCC_M:
-            if ( ( CPU_REG_AF & CPU_FLAG_S ) != 0 )
+            if ( flags_get( CPU_FLAG_S ) != 0 )
                 rc = true;
             break;
     }
@@ -351,19 +308,19 @@ is_cc(
     switch( ( op_code & 0x18 ) >> 3 )
     {
         case    CC_NZ:
-            if ( ( CPU_REG_AF & CPU_FLAG_Z ) == 0 )
+            if ( flags_get( CPU_FLAG_Z ) == 0 )
                 rc = true;
             break;
         case    CC_Z:
-            if ( ( CPU_REG_AF & CPU_FLAG_Z ) != 0 )
+            if ( flags_get( CPU_FLAG_Z ) != 0 )
                 rc = true;
             break;
         case    CCC_NC:
-            if ( ( CPU_REG_AF & CPU_FLAG_C ) == 0 )
+            if ( flags_get( CPU_FLAG_C ) == 0 )
                 rc = true;
             break;
         case    CC_C:
-            if ( ( CPU_REG_AF & CPU_FLAG_C ) != 0 )
+            if ( flags_get( CPU_FLAG_C ) != 0 )
                 rc = true;
             break;
     }
@@ -393,9 +350,9 @@ push(
     uint16_t                    data
     )
 {
-    //  Save the high byte on the stack
-    memory_put_8( --CPU_REG_SP, ( ( data & 0xFF00 ) >> 8 ) );
-    memory_put_8( --CPU_REG_SP, ( ( data & 0x00FF )      ) );
+    //  The low byte ends up at the new SP, the high byte above it
+    CPU_REG_SP -= 2;
+    memory_put_16_p( CPU_REG_SP, data );
 }
 
 /****************************************************************************/
@@ -419,9 +376,9 @@ pop(
      *  @parm   data                    Data removed from the stack         */
     uint16_t                    data;
 
-    //  Save the high byte on the stack
-    data  = ( memory_get_8( CPU_REG_SP++ )      );
-    data |= ( memory_get_8( CPU_REG_SP++ ) << 8 );
+    //  The low byte is at SP, the high byte above it
+    data = memory_get_16_p( CPU_REG_SP );
+    CPU_REG_SP += 2;
 
     return( data );
 }
@@ -627,6 +584,10 @@ op_code_fd(
  *  @return                     Zero for success. Any other value is an error.
  *
  *  @note
+ *      --resume {file}         Skip the POST and the boot, continue from a
+ *                              snapshot written by the CP SAVE command.
+ *      --zygote {socket}       Boot once without a terminal, then fork a
+ *                              batch job for every connection ( zygote.c ).
  *
  ****************************************************************************/
 
@@ -642,11 +603,23 @@ main(
     /**
      *  @param  op_code             Current instruction code                */
     uint8_t                     op_code;
+    /**
+     *  @param  resume_file         Snapshot named by --resume              */
+    char                        *   resume_file;
+    /**
+     *  @param  zygote_name         Socket named by --zygote                */
+    char                        *   zygote_name;
+    /**
+     *  @param  arg_ndx             Index into argv[ ]                      */
+    int                         arg_ndx;
 
     /************************************************************************
      *  OP-Code Table Initialization
      ************************************************************************/
 
+    //  Build the condition flag tables.
+    flags_init( );
+
     //  Initialize the instruction maps.
     op_code_i80_init( );
     op_code_z80_init( );
@@ -657,11 +630,72 @@ main(
     op_code_FD_init( );
     op_code_FDCB_init( );
 
+    //  Create the guest and run it on this thread
+    machine_bind( machine_create( ) );
+
     //  Install the signal handler
     if ( signal( SIGINT, sig_handler ) == SIG_ERR )
     {
         printf( "\nCan't catch SIGINT\n" );
     }
+    if ( signal( SIGUSR1, sig_handler ) == SIG_ERR )
+    {
+        printf( "\nCan't catch SIGUSR1\n" );
+    }
+
+    /************************************************************************
+     *  Resume From A Snapshot
+     ************************************************************************/
+
+    //  Look for --resume {file} and --zygote {socket}
+    resume_file = NULL;
+    zygote_name = NULL;
+    for( arg_ndx = 1; arg_ndx < ( argc - 1 ); arg_ndx += 1 )
+    {
+        if ( strcmp( argv[ arg_ndx ], "--resume" ) == 0 )
+        {
+            resume_file = argv[ arg_ndx + 1 ];
+        }
+        else
+        if ( strcmp( argv[ arg_ndx ], "--zygote" ) == 0 )
+        {
+            zygote_name = argv[ arg_ndx + 1 ];
+        }
+    }
+
+    //  Is this a fork server ?
+    if ( zygote_name != NULL )
+    {
+        //  YES:    Can it listen ?
+        if ( zygote_init( zygote_name ) == false )
+        {
+            //  NO:     Nothing to do
+            printf( "\nUnable to listen on '%s'\n", zygote_name );
+            return( 1 );
+        }
+
+        //  Boot without a terminal
+        bios_console_fd( STDIN_FILENO, STDOUT_FILENO );
+    }
+
+    //  Was a snapshot named ?
+    if ( resume_file != NULL )
+    {
+        //  YES:    Can it be restored ?
+        if ( machine_load( resume_file ) == true )
+        {
+            //  YES:    Continue where it was saved
+            inst_resume( );
+
+            //  Shutdown
+            bios_shutdown( );
+
+            return( 0 );
+        }
+
+        //  NO:     Start the usual way
+        printf( "\n'%s' is not a snapshot of this build\n", resume_file );
+    }
 
     /************************************************************************
      *  Power On Self Test
@@ -691,6 +725,10 @@ main(
     if ( post_rc == true )  post_rc = call_post( );
     //  IO
     if ( post_rc == true )  post_rc = io_post( );
+    //  MACHINE
+    if ( post_rc == true )  post_rc = machine_post( );
+    //  DISK
+    if ( post_rc == true )  post_rc = disk_post( );
 
     //  Have all tests passes so far ?
     if ( post_rc == true )
@@ -38,7 +38,9 @@
 #include "global.h"             //  Global definitions
 #include "memory.h"             //  Memory management and access
 #include "registers.h"          //  All things CPU registers.
+#include "flags.h"              //  Precomputed condition flag tables
 #include "math.h"               //  8 bit instrucions.
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -113,60 +115,12 @@ add_8(
     /**
      *  @param  sum                 The sum of the add operation            */
     uint16_t                    sum;
-    /**
-     *  @param  half                Half carry difference                   */
-    uint8_t                     half;
 
     //  sum = addend + augend + carry
     sum = (uint16_t)addend + (uint16_t)augend + (uint16_t)carry;
 
-    /************************************************************************
-     *  SET FLAGS
-     ************************************************************************/
-
-    //  Carry
-    if ( ( sum & 0x0100 ) == 0x0100 ) SET_FLAG_C( ); else CLEAR_FLAG_C( );
-
-    //  SUBTRACT/ADD
-    CLEAR_FLAG_N( );
-
-    //  Are we running Intel 8080 mode ?
-    if ( CPU == CPU_I80 )
-    {
-        //  YES:    Set the 'PARITY' flag
-        if ( parity_8( sum & 0x00FF ) == 0 )
-            CLEAR_FLAG_PV( );       //  Parity Even
-        else
-            SET_FLAG_PV( );         //  Parity Odd
-    }
-    else
-    {
-        //  NO:     PARITY/OVERFLOW
-        if (    ( ( addend & 0x80 ) == ( augend & 0x80 ) )
-             && (      sum & 0x80 ) != ( addend & 0x80 ) )
-            SET_FLAG_PV( );
-        else
-            CLEAR_FLAG_PV( );
-    }
-
-    //  HALF CARRY
-    half = ( ( addend & 0x0F ) + ( augend & 0x0F ) + carry );
-    if ( ( half & 0x10 ) == 0x10 )
-        SET_FLAG_H( );
-    else
-        CLEAR_FLAG_H( );
-
-    //  ZERO
-    if ( ( sum & 0x00FF ) == 0x00 )
-        SET_FLAG_Z( );
-    else
-        CLEAR_FLAG_Z( );
-
-    //  SIGN
-    if ( ( sum & 0x0080 ) == 0x80 )
-        SET_FLAG_S( );
-    else
-        CLEAR_FLAG_S( );
+    //  Record the operation, the flags are set when they are read
+    FLAGS_RECORD( FLAGS_OP_ADD, addend, augend, carry, sum );
 
     /************************************************************************
      *  Function Exit
@@ -208,63 +162,12 @@ sub_8(
     /**
      *  @param  difference          The difference of the add operation     */
     uint16_t                    difference;
-    /**
-     *  @param  half                Half carry difference                   */
-    uint8_t                     half;
 
     //  difference = minuend - subtrahend - borrow
     difference = (uint16_t)minuend - (uint16_t)subtrahend - (uint16_t)borrow;
 
-    /************************************************************************
-     *  SET FLAGS
-     ************************************************************************/
-
-    //  Carry
-    if ( ( difference & 0x0100 ) == 0x0100 )
-        SET_FLAG_C( );
-    else
-        CLEAR_FLAG_C( );
-
-    //  SUBTRACT/ADD
-    SET_FLAG_N( );
-
-    //  Are we running Intel 8080 mode ?
-    if ( CPU == CPU_I80 )
-    {
-        //  YES:    Set the 'PARITY' flag
-        if ( parity_8( difference & 0x00FF ) == 0 )
-            CLEAR_FLAG_PV( );       //  Parity Even
-        else
-            SET_FLAG_PV( );         //  Parity Odd
-    }
-    else
-    {
-        //  NO:     PARITY/OVERFLOW
-        if (    ( ( minuend  & 0x80 ) != ( subtrahend & 0x80 ) )
-             && ( difference & 0x80 ) != ( minuend    & 0x80 ) )
-            SET_FLAG_PV( );
-        else
-            CLEAR_FLAG_PV( );
-    }
-
-    //  HALF CARRY
-    half = ( ( minuend & 0x0F ) - ( subtrahend & 0x0F ) - borrow );
-    if ( ( half & 0x10 ) == 0x10 )
-        SET_FLAG_H( );
-    else
-        CLEAR_FLAG_H( );
-
-    //  ZERO
-    if ( ( difference & 0x00FF ) == 0x00 )
-        SET_FLAG_Z( );
-    else
-        CLEAR_FLAG_Z( );
-
-    //  SIGN
-    if ( ( difference & 0x0080 ) == 0x0080 )
-        SET_FLAG_S( );
-    else
-        CLEAR_FLAG_S( );
+    //  Record the operation, the flags are set when they are read
+    FLAGS_RECORD( FLAGS_OP_SUB, minuend, subtrahend, borrow, difference );
 
     /************************************************************************
      *  Function Exit
@@ -302,6 +205,9 @@ inc_8(
     /**
      *  @param  sum                 The sum of the add operation            */
     uint16_t                    sum;
+    /**
+     *  @param  carry               The carry flag is not effected          */
+    uint16_t                    carry;
 
     //  Create 16 bit signed numbers
     if ( number > 127 ) number |= 0xFF00;
@@ -309,51 +215,9 @@ inc_8(
     //  sum = addend + augend + carry
     sum = (uint16_t)number + 1;
 
-    /************************************************************************
-     *  SET FLAGS
-     ************************************************************************/
-
-    //  Carry
-    //          The carry flag is not effected by this instruction.
-
-    //  SUBTRACT/ADD
-    CLEAR_FLAG_N( );
-
-    //  Are we running Intel 8080 mode ?
-    if ( CPU == CPU_I80 )
-    {
-        //  YES:    Set the 'PARITY' flag
-        if ( parity_8( sum & 0x00FF ) == 0 )
-            CLEAR_FLAG_PV( );       //  Parity Even
-        else
-            SET_FLAG_PV( );         //  Parity Odd
-    }
-    else
-    {
-        //  NO:     PARITY/OVERFLOW
-        if ( number == 0x7F )
-            SET_FLAG_PV( );
-        else
-            CLEAR_FLAG_PV( );
-    }
-
-    //  HALF CARRY
-    if ( number & 0x0F == 0x0F )
-        SET_FLAG_H( );
-    else
-        CLEAR_FLAG_H( );
-
-    //  ZERO
-    if ( ( sum & 0x00FF ) == 0x0000 )
-        SET_FLAG_Z( );
-    else
-        CLEAR_FLAG_Z( );
-
-    //  SIGN
-    if ( ( sum & 0x0080 ) == 0x0080 )
-        SET_FLAG_S( );
-    else
-        CLEAR_FLAG_S( );
+    //  Record the operation, the flags are set when they are read
+    carry = flags_get( CPU_FLAG_C );
+    FLAGS_RECORD( FLAGS_OP_INC, number & 0x00FF, 0, carry, sum );
 
     /************************************************************************
      *  Function Exit
@@ -391,6 +255,9 @@ dec_8(
     /**
      *  @param  sum                 The sum of the add operation            */
     uint16_t                    difference;
+    /**
+     *  @param  carry               The carry flag is not effected          */
+    uint16_t                    carry;
 
     //  Create 16 bit signed numbers
     if ( number > 127 ) number |= 0xFF00;
@@ -398,39 +265,9 @@ dec_8(
     //  sum = addend + augend + carry
     difference = (uint16_t)number - 1;
 
-    /************************************************************************
-     *  SET FLAGS
-     ************************************************************************/
-
-    //  Carry
-    //          The carry flag is not effected by this instruction.
-
-    //  SUBTRACT/ADD
-    SET_FLAG_N( );
-
-    //  PARITY/OVERFLOW
-    if ( number == 0x80 )
-        SET_FLAG_PV( );
-    else
-        CLEAR_FLAG_PV( );
-
-    //  HALF CARRY
-    if ( number & 0x1F == 0x1F )
-        SET_FLAG_H( );
-    else
-        CLEAR_FLAG_H( );
-
-    //  ZERO
-    if ( ( difference & 0x00FF ) == 0x0000 )
-        SET_FLAG_Z( );
-    else
-        CLEAR_FLAG_Z( );
-
-    //  SIGN
-    if ( ( difference & 0x0080 ) == 0x0080 )
-        SET_FLAG_S( );
-    else
-        CLEAR_FLAG_S( );
+    //  Record the operation, the flags are set when they are read
+    carry = flags_get( CPU_FLAG_C );
+    FLAGS_RECORD( FLAGS_OP_DEC, number & 0x00FF, 0, carry, difference );
 
     /************************************************************************
      *  Function Exit
@@ -476,7 +313,7 @@ math_addr_i80(
     PUT_A( add_8( reg_get_sr( op_code ), GET_A( ), 0 ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -511,7 +348,7 @@ math_addn_i80(
     PUT_A( add_8( memory_get_8( CPU_REG_PC++ ), GET_A( ), 0 ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -547,7 +384,7 @@ math_addhl_i80(
     PUT_A( add_8( memory_get_8( CPU_REG_HL ), GET_A( ), 0 ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -583,7 +420,7 @@ math_adcr_i80(
     PUT_A( add_8( reg_get_sr( op_code ), GET_A( ), GET_FLAG_C( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -618,7 +455,7 @@ math_adcn_i80(
     PUT_A( add_8( memory_get_8( CPU_REG_PC++ ), GET_A( ), GET_FLAG_C( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -654,7 +491,7 @@ math_adchl_i80(
     PUT_A( add_8( memory_get_8( CPU_REG_HL ), GET_A( ), GET_FLAG_C( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -683,7 +520,7 @@ math_subr_i80(
     PUT_A( sub_8( GET_A( ), reg_get_sr( op_code ), 0 ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -711,7 +548,7 @@ math_subn_i80(
     PUT_A( sub_8( GET_A( ), memory_get_8( CPU_REG_PC++ ), 0 ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -740,7 +577,7 @@ math_subhl_i80(
     PUT_A( sub_8( GET_A( ), memory_get_8( CPU_REG_HL ), 0 ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -769,7 +606,7 @@ math_sbcr_i80(
     PUT_A( sub_8( GET_A( ), reg_get_sr( op_code ), GET_FLAG_C( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -797,7 +634,7 @@ math_sbcn_i80(
     PUT_A( sub_8( GET_A( ), memory_get_8( CPU_REG_PC++ ), GET_FLAG_C( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -826,7 +663,7 @@ math_sbchl_i80(
     PUT_A( sub_8( GET_A( ), memory_get_8( CPU_REG_HL ), GET_FLAG_C( ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   7;
+    machine->operation_rc.states =   7;
 }
 
 /****************************************************************************/
@@ -854,7 +691,7 @@ math_incr_i80(
     reg_put_dr( op_code, inc_8( reg_get_dr( op_code ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -882,7 +719,7 @@ math_inchl_i80(
     memory_put_8( CPU_REG_HL, ( inc_8( memory_get_8( CPU_REG_HL ) ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  11;
+    machine->operation_rc.states =  11;
 }
 
 /****************************************************************************/
@@ -910,9 +747,142 @@ math_decr_r80(
     reg_put_dr( op_code, dec_8( reg_get_dr( op_code ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
+/****************************************************************************/
+/**
+ *  ADD, ADC, SUB, SBC, INC and DEC r with the register resolved at compile time.
+ *
+ *  @parm   op_code             The operation code of the current instruction.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      math_addr_i80_B( ) is ADD A, B and so on.  The op-code tables point
+ *      at these instead of the generic handlers so the register field is
+ *      never decoded at run time.
+ *
+ ****************************************************************************/
+
+#define MATH_R( R )                                                         \
+void                                                                        \
+math_addr_i80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    )                                                                       \
+{                                                                           \
+    PUT_A( add_8( GET_##R( ), GET_A( ), 0 ) );                              \
+    machine->operation_rc.states =   4;                                     \
+}                                                                           \
+                                                                            \
+void                                                                        \
+math_adcr_i80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    )                                                                       \
+{                                                                           \
+    PUT_A( add_8( GET_##R( ), GET_A( ), GET_FLAG_C( ) ) );                  \
+    machine->operation_rc.states =   4;                                     \
+}                                                                           \
+                                                                            \
+void                                                                        \
+math_subr_i80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    )                                                                       \
+{                                                                           \
+    PUT_A( sub_8( GET_A( ), GET_##R( ), 0 ) );                              \
+    machine->operation_rc.states =   4;                                     \
+}                                                                           \
+                                                                            \
+void                                                                        \
+math_sbcr_i80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    )                                                                       \
+{                                                                           \
+    PUT_A( sub_8( GET_A( ), GET_##R( ), GET_FLAG_C( ) ) );                  \
+    machine->operation_rc.states =   4;                                     \
+}                                                                           \
+                                                                            \
+void                                                                        \
+math_incr_i80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    )                                                                       \
+{                                                                           \
+    PUT_##R( inc_8( GET_##R( ) ) );                                         \
+    machine->operation_rc.states =   4;                                     \
+}                                                                           \
+                                                                            \
+void                                                                        \
+math_decr_r80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    )                                                                       \
+{                                                                           \
+    PUT_##R( dec_8( GET_##R( ) ) );                                         \
+    machine->operation_rc.states =   4;                                     \
+}
+REG_R_EACH( MATH_R )
+#undef  MATH_R
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  math_addr_i80_op    Handlers by register code                   */
+#define MATH_R_OP( R )  [ R_##R ] = math_addr_i80_##R,
+void                        (* const math_addr_i80_op[ 8 ])( uint8_t ) =
+{
+    REG_R_EACH( MATH_R_OP )
+};
+#undef  MATH_R_OP
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  math_adcr_i80_op    Handlers by register code                   */
+#define MATH_R_OP( R )  [ R_##R ] = math_adcr_i80_##R,
+void                        (* const math_adcr_i80_op[ 8 ])( uint8_t ) =
+{
+    REG_R_EACH( MATH_R_OP )
+};
+#undef  MATH_R_OP
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  math_subr_i80_op    Handlers by register code                   */
+#define MATH_R_OP( R )  [ R_##R ] = math_subr_i80_##R,
+void                        (* const math_subr_i80_op[ 8 ])( uint8_t ) =
+{
+    REG_R_EACH( MATH_R_OP )
+};
+#undef  MATH_R_OP
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  math_sbcr_i80_op    Handlers by register code                   */
+#define MATH_R_OP( R )  [ R_##R ] = math_sbcr_i80_##R,
+void                        (* const math_sbcr_i80_op[ 8 ])( uint8_t ) =
+{
+    REG_R_EACH( MATH_R_OP )
+};
+#undef  MATH_R_OP
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  math_incr_i80_op    Handlers by register code                   */
+#define MATH_R_OP( R )  [ R_##R ] = math_incr_i80_##R,
+void                        (* const math_incr_i80_op[ 8 ])( uint8_t ) =
+{
+    REG_R_EACH( MATH_R_OP )
+};
+#undef  MATH_R_OP
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  math_decr_r80_op    Handlers by register code                   */
+#define MATH_R_OP( R )  [ R_##R ] = math_decr_r80_##R,
+void                        (* const math_decr_r80_op[ 8 ])( uint8_t ) =
+{
+    REG_R_EACH( MATH_R_OP )
+};
+#undef  MATH_R_OP
+//----------------------------------------------------------------------------
+
 /****************************************************************************/
 /**                     Page        Op-Code
  *  DEC  (HL)            170        10110101
@@ -938,7 +908,7 @@ math_dechl_i80(
     memory_put_8( CPU_REG_HL, ( dec_8( memory_get_8( CPU_REG_HL ) ) ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  11;
+    machine->operation_rc.states =  11;
 }
 
 /****************************************************************************/
@@ -1050,88 +1020,19 @@ math_daa_i80(
     )
 {
     /**
-     *  @param  tmp_a_l4        Low nibble of REG-A                         */
-    uint16_t                    tmp_a_l4;
-    /**
-     *  @param  tmp_a_h4        Upper nibble of REG-A                       */
-    uint16_t                    tmp_a_h4;
-    /**
-     *  @param  sum                 The sum of the add operation            */
-    uint8_t                     sum;
+     *  @param  daa             The adjusted A and its flags                */
+    const
+    struct  flags_daa_t     *   daa;
 
-    //  Copy Reg-A
-    tmp_a_l4 = GET_A( ) & 0x0F;
-    tmp_a_h4 = GET_A( ) & 0xF0;
+    //  Look up A, C and H ( N makes no difference on the 8080 )
+    daa = &flags_daa[ FLAGS_MODE( CPU_I80 ) ][ FLAGS_DAA_INDEX( GET_A( ), GET_F( ) ) ];
 
-    //  Is the lower nibble greater than 9
-    //      or the half carry flag set
-    if(    ( tmp_a_l4         > 9 )
-        || ( GET_FLAG_H( )   != 0 ) )
-    {
-        //  YES:    Add six to the low nibble
-        tmp_a_l4 += 6;
-
-        //  Do we have to set the half carry flag ?
-        if( tmp_a_l4 > 0x0F )
-        {
-            //  YES:    Set half carry and increment the upper nibble
-            SET_FLAG_H( );
-            tmp_a_h4 += 0x10;
-        }
-        else
-        {
-            //  NO:     Clear the half carry flag
-            CLEAR_FLAG_H( );
-        }
-    }
-
-
-    //  Is the upper nibble greater than 9
-    //      or the      carry flag set
-    if(    ( tmp_a_h4         > 0x90 )
-        || ( GET_FLAG_C( )    !=   0 ) )
-    {
-        //  YES:    Add nine to the low nibble
-        tmp_a_h4 += 0x60;
-
-        //  Do we have to set the half carry flag ?
-        if( tmp_a_h4 > 0xFF )
-            SET_FLAG_C( );
-        else
-            CLEAR_FLAG_C( );
-    }
-
-    sum  = ( tmp_a_l4 & 0x0F );
-    sum |=   tmp_a_h4;
-
-    //  Save the result back in register A
-    PUT_A( sum );
-
-    uint16_t bar = GET_A( );
-
-    //  SUBTRACT/ADD
-    CLEAR_FLAG_N( );
-
-    //  YES:    Set the 'PARITY' flag
-    if ( parity_8( GET_A( ) & 0x00FF ) == 0 )
-        CLEAR_FLAG_PV( );       //  Parity Even
-    else
-        SET_FLAG_PV( );         //  Parity Odd
-
-    //  ZERO
-    if ( ( GET_A( ) & 0x00FF ) == 0x00 )
-        SET_FLAG_Z( );
-    else
-        CLEAR_FLAG_Z( );
-
-    //  SIGN
-    if ( ( GET_A( ) & 0x0080 ) == 0x80 )
-        SET_FLAG_S( );
-    else
-        CLEAR_FLAG_S( );
+    //  Save the result back in register A and set the flags
+    CPU_REG_AF = ( (uint16_t)daa->a << 8 )
+               | ( CPU_REG_AF & daa->keep ) | daa->f;
 
     //  Set the number of states for this instruction
-    operation_rc.states =  11;
+    machine->operation_rc.states =  11;
 }
 
 /****************************************************************************/
@@ -1170,167 +1071,19 @@ math_daa_z80(
     )
 {
     /**
-     *  @param  reg_a               The current value of register A         */
-    uint16_t                    reg_a;
-    /**
-     *  @param  reg_f               The current value of register F         */
-    uint16_t                    reg_f;
+     *  @param  daa             The adjusted A and its flags                */
+    const
+    struct  flags_daa_t     *   daa;
 
-    //  Get local copies of register A and F.
-    reg_a = GET_A( );
-    reg_f = GET_F( );
-
-    //  Was the previous arithmetic instruction ADDITION ?
-    if ( ( reg_f & CPU_FLAG_N ) == 0 )
-    {
-        //  YES:    ADDITION
-        //  1       0   0-9     0   0-9     00      0
-        if (    ( ( reg_f & CPU_FLAG_C ) ==    0 )      //  C = 0
-             && ( ( reg_a &       0xF0 ) <= 0x90 )      //  7-4     0-9
-             && ( ( reg_f & CPU_FLAG_H ) ==    0 )      //  H = 0
-             && ( ( reg_a &       0x0F ) <= 0x09 ) )    //  3-0     0-9
-        {
-            //  Nothing to do here
-            reg_a = reg_a;  //  For debug.
-        }
-        //  2       0   0-8     0   A-F     06      0
-        else
-        if (    ( ( reg_f & CPU_FLAG_C ) ==    0 )      //  C = 0
-             && ( ( reg_a &       0xF0 ) <= 0x80 )      //  7-4     0-8
-             && ( ( reg_f & CPU_FLAG_H ) ==    0 )      //  H = 0
-             && ( ( reg_a &       0x0F ) >= 0x0A ) )    //  3-0     A-F
-        {
-            //  Adjust register A by adding 0x06
-            reg_a += 0x06;
-        }
-        //  3       0   0-9     1   0-3     06      0
-        else
-        if (    ( ( reg_f & CPU_FLAG_C ) ==    0 )      //  C = 0
-             && ( ( reg_a &       0xF0 ) <= 0x90 )      //  7-4     0-9
-             && ( ( reg_f & CPU_FLAG_H ) !=    0 )      //  H = 1
-             && ( ( reg_a &       0x0F ) <= 0x03 ) )    //  3-0     0-3
-        {
-            //  Adjust register A by adding 0x06
-            reg_a += 0x06;
-        }
-        //  4       0   A-F     0   0-9     60      1
-        else
-        if (    ( ( reg_f & CPU_FLAG_C ) ==    0 )      //  C = 0
-             && ( ( reg_a &       0xF0 ) >= 0xA0 )      //  7-4     A-F
-             && ( ( reg_f & CPU_FLAG_H ) ==    0 )      //  H = 0
-             && ( ( reg_a &       0x0F ) <= 0x09 ) )    //  3-0     0-9
-        {
-            //  Adjust register A by adding 0x60 and set the carry flag
-            reg_a += 0x60;
-            SET_FLAG_C( );
-        }
-        //  5       0   9-F     0   A-F     66      1
-        else
-        if (    ( ( reg_f & CPU_FLAG_C ) ==    0 )      //  C = 0
-             && ( ( reg_a &       0xF0 ) >= 0x90 )      //  7-4     9-F
-             && ( ( reg_f & CPU_FLAG_H ) ==    0 )      //  H = 0
-             && ( ( reg_a &       0x0F ) >= 0x0A ) )    //  3-0     A-F
-        {
-            //  Adjust register A by adding 0x60 and set the carry flag
-            reg_a += 0x66;
-            SET_FLAG_C( );
-        }
-        //  6       0   A-F     1   0-3     66      1
-        else
-        if (    ( ( reg_f & CPU_FLAG_C ) ==    0 )      //  C = 0
-             && ( ( reg_a &       0xF0 ) >= 0xA0 )      //  7-4     A-F
-             && ( ( reg_f & CPU_FLAG_H ) !=    0 )      //  H = 1
-             && ( ( reg_a &       0x0F ) <= 0x03 ) )    //  3-0     0-3
-        {
-            //  Adjust register A by adding 0x60 and set the carry flag
-            reg_a += 0x66;
-            SET_FLAG_C( );
-        }
-        //  7       1   0-2     0   0-9     60      1
-        else
-        if (    ( ( reg_f & CPU_FLAG_C ) !=    0 )      //  C = 1
-             && ( ( reg_a &       0xF0 ) <= 0x20 )      //  7-4     0-2
-             && ( ( reg_f & CPU_FLAG_H ) ==    0 )      //  H = 0
-             && ( ( reg_a &       0x0F ) <= 0x09 ) )    //  3-0     0-9
-        {
-            //  Adjust register A by adding 0x60 and set the carry flag
-            reg_a += 0x60;
-            SET_FLAG_C( );
-        }
-        //  8       1   0-2     0   A-F     66      1
-        else
-        if (    ( ( reg_f & CPU_FLAG_C ) !=    0 )      //  C = 1
-             && ( ( reg_a &       0xF0 ) <= 0x20 )      //  7-4     0-2
-             && ( ( reg_f & CPU_FLAG_H ) ==    0 )      //  H = 0
-             && ( ( reg_a &       0x0F ) >= 0x0A ) )    //  3-0     A-F
-        {
-            //  Adjust register A by adding 0x60 and set the carry flag
-            reg_a += 0x66;
-            SET_FLAG_C( );
-        }
-        //  9       1   0-3     1   0-3     66      1
-        else
-        if (    ( ( reg_f & CPU_FLAG_C ) !=    0 )      //  C = 1
-             && ( ( reg_a &       0xF0 ) <= 0x30 )      //  7-4     0-3
-             && ( ( reg_f & CPU_FLAG_H ) !=    0 )      //  H = 1
-             && ( ( reg_a &       0x0F ) <= 0x03 ) )    //  3-0     0-3
-        {
-            //  Adjust register A by adding 0x60 and set the carry flag
-            reg_a += 0x66;
-            SET_FLAG_C( );
-        }
-    }
-    else
-    {
-        //  NO:     SUBTRACTION
-        //  10      0   0-9     0   0-0     00      0
-        if (    ( ( reg_f & CPU_FLAG_C ) ==    0 )      //  C = 0
-             && ( ( reg_a &       0xF0 ) <= 0x90 )      //  7-4     0-9
-             && ( ( reg_f & CPU_FLAG_H ) ==    0 )      //  H = 0
-             && ( ( reg_a &       0x0F ) <= 0x09 ) )    //  3-0     0-9
-        {
-            //  Nothing to do here
-            reg_a = reg_a;  //  For debug.
-        }
-        //  11      0   0-8     1   6-F     FA      0
-        else
-        if (    ( ( reg_f & CPU_FLAG_C ) ==    0 )      //  C = 0
-             && ( ( reg_a &       0xF0 ) <= 0x80 )      //  7-4     0-8
-             && ( ( reg_f & CPU_FLAG_H ) !=    0 )      //  H = 1
-             && ( ( reg_a &       0x0F ) >= 0x06 ) )    //  3-0     6-F
-        {
-            //  Adjust register A by adding 0x60 and set the carry flag
-            reg_a += 0xFA;
-        }
-        //  12      1   7-F     0   0-9     A0      1
-        else
-        if (    ( ( reg_f & CPU_FLAG_C ) !=    0 )      //  C = 1
-             && ( ( reg_a &       0xF0 ) >= 0x70 )      //  7-4     7-F
-             && ( ( reg_f & CPU_FLAG_H ) ==    0 )      //  H = 0
-             && ( ( reg_a &       0x0F ) <= 0x09 ) )    //  3-0     0-9
-        {
-            //  Adjust register A by adding 0x60 and set the carry flag
-            reg_a += 0xA0;
-            SET_FLAG_C( );
-        }
-        //  13      1   6-F     1   6-F     9A      1
-        else
-        if (    ( ( reg_f & CPU_FLAG_C ) !=    0 )      //  C = 1
-             && ( ( reg_a &       0xF0 ) >= 0x60 )      //  7-4     6-F
-             && ( ( reg_f & CPU_FLAG_H ) !=    0 )      //  H = 1
-             && ( ( reg_a &       0x0F ) >= 0x06 ) )    //  3-0     6-F
-        {
-            //  Adjust register A by adding 0x60 and set the carry flag
-            reg_a += 0x9A;
-            SET_FLAG_C( );
-        }
-    }
+    //  Look up A, N, C and H
+    daa = &flags_daa[ FLAGS_MODE( CPU_Z80 ) ][ FLAGS_DAA_INDEX( GET_A( ), GET_F( ) ) ];
 
-    //  Save the result back in register A
-    PUT_A( reg_a );
+    //  Save the result back in register A and set the flags
+    CPU_REG_AF = ( (uint16_t)daa->a << 8 )
+               | ( CPU_REG_AF & daa->keep ) | daa->f;
 
     //  Set the number of states for this instruction
-    operation_rc.states =  11;
+    machine->operation_rc.states =  11;
 }
 
 /****************************************************************************/
@@ -1379,7 +1132,7 @@ math_cpl_i80(
     // S is not affected.
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -1426,7 +1179,7 @@ math_ccf_i80(
     // S is not affected.
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -1473,7 +1226,7 @@ math_scf_i80(
     // S is not affected.
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -1499,6 +1252,6 @@ math_neg_ED(
     PUT_A( sub_8( 0, GET_A( ), 0 ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   8;
+    machine->operation_rc.states =   8;
 }
 /****************************************************************************/
\ No newline at end of file
@@ -70,6 +70,30 @@
  * Prototypes
  ****************************************************************************/
 
+//----------------------------------------------------------------------------
+uint8_t
+add_8(
+    uint16_t                    addend,
+    uint16_t                    augend,
+    uint16_t                    carry
+    );
+//----------------------------------------------------------------------------
+uint8_t
+sub_8(
+    uint16_t                    minuend,
+    uint16_t                    subtrahend,
+    uint16_t                    borrow
+    );
+//----------------------------------------------------------------------------
+uint8_t
+inc_8(
+    uint16_t                    number
+    );
+//----------------------------------------------------------------------------
+uint8_t
+dec_8(
+    uint16_t                    number
+    );
 //------------------------------------------------------------------------ 145
 void
 math_addr_i80(
@@ -145,6 +169,49 @@ void
 math_decr_r80(
     uint8_t                     op_code
     );
+//----------------------------------------------------------------------------
+/*  ADD, ADC, SUB, SBC, INC and DEC r, one handler for each register        */
+#define MATH_R_PROTO( R )                                                   \
+void                                                                        \
+math_addr_i80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    );                                                                      \
+void                                                                        \
+math_adcr_i80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    );                                                                      \
+void                                                                        \
+math_subr_i80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    );                                                                      \
+void                                                                        \
+math_sbcr_i80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    );                                                                      \
+void                                                                        \
+math_incr_i80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    );                                                                      \
+void                                                                        \
+math_decr_r80_##R(                                                          \
+    uint8_t                     op_code                                     \
+    );
+REG_R_EACH( MATH_R_PROTO )
+#undef  MATH_R_PROTO
+//----------------------------------------------------------------------------
+/*  The same handlers by register code, NULL for (HL)                       */
+extern
+void                        (* const math_addr_i80_op[ 8 ])( uint8_t );
+extern
+void                        (* const math_adcr_i80_op[ 8 ])( uint8_t );
+extern
+void                        (* const math_subr_i80_op[ 8 ])( uint8_t );
+extern
+void                        (* const math_sbcr_i80_op[ 8 ])( uint8_t );
+extern
+void                        (* const math_incr_i80_op[ 8 ])( uint8_t );
+extern
+void                        (* const math_decr_r80_op[ 8 ])( uint8_t );
 //------------------------------------------------------------------------ 170
 void
 math_dechl_i80(
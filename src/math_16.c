@@ -39,6 +39,7 @@
 #include "memory.h"             //  Memory management and access
 #include "registers.h"          //  All things CPU registers.
 #include "math_16.h"            //  16 bit Arithmatic instrucions.
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -273,7 +274,7 @@ math_addhlss_i80(
     CPU_REG_HL = ( add_16( (uint32_t)CPU_REG_HL, (uint32_t)reg_get_ss( op_code ), 0 ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  11;
+    machine->operation_rc.states =  11;
 }
 
 /****************************************************************************/
@@ -301,7 +302,7 @@ math_incss_i80(
     reg_put_ss( op_code, ( reg_get_ss( op_code ) + 1 ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   6;
+    machine->operation_rc.states =   6;
 }
 
 /****************************************************************************/
@@ -329,7 +330,7 @@ math_decss_i80(
     reg_put_ss( op_code, ( reg_get_ss( op_code ) - 1 ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =   6;
+    machine->operation_rc.states =   6;
 }
 
 /****************************************************************************/
@@ -362,7 +363,7 @@ math_adchlss_ED(
     CPU_REG_HL = add_16( CPU_REG_HL, reg_get_ss( op_code ), GET_FLAG_C( ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  15;
+    machine->operation_rc.states =  15;
 }
 
 /****************************************************************************/
@@ -395,6 +396,6 @@ math_sbchlss_ED(
     CPU_REG_HL = sub_16( CPU_REG_HL, reg_get_ss( op_code ), GET_FLAG_C( ) );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  15;
+    machine->operation_rc.states =  15;
 }
 /****************************************************************************/
\ No newline at end of file
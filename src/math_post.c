@@ -27,6 +27,7 @@
 #include <stdlib.h>             //  ANSI standard library.
 #include <unistd.h>             //  UNIX standard library.
 #include <stdio.h>              //  Standard I/O definitions
+#include <string.h>             //  Functions for managing strings
                                 //*******************************************
 
 
@@ -40,6 +41,8 @@
 #include "registers.h"          //  All things CPU registers.
 #include "op_code.h"            //  OP-Code instruction maps
 #include "math.h"               //  8 bit instrucions.
+#include "machine.h"            //  Guest machine context
+#include "block_cache.h"        //  Decoded block cache
                                 //*******************************************
 
 /****************************************************************************
@@ -54,6 +57,11 @@
  ****************************************************************************/
 
 //----------------------------------------------------------------------------
+/**
+ *  @param  POST_LOOP_STACK     Top of the stack of the hot loop tests
+ *  @param  POST_LOOP_PUSHED    Bytes the hot loop tests push               */
+#define POST_LOOP_STACK         ( 0x9000 )
+#define POST_LOOP_PUSHED        ( 0x1000 )
 //----------------------------------------------------------------------------
 
 /****************************************************************************
@@ -6065,6 +6073,306 @@ tc_neg_00(
     return( post_rc );
 }
 
+/****************************************************************************/
+/**
+ *  Run a hot loop once interpreted and once translated, compare the results.
+ *
+ *  @param  name                Name of the test for the messages
+ *  @param  program             The test program, it pushes AF every time
+ *                              around the loop
+ *  @param  size                Bytes in the program
+ *
+ *  @return post_rc             TRUE when both runs end in the same state,
+ *                              else FALSE is returned.
+ *
+ *  @note
+ *      The loop runs often enough for its blocks to be translated to native
+ *      code when the JIT is enabled.  Every A / F it pushed is compared, so
+ *      a flag that is only wrong in the middle of the loop is found too.
+ *      Without the JIT both runs are interpreted.
+ *
+ ****************************************************************************/
+
+static
+int
+post_alu_loop(
+    const
+    char                    *   name,
+    uint8_t                 *   program,
+    uint16_t                    size
+    )
+{
+    /**
+     *  @param  post_rc             0 (FALSE) = tests passes                */
+    int                         post_rc;
+    /**
+     *  @param  pass                0 interpreted, 1 translated             */
+    int                         pass;
+    /**
+     *  @param  stack               What each run pushed                    */
+    static
+    uint8_t                     stack[ 2 ][ POST_LOOP_PUSHED ];
+    /**
+     *  @param  pair                AF, BC, DE and HL after each run        */
+    uint16_t                    pair[ 2 ][ 4 ];
+#if JIT_ENABLE
+    /**
+     *  @param  jit_disabled        The JIT setting to put back             */
+    bool                        jit_disabled;
+
+    jit_disabled = machine->jit_disabled;
+#endif
+
+    for( pass = 0; pass < 2; pass += 1 )
+    {
+#if JIT_ENABLE
+        //  Interpret the first run, translate the second one
+        machine->jit_disabled = ( pass == 0 ) ? true : jit_disabled;
+        block_cache_flush( );
+#endif
+
+        //  Start with the same stack and program
+        memset( stack[ pass ], 0, POST_LOOP_PUSHED );
+        memory_load( POST_LOOP_STACK - POST_LOOP_PUSHED, POST_LOOP_PUSHED, stack[ pass ] );
+        memory_load( 0x0000, size, program );
+
+        //  Run the program
+        inst_fetch( );
+
+        memory_read( stack[ pass ], POST_LOOP_PUSHED, POST_LOOP_STACK - POST_LOOP_PUSHED );
+        pair[ pass ][ 0 ] = CPU_REG_AF;
+        pair[ pass ][ 1 ] = CPU_REG_BC;
+        pair[ pass ][ 2 ] = CPU_REG_DE;
+        pair[ pass ][ 3 ] = CPU_REG_HL;
+    }
+
+#if JIT_ENABLE
+    machine->jit_disabled = jit_disabled;
+    block_cache_flush( );
+#endif
+
+    /************************************************************************
+     *  Verify the results
+     ************************************************************************/
+
+    post_rc = (    ( memcmp( pair[ 0 ], pair[ 1 ], sizeof( pair[ 0 ] ) ) == 0 )
+                && ( memcmp( stack[ 0 ], stack[ 1 ], POST_LOOP_PUSHED ) == 0 ) );
+
+    if ( post_rc == false )
+    {
+        //  NO:     Write an error message
+        printf( "POST: %s failed: [translated != interpreted]\n", name );
+        printf( "POST: AF = 0x%04X / 0x%04X\n", pair[ 0 ][ 0 ], pair[ 1 ][ 0 ] );
+        printf( "POST: BC = 0x%04X / 0x%04X\n", pair[ 0 ][ 1 ], pair[ 1 ][ 1 ] );
+        printf( "POST: DE = 0x%04X / 0x%04X\n", pair[ 0 ][ 2 ], pair[ 1 ][ 2 ] );
+        printf( "POST: HL = 0x%04X / 0x%04X\n", pair[ 0 ][ 3 ], pair[ 1 ][ 3 ] );
+    }
+
+    //  DONE!
+    return( post_rc );
+}
+
+/****************************************************************************/
+/**
+ *  ADD / ADC / SUB     (hot loop)
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      ADC only passes C on, so the JIT computes it with the host flags.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_alu_loop_00(
+    void
+    )
+{
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        0x31, 0x00, 0x90,       //  0000    LD   SP, x'9000
+        0x01, 0x78, 0x56,       //  0003    LD   BC, x'5678
+        0x21, 0x34, 0x12,       //  0006    LD   HL, x'1234
+        0x1E, 0x9A,             //  0009    LD   E,  x'9A
+        0x16, 0xC8,             //  000B    LD   D,  200
+        0x3E, 0x5C,             //  000D    LD   A,  x'5C
+        0x37,                   //  000F    SCF
+        0x85,                   //  0010 L: ADD  A, L
+        0x6F,                   //  0011    LD   L, A
+        0x8C,                   //  0012    ADC  A, H
+        0x95,                   //  0013    SUB  L
+        0x67,                   //  0014    LD   H, A
+        0xF5,                   //  0015    PUSH AF
+        0x15,                   //  0016    DEC  D
+        0xC2, 0x10, 0x00,       //  0017    JP   NZ, L
+        0x76      };            //  001A    HALT
+
+    //  DONE!
+    return( post_alu_loop( "tc_alu_loop_00", program, sizeof( program ) ) );
+}
+
+/****************************************************************************/
+/**
+ *  ADC / SUB at the start of a block     (hot loop)
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      The block is entered with the flags of DEC still recorded.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_alu_loop_01(
+    void
+    )
+{
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        0x31, 0x00, 0x90,       //  0000    LD   SP, x'9000
+        0x01, 0x78, 0x56,       //  0003    LD   BC, x'5678
+        0x21, 0x34, 0x12,       //  0006    LD   HL, x'1234
+        0x1E, 0x9A,             //  0009    LD   E,  x'9A
+        0x16, 0xC8,             //  000B    LD   D,  200
+        0x3E, 0x5C,             //  000D    LD   A,  x'5C
+        0x37,                   //  000F    SCF
+        0x8B,                   //  0010 L: ADC  A, E
+        0x90,                   //  0011    SUB  B
+        0x47,                   //  0012    LD   B, A
+        0xF5,                   //  0013    PUSH AF
+        0x8B,                   //  0014    ADC  A, E
+        0xF5,                   //  0015    PUSH AF
+        0x15,                   //  0016    DEC  D
+        0xC2, 0x10, 0x00,       //  0017    JP   NZ, L
+        0x76      };            //  001A    HALT
+
+    //  DONE!
+    return( post_alu_loop( "tc_alu_loop_01", program, sizeof( program ) ) );
+}
+
+/****************************************************************************/
+/**
+ *  Every 8 bit arithmetic and logic group     (hot loop)
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      Register, immediate and (HL) operands, with all, only C or none of
+ *      the flags read afterwards.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_alu_loop_02(
+    void
+    )
+{
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        0x31, 0x00, 0x90,       //  0000    LD   SP, x'9000
+        0x01, 0x78, 0x56,       //  0003    LD   BC, x'5678
+        0x21, 0x34, 0x12,       //  0006    LD   HL, x'1234
+        0x1E, 0x9A,             //  0009    LD   E,  x'9A
+        0x16, 0xC8,             //  000B    LD   D,  200
+        0x3E, 0x5C,             //  000D    LD   A,  x'5C
+        0x37,                   //  000F    SCF
+        0x9B,                   //  0010 L: SBC  A, E
+        0xF5,                   //  0011    PUSH AF
+        0xA9,                   //  0012    XOR  C
+        0xCE, 0x35,             //  0013    ADC  A, x'35
+        0xBD,                   //  0015    CP   L
+        0x9E,                   //  0016    SBC  A, (HL)
+        0xA4,                   //  0017    AND  H
+        0xB0,                   //  0018    OR   B
+        0x83,                   //  0019    ADD  A, E
+        0x4F,                   //  001A    LD   C, A
+        0x1D,                   //  001B    DEC  E
+        0xF5,                   //  001C    PUSH AF
+        0xD6, 0x07,             //  001D    SUB  7
+        0xDE, 0x3B,             //  001F    SBC  A, x'3B
+        0xF5,                   //  0021    PUSH AF
+        0x15,                   //  0022    DEC  D
+        0xC2, 0x10, 0x00,       //  0023    JP   NZ, L
+        0x76      };            //  0026    HALT
+
+    //  (HL) is part of what is compared
+    memory_put_8( 0x1234, 0xC3 );
+
+    //  DONE!
+    return( post_alu_loop( "tc_alu_loop_02", program, sizeof( program ) ) );
+}
+
+/****************************************************************************/
+/**
+ *  INC / DEC / CPL / CCF / SCF and a branch on C     (hot loop)
+ *
+ *  @param
+ *
+ *  @return post_rc             TRUE when all POST tests pass, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      INC B and INC A are followed by instructions that replace their
+ *      flags or only read C, so the JIT leaves the flags out.  (HL) is in
+ *      the stack area, which starts out cleared for both runs.
+ *
+ ****************************************************************************/
+
+static
+int
+tc_flag_loop_00(
+    void
+    )
+{
+    /**
+     *  @param  program             The test program                        */
+    uint8_t                     program[ ] = {
+        0x31, 0x00, 0x90,       //  0000    LD   SP, x'9000
+        0x01, 0x78, 0x56,       //  0003    LD   BC, x'5678
+        0x21, 0x00, 0x81,       //  0006    LD   HL, x'8100
+        0x1E, 0x9A,             //  0009    LD   E,  x'9A
+        0x16, 0xC8,             //  000B    LD   D,  200
+        0x3E, 0x5C,             //  000D    LD   A,  x'5C
+        0x37,                   //  000F    SCF
+        0x04,                   //  0010 L: INC  B
+        0x80,                   //  0011    ADD  A, B
+        0x3C,                   //  0012    INC  A
+        0x89,                   //  0013    ADC  A, C
+        0x0D,                   //  0014    DEC  C
+        0xF5,                   //  0015    PUSH AF
+        0x2F,                   //  0016    CPL
+        0x3F,                   //  0017    CCF
+        0xD2, 0x1C, 0x00,       //  0018    JP   NC, M
+        0x1C,                   //  001B    INC  E
+        0x37,                   //  001C M: SCF
+        0x9B,                   //  001D    SBC  A, E
+        0x1D,                   //  001E    DEC  E
+        0x34,                   //  001F    INC  (HL)
+        0x46,                   //  0020    LD   B, (HL)
+        0xF5,                   //  0021    PUSH AF
+        0x15,                   //  0022    DEC  D
+        0xC2, 0x10, 0x00,       //  0023    JP   NZ, L
+        0x76      };            //  0026    HALT
+
+    //  DONE!
+    return( post_alu_loop( "tc_flag_loop_00", program, sizeof( program ) ) );
+}
+
 /****************************************************************************
  * MAIN
  ****************************************************************************/
@@ -6218,6 +6526,11 @@ math_post(
             if ( post_rc == true )  post_rc = tc_neg_00( );         //  NEG
         }
 
+        if ( post_rc == true )      post_rc = tc_alu_loop_00( );    //  ADD / ADC / SUB
+        if ( post_rc == true )      post_rc = tc_alu_loop_01( );    //  ADC at a block start
+        if ( post_rc == true )      post_rc = tc_alu_loop_02( );    //  Every group
+        if ( post_rc == true )      post_rc = tc_flag_loop_00( );   //  INC / DEC / CCF ..
+
         //  Was the test suite successfully complete :
         if( post_rc == true )
         {
@@ -39,6 +39,8 @@
                                 //*******************************************
 #include "global.h"             //  Global definitions
 #include "registers.h"          //  All things CPU registers.
+#include "block_cache.h"        //  Decoded basic block cache
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -53,7 +55,13 @@
  ****************************************************************************/
 
 //----------------------------------------------------------------------------
-#define MEMORY_SIZE             ( 0x0000FFFF )
+/**
+ *  @param  CPU_MEM             CPU Main Memory of the bound guest          */
+#define CPU_MEM                 ( machine->memory )
+//----------------------------------------------------------------------------
+/**
+ *  @param  BANK_STORE          Bytes of mem_banks, bank 0 is main memory   */
+#define BANK_STORE              ( (size_t)( MEMORY_BANKS - 1 ) * MEMORY_COMMON )
 //----------------------------------------------------------------------------
 
 /****************************************************************************
@@ -68,9 +76,6 @@
  ****************************************************************************/
 
 //----------------------------------------------------------------------------
-/**
- *  @param  CPU_MEM             CPU Main Memory                             */
-uint8_t                     CPU_MEM[ MEMORY_SIZE ];
 //----------------------------------------------------------------------------
 
 /****************************************************************************
@@ -78,17 +83,545 @@ uint8_t                     CPU_MEM[ MEMORY_SIZE ];
  ****************************************************************************/
 
 //---------------------------------------------------------------------------
+/**
+ *  @param  post_watched        Writes seen by the POST write handler       */
+static
+int                             post_watched;
 //---------------------------------------------------------------------------
 
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************/
+/**
+ *  Where the contents of a page are kept.
+ *
+ *  @param  guest               The guest
+ *  @param  page                Page number
+ *
+ *  @return                     The page in main memory, or in mem_banks when
+ *                              it is below MEMORY_COMMON and a bank other
+ *                              than 0 is visible.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+uint8_t *
+memory_page_base(
+    struct  machine_t       *   guest,
+    uint32_t                    page
+    )
+{
+    //  Is the page in a bank that isn't main memory ?
+    if (    ( guest->mem_bank != 0 )
+         && ( page < ( MEMORY_COMMON >> MEMORY_PAGE_SHIFT ) ) )
+    {
+        //  YES:    It is in the bank store
+        return( &guest->mem_banks[ ( ( guest->mem_bank - 1 ) * MEMORY_COMMON )
+                                 + ( page << MEMORY_PAGE_SHIFT ) ] );
+    }
+
+    //  DONE!
+    return( &guest->memory[ page << MEMORY_PAGE_SHIFT ] );
+}
+
+/****************************************************************************/
+/**
+ *  Copy between a buffer and the guest address space.
+ *
+ *  @param  address             First memory address.
+ *  @param  size                Number of bytes, wraps at x'FFFF.
+ *  @param  data_p              The buffer.
+ *  @param  load                Copy the buffer into memory, otherwise copy
+ *                              memory into the buffer.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      A page at a time, so it sees the visible bank.  The mapping is
+ *      ignored, ROM is written and handlers are not called.
+ *
+ ****************************************************************************/
+
+static
+void
+memory_copy(
+    uint16_t                    address,
+    uint32_t                    size,
+    uint8_t                 *   data_p,
+    bool                        load
+    )
+{
+    /**
+     *  @param  length          Bytes copied in this page                   */
+    uint32_t                    length;
+    /**
+     *  @param  base            Where the bytes are in the page             */
+    uint8_t                 *   base;
+
+    //  Loop through the pages of the range
+    while( size != 0 )
+    {
+        length = MEMORY_PAGE_SIZE - MEMORY_OFFSET( address );
+        if ( length > size )
+        {
+            length = size;
+        }
+        base = memory_page_base( machine, address >> MEMORY_PAGE_SHIFT )
+             + MEMORY_OFFSET( address );
+
+        if ( load == true )
+        {
+            memcpy( base, data_p, length );
+        }
+        else
+        {
+            memcpy( data_p, base, length );
+        }
+
+        address = (uint16_t)( address + length );
+        data_p += length;
+        size   -= length;
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Point the page tables of a guest at what is mapped at one page.
+ *
+ *  @param  guest               The guest
+ *  @param  page                Page number
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      A direction with a handler gets a NULL pointer, which sends the
+ *      accessors to the handler.  ROM writes go to the sink page.
+ *
+ ****************************************************************************/
+
+static
+void
+memory_page_set(
+    struct  machine_t       *   guest,
+    int                         page
+    )
+{
+    /**
+     *  @param  entry           What is mapped at the page                  */
+    struct  memory_page_t   *   entry;
+    /**
+     *  @param  base            The page in main memory                     */
+    uint8_t                 *   base;
+
+    entry = &guest->mem_page[ page ];
+    base  = memory_page_base( guest, page );
+
+    //  Reads
+    guest->mem_read[ page ] = ( entry->read != NULL ) ? NULL : base;
+
+    //  Writes
+    if ( entry->write != NULL )
+    {
+        guest->mem_write[ page ] = NULL;
+    }
+    else
+    if ( entry->rom == true )
+    {
+        guest->mem_write[ page ] = guest->mem_sink;
+    }
+    else
+    {
+        guest->mem_write[ page ] = base;
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Map the pages of an address range of the bound guest.
+ *
+ *  @param  address             First address, rounded down to a page.
+ *  @param  size                Number of bytes, rounded up to whole pages.
+ *  @param  entry               What is mapped at each of the pages.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Blocks decoded while the old mapping was in place are discarded.
+ *
+ ****************************************************************************/
+
+static
+void
+memory_map(
+    uint16_t                    address,
+    uint32_t                    size,
+    const
+    struct  memory_page_t   *   entry
+    )
+{
+    /**
+     *  @param  page            Page being mapped                           */
+    uint32_t                    page;
+    /**
+     *  @param  last            Last page mapped                            */
+    uint32_t                    last;
+
+    //  Is there anything to map ?
+    if ( size == 0 )
+    {
+        //  NO:     Done
+        return;
+    }
+
+    last = ( (uint32_t)address + size - 1 ) >> MEMORY_PAGE_SHIFT;
+    if ( last >= MEMORY_PAGES )
+    {
+        last = MEMORY_PAGES - 1;
+    }
+
+    //  Loop through the pages
+    for( page = address >> MEMORY_PAGE_SHIFT; page <= last; page += 1 )
+    {
+        //  Keep the count of read handlers
+        if ( machine->mem_page[ page ].read != NULL )
+        {
+            machine->mem_read_hooks -= 1;
+        }
+        if ( entry->read != NULL )
+        {
+            machine->mem_read_hooks += 1;
+        }
+
+        machine->mem_page[ page ] = *entry;
+        memory_page_set( machine, page );
+    }
+
+#if INST_ENGINE == INST_ENGINE_BLOCK
+    //  Translations may have read or written the old mapping directly
+    block_cache_flush( );
+#endif
+}
+
+/****************************************************************************/
+/**
+ *  Is an address range plain RAM ?
+ *
+ *  @param  address             First address.
+ *  @param  size                Number of bytes, the range must not cross
+ *                              the end of memory.
+ *  @param  write               The range is written as well as read.
+ *
+ *  @return                     TRUE when the range can be accessed directly
+ *                              in main memory, else FALSE is returned.
+ *
+ *  @note
+ *      Pages of a bank other than 0 are not in main memory, the block
+ *      kernels leave them to the byte loops.
+ *
+ ****************************************************************************/
+
+static
+bool
+memory_plain(
+    uint16_t                    address,
+    uint32_t                    size,
+    bool                        write
+    )
+{
+    /**
+     *  @param  page            Page being checked                          */
+    uint32_t                    page;
+    /**
+     *  @param  base            The page in main memory                     */
+    uint8_t                 *   base;
+
+    //  Loop through the pages of the range
+    for( page = address >> MEMORY_PAGE_SHIFT;
+         ( size != 0 ) && ( page <= ( ( address + size - 1 ) >> MEMORY_PAGE_SHIFT ) );
+         page += 1 )
+    {
+        base = &CPU_MEM[ page << MEMORY_PAGE_SHIFT ];
+
+        //  Is it mapped or protected ?
+        if (    ( machine->mem_read[ page ] != base )
+             || ( ( write == true ) && ( machine->mem_write[ page ] != base ) ) )
+        {
+            //  YES:    It has to be accessed byte by byte
+            return( false );
+        }
+    }
+
+    //  DONE!
+    return( true );
+}
 
 /****************************************************************************
  * MAIN
  ****************************************************************************/
 
+/****************************************************************************/
+/**
+ *  Give a new guest plain RAM at every address.
+ *
+ *  @param  guest               The new guest.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Bank 0 is visible, the other banks are allocated by the first bank
+ *      switch.
+ *
+ ****************************************************************************/
+
+void
+memory_create(
+    struct  machine_t       *   guest
+    )
+{
+    /**
+     *  @param  page            Page being set up                           */
+    int                         page;
+
+    guest->mem_read_hooks = 0;
+    guest->mem_bank = 0;
+    guest->mem_banks = NULL;
+
+    //  Loop through all pages
+    for( page = 0; page < MEMORY_PAGES; page += 1 )
+    {
+        memset( &guest->mem_page[ page ], 0, sizeof( guest->mem_page[ page ] ) );
+        memory_page_set( guest, page );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Release the banks of a guest.
+ *
+ *  @param  guest               The guest, it must not be running.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+memory_destroy(
+    struct  machine_t       *   guest
+    )
+{
+    free( guest->mem_banks );
+    guest->mem_banks = NULL;
+}
+
+/****************************************************************************/
+/**
+ *  Map plain RAM at an address range.
+ *
+ *  @param  address             First address, rounded down to a page.
+ *  @param  size                Number of bytes, rounded up to whole pages.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Undoes memory_map_rom( ), memory_map_device( ) and
+ *      memory_map_watch( ).
+ *
+ ****************************************************************************/
+
+void
+memory_map_ram(
+    uint16_t                    address,
+    uint32_t                    size
+    )
+{
+    /**
+     *  @param  entry           What is mapped                              */
+    struct  memory_page_t       entry = { NULL, NULL, false, false };
+
+    memory_map( address, size, &entry );
+}
+
+/****************************************************************************/
+/**
+ *  Make an address range read only.
+ *
+ *  @param  address             First address, rounded down to a page.
+ *  @param  size                Number of bytes, rounded up to whole pages.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Guest writes are ignored.  memory_load( ) still writes the range, so
+ *      it is how the contents of the ROM are put there.
+ *
+ ****************************************************************************/
+
+void
+memory_map_rom(
+    uint16_t                    address,
+    uint32_t                    size
+    )
+{
+    /**
+     *  @param  entry           What is mapped                              */
+    struct  memory_page_t       entry = { NULL, NULL, true, false };
+
+    memory_map( address, size, &entry );
+}
+
+/****************************************************************************/
+/**
+ *  Map a device at an address range.
+ *
+ *  @param  address             First address, rounded down to a page.
+ *  @param  size                Number of bytes, rounded up to whole pages.
+ *  @param  read                Called for every guest read, NULL when reads
+ *                              come from RAM.
+ *  @param  write               Called for every guest write, NULL when
+ *                              writes go to RAM.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      While any page has a read handler nothing is translated, because
+ *      translated code reads main memory directly.
+ *
+ ****************************************************************************/
+
+void
+memory_map_device(
+    uint16_t                    address,
+    uint32_t                    size,
+    uint8_t                 ( * read  )( uint16_t address ),
+    void                    ( * write )( uint16_t address, uint8_t data )
+    )
+{
+    /**
+     *  @param  entry           What is mapped                              */
+    struct  memory_page_t       entry = { read, write, false, false };
+
+    memory_map( address, size, &entry );
+}
+
+/****************************************************************************/
+/**
+ *  Trap the writes to an address range.
+ *
+ *  @param  address             First address, rounded down to a page.
+ *  @param  size                Number of bytes, rounded up to whole pages.
+ *  @param  write               Called after every guest write has reached
+ *                              RAM.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Reads are not affected.
+ *
+ ****************************************************************************/
+
+void
+memory_map_watch(
+    uint16_t                    address,
+    uint32_t                    size,
+    void                    ( * write )( uint16_t address, uint8_t data )
+    )
+{
+    /**
+     *  @param  entry           What is mapped                              */
+    struct  memory_page_t       entry = { NULL, write, false, true };
+
+    memory_map( address, size, &entry );
+}
+
+/****************************************************************************/
+/**
+ *  Make a bank visible below MEMORY_COMMON.
+ *
+ *  @param  bank                The bank, ignored unless it is less than
+ *                              MEMORY_BANKS.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Bank 0 is main memory, the others are in mem_banks.  A switch only
+ *      repoints the page tables below MEMORY_COMMON, nothing is copied.
+ *      The blocks decoded below MEMORY_COMMON are discarded page by page,
+ *      the BIOS and BDOS in common memory stay cached.  Translated code
+ *      reads main memory directly, so it only runs while bank 0 is
+ *      visible.
+ *
+ ****************************************************************************/
+
+void
+memory_bank_select(
+    uint8_t                     bank
+    )
+{
+    /**
+     *  @param  page            Page being repointed                        */
+    uint32_t                    page;
+
+    //  Is it a change to a valid bank ?
+    if (    ( bank >= MEMORY_BANKS )
+         || ( bank == machine->mem_bank ) )
+    {
+        //  NO:     Nothing to do
+        return;
+    }
+
+    //  Is this the first bank switch ?
+    if ( machine->mem_banks == NULL )
+    {
+        //  YES:    Allocate the banks
+        machine->mem_banks = malloc( BANK_STORE );
+        if ( machine->mem_banks == NULL )
+        {
+            printf( "memory: out of memory\n" );
+            exit( 1 );
+        }
+        memset( machine->mem_banks, 0x76, BANK_STORE );
+    }
+
+#if INST_ENGINE == INST_ENGINE_BLOCK
+    //  Discard any blocks decoded from the old bank
+    block_cache_write_range( 0, MEMORY_COMMON );
+#endif
+
+    //  Point the banked pages at the new bank
+    machine->mem_bank = bank;
+    for( page = 0; page < ( MEMORY_COMMON >> MEMORY_PAGE_SHIFT ); page += 1 )
+    {
+        memory_page_set( machine, page );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Which bank is visible below MEMORY_COMMON ?
+ *
+ *  @param
+ *
+ *  @return                     The bank number.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+uint8_t
+memory_bank_get(
+    void
+    )
+{
+    //  DONE!
+    return( machine->mem_bank );
+}
+
 /****************************************************************************/
 /**
  *  Initialize all memory to x'00
@@ -101,69 +634,387 @@ uint8_t                     CPU_MEM[ MEMORY_SIZE ];
  *
  ****************************************************************************/
 
-void
-memory_init(
-    void
-    )
-{
-    //  Clear everything out of main memory
-//  memset( CPU_MEM, 0x00, sizeof( CPU_MEM ) );     //  NOP
-    memset( CPU_MEM, 0x76, sizeof( CPU_MEM ) );     //  HALT
+void
+memory_init(
+    void
+    )
+{
+    //  Clear everything out of main memory
+//  memset( CPU_MEM, 0x00, sizeof( CPU_MEM ) );     //  NOP
+    memset( CPU_MEM, 0x76, sizeof( CPU_MEM ) );     //  HALT
+
+    //  The other banks as well
+    if ( machine->mem_banks != NULL )
+    {
+        memset( machine->mem_banks, 0x76, BANK_STORE );
+    }
+
+#if INST_ENGINE == INST_ENGINE_BLOCK
+    //  Nothing decoded from the old contents is valid
+    block_cache_flush( );
+#endif
+}
+
+/****************************************************************************/
+/**
+ *  Load memory with data.
+ *
+ *  @param  address             Starting memory address.
+ *  @param  size                Number of bytes to load.
+ *  @param  data_p              Pointer to the data to load.
+ *
+ *  @return
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+memory_load(
+    uint16_t                    address,
+    uint16_t                    size,
+    uint8_t                 *   data_p
+    )
+{
+#if INST_ENGINE == INST_ENGINE_BLOCK
+    //  Discard any blocks decoded from this range
+    block_cache_write_range( address, size );
+#endif
+
+    //  Copy the data into memory
+    memory_copy( address, size, data_p, true );
+}
+
+/****************************************************************************/
+/**
+ *  Read CPU memory.
+ *
+ *  @param  data_p              Pointer to the data to load.
+ *  @param  size                Number of bytes to load.
+ *  @param  address             Starting memory address.
+ *
+ *  @return
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+memory_read(
+    uint8_t                 *   data_p,
+    uint16_t                    size,
+    uint16_t                    address
+    )
+{
+    //  Copy the data out of memory
+    memory_copy( address, size, data_p, false );
+}
+
+/****************************************************************************/
+/**
+ *  Copy all of CPU memory.
+ *
+ *  @param  data_p              Where MEMORY_IMAGE_SIZE bytes are written.
+ *
+ *  @return
+ *
+ *  @note
+ *      The address space as the guest sees it, then every bank, then the
+ *      visible bank with x'80 set when the banks were allocated.  The
+ *      mapping is not part of it, the handlers belong to the host.
+ *
+ ****************************************************************************/
+
+void
+memory_snapshot(
+    uint8_t                 *   data_p
+    )
+{
+    memory_copy( 0, MEMORY_SIZE, data_p, false );
+    data_p += MEMORY_SIZE;
+
+    //  Has there been a bank switch ?
+    if ( machine->mem_banks != NULL )
+    {
+        //  YES:    Copy the banks, bank 0 is in main memory
+        memcpy( data_p, CPU_MEM, MEMORY_COMMON );
+        memcpy( data_p + MEMORY_COMMON, machine->mem_banks, BANK_STORE );
+        data_p[ MEMORY_BANKS * MEMORY_COMMON ] = machine->mem_bank | 0x80;
+    }
+    else
+    {
+        //  NO:     There is only bank 0
+        memset( data_p, 0x00, (size_t)MEMORY_BANKS * MEMORY_COMMON );
+        data_p[ MEMORY_BANKS * MEMORY_COMMON ] = 0;
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Replace all of CPU memory.
+ *
+ *  @param  data_p              MEMORY_IMAGE_SIZE bytes, from
+ *                              memory_snapshot( ).
+ *
+ *  @return
+ *
+ *  @note
+ *      The visible bank is taken from the address space, so an image whose
+ *      copy of that bank is stale restores the same way.
+ *
+ ****************************************************************************/
+
+void
+memory_restore(
+    const
+    uint8_t                 *   data_p
+    )
+{
+    /**
+     *  @param  bank            Visible bank and whether there are banks    */
+    uint8_t                     bank;
+    /**
+     *  @param  page            Page being repointed                        */
+    uint32_t                    page;
+
+    //  Copy the data into memory, as if bank 0 was visible
+    memcpy( CPU_MEM, data_p, MEMORY_SIZE );
+    data_p += MEMORY_SIZE;
+    bank = data_p[ MEMORY_BANKS * MEMORY_COMMON ];
+    machine->mem_bank = ( bank & 0x7F ) % MEMORY_BANKS;
+
+    //  Had there been a bank switch ?
+    if ( ( bank & 0x80 ) != 0 )
+    {
+        //  YES:    Bring the banks back
+        if ( machine->mem_banks == NULL )
+        {
+            machine->mem_banks = malloc( BANK_STORE );
+            if ( machine->mem_banks == NULL )
+            {
+                printf( "memory: out of memory\n" );
+                exit( 1 );
+            }
+        }
+        memcpy( machine->mem_banks, data_p + MEMORY_COMMON, BANK_STORE );
+
+        //  Is another bank visible ?
+        if ( machine->mem_bank != 0 )
+        {
+            //  YES:    Move it to its place and bring bank 0 back
+            memcpy( &machine->mem_banks[ ( machine->mem_bank - 1 ) * MEMORY_COMMON ],
+                    CPU_MEM, MEMORY_COMMON );
+            memcpy( CPU_MEM, data_p, MEMORY_COMMON );
+        }
+    }
+    else
+    {
+        //  NO:     Only bank 0
+        free( machine->mem_banks );
+        machine->mem_banks = NULL;
+        machine->mem_bank = 0;
+    }
+
+    //  Point the banked pages at the visible bank
+    for( page = 0; page < ( MEMORY_COMMON >> MEMORY_PAGE_SHIFT ); page += 1 )
+    {
+        memory_page_set( machine, page );
+    }
+
+#if INST_ENGINE == INST_ENGINE_BLOCK
+    //  Nothing decoded from the old contents is valid
+    block_cache_flush( );
+#endif
+}
+
+/****************************************************************************/
+/**
+ *  Read a byte from a page that has a read handler.
+ *
+ *  @param  address             Memory address
+ *
+ *  @return                     What the handler returned.
+ *
+ *  @note
+ *      The slow path of memory_get_8( ), kept out of line so the inline
+ *      accessor stays small.
+ *
+ ****************************************************************************/
+
+uint8_t
+memory_get_hook(
+    uint16_t                    address
+    )
+{
+    //  DONE!
+    return( machine->mem_page[ address >> MEMORY_PAGE_SHIFT ].read( address ) );
+}
+
+/****************************************************************************/
+/**
+ *  Write a byte to a page that has a write handler.
+ *
+ *  @param  address             Memory address
+ *  @param  data                Data to be written.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The slow path of memory_put_8( ).
+ *
+ ****************************************************************************/
+
+void
+memory_put_hook(
+    uint16_t                    address,
+    uint8_t                     data
+    )
+{
+    /**
+     *  @param  entry           What is mapped at the page                  */
+    struct  memory_page_t   *   entry;
+
+    entry = &machine->mem_page[ address >> MEMORY_PAGE_SHIFT ];
+
+    //  Does the write reach RAM ?
+    if ( entry->watch == true )
+    {
+        //  YES:    Before the handler sees it
+        memory_page_base( machine, address >> MEMORY_PAGE_SHIFT )
+            [ MEMORY_OFFSET( address ) ] = data;
+    }
+    entry->write( address, data );
+}
+
+#if MEMORY_CHECKED
+/****************************************************************************/
+/**
+ *  Check one guest memory access.
+ *
+ *  @param  address             First address accessed.
+ *  @param  width               Bytes accessed, 1 or 2.
+ *  @param  data                Data written, 0 for a read.
+ *  @param  write               The access is a write.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Only in a MEMORY_CHECKED build, through MEMORY_CHECK( ).  A page
+ *      table entry that points outside the guest is fatal, a watchpoint
+ *      is reported and the access is logged when a log is open.
+ *
+ ****************************************************************************/
+
+void
+memory_check(
+    uint16_t                    address,
+    int                         width,
+    uint16_t                    data,
+    bool                        write
+    )
+{
+    /**
+     *  @param  byte            Address of the byte being checked           */
+    uint16_t                    byte;
+    /**
+     *  @param  page            Page table entry of the byte                */
+    uint8_t                 *   page;
+    /**
+     *  @param  ndx             Byte being checked                          */
+    int                         ndx;
+
+    //  Loop through the bytes of the access
+    for( ndx = 0; ndx < width; ndx += 1 )
+    {
+        byte = (uint16_t)( address + ndx );
+        page = ( write == true ) ? machine->mem_write[ byte >> MEMORY_PAGE_SHIFT ]
+                                 : machine->mem_read[  byte >> MEMORY_PAGE_SHIFT ];
+
+        //  Does the page table point into this guest ?
+        if (    ( page != NULL )
+             && ( page != machine->mem_sink )
+             && ( page != memory_page_base( machine, byte >> MEMORY_PAGE_SHIFT ) ) )
+        {
+            //  NO:     Nothing that follows can be trusted
+            printf( "MEMORY: page table entry for %04X is corrupt\r\n", byte );
+            abort( );
+        }
+
+        //  Is there a watchpoint ?
+        if ( ( machine->mem_watch[ byte >> 3 ] & ( 1 << ( byte & 7 ) ) ) != 0 )
+        {
+            //  YES:    Report it
+            machine->mem_watch_hits += 1;
+            printf( "MEMORY: watchpoint %04X %s at PC %04X\r\n",
+                    byte, ( write == true ) ? "written" : "read", CPU_REG_PC );
+        }
+    }
+
+    //  Is the access being logged ?
+    if ( machine->mem_log != NULL )
+    {
+        //  YES:    PC, R or W, width, address and data
+        fprintf( machine->mem_log, "%04X %c%d %04X %04X\n",
+                 CPU_REG_PC, ( write == true ) ? 'W' : 'R', width, address, data );
+    }
 }
 
 /****************************************************************************/
 /**
- *  Load memory with data.
+ *  Set or clear a watchpoint.
  *
- *  @param  address             Starting memory address.
- *  @param  size                Number of bytes to load.
- *  @param  data_p              Pointer to the data to load.
+ *  @param  address             The watched address.
+ *  @param  enable              TRUE sets the watchpoint, FALSE clears it.
  *
- *  @return
+ *  @return                     No information is returned from this function.
  *
  *  @note
+ *      Only in a MEMORY_CHECKED build.
  *
  ****************************************************************************/
 
 void
-memory_load(
+memory_watchpoint(
     uint16_t                    address,
-    uint16_t                    size,
-    uint8_t                 *   data_p
+    bool                        enable
     )
 {
-    //  Copy the data into memory
-    memcpy( &CPU_MEM[ address ], data_p, size );
+    if ( enable == true )
+    {
+        machine->mem_watch[ address >> 3 ] |=  ( 1 << ( address & 7 ) );
+    }
+    else
+    {
+        machine->mem_watch[ address >> 3 ] &= ~( 1 << ( address & 7 ) );
+    }
 }
 
 /****************************************************************************/
 /**
- *  Read CPU memory.
+ *  Log every guest memory access.
  *
- *  @param  data_p              Pointer to the data to load.
- *  @param  size                Number of bytes to load.
- *  @param  address             Starting memory address.
+ *  @param  log                 Where the accesses are written, NULL stops
+ *                              the log.
  *
- *  @return
+ *  @return                     No information is returned from this function.
  *
  *  @note
+ *      Only in a MEMORY_CHECKED build.  The caller owns the file.
  *
  ****************************************************************************/
 
 void
-memory_read(
-    uint8_t                 *   data_p,
-    uint16_t                    size,
-    uint16_t                    address
+memory_log(
+    FILE                    *   log
     )
 {
-    //  Copy the data into memory
-    memcpy( data_p, &CPU_MEM[ address ], size );
+    machine->mem_log = log;
 }
+#endif
 
 /****************************************************************************/
 /**
- *  Get a byte of data from global memory using the provided address.
+ *  Get two bytes of data from global memory using the provided address.
  *
  *  @param  address             Memory address
  *
@@ -173,14 +1024,14 @@ memory_read(
  *
  ****************************************************************************/
 
-uint8_t
-memory_get_8(
+uint16_t
+memory_get_16(
     uint16_t                    address
     )
 {
     /**
      *  @param  var                 var description                         */
-    uint8_t                     data;
+    uint16_t                    data;
 
     /************************************************************************
      *  Function Initialization
@@ -192,7 +1043,8 @@ memory_get_8(
      ************************************************************************/
 
     //  Memory read
-    data = CPU_MEM[ address ];
+    data  = ( memory_get_8( address                     ) << 8 );
+    data |= ( memory_get_8( (uint16_t)( address + 1 ) )      );
 
     /************************************************************************
      *  Function Exit
@@ -207,21 +1059,20 @@ memory_get_8(
  *  Get two bytes of data from global memory using the provided address.
  *
  *  @param  address             Memory address
+ *  @param  data                Data to be written onto memory.
  *
- *  @return data                Data read from memory locatopn 'address'.
+ *  @return                     No information is returned from this function
  *
  *  @note
  *
  ****************************************************************************/
 
-uint16_t
-memory_get_16(
-    uint16_t                    address
+void
+memory_put_16(
+    uint16_t                    address,
+    uint16_t                    data
     )
 {
-    /**
-     *  @param  var                 var description                         */
-    uint16_t                    data;
 
     /************************************************************************
      *  Function Initialization
@@ -232,194 +1083,291 @@ memory_get_16(
      *  Function Code
      ************************************************************************/
 
-    //  Memory read
-    data  = ( CPU_MEM[ address     ] << 8 );
-    data |= ( CPU_MEM[ address + 1 ]      );
+    //  Memory write
+    memory_put_8( address,                     ( ( data & 0xFF00 ) >> 8 ) );
+    memory_put_8( (uint16_t)( address + 1 ), ( ( data & 0x00FF )      ) );
 
     /************************************************************************
      *  Function Exit
      ************************************************************************/
 
     //  DONE!
-    return( data );
-}
-
-/****************************************************************************/
-/**
- *  Put two bytes of data into global memory using the provided address.
- *
- *  @param  address             Memory address
- *  @param  data                Data to be stored.
- *
- *  @return                     No data is returned from this function.
- *
- *  @note
- *      Data is stored in reverse order. [ (LL), (HH) ]
- *
- ****************************************************************************/
-
-uint16_t
-memory_put_16_p(
-    uint16_t                    address,
-    uint16_t                    data
-    )
-{
-
-    //  Memory read
-    CPU_MEM[ address     ] = ( ( data & 0x00FF )      );
-    CPU_MEM[ address + 1 ] = ( ( data & 0xFF00 ) >> 8 );
-
 }
 
 /****************************************************************************/
 /**
- *  Get two bytes of data from global memory using the provided address.
+ *  Copy a block upward the way LDIR does.
  *
- *  @param  address             Memory address
+ *  @param  dest                Lowest destination address ( DE ).
+ *  @param  source              Lowest source address ( HL ).
+ *  @param  size                Number of bytes to copy.
  *
- *  @return data                Data read from memory locatopn 'address'.
+ *  @return                     false when either range crosses the end of
+ *                              memory or is not plain RAM, nothing is
+ *                              copied then.
  *
  *  @note
- *      Data is retrieved in reverse order. [ (LL), (HH) ]
+ *      The result is the same as copying one byte at a time from the
+ *      lowest address.  When the destination starts inside the source the
+ *      copy replicates the bytes in between, so it is done in chunks that
+ *      never overlap ( a fill when DE = HL + 1 ).
  *
  ****************************************************************************/
 
-uint16_t
-memory_get_16_p(
-    uint16_t                    address
+bool
+memory_copy_up(
+    uint16_t                    dest,
+    uint16_t                    source,
+    uint32_t                    size
     )
 {
     /**
-     *  @param  var                 var description                         */
-    uint16_t                    data;
-
-    /************************************************************************
-     *  Function Initialization
-     ************************************************************************/
-
+     *  @param  distance        How far the destination is above the source */
+    uint32_t                    distance;
+    /**
+     *  @param  offset          Offset of the chunk being copied            */
+    uint32_t                    offset;
+    /**
+     *  @param  length          Bytes in the chunk being copied             */
+    uint32_t                    length;
+
+    //  Do both ranges fit below the end of memory ?
+    if (    ( ( (uint32_t)dest   + size ) > MEMORY_SIZE )
+         || ( ( (uint32_t)source + size ) > MEMORY_SIZE )
+         || ( memory_plain( dest,   size, true  ) == false )
+         || ( memory_plain( source, size, false ) == false ) )
+    {
+        //  NO:     The caller copies byte by byte
+        return( false );
+    }
 
-    /************************************************************************
-     *  Function Code
-     ************************************************************************/
+#if INST_ENGINE == INST_ENGINE_BLOCK
+    //  Discard any blocks decoded from this range
+    block_cache_write_range( dest, size );
+#endif
 
-    //  Memory read
-    data  = ( CPU_MEM[ address     ]      );
-    data |= ( CPU_MEM[ address + 1 ] << 8 );
+    distance = (uint32_t)dest - source;
 
-    /************************************************************************
-     *  Function Exit
-     ************************************************************************/
+    //  Does the destination start inside the source ?
+    if ( ( dest > source ) && ( distance < size ) )
+    {
+        //  YES:    Is it the next byte ?
+        if ( distance == 1 )
+        {
+            //  YES:    The first byte is copied everywhere
+            memset( &CPU_MEM[ dest ], CPU_MEM[ source ], size );
+        }
+        else
+        {
+            //  NO:     Every chunk reads what the chunk before it wrote
+            for( offset = 0; offset < size; offset += distance )
+            {
+                length = ( ( size - offset ) < distance ) ? ( size - offset ) : distance;
+                memcpy( &CPU_MEM[ dest + offset ], &CPU_MEM[ source + offset ], length );
+            }
+        }
+    }
+    else
+    {
+        //  NO:     A plain move gives the same result
+        memmove( &CPU_MEM[ dest ], &CPU_MEM[ source ], size );
+    }
 
     //  DONE!
-    return( data );
+    return( true );
 }
 
 /****************************************************************************/
 /**
- *  Get a bytes of data from global memory using the provided address.
+ *  Copy a block downward the way LDDR does.
  *
- *  @param  address             Memory address
- *  @param  data                Data to be written onto memory.
+ *  @param  dest                Highest destination address ( DE ).
+ *  @param  source              Highest source address ( HL ).
+ *  @param  size                Number of bytes to copy.
  *
- *  @return                     No information is returned from this function
+ *  @return                     false when either range crosses the start
+ *                              of memory or is not plain RAM, nothing is
+ *                              copied then.
  *
  *  @note
+ *      The mirror image of memory_copy_up( ).
  *
  ****************************************************************************/
 
-void
-memory_put_8(
-    uint16_t                    address,
-    uint8_t                     data
+bool
+memory_copy_down(
+    uint16_t                    dest,
+    uint16_t                    source,
+    uint32_t                    size
     )
 {
+    /**
+     *  @param  distance        How far the destination is below the source */
+    uint32_t                    distance;
+    /**
+     *  @param  offset          Offset of the chunk being copied            */
+    uint32_t                    offset;
+    /**
+     *  @param  length          Bytes in the chunk being copied             */
+    uint32_t                    length;
+
+    //  Do both ranges fit inside memory ?
+    if (    ( ( (uint32_t)dest   + 1 ) < size )
+         || ( ( (uint32_t)source + 1 ) < size )
+         || ( dest   >= MEMORY_SIZE )
+         || ( source >= MEMORY_SIZE )
+         || ( memory_plain( dest   + 1 - size, size, true  ) == false )
+         || ( memory_plain( source + 1 - size, size, false ) == false ) )
+    {
+        //  NO:     The caller copies byte by byte
+        return( false );
+    }
 
-    /************************************************************************
-     *  Function Initialization
-     ************************************************************************/
-
-
-    /************************************************************************
-     *  Function Code
-     ************************************************************************/
+#if INST_ENGINE == INST_ENGINE_BLOCK
+    //  Discard any blocks decoded from this range
+    block_cache_write_range( dest + 1 - size, size );
+#endif
 
-    //  Memory read
-    CPU_MEM[ address ] = data;
+    distance = (uint32_t)source - dest;
 
-    /************************************************************************
-     *  Function Exit
-     ************************************************************************/
+    //  Does the destination start inside the source ?
+    if ( ( dest < source ) && ( distance < size ) )
+    {
+        //  YES:    Is it the next byte ?
+        if ( distance == 1 )
+        {
+            //  YES:    The first byte is copied everywhere
+            memset( &CPU_MEM[ dest + 1 - size ], CPU_MEM[ source ], size );
+        }
+        else
+        {
+            //  NO:     Every chunk reads what the chunk before it wrote
+            for( offset = 0; offset < size; offset += distance )
+            {
+                length = ( ( size - offset ) < distance ) ? ( size - offset ) : distance;
+                memcpy( &CPU_MEM[ dest   + 1 - offset - length ],
+                        &CPU_MEM[ source + 1 - offset - length ], length );
+            }
+        }
+    }
+    else
+    {
+        //  NO:     A plain move gives the same result
+        memmove( &CPU_MEM[ dest + 1 - size ], &CPU_MEM[ source + 1 - size ], size );
+    }
 
     //  DONE!
+    return( true );
 }
 
 /****************************************************************************/
 /**
- *  Get two bytes of data from global memory using the provided address.
+ *  Search upward for a byte the way CPIR does.
  *
- *  @param  address             Memory address
- *  @param  data                Data to be written onto memory.
+ *  @param  address             Lowest address searched ( HL ).
+ *  @param  size                Number of bytes to search.
+ *  @param  data                The byte searched for ( A ).
+ *  @param  compared            Returns the number of bytes compared, up to
+ *                              and including the byte that matched.
  *
- *  @return                     No information is returned from this function
+ *  @return                     false when the range crosses the end of
+ *                              memory or has a read handler, nothing is
+ *                              searched then.
  *
  *  @note
  *
  ****************************************************************************/
 
-void
-memory_put_16(
+bool
+memory_find_up(
     uint16_t                    address,
-    uint16_t                    data
+    uint32_t                    size,
+    uint8_t                     data,
+    uint32_t                *   compared
     )
 {
+    /**
+     *  @param  match           The matching byte                           */
+    uint8_t                 *   match;
 
-    /************************************************************************
-     *  Function Initialization
-     ************************************************************************/
-
-
-    /************************************************************************
-     *  Function Code
-     ************************************************************************/
+    //  Does the range fit below the end of memory ?
+    if (    ( ( (uint32_t)address + size ) > MEMORY_SIZE )
+         || ( memory_plain( address, size, false ) == false ) )
+    {
+        //  NO:     The caller searches byte by byte
+        return( false );
+    }
 
-    //  Memory read
-    CPU_MEM[ ( address     ) ] = ( ( data & 0xFF00 ) >> 8 );
-    CPU_MEM[ ( address + 1 ) ] = ( ( data & 0x00FF )      );
+    //  Search
+    match = memchr( &CPU_MEM[ address ], data, size );
 
-    /************************************************************************
-     *  Function Exit
-     ************************************************************************/
+    //  Was it found ?
+    if ( match != NULL )
+    {
+        //  YES:    Stop at the match
+        *compared = (uint32_t)( match - &CPU_MEM[ address ] ) + 1;
+    }
+    else
+    {
+        //  NO:     Everything was compared
+        *compared = size;
+    }
 
     //  DONE!
+    return( true );
 }
 
 /****************************************************************************/
 /**
- *  Program Counter (PC) is pointing to address_low and PC + 1 is pointing to
- *  address_high.  Read these two bytes and return with the address.
+ *  Search downward for a byte the way CPDR does.
  *
- *  @parm
+ *  @param  address             Highest address searched ( HL ).
+ *  @param  size                Number of bytes to search.
+ *  @param  data                The byte searched for ( A ).
+ *  @param  compared            Returns the number of bytes compared, down
+ *                              to and including the byte that matched.
  *
- *  @return address             The address.
+ *  @return                     false when the range crosses the start of
+ *                              memory or has a read handler, nothing is
+ *                              searched then.
  *
  *  @note
  *
  ****************************************************************************/
 
-uint16_t
-memory_get_16_pc_p(
-    void
+bool
+memory_find_down(
+    uint16_t                    address,
+    uint32_t                    size,
+    uint8_t                     data,
+    uint32_t                *   compared
     )
 {
     /**
-     *  @param  address             Address of the source data              */
-    uint16_t                    address;
+     *  @param  count           Bytes compared so far                       */
+    uint32_t                    count;
 
-    //  Get the data address.
-    address  = ( memory_get_8( CPU_REG_PC++ )      );
-    address |= ( memory_get_8( CPU_REG_PC++ ) << 8 );
+    //  Does the range fit inside memory ?
+    if (    ( ( (uint32_t)address + 1 ) < size )
+         || ( address >= MEMORY_SIZE )
+         || ( memory_plain( address + 1 - size, size, false ) == false ) )
+    {
+        //  NO:     The caller searches byte by byte
+        return( false );
+    }
+
+    //  Search ( the last byte counts as compared whether it matches or not )
+    for( count = 1; count < size; count += 1 )
+    {
+        if ( CPU_MEM[ address + 1 - count ] == data )
+        {
+            break;
+        }
+    }
+    *compared = count;
 
-    return( address );
+    //  DONE!
+    return( true );
 }
 
 /****************************************************************************/
@@ -498,6 +1446,51 @@ memory_dump(
     printf( "\n" );
 }
 
+/****************************************************************************/
+/**
+ *  Read handler of the device page used by memory_post( ).
+ *
+ *  @param  address             Memory address
+ *
+ *  @return                     The low byte of the address, x'5A flipped.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+uint8_t
+post_device_read(
+    uint16_t                    address
+    )
+{
+    //  DONE!
+    return( ( address & 0xFF ) ^ 0x5A );
+}
+
+/****************************************************************************/
+/**
+ *  Write handler of the device and watch pages used by memory_post( ).
+ *
+ *  @param  address             Memory address
+ *  @param  data                Data written by the guest.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+post_device_write(
+    uint16_t                    address,
+    uint8_t                     data
+    )
+{
+    post_watched += 1;
+}
+
 /****************************************************************************/
 /**
  *  Memory Power On Self Test
@@ -518,13 +1511,27 @@ memory_post(
 {
     /**
      *  @param  address             Current Write/Read location             */
-    uint16_t                    address;
+    uint32_t                    address;
     /**
      *  @param  data_8              A byte of data                          */
     uint8_t                     data_8;
     /**
      *  @param  data_8              A word of data                          */
     uint16_t                    data_16;
+    /**
+     *  @param  mapped              Mapped pages behaved                    */
+    bool                        mapped;
+    /**
+     *  @param  bytes               Data loaded across the end of a bank    */
+    uint8_t                     bytes[ 2 ];
+    /**
+     *  @param  image               Snapshot of memory                      */
+    uint8_t                 *   image;
+#if MEMORY_CHECKED
+    /**
+     *  @param  log                 Access log                              */
+    FILE                    *   log;
+#endif
     /**
      *  @param  post_rc             0 (FALSE) = tests passes                 */
     int                         post_rc;
@@ -545,7 +1552,7 @@ memory_post(
 
     // Loop through all memory writing data
     for ( address = 0;
-          address != MEMORY_SIZE;
+          address < MEMORY_SIZE;
           address += 1 )
     {
         memory_put_8( address, ( address & 0x00FF ) );
@@ -553,7 +1560,7 @@ memory_post(
 
     //  This time read and verify the data
     for ( address = 0;
-          address != MEMORY_SIZE;
+          address < MEMORY_SIZE;
           address += 1 )
     {
         data_8 = memory_get_8( address );
@@ -562,7 +1569,7 @@ memory_post(
         if ( data_8 != ( address & 0x00FF ) )
         {
             //  NO:     Write an error message
-            printf( "POST: Memory byte R/W failed at address %08X\n", address );
+            printf( "POST: Memory byte R/W failed at address %08X\n", (unsigned)address );
 
             //  Set the return code to FALSE.
             post_rc = false;
@@ -575,7 +1582,7 @@ memory_post(
 
     // Loop through all memory writing data
     for ( address = 0;
-          address != ( MEMORY_SIZE - 1 );
+          address < ( MEMORY_SIZE - 1 );
           address += 2 )
     {
         memory_put_16( address, address );
@@ -583,7 +1590,7 @@ memory_post(
 
     //  This time read and verify the data
     for ( address = 0;
-          address != ( MEMORY_SIZE - 1 );
+          address < ( MEMORY_SIZE - 1 );
           address += 2 )
     {
         data_16 = memory_get_16( address );
@@ -592,7 +1599,7 @@ memory_post(
         if ( data_16 != address )
         {
             //  NO:     Write an error message
-            printf( "POST: Memory word R/W failed at address %04X\n", address );
+            printf( "POST: Memory word R/W failed at address %04X\n", (unsigned)address );
 
             //  Set the return code to FALSE.
             post_rc = false;
@@ -622,13 +1629,149 @@ memory_post(
         if ( data_16 != address )
         {
             //  NO:     Write an error message
-            printf( "POST: Memory word R/W failed at address %08X\n", address );
+            printf( "POST: Memory word R/W failed at address %08X\n", (unsigned)address );
 
             //  Set the return code to FALSE.
             post_rc = false;
         }
     }
 
+    /************************************************************************
+     *  Word Write & Read (wrap at x'FFFF)
+     ************************************************************************/
+
+    memory_put_16( 0xFFFF, 0x1234 );
+    memory_put_16_p( 0xFFFE, 0xABCD );
+    if (    ( memory_get_8( 0xFFFF ) != 0xAB )
+         || ( memory_get_8( 0x0000 ) != 0x34 )
+         || ( memory_get_16_p( 0xFFFF ) != 0x34AB ) )
+    {
+        printf( "POST: Memory word R/W failed at address 0000FFFF\n" );
+        post_rc = false;
+    }
+
+    /************************************************************************
+     *  Mapped pages
+     ************************************************************************/
+
+    post_watched = 0;
+    memory_put_8( 0x4000, 0x11 );
+    memory_put_8( 0x4100, 0x22 );
+    memory_put_8( 0x4200, 0x33 );
+
+    memory_map_rom( 0x4000, MEMORY_PAGE_SIZE );
+    memory_map_device( 0x4100, MEMORY_PAGE_SIZE, post_device_read, post_device_write );
+    memory_map_watch( 0x4200, MEMORY_PAGE_SIZE, post_device_write );
+
+    memory_put_8( 0x4000, 0x44 );
+    memory_put_8( 0x4101, 0x55 );
+    memory_put_8( 0x4200, 0x66 );
+    mapped  = ( memory_get_8( 0x4000 ) == 0x11 );           //  ROM
+    mapped &= ( memory_get_8( 0x4101 ) == 0x5B );           //  Device
+    mapped &= ( post_watched == 2 );
+    mapped &= ( memory_get_8( 0x4200 ) == 0x66 );           //  Watch
+
+    //  The block kernels leave mapped pages to the byte loops
+    mapped &= ( memory_copy_up( 0x4000, 0x5000, 16 ) == false );
+    mapped &= ( memory_copy_up( 0x5000, 0x4000, 16 ) == true  );
+
+    memory_map_ram( 0x4000, 3 * MEMORY_PAGE_SIZE );
+    memory_put_8( 0x4000, 0x77 );
+    mapped &= ( memory_get_8( 0x4000 ) == 0x77 );
+    mapped &= ( memory_get_8( 0x4100 ) == 0x22 );
+    mapped &= ( machine->mem_read_hooks == 0 );
+
+    if ( mapped == false )
+    {
+        printf( "POST: Memory mapped pages failed\n" );
+        post_rc = false;
+    }
+
+    /************************************************************************
+     *  Bank switching
+     ************************************************************************/
+
+    memory_put_8( 0x0100, 0x11 );
+    memory_put_8( MEMORY_COMMON, 0x33 );
+    data_8 = memory_get_8( MEMORY_COMMON - 1 );
+    memory_bank_select( 1 );
+    mapped  = ( memory_get_8( 0x0100 ) == 0x76 );           //  A new bank
+    memory_put_8( 0x0100, 0x22 );
+    mapped &= ( memory_get_8( MEMORY_COMMON ) == 0x33 );    //  Common
+    mapped &= ( CPU_MEM[ 0x0100 ] == 0x11 );                //  Not copied
+    memory_bank_select( MEMORY_BANKS );                     //  Ignored
+    mapped &= ( memory_bank_get( ) == 1 );
+
+    //  Loads and reads see the visible bank
+    bytes[ 0 ] = 0x44;
+    bytes[ 1 ] = 0x55;
+    memory_load( MEMORY_COMMON - 1, 2, bytes );
+    mapped &= ( memory_get_16_p( MEMORY_COMMON - 1 ) == 0x5544 );
+    memory_read( bytes, 1, 0x0100 );
+    mapped &= ( bytes[ 0 ] == 0x22 );
+
+    //  The block kernels leave the bank to the byte loops
+    mapped &= ( memory_copy_up( 0x0200, 0x0300, 16 ) == false );
+
+    memory_bank_select( 0 );
+    mapped &= ( memory_get_8( 0x0100 ) == 0x11 );
+    mapped &= ( memory_get_8( MEMORY_COMMON - 1 ) == data_8 );
+    memory_bank_select( 1 );
+    mapped &= ( memory_get_8( 0x0100 ) == 0x22 );
+
+    //  A snapshot taken in bank 1 brings bank 1 back
+    image = malloc( MEMORY_IMAGE_SIZE );
+    if ( image != NULL )
+    {
+        memory_snapshot( image );
+        memory_bank_select( 0 );
+        memory_put_8( 0x0100, 0x99 );
+        memory_restore( image );
+        mapped &= ( memory_bank_get( ) == 1 );
+        mapped &= ( memory_get_8( 0x0100 ) == 0x22 );
+        memory_bank_select( 0 );
+        mapped &= ( memory_get_8( 0x0100 ) == 0x11 );
+        free( image );
+    }
+    memory_bank_select( 0 );
+
+    if ( mapped == false )
+    {
+        printf( "POST: Memory bank switching failed\n" );
+        post_rc = false;
+    }
+
+#if MEMORY_CHECKED
+    /************************************************************************
+     *  Watchpoints and the access log
+     ************************************************************************/
+
+    log = tmpfile( );
+    memory_watchpoint( 0x4000, true );
+    memory_log( log );
+    machine->mem_watch_hits = 0;
+
+    memory_put_8( 0x4000, 0x12 );                           //  Hit
+    memory_put_16_p( 0x3FFF, 0x3456 );                      //  Hit, 2 writes
+    memory_get_8( 0x4001 );                                 //  Miss
+
+    memory_log( NULL );
+    memory_watchpoint( 0x4000, false );
+    memory_get_8( 0x4000 );                                 //  Cleared
+
+    if (    ( machine->mem_watch_hits != 2 )
+         || ( log == NULL )
+         || ( ftell( log ) != ( 4 * 18 ) ) )
+    {
+        printf( "POST: Memory checked build failed\n" );
+        post_rc = false;
+    }
+    if ( log != NULL )
+    {
+        fclose( log );
+    }
+#endif
+
     /************************************************************************
      *  Function Exit
      ************************************************************************/
@@ -11,9 +11,12 @@
 
 /******************************** JAVADOC ***********************************/
 /**
- *  This file contains definitions (etc.) for the CPU registers.
+ *  This file contains definitions (etc.) for CPU memory.
  *
  *  @note
+ *      The accessors are inline functions at the end of this file.  They
+ *      need the complete struct machine_t, so machine.h includes this file
+ *      a second time once it is defined.
  *
  ****************************************************************************/
 
@@ -29,6 +32,8 @@
  ****************************************************************************/
 
                                 //*******************************************
+#include <stdio.h>              //  FILE
+#include <string.h>             //  memcpy( )
                                 //*******************************************
 
 /****************************************************************************
@@ -43,6 +48,32 @@
  ****************************************************************************/
 
 //----------------------------------------------------------------------------
+#define MEMORY_SIZE             ( 0x00010000 )
+//----------------------------------------------------------------------------
+/**
+ *  @param  MEMORY_PAGE_SHIFT   Address bits below the page number
+ *  @param  MEMORY_PAGE_SIZE    Bytes in a page
+ *  @param  MEMORY_PAGES        Pages in the address space                  */
+#define MEMORY_PAGE_SHIFT       ( 8 )
+#define MEMORY_PAGE_SIZE        ( 1 << MEMORY_PAGE_SHIFT )
+#define MEMORY_PAGES            ( MEMORY_SIZE >> MEMORY_PAGE_SHIFT )
+//----------------------------------------------------------------------------
+/**
+ *  @param  MEMORY_BANKS        Banks of the banked memory
+ *  @param  MEMORY_COMMON       First address of common memory, everything
+ *                              below it is banked
+ *  @param  MEMORY_BANK_PORT    I/O port that selects ( OUT ) or reports
+ *                              ( IN ) the bank                             */
+#define MEMORY_BANKS            ( 8 )
+#define MEMORY_COMMON           ( 0xC000 )
+#define MEMORY_BANK_PORT        ( 0xFD )
+//----------------------------------------------------------------------------
+/**
+ *  @param  MEMORY_IMAGE_SIZE   Bytes written by memory_snapshot( ): the
+ *                              address space, every bank and the bank
+ *                              number                                      */
+#define MEMORY_IMAGE_SIZE       ( MEMORY_SIZE                               \
+                                + ( MEMORY_BANKS * MEMORY_COMMON ) + 1 )
 //----------------------------------------------------------------------------
 
 /****************************************************************************
@@ -56,6 +87,28 @@
  * Structures
  ****************************************************************************/
 
+//----------------------------------------------------------------------------
+/**
+ *  @param  machine_t           Guest machine context ( machine.h )         */
+struct  machine_t;
+//----------------------------------------------------------------------------
+/**
+ *  @param  memory_page_t       What is mapped at one page                  */
+struct  memory_page_t
+{
+    /**
+     *  @param  read            Read handler, NULL for RAM                  */
+    uint8_t                 ( * read  )( uint16_t address );
+    /**
+     *  @param  write           Write handler, NULL for RAM                 */
+    void                    ( * write )( uint16_t address, uint8_t data );
+    /**
+     *  @param  rom             Writes are ignored                          */
+    bool                        rom;
+    /**
+     *  @param  watch           Writes reach RAM, then the write handler    */
+    bool                        watch;
+};
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 
@@ -72,6 +125,53 @@
 
 //----------------------------------------------------------------------------
 void
+memory_create(
+    struct  machine_t       *   guest
+    );
+//----------------------------------------------------------------------------
+void
+memory_destroy(
+    struct  machine_t       *   guest
+    );
+//----------------------------------------------------------------------------
+void
+memory_map_ram(
+    uint16_t                    address,
+    uint32_t                    size
+    );
+//----------------------------------------------------------------------------
+void
+memory_map_rom(
+    uint16_t                    address,
+    uint32_t                    size
+    );
+//----------------------------------------------------------------------------
+void
+memory_map_device(
+    uint16_t                    address,
+    uint32_t                    size,
+    uint8_t                 ( * read  )( uint16_t address ),
+    void                    ( * write )( uint16_t address, uint8_t data )
+    );
+//----------------------------------------------------------------------------
+void
+memory_map_watch(
+    uint16_t                    address,
+    uint32_t                    size,
+    void                    ( * write )( uint16_t address, uint8_t data )
+    );
+//----------------------------------------------------------------------------
+void
+memory_bank_select(
+    uint8_t                     bank
+    );
+//----------------------------------------------------------------------------
+uint8_t
+memory_bank_get(
+    void
+    );
+//----------------------------------------------------------------------------
+void
 memory_init(
     void
     );
@@ -90,31 +190,52 @@ memory_read(
     uint16_t                    address
     );
 //----------------------------------------------------------------------------
-uint8_t
-memory_get_8(
-    uint16_t                    address
+void
+memory_snapshot(
+    uint8_t                 *   data_p
     );
 //----------------------------------------------------------------------------
-uint16_t
-memory_get_16(
+void
+memory_restore(
+    const
+    uint8_t                 *   data_p
+    );
+//----------------------------------------------------------------------------
+uint8_t
+memory_get_hook(
     uint16_t                    address
     );
 //----------------------------------------------------------------------------
-uint16_t
-memory_put_16_p(
+void
+memory_put_hook(
     uint16_t                    address,
-    uint16_t                    data
+    uint8_t                     data
     );
 //----------------------------------------------------------------------------
-uint16_t
-memory_get_16_p(
-    uint16_t                    address
+#if MEMORY_CHECKED
+void
+memory_check(
+    uint16_t                    address,
+    int                         width,
+    uint16_t                    data,
+    bool                        write
     );
 //----------------------------------------------------------------------------
 void
-memory_put_8(
+memory_watchpoint(
     uint16_t                    address,
-    uint8_t                     data
+    bool                        enable
+    );
+//----------------------------------------------------------------------------
+void
+memory_log(
+    FILE                    *   log
+    );
+#endif
+//----------------------------------------------------------------------------
+uint16_t
+memory_get_16(
+    uint16_t                    address
     );
 //----------------------------------------------------------------------------
 void
@@ -123,9 +244,34 @@ memory_put_16(
     uint16_t                    data
     );
 //----------------------------------------------------------------------------
-uint16_t
-memory_get_16_pc_p(
-    void
+bool
+memory_copy_up(
+    uint16_t                    dest,
+    uint16_t                    source,
+    uint32_t                    size
+    );
+//----------------------------------------------------------------------------
+bool
+memory_copy_down(
+    uint16_t                    dest,
+    uint16_t                    source,
+    uint32_t                    size
+    );
+//----------------------------------------------------------------------------
+bool
+memory_find_up(
+    uint16_t                    address,
+    uint32_t                    size,
+    uint8_t                     data,
+    uint32_t                *   compared
+    );
+//----------------------------------------------------------------------------
+bool
+memory_find_down(
+    uint16_t                    address,
+    uint32_t                    size,
+    uint8_t                     data,
+    uint32_t                *   compared
     );
 //----------------------------------------------------------------------------
 int
@@ -142,4 +288,254 @@ memory_dump(
 
 /****************************************************************************/
 
-#endif                      //    MEMORY_H
\ No newline at end of file
+#endif                      //    MEMORY_H
+
+/****************************************************************************
+ * Inline Functions
+ ****************************************************************************/
+
+#if defined( MACHINE_T_COMPLETE ) && !defined( MEMORY_INLINE )
+#define MEMORY_INLINE
+
+                                //*******************************************
+#include "block_cache.h"        //  Decoded basic block cache
+                                //*******************************************
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  MEMORY_CHECK        Check one access in a MEMORY_CHECKED build,
+ *                              nothing at all otherwise                    */
+#if MEMORY_CHECKED
+#define MEMORY_CHECK( A, W, D, WR )     memory_check( ( A ), ( W ), ( D ), ( WR ) )
+#else
+#define MEMORY_CHECK( A, W, D, WR )     ( (void)0 )
+#endif
+//----------------------------------------------------------------------------
+/**
+ *  @param  MEMORY_OFFSET       Offset of an address inside its page        */
+#define MEMORY_OFFSET( A )      ( ( A ) & ( MEMORY_PAGE_SIZE - 1 ) )
+//----------------------------------------------------------------------------
+
+/****************************************************************************/
+/**
+ *  Get a byte of data from global memory using the provided address.
+ *
+ *  @param  address             Memory address
+ *
+ *  @return data                Data read from memory location 'address'.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static inline
+uint8_t
+memory_get_8(
+    uint16_t                    address
+    )
+{
+    /**
+     *  @param  page            The page for reads                          */
+    const
+    uint8_t                 *   page;
+
+    MEMORY_CHECK( address, 1, 0, false );
+
+    //  Memory read
+    page = machine->mem_read[ address >> MEMORY_PAGE_SHIFT ];
+    if ( __builtin_expect( page != NULL, 1 ) )
+    {
+        return( page[ MEMORY_OFFSET( address ) ] );
+    }
+
+    //  The page has a read handler
+    return( memory_get_hook( address ) );
+}
+
+/****************************************************************************/
+/**
+ *  Put a byte of data into global memory using the provided address.
+ *
+ *  @param  address             Memory address
+ *  @param  data                Data to be written into memory.
+ *
+ *  @return                     No information is returned from this function
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static inline
+void
+memory_put_8(
+    uint16_t                    address,
+    uint8_t                     data
+    )
+{
+    /**
+     *  @param  page            The page for writes                         */
+    uint8_t                 *   page;
+
+    MEMORY_CHECK( address, 1, data, true );
+
+#if INST_ENGINE == INST_ENGINE_BLOCK
+    //  Discard any blocks decoded from this byte
+    block_cache_write( address );
+#endif
+
+    //  Memory write
+    page = machine->mem_write[ address >> MEMORY_PAGE_SHIFT ];
+    if ( __builtin_expect( page != NULL, 1 ) )
+    {
+        page[ MEMORY_OFFSET( address ) ] = data;
+        return;
+    }
+
+    //  The page has a write handler
+    memory_put_hook( address, data );
+}
+
+/****************************************************************************/
+/**
+ *  Get two bytes of data from global memory using the provided address.
+ *
+ *  @param  address             Memory address
+ *
+ *  @return data                Data read from memory location 'address'.
+ *
+ *  @note
+ *      Data is retrieved in reverse order. [ (LL), (HH) ]
+ *
+ *      A word that does not cross a page is one little-endian load.  One
+ *      that does, x'FFFF wrapping to x'0000 included, is read a byte at a
+ *      time.
+ *
+ ****************************************************************************/
+
+static inline
+uint16_t
+memory_get_16_p(
+    uint16_t                    address
+    )
+{
+    /**
+     *  @param  page            The page for reads                          */
+    const
+    uint8_t                 *   page;
+    /**
+     *  @param  data            Data read from memory                       */
+    uint16_t                    data;
+
+    page = machine->mem_read[ address >> MEMORY_PAGE_SHIFT ];
+
+    //  Is it one load from RAM ?
+    if ( __builtin_expect(    ( page != NULL )
+                           && ( MEMORY_OFFSET( address ) != ( MEMORY_PAGE_SIZE - 1 ) ), 1 ) )
+    {
+        //  YES:    The host decides the byte order
+        MEMORY_CHECK( address, 2, 0, false );
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        memcpy( &data, &page[ MEMORY_OFFSET( address ) ], sizeof( data ) );
+#else
+        data  = ( page[ MEMORY_OFFSET( address )     ]      );
+        data |= ( page[ MEMORY_OFFSET( address ) + 1 ] << 8 );
+#endif
+        return( data );
+    }
+
+    //  Crosses a page or has a read handler
+    data  = ( memory_get_8( address                     )      );
+    data |= ( memory_get_8( (uint16_t)( address + 1 ) ) << 8 );
+
+    //  DONE!
+    return( data );
+}
+
+/****************************************************************************/
+/**
+ *  Put two bytes of data into global memory using the provided address.
+ *
+ *  @param  address             Memory address
+ *  @param  data                Data to be stored.
+ *
+ *  @return                     No data is returned from this function.
+ *
+ *  @note
+ *      Data is stored in reverse order. [ (LL), (HH) ]
+ *
+ *      The mirror image of memory_get_16_p( ).
+ *
+ ****************************************************************************/
+
+static inline
+void
+memory_put_16_p(
+    uint16_t                    address,
+    uint16_t                    data
+    )
+{
+    /**
+     *  @param  page            The page for writes                         */
+    uint8_t                 *   page;
+
+    page = machine->mem_write[ address >> MEMORY_PAGE_SHIFT ];
+
+    //  Is it one store to RAM ?
+    if ( __builtin_expect(    ( page != NULL )
+                           && ( MEMORY_OFFSET( address ) != ( MEMORY_PAGE_SIZE - 1 ) ), 1 ) )
+    {
+        //  YES:    The host decides the byte order
+        MEMORY_CHECK( address, 2, data, true );
+#if INST_ENGINE == INST_ENGINE_BLOCK
+        //  Discard any blocks decoded from these bytes
+        block_cache_write( address     );
+        block_cache_write( address + 1 );
+#endif
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        memcpy( &page[ MEMORY_OFFSET( address ) ], &data, sizeof( data ) );
+#else
+        page[ MEMORY_OFFSET( address )     ] = ( ( data & 0x00FF )      );
+        page[ MEMORY_OFFSET( address ) + 1 ] = ( ( data & 0xFF00 ) >> 8 );
+#endif
+        return;
+    }
+
+    //  Crosses a page or has a write handler
+    memory_put_8( address,                     ( ( data & 0x00FF )      ) );
+    memory_put_8( (uint16_t)( address + 1 ), ( ( data & 0xFF00 ) >> 8 ) );
+}
+
+/****************************************************************************/
+/**
+ *  Program Counter (PC) is pointing to address_low and PC + 1 is pointing to
+ *  address_high.  Read these two bytes and return with the address.
+ *
+ *  @param
+ *
+ *  @return address             The address.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static inline
+uint16_t
+memory_get_16_pc_p(
+    void
+    )
+{
+    /**
+     *  @param  address         Address of the source data                  */
+    uint16_t                    address;
+
+    //  Get the data address.
+    address = memory_get_16_p( CPU_REG_PC );
+    CPU_REG_PC += 2;
+
+    //  DONE!
+    return( address );
+}
+
+/****************************************************************************/
+
+#endif                      //    MEMORY_INLINE
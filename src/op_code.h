@@ -85,6 +85,16 @@ inst_fetch(
     );
 //----------------------------------------------------------------------------
 void
+inst_resume(
+    void
+    );
+//----------------------------------------------------------------------------
+void
+inst_threaded(
+    void
+    );
+//----------------------------------------------------------------------------
+void
 inst_fetch_CB(
     uint8_t                     op_code
     );
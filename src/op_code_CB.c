@@ -50,6 +50,7 @@
 #include "jump.h"               //  Jump instructions
 #include "call.h"               //  Call instructions
 #include "io.h"                 //  Input & Output instructions
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -148,7 +149,7 @@ invalid_op_code(
     /************************************************************************
      *  Function Exit
      ************************************************************************/
-    operation_rc.states = 0;
+    machine->operation_rc.states = 0;
 
     //  DONE!
 }
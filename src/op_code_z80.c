@@ -50,6 +50,7 @@
 #include "jump.h"               //  Jump instructions
 #include "call.h"               //  Call instructions
 #include "io.h"                 //  Input & Output instructions
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -148,7 +149,7 @@ invalid_op_code(
     /************************************************************************
      *  Function Exit
      ************************************************************************/
-    operation_rc.states = 0;
+    machine->operation_rc.states = 0;
 
     //  DONE!
 }
@@ -181,16 +182,16 @@ op_code_z80_init(
     op_code_z80_table[ 0x01 ] = ld_ssNN_i80;                //  LD      BC, nn
     op_code_z80_table[ 0x02 ] = ld_ssa_i80;                 //  LD      (BC), A
     op_code_z80_table[ 0x03 ] = math_incss_i80;             //  INC     BC
-    op_code_z80_table[ 0x04 ] = math_incr_i80;              //  INC     B
-    op_code_z80_table[ 0x05 ] = math_decr_r80;              //  DEC     B
+    op_code_z80_table[ 0x04 ] = math_incr_i80_B;            //  INC     B
+    op_code_z80_table[ 0x05 ] = math_decr_r80_B;            //  DEC     B
     op_code_z80_table[ 0x06 ] = ld_rn_i80;                  //  LD      B, n
     op_code_z80_table[ 0x07 ] = shift_rlca_i80;             //  RLCA
     op_code_z80_table[ 0x08 ] = ex_afaf_z80;                //  EX      AF, AF' (Z80)
     op_code_z80_table[ 0x09 ] = math_addhlss_i80;           //  ADD     HL, BC
     op_code_z80_table[ 0x0A ] = ld_ass_i80;                 //  LD      A, (BC)
     op_code_z80_table[ 0x0B ] = math_decss_i80;             //  DEC     BC
-    op_code_z80_table[ 0x0C ] = math_incr_i80;              //  INC     C
-    op_code_z80_table[ 0x0D ] = math_decr_r80;              //  DEC     C
+    op_code_z80_table[ 0x0C ] = math_incr_i80_C;            //  INC     C
+    op_code_z80_table[ 0x0D ] = math_decr_r80_C;            //  DEC     C
     op_code_z80_table[ 0x0E ] = ld_rn_i80;                  //  LD      C, n
     op_code_z80_table[ 0x0F ] = shift_rrca_i80;             //  RRCA
     //========================================================================
@@ -198,16 +199,16 @@ op_code_z80_init(
     op_code_z80_table[ 0x11 ] = ld_ssNN_i80;                //  LD      DE, nn
     op_code_z80_table[ 0x12 ] = ld_ssa_i80;                 //  LD      (DE), A
     op_code_z80_table[ 0x13 ] = math_incss_i80;             //  INC     DE
-    op_code_z80_table[ 0x14 ] = math_incr_i80;              //  INC     D
-    op_code_z80_table[ 0x15 ] = math_decr_r80;              //  DEC     D
+    op_code_z80_table[ 0x14 ] = math_incr_i80_D;            //  INC     D
+    op_code_z80_table[ 0x15 ] = math_decr_r80_D;            //  DEC     D
     op_code_z80_table[ 0x16 ] = ld_rn_i80;                  //  LD      D, n
     op_code_z80_table[ 0x17 ] = shift_rla_i80;              //  RLA
     op_code_z80_table[ 0x18 ] = jump_jr_z80;                //  JR      e       (Z80)
     op_code_z80_table[ 0x19 ] = math_addhlss_i80;           //  ADD     HL, DE
     op_code_z80_table[ 0x1A ] = ld_ass_i80;                 //  LD      A, (DE)
     op_code_z80_table[ 0x1B ] = math_decss_i80;             //  DEC     DE
-    op_code_z80_table[ 0x1C ] = math_incr_i80;              //  INC     E
-    op_code_z80_table[ 0x1D ] = math_decr_r80;              //  DEC     E
+    op_code_z80_table[ 0x1C ] = math_incr_i80_E;            //  INC     E
+    op_code_z80_table[ 0x1D ] = math_decr_r80_E;            //  DEC     E
     op_code_z80_table[ 0x1E ] = ld_rn_i80;                  //  LD      E, n
     op_code_z80_table[ 0x1F ] = shift_rra_i80;              //  RRA
     //========================================================================
@@ -215,16 +216,16 @@ op_code_z80_init(
     op_code_z80_table[ 0x21 ] = ld_ssNN_i80;                //  LD      HL, nn
     op_code_z80_table[ 0x22 ] = ld_nnhl_i80;                //  LD      (nn), HL
     op_code_z80_table[ 0x23 ] = math_incss_i80;             //  INC     HL
-    op_code_z80_table[ 0x24 ] = math_incr_i80;              //  INC     H
-    op_code_z80_table[ 0x25 ] = math_decr_r80;              //  DEC     H
+    op_code_z80_table[ 0x24 ] = math_incr_i80_H;            //  INC     H
+    op_code_z80_table[ 0x25 ] = math_decr_r80_H;            //  DEC     H
     op_code_z80_table[ 0x26 ] = ld_rn_i80;                  //  LD      H, n
     op_code_z80_table[ 0x27 ] = math_daa_z80;               //  DAA
     op_code_z80_table[ 0x28 ] = jump_jrcc_z80;              //  JR      Z, e    (Z80)
     op_code_z80_table[ 0x29 ] = math_addhlss_i80;           //  ADD     HL, HL
     op_code_z80_table[ 0x2A ] = ld_hlnn_i80;                //  LD      HL, (nn)
     op_code_z80_table[ 0x2B ] = math_decss_i80;             //  DEC     HL
-    op_code_z80_table[ 0x2C ] = math_incr_i80;              //  INC     L
-    op_code_z80_table[ 0x2D ] = math_decr_r80;              //  DEC     L
+    op_code_z80_table[ 0x2C ] = math_incr_i80_L;            //  INC     L
+    op_code_z80_table[ 0x2D ] = math_decr_r80_L;            //  DEC     L
     op_code_z80_table[ 0x2E ] = ld_rn_i80;                  //  LD      L, n
     op_code_z80_table[ 0x2F ] = math_cpl_i80;               //  CPL
     //========================================================================
@@ -240,61 +241,61 @@ op_code_z80_init(
     op_code_z80_table[ 0x39 ] = math_addhlss_i80;           //  ADD     HL, SP
     op_code_z80_table[ 0x3A ] = ld_ann_i80;                 //  LD      A, (nn)
     op_code_z80_table[ 0x3B ] = math_decss_i80;             //  DEC     SP
-    op_code_z80_table[ 0x3C ] = math_incr_i80;              //  INC     A
-    op_code_z80_table[ 0x3D ] = math_decr_r80;              //  DEC     A
+    op_code_z80_table[ 0x3C ] = math_incr_i80_A;            //  INC     A
+    op_code_z80_table[ 0x3D ] = math_decr_r80_A;            //  DEC     A
     op_code_z80_table[ 0x3E ] = ld_rn_i80;                  //  LD      A, n
     op_code_z80_table[ 0x3F ] = math_ccf_i80;               //  CFF
     //========================================================================
-    op_code_z80_table[ 0x40 ] = ld_rr_i80;                  //  LD      B, B'
-    op_code_z80_table[ 0x41 ] = ld_rr_i80;                  //  LD      B, C'
-    op_code_z80_table[ 0x42 ] = ld_rr_i80;                  //  LD      B, D'
-    op_code_z80_table[ 0x43 ] = ld_rr_i80;                  //  LD      B, E'
-    op_code_z80_table[ 0x44 ] = ld_rr_i80;                  //  LD      B, H'
-    op_code_z80_table[ 0x45 ] = ld_rr_i80;                  //  LD      B, L'
+    op_code_z80_table[ 0x40 ] = ld_rr_i80_BB;               //  LD      B, B'
+    op_code_z80_table[ 0x41 ] = ld_rr_i80_BC;               //  LD      B, C'
+    op_code_z80_table[ 0x42 ] = ld_rr_i80_BD;               //  LD      B, D'
+    op_code_z80_table[ 0x43 ] = ld_rr_i80_BE;               //  LD      B, E'
+    op_code_z80_table[ 0x44 ] = ld_rr_i80_BH;               //  LD      B, H'
+    op_code_z80_table[ 0x45 ] = ld_rr_i80_BL;               //  LD      B, L'
     op_code_z80_table[ 0x46 ] = ld_rhl_i80;                 //  LD      B, (HL)
-    op_code_z80_table[ 0x47 ] = ld_rr_i80;                  //  LD      C, A'
-    op_code_z80_table[ 0x48 ] = ld_rr_i80;                  //  LD      C, B'
-    op_code_z80_table[ 0x49 ] = ld_rr_i80;                  //  LD      C, C'
-    op_code_z80_table[ 0x4A ] = ld_rr_i80;                  //  LD      C, D'
-    op_code_z80_table[ 0x4B ] = ld_rr_i80;                  //  LD      C, E'
-    op_code_z80_table[ 0x4C ] = ld_rr_i80;                  //  LD      C, H'
-    op_code_z80_table[ 0x4D ] = ld_rr_i80;                  //  LD      C, L'
+    op_code_z80_table[ 0x47 ] = ld_rr_i80_BA;               //  LD      C, A'
+    op_code_z80_table[ 0x48 ] = ld_rr_i80_CB;               //  LD      C, B'
+    op_code_z80_table[ 0x49 ] = ld_rr_i80_CC;               //  LD      C, C'
+    op_code_z80_table[ 0x4A ] = ld_rr_i80_CD;               //  LD      C, D'
+    op_code_z80_table[ 0x4B ] = ld_rr_i80_CE;               //  LD      C, E'
+    op_code_z80_table[ 0x4C ] = ld_rr_i80_CH;               //  LD      C, H'
+    op_code_z80_table[ 0x4D ] = ld_rr_i80_CL;               //  LD      C, L'
     op_code_z80_table[ 0x4E ] = ld_rhl_i80;                 //  LD      C, (HL)
-    op_code_z80_table[ 0x4F ] = ld_rr_i80;                  //  LD      C, A'
+    op_code_z80_table[ 0x4F ] = ld_rr_i80_CA;               //  LD      C, A'
     //========================================================================
-    op_code_z80_table[ 0x50 ] = ld_rr_i80;                  //  LD      D, B'
-    op_code_z80_table[ 0x51 ] = ld_rr_i80;                  //  LD      D, C'
-    op_code_z80_table[ 0x52 ] = ld_rr_i80;                  //  LD      D, D'
-    op_code_z80_table[ 0x53 ] = ld_rr_i80;                  //  LD      D, E'
-    op_code_z80_table[ 0x54 ] = ld_rr_i80;                  //  LD      D, H'
-    op_code_z80_table[ 0x55 ] = ld_rr_i80;                  //  LD      D, L'
+    op_code_z80_table[ 0x50 ] = ld_rr_i80_DB;               //  LD      D, B'
+    op_code_z80_table[ 0x51 ] = ld_rr_i80_DC;               //  LD      D, C'
+    op_code_z80_table[ 0x52 ] = ld_rr_i80_DD;               //  LD      D, D'
+    op_code_z80_table[ 0x53 ] = ld_rr_i80_DE;               //  LD      D, E'
+    op_code_z80_table[ 0x54 ] = ld_rr_i80_DH;               //  LD      D, H'
+    op_code_z80_table[ 0x55 ] = ld_rr_i80_DL;               //  LD      D, L'
     op_code_z80_table[ 0x56 ] = ld_rhl_i80;                 //  LD      D, (HL)
-    op_code_z80_table[ 0x57 ] = ld_rr_i80;                  //  LD      E, A'
-    op_code_z80_table[ 0x58 ] = ld_rr_i80;                  //  LD      E, B'
-    op_code_z80_table[ 0x59 ] = ld_rr_i80;                  //  LD      E, C'
-    op_code_z80_table[ 0x5A ] = ld_rr_i80;                  //  LD      E, D'
-    op_code_z80_table[ 0x5B ] = ld_rr_i80;                  //  LD      E, E'
-    op_code_z80_table[ 0x5C ] = ld_rr_i80;                  //  LD      E, H'
-    op_code_z80_table[ 0x5D ] = ld_rr_i80;                  //  LD      E, L'
+    op_code_z80_table[ 0x57 ] = ld_rr_i80_DA;               //  LD      E, A'
+    op_code_z80_table[ 0x58 ] = ld_rr_i80_EB;               //  LD      E, B'
+    op_code_z80_table[ 0x59 ] = ld_rr_i80_EC;               //  LD      E, C'
+    op_code_z80_table[ 0x5A ] = ld_rr_i80_ED;               //  LD      E, D'
+    op_code_z80_table[ 0x5B ] = ld_rr_i80_EE;               //  LD      E, E'
+    op_code_z80_table[ 0x5C ] = ld_rr_i80_EH;               //  LD      E, H'
+    op_code_z80_table[ 0x5D ] = ld_rr_i80_EL;               //  LD      E, L'
     op_code_z80_table[ 0x5E ] = ld_rhl_i80;                 //  LD      E, (HL)
-    op_code_z80_table[ 0x5F ] = ld_rr_i80;                  //  LD      E, A'
+    op_code_z80_table[ 0x5F ] = ld_rr_i80_EA;               //  LD      E, A'
     //========================================================================
-    op_code_z80_table[ 0x60 ] = ld_rr_i80;                  //  LD      H, B'
-    op_code_z80_table[ 0x61 ] = ld_rr_i80;                  //  LD      H, C'
-    op_code_z80_table[ 0x62 ] = ld_rr_i80;                  //  LD      H, D'
-    op_code_z80_table[ 0x63 ] = ld_rr_i80;                  //  LD      H, E'
-    op_code_z80_table[ 0x64 ] = ld_rr_i80;                  //  LD      H, H'
-    op_code_z80_table[ 0x65 ] = ld_rr_i80;                  //  LD      H, L'
+    op_code_z80_table[ 0x60 ] = ld_rr_i80_HB;               //  LD      H, B'
+    op_code_z80_table[ 0x61 ] = ld_rr_i80_HC;               //  LD      H, C'
+    op_code_z80_table[ 0x62 ] = ld_rr_i80_HD;               //  LD      H, D'
+    op_code_z80_table[ 0x63 ] = ld_rr_i80_HE;               //  LD      H, E'
+    op_code_z80_table[ 0x64 ] = ld_rr_i80_HH;               //  LD      H, H'
+    op_code_z80_table[ 0x65 ] = ld_rr_i80_HL;               //  LD      H, L'
     op_code_z80_table[ 0x66 ] = ld_rhl_i80;                 //  LD      H, (HL)
-    op_code_z80_table[ 0x67 ] = ld_rr_i80;                  //  LD      H, A'
-    op_code_z80_table[ 0x68 ] = ld_rr_i80;                  //  LD      L, B'
-    op_code_z80_table[ 0x69 ] = ld_rr_i80;                  //  LD      L, C'
-    op_code_z80_table[ 0x6A ] = ld_rr_i80;                  //  LD      L, D'
-    op_code_z80_table[ 0x6B ] = ld_rr_i80;                  //  LD      L, E'
-    op_code_z80_table[ 0x6C ] = ld_rr_i80;                  //  LD      L, H'
-    op_code_z80_table[ 0x6D ] = ld_rr_i80;                  //  LD      L, L'
+    op_code_z80_table[ 0x67 ] = ld_rr_i80_HA;               //  LD      H, A'
+    op_code_z80_table[ 0x68 ] = ld_rr_i80_LB;               //  LD      L, B'
+    op_code_z80_table[ 0x69 ] = ld_rr_i80_LC;               //  LD      L, C'
+    op_code_z80_table[ 0x6A ] = ld_rr_i80_LD;               //  LD      L, D'
+    op_code_z80_table[ 0x6B ] = ld_rr_i80_LE;               //  LD      L, E'
+    op_code_z80_table[ 0x6C ] = ld_rr_i80_LH;               //  LD      L, H'
+    op_code_z80_table[ 0x6D ] = ld_rr_i80_LL;               //  LD      L, L'
     op_code_z80_table[ 0x6E ] = ld_rhl_i80;                 //  LD      L, (HL)
-    op_code_z80_table[ 0X6F ] = ld_rr_i80;                  //  LD      L, A'
+    op_code_z80_table[ 0X6F ] = ld_rr_i80_LA;               //  LD      L, A'
     //========================================================================
     op_code_z80_table[ 0x70 ] = ld_hlr_i80;                 //  LD      (HL), B
     op_code_z80_table[ 0x71 ] = ld_hlr_i80;                 //  LD      (HL), C
@@ -304,82 +305,82 @@ op_code_z80_init(
     op_code_z80_table[ 0x75 ] = ld_hlr_i80;                 //  LD      (HL), L
     op_code_z80_table[ 0x76 ] = control_hlt_i80;            //  HALT
     op_code_z80_table[ 0x77 ] = ld_hlr_i80;                 //  LD      (HL), B
-    op_code_z80_table[ 0x78 ] = ld_rr_i80;                  //  LD      A, B'
-    op_code_z80_table[ 0x79 ] = ld_rr_i80;                  //  LD      A, C'
-    op_code_z80_table[ 0x7A ] = ld_rr_i80;                  //  LD      A, D'
-    op_code_z80_table[ 0x7B ] = ld_rr_i80;                  //  LD      A, E'
-    op_code_z80_table[ 0x7C ] = ld_rr_i80;                  //  LD      A, H'
-    op_code_z80_table[ 0x7D ] = ld_rr_i80;                  //  LD      A, L'
+    op_code_z80_table[ 0x78 ] = ld_rr_i80_AB;               //  LD      A, B'
+    op_code_z80_table[ 0x79 ] = ld_rr_i80_AC;               //  LD      A, C'
+    op_code_z80_table[ 0x7A ] = ld_rr_i80_AD;               //  LD      A, D'
+    op_code_z80_table[ 0x7B ] = ld_rr_i80_AE;               //  LD      A, E'
+    op_code_z80_table[ 0x7C ] = ld_rr_i80_AH;               //  LD      A, H'
+    op_code_z80_table[ 0x7D ] = ld_rr_i80_AL;               //  LD      A, L'
     op_code_z80_table[ 0x7E ] = ld_rhl_i80;                 //  LD      A, (HL)
-    op_code_z80_table[ 0X7F ] = ld_rr_i80;                  //  LD      A, B'
+    op_code_z80_table[ 0X7F ] = ld_rr_i80_AA;               //  LD      A, B'
     //========================================================================
-    op_code_z80_table[ 0x80 ] = math_addr_i80;              //  ADD     A, B
-    op_code_z80_table[ 0x81 ] = math_addr_i80;              //  ADD     A, C
-    op_code_z80_table[ 0x82 ] = math_addr_i80;              //  ADD     A, D
-    op_code_z80_table[ 0x83 ] = math_addr_i80;              //  ADD     A, E
-    op_code_z80_table[ 0x84 ] = math_addr_i80;              //  ADD     A, H
-    op_code_z80_table[ 0x85 ] = math_addr_i80;              //  ADD     A, L
+    op_code_z80_table[ 0x80 ] = math_addr_i80_B;            //  ADD     A, B
+    op_code_z80_table[ 0x81 ] = math_addr_i80_C;            //  ADD     A, C
+    op_code_z80_table[ 0x82 ] = math_addr_i80_D;            //  ADD     A, D
+    op_code_z80_table[ 0x83 ] = math_addr_i80_E;            //  ADD     A, E
+    op_code_z80_table[ 0x84 ] = math_addr_i80_H;            //  ADD     A, H
+    op_code_z80_table[ 0x85 ] = math_addr_i80_L;            //  ADD     A, L
     op_code_z80_table[ 0x86 ] = math_addhl_i80;             //  ADD     A, (HL)
-    op_code_z80_table[ 0x87 ] = math_addr_i80;              //  ADD     A, A
-    op_code_z80_table[ 0x88 ] = math_adcr_i80;              //  ADC     A, B
-    op_code_z80_table[ 0x89 ] = math_adcr_i80;              //  ADC     A, C
-    op_code_z80_table[ 0x8A ] = math_adcr_i80;              //  ADC     A, D
-    op_code_z80_table[ 0x8B ] = math_adcr_i80;              //  ADC     A, E
-    op_code_z80_table[ 0x8C ] = math_adcr_i80;              //  ADC     A, H
-    op_code_z80_table[ 0x8D ] = math_adcr_i80;              //  ADC     A, L
+    op_code_z80_table[ 0x87 ] = math_addr_i80_A;            //  ADD     A, A
+    op_code_z80_table[ 0x88 ] = math_adcr_i80_B;            //  ADC     A, B
+    op_code_z80_table[ 0x89 ] = math_adcr_i80_C;            //  ADC     A, C
+    op_code_z80_table[ 0x8A ] = math_adcr_i80_D;            //  ADC     A, D
+    op_code_z80_table[ 0x8B ] = math_adcr_i80_E;            //  ADC     A, E
+    op_code_z80_table[ 0x8C ] = math_adcr_i80_H;            //  ADC     A, H
+    op_code_z80_table[ 0x8D ] = math_adcr_i80_L;            //  ADC     A, L
     op_code_z80_table[ 0x8E ] = math_adchl_i80;             //  ADC     A, (HL)
-    op_code_z80_table[ 0x8F ] = math_adcr_i80;              //  ADC     A, A
+    op_code_z80_table[ 0x8F ] = math_adcr_i80_A;            //  ADC     A, A
     //========================================================================
-    op_code_z80_table[ 0x90 ] = math_subr_i80;              //  SUB     A, B
-    op_code_z80_table[ 0x91 ] = math_subr_i80;              //  SUB     A, C
-    op_code_z80_table[ 0x92 ] = math_subr_i80;              //  SUB     A, D
-    op_code_z80_table[ 0x93 ] = math_subr_i80;              //  SUB     A, E
-    op_code_z80_table[ 0x94 ] = math_subr_i80;              //  SUB     A, H
-    op_code_z80_table[ 0x95 ] = math_subr_i80;              //  SUB     A, L
+    op_code_z80_table[ 0x90 ] = math_subr_i80_B;            //  SUB     A, B
+    op_code_z80_table[ 0x91 ] = math_subr_i80_C;            //  SUB     A, C
+    op_code_z80_table[ 0x92 ] = math_subr_i80_D;            //  SUB     A, D
+    op_code_z80_table[ 0x93 ] = math_subr_i80_E;            //  SUB     A, E
+    op_code_z80_table[ 0x94 ] = math_subr_i80_H;            //  SUB     A, H
+    op_code_z80_table[ 0x95 ] = math_subr_i80_L;            //  SUB     A, L
     op_code_z80_table[ 0x96 ] = math_subhl_i80;             //  SUB     A, (HL)
-    op_code_z80_table[ 0x97 ] = math_subr_i80;              //  SUB     A, A
-    op_code_z80_table[ 0x98 ] = math_sbcr_i80;              //  SBC     A, B
-    op_code_z80_table[ 0x99 ] = math_sbcr_i80;              //  SBC     A, D
-    op_code_z80_table[ 0x9A ] = math_sbcr_i80;              //  SBC     A, E
-    op_code_z80_table[ 0x9B ] = math_sbcr_i80;              //  SBC     A, F
-    op_code_z80_table[ 0x9C ] = math_sbcr_i80;              //  SBC     A, H
-    op_code_z80_table[ 0x9D ] = math_sbcr_i80;              //  SBC     A, L
+    op_code_z80_table[ 0x97 ] = math_subr_i80_A;            //  SUB     A, A
+    op_code_z80_table[ 0x98 ] = math_sbcr_i80_B;            //  SBC     A, B
+    op_code_z80_table[ 0x99 ] = math_sbcr_i80_C;            //  SBC     A, D
+    op_code_z80_table[ 0x9A ] = math_sbcr_i80_D;            //  SBC     A, E
+    op_code_z80_table[ 0x9B ] = math_sbcr_i80_E;            //  SBC     A, F
+    op_code_z80_table[ 0x9C ] = math_sbcr_i80_H;            //  SBC     A, H
+    op_code_z80_table[ 0x9D ] = math_sbcr_i80_L;            //  SBC     A, L
     op_code_z80_table[ 0x9E ] = math_sbchl_i80;             //  SBC     A, (HL)
-    op_code_z80_table[ 0x9F ] = math_sbcr_i80;              //  SBC     A, A
+    op_code_z80_table[ 0x9F ] = math_sbcr_i80_A;            //  SBC     A, A
     //========================================================================
-    op_code_z80_table[ 0xA0 ] = logic_andr_i80;             //  AND     B
-    op_code_z80_table[ 0xA1 ] = logic_andr_i80;             //  AND     C
-    op_code_z80_table[ 0xA2 ] = logic_andr_i80;             //  AND     D
-    op_code_z80_table[ 0xA3 ] = logic_andr_i80;             //  AND     E
-    op_code_z80_table[ 0xA4 ] = logic_andr_i80;             //  AND     H
-    op_code_z80_table[ 0xA5 ] = logic_andr_i80;             //  AND     L
+    op_code_z80_table[ 0xA0 ] = logic_andr_i80_B;           //  AND     B
+    op_code_z80_table[ 0xA1 ] = logic_andr_i80_C;           //  AND     C
+    op_code_z80_table[ 0xA2 ] = logic_andr_i80_D;           //  AND     D
+    op_code_z80_table[ 0xA3 ] = logic_andr_i80_E;           //  AND     E
+    op_code_z80_table[ 0xA4 ] = logic_andr_i80_H;           //  AND     H
+    op_code_z80_table[ 0xA5 ] = logic_andr_i80_L;           //  AND     L
     op_code_z80_table[ 0xA6 ] = logic_andhl_i80;            //  AND     (HL)
-    op_code_z80_table[ 0xA7 ] = logic_andr_i80;             //  AND     A
-    op_code_z80_table[ 0xA8 ] = logic_xorr_i80;             //  XOR     B
-    op_code_z80_table[ 0xA9 ] = logic_xorr_i80;             //  XOR     C
-    op_code_z80_table[ 0xAA ] = logic_xorr_i80;             //  XOR     D
-    op_code_z80_table[ 0xAB ] = logic_xorr_i80;             //  XOR     E
-    op_code_z80_table[ 0xAC ] = logic_xorr_i80;             //  XOR     H
-    op_code_z80_table[ 0xAD ] = logic_xorr_i80;             //  XOR     L
+    op_code_z80_table[ 0xA7 ] = logic_andr_i80_A;           //  AND     A
+    op_code_z80_table[ 0xA8 ] = logic_xorr_i80_B;           //  XOR     B
+    op_code_z80_table[ 0xA9 ] = logic_xorr_i80_C;           //  XOR     C
+    op_code_z80_table[ 0xAA ] = logic_xorr_i80_D;           //  XOR     D
+    op_code_z80_table[ 0xAB ] = logic_xorr_i80_E;           //  XOR     E
+    op_code_z80_table[ 0xAC ] = logic_xorr_i80_H;           //  XOR     H
+    op_code_z80_table[ 0xAD ] = logic_xorr_i80_L;           //  XOR     L
     op_code_z80_table[ 0xAE ] = logic_xorhl_i80;            //  XOR     (HL)
-    op_code_z80_table[ 0xAF ] = logic_xorr_i80;             //  XOR     A
+    op_code_z80_table[ 0xAF ] = logic_xorr_i80_A;           //  XOR     A
     //========================================================================
-    op_code_z80_table[ 0xB0 ] = logic_orr_i80;              //  OR      B
-    op_code_z80_table[ 0xB1 ] = logic_orr_i80;              //  OR      C
-    op_code_z80_table[ 0xB2 ] = logic_orr_i80;              //  OR      D
-    op_code_z80_table[ 0xB3 ] = logic_orr_i80;              //  OR      E
-    op_code_z80_table[ 0xB4 ] = logic_orr_i80;              //  OR      H
-    op_code_z80_table[ 0xB5 ] = logic_orr_i80;              //  OR      L
+    op_code_z80_table[ 0xB0 ] = logic_orr_i80_B;            //  OR      B
+    op_code_z80_table[ 0xB1 ] = logic_orr_i80_C;            //  OR      C
+    op_code_z80_table[ 0xB2 ] = logic_orr_i80_D;            //  OR      D
+    op_code_z80_table[ 0xB3 ] = logic_orr_i80_E;            //  OR      E
+    op_code_z80_table[ 0xB4 ] = logic_orr_i80_H;            //  OR      H
+    op_code_z80_table[ 0xB5 ] = logic_orr_i80_L;            //  OR      L
     op_code_z80_table[ 0xB6 ] = logic_orhl_i80;             //  OR      (HL)
-    op_code_z80_table[ 0xB7 ] = logic_orr_i80;              //  OR      A
-    op_code_z80_table[ 0xB8 ] = logic_cpr_i80;              //  CP      B
-    op_code_z80_table[ 0xB9 ] = logic_cpr_i80;              //  CP      C
-    op_code_z80_table[ 0xBA ] = logic_cpr_i80;              //  CP      D
-    op_code_z80_table[ 0xBB ] = logic_cpr_i80;              //  CP      E
-    op_code_z80_table[ 0xBC ] = logic_cpr_i80;              //  CP      H
-    op_code_z80_table[ 0xBD ] = logic_cpr_i80;              //  CP      L
+    op_code_z80_table[ 0xB7 ] = logic_orr_i80_A;            //  OR      A
+    op_code_z80_table[ 0xB8 ] = logic_cpr_i80_B;            //  CP      B
+    op_code_z80_table[ 0xB9 ] = logic_cpr_i80_C;            //  CP      C
+    op_code_z80_table[ 0xBA ] = logic_cpr_i80_D;            //  CP      D
+    op_code_z80_table[ 0xBB ] = logic_cpr_i80_E;            //  CP      E
+    op_code_z80_table[ 0xBC ] = logic_cpr_i80_H;            //  CP      H
+    op_code_z80_table[ 0xBD ] = logic_cpr_i80_L;            //  CP      L
     op_code_z80_table[ 0xBE ] = logic_cphl_i80;             //  CP      (HL)
-    op_code_z80_table[ 0xBF ] = logic_cpr_i80;              //  CP      A
+    op_code_z80_table[ 0xBF ] = logic_cpr_i80_A;            //  CP      A
     //========================================================================
     op_code_z80_table[ 0xC0 ] = ret_cc_i80;                 //  RET     NZ
     op_code_z80_table[ 0xC1 ] = ld_popqq_i80;               //  POP     BC
@@ -443,7 +444,7 @@ op_code_z80_init(
     op_code_z80_table[ 0xF8 ] = ret_cc_i80;                 //  RET     M
     op_code_z80_table[ 0xF9 ] = ld_sphl_i80;                //  LD      SP, HL
     op_code_z80_table[ 0xFA ] = jump_jpccnn_i80;            //  JP,     M, nn
-    op_code_z80_table[ 0xFB ] = control_di_i80;             //  EI
+    op_code_z80_table[ 0xFB ] = control_ei_i80;             //  EI
     op_code_z80_table[ 0xFC ] = call_ccnn_i80;              //  CALL    M, nn
     op_code_z80_table[ 0xFD ] = inst_fetch_FD;              //  EIS             (Z80)
     op_code_z80_table[ 0xFE ] = logic_cpn_i80;              //  CP      n
@@ -0,0 +1,300 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Real-time pacing of the guest clock.
+ *
+ *  The instruction loops add up the clock states of every instruction and
+ *  hand the running count to PACE( ).  Once a slice ( about 1 ms of guest
+ *  time ) has been executed pace_sync( ) works out when the host clock
+ *  should read for that many states at the target clock and, if the
+ *  emulator is ahead, sleeps until then with an absolute deadline.  Time
+ *  spent emulating is not added on top of the sleep and the host is idle
+ *  for the rest of every slice.
+ *
+ *  When the emulator falls well behind ( the host was busy or the guest
+ *  waited for console input ) the pacing starts over from the current time
+ *  instead of running flat out to catch up.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+#define _POSIX_C_SOURCE 200112L //  clock_nanosleep( )
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <stdio.h>              //  Standard I/O definitions
+#include <errno.h>              //  Error numbers
+#include <time.h>               //  Time stuff
+                                //*******************************************
+
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "pace.h"               //  Real-time pacing
+#include "machine.h"            //  Guest machine context
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  PACE_SLICES         Host clock checks per second of guest time  */
+#define PACE_SLICES             ( 1000 )
+//----------------------------------------------------------------------------
+/**
+ *  @param  PACE_SLIP_NS        How far behind before pacing starts over    */
+#define PACE_SLIP_NS            ( 50000000 )
+//----------------------------------------------------------------------------
+/**
+ *  @param  NS_PER_SECOND       Nanoseconds in one second                   */
+#define NS_PER_SECOND           ( 1000000000 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  pace_config         Requested clock ( or PACE_CLOCK_CPU ), the
+ *                              same for every guest                        */
+static
+uint32_t                        pace_config = PACE_CLOCK;
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Read the monotonic host clock.
+ *
+ *  @param
+ *
+ *  @return                     Host time in nanoseconds.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+uint64_t
+pace_now(
+    void
+    )
+{
+    /**
+     *  @param  now             Current host time                           */
+    struct timespec             now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return( ( (uint64_t)now.tv_sec * NS_PER_SECOND ) + now.tv_nsec );
+}
+
+/****************************************************************************/
+/**
+ *  Work out the clock the guest is to be held to.
+ *
+ *  @param
+ *
+ *  @return                     Target clock in Hz, zero for unlimited.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+uint32_t
+pace_target(
+    void
+    )
+{
+    //  Does the clock follow the CPU mode ?
+    if ( pace_config == PACE_CLOCK_CPU )
+    {
+        //  YES:    2 MHz for the 8080, 4 MHz for the Z80
+        return( ( CPU == CPU_Z80 ) ? PACE_CLOCK_Z80 : PACE_CLOCK_I80 );
+    }
+
+    return( pace_config );
+}
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Select the guest clock.
+ *
+ *  @param  clock_hz            Clock in Hz, PACE_CLOCK_CPU or
+ *                              PACE_CLOCK_UNLIMITED.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Takes effect at the next instruction.
+ *
+ ****************************************************************************/
+
+void
+pace_clock(
+    uint32_t                    clock_hz
+    )
+{
+    //  Save the new clock
+    pace_config = clock_hz;
+
+    //  Have the next PACE( ) pick it up
+    machine->pace_due = 0;
+}
+
+/****************************************************************************/
+/**
+ *  Start pacing from the current host time.
+ *
+ *  @param  t_states            Clock states executed so far.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+pace_start(
+    uint64_t                    t_states
+    )
+{
+    //  Take a new origin
+    machine->pace_hz = pace_target( );
+    machine->pace_origin_ns = pace_now( );
+    machine->pace_origin_states = t_states;
+
+    //  Is the clock unlimited ?
+    if ( machine->pace_hz == PACE_CLOCK_UNLIMITED )
+    {
+        //  YES:    PACE( ) never calls back
+        machine->pace_due = UINT64_MAX;
+    }
+    else
+    {
+        //  NO:     Check again after one slice
+        machine->pace_due = t_states + ( machine->pace_hz / PACE_SLICES );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Hold the emulator back until the host clock catches up with the guest.
+ *
+ *  @param  t_states            Clock states executed so far.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called by PACE( ) once per slice.
+ *
+ ****************************************************************************/
+
+void
+pace_sync(
+    uint64_t                    t_states
+    )
+{
+    /**
+     *  @param  elapsed         States executed since the origin            */
+    uint64_t                    elapsed;
+    /**
+     *  @param  seconds         Whole seconds of guest time in elapsed      */
+    uint64_t                    seconds;
+    /**
+     *  @param  deadline_ns     Host time the guest has run up to           */
+    uint64_t                    deadline_ns;
+    /**
+     *  @param  now_ns          Current host time                           */
+    uint64_t                    now_ns;
+    /**
+     *  @param  deadline        deadline_ns for clock_nanosleep( )          */
+    struct timespec             deadline;
+
+    //  Did the target clock change ( or was pacing never started ) ?
+    if (    ( machine->pace_hz != pace_target( ) )
+         || ( machine->pace_hz == PACE_CLOCK_UNLIMITED ) )
+    {
+        //  YES:    Start over at the new clock
+        pace_start( t_states );
+        return;
+    }
+
+    //  Move whole seconds into the origin to keep the arithmetic in range
+    elapsed = t_states - machine->pace_origin_states;
+    seconds = elapsed / machine->pace_hz;
+    machine->pace_origin_states += ( seconds * machine->pace_hz );
+    machine->pace_origin_ns += ( seconds * NS_PER_SECOND );
+    elapsed -= ( seconds * machine->pace_hz );
+
+    //  When should the host clock read for this many states ?
+    deadline_ns = machine->pace_origin_ns
+                + ( ( elapsed * NS_PER_SECOND ) / machine->pace_hz );
+    now_ns = pace_now( );
+
+    //  Is the emulator ahead of the guest clock ?
+    if ( deadline_ns > now_ns )
+    {
+        //  YES:    Sleep until the guest clock catches up
+        deadline.tv_sec = deadline_ns / NS_PER_SECOND;
+        deadline.tv_nsec = deadline_ns % NS_PER_SECOND;
+        while( clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME,
+                                &deadline, NULL ) == EINTR );
+    }
+    else if ( ( now_ns - deadline_ns ) > PACE_SLIP_NS )
+    {
+        //  Too far behind to catch up, start over from here
+        pace_start( t_states );
+        return;
+    }
+
+    //  Check again after one slice
+    machine->pace_due = t_states + ( machine->pace_hz / PACE_SLICES );
+}
+
+/****************************************************************************/
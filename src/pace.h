@@ -0,0 +1,97 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+#ifndef PACE_H
+#define PACE_H
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Real-time pacing of the guest clock.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * System APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Application APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  PACE                Called with the running clock state count
+ *                              after every instruction ( or block ).  Only
+ *                              a compare until a slice is used up.         */
+#define PACE( T_STATES )        if ( ( T_STATES ) >= machine->pace_due )    \
+                                    pace_sync( T_STATES )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Prototypes
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+void
+pace_clock(
+    uint32_t                    clock_hz
+    );
+//----------------------------------------------------------------------------
+void
+pace_start(
+    uint64_t                    t_states
+    );
+//----------------------------------------------------------------------------
+void
+pace_sync(
+    uint64_t                    t_states
+    );
+//----------------------------------------------------------------------------
+
+/****************************************************************************/
+
+#endif                      //    PACE_H
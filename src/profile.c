@@ -0,0 +1,711 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Guest hot-spot profiler.
+ *
+ *  Built with -DPROFILE_ENABLE=1 the table engine counts every instruction
+ *  it executes:
+ *
+ *      profile_pc      Executions of each guest address
+ *      profile_states  Clock states spent at each guest address
+ *      profile_op      Executions of each op-code in each op-code table
+ *      profile_pair    Executions of each pair of consecutive op-codes
+ *
+ *  CALL, RST and RET drive a shadow call stack.  Every distinct stack is a
+ *  node of a call tree and the clock states of each instruction are added
+ *  to the node that was current when it ran.  Guest code that leaves a
+ *  subroutine without a RET ( popping the return address, etc. ) leaves
+ *  the shadow stack deeper than the real one; the extra levels simply show
+ *  up in the call tree.
+ *
+ *  At exit two files are written to the current directory: PROFILE_REPORT,
+ *  the hot addresses, op-codes and op-code pairs sorted by cost, and
+ *  PROFILE_FOLDED, one "caller;callee;... states" line per call stack that
+ *  flame graph tools read directly.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <inttypes.h>           //  PRIu64
+#include <stdlib.h>             //  ANSI standard library.
+#include <stdio.h>              //  Standard I/O definitions
+#include <string.h>             //  Functions for managing strings
+                                //*******************************************
+
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "memory.h"             //  Memory management and access
+#include "registers.h"          //  All things CPU registers.
+#include "disassemble.h"        //  Disassembler
+#include "profile.h"            //  Guest hot-spot profiler
+#include "machine.h"            //  Guest machine context
+                                //*******************************************
+
+#if PROFILE_ENABLE
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  PROFILE_NODES       Maximum number of call tree nodes           */
+#define PROFILE_NODES           ( 0x10000 )
+//----------------------------------------------------------------------------
+/**
+ *  @param  PROFILE_TOP_PC      Addresses listed in the report              */
+#define PROFILE_TOP_PC          ( 256 )
+//----------------------------------------------------------------------------
+/**
+ *  @param  PROFILE_TOP_PAIR    Op-code pairs listed in the report          */
+#define PROFILE_TOP_PAIR        ( 64 )
+//----------------------------------------------------------------------------
+/**
+ *  @param  PROFILE_ROOT        Call tree node for code outside any CALL    */
+#define PROFILE_ROOT            ( 0 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  profile_node_t      One call stack                              */
+struct  profile_node_t
+{
+    /**
+     *  @param  address         Address of the subroutine called            */
+    uint16_t                    address;
+    /**
+     *  @param  parent          Node of the caller                          */
+    uint32_t                    parent;
+    /**
+     *  @param  child           First subroutine called from here           */
+    uint32_t                    child;
+    /**
+     *  @param  sibling         Next subroutine called by the same caller   */
+    uint32_t                    sibling;
+    /**
+     *  @param  states          Clock states spent in the subroutine itself */
+    uint64_t                    states;
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  profile_op          Executions of every op-code by table        */
+uint64_t                        profile_op[ PROFILE_TABLES ][ 0x100 ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  profile_pc          Executions of every guest address           */
+static
+uint64_t                        profile_pc[ 0x10000 ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  profile_states      Clock states spent at every guest address   */
+static
+uint64_t                        profile_states[ 0x10000 ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  profile_pair        Executions of every op-code pair            */
+static
+uint64_t                        profile_pair[ 0x10000 ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  profile_last        Op-code of the previous instruction         */
+static
+uint8_t                         profile_last;
+//----------------------------------------------------------------------------
+/**
+ *  @param  profile_node        The call tree                               */
+static
+struct  profile_node_t          profile_node[ PROFILE_NODES ];
+//----------------------------------------------------------------------------
+/**
+ *  @param  node_count          Call tree nodes in use                      */
+static
+uint32_t                        node_count;
+//----------------------------------------------------------------------------
+/**
+ *  @param  node_current        Node of the code that is running            */
+static
+uint32_t                        node_current;
+//----------------------------------------------------------------------------
+/**
+ *  @param  node_lost           Calls not entered because the tree is full  */
+static
+uint32_t                        node_lost;
+//----------------------------------------------------------------------------
+/**
+ *  @param  table_name          Names of the op-code tables                 */
+static
+const
+char                        *   table_name[ PROFILE_TABLES ] =
+{
+    "i80", "z80", "CB", "DD", "DDCB", "ED", "FD", "FDCB"
+};
+//----------------------------------------------------------------------------
+/**
+ *  @param  sort_key            Counters qsort( ) compares by               */
+static
+const
+uint64_t                    *   sort_key;
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  qsort( ) compare function, largest sort_key[ ] first.
+ *
+ *  @param  left                First index
+ *  @param  right               Second index
+ *
+ *  @return                     <0, 0, >0 like strcmp( ).
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+int
+profile_compare(
+    const
+    void                    *   left,
+    const
+    void                    *   right
+    )
+{
+    /**
+     *  @param  key_l           Counter of the first index                  */
+    uint64_t                    key_l;
+    /**
+     *  @param  key_r           Counter of the second index                 */
+    uint64_t                    key_r;
+
+    key_l = sort_key[ *(const uint32_t *)left ];
+    key_r = sort_key[ *(const uint32_t *)right ];
+
+    return( ( key_l < key_r ) - ( key_l > key_r ) );
+}
+
+/****************************************************************************/
+/**
+ *  List the non zero counters, largest first.
+ *
+ *  @param  counter             The counters
+ *  @param  count               Number of counters
+ *  @param  order               Receives the indexes of the non zero ones
+ *
+ *  @return                     Number of indexes in order[ ].
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+uint32_t
+profile_sort(
+    const
+    uint64_t                *   counter,
+    uint32_t                    count,
+    uint32_t                *   order
+    )
+{
+    /**
+     *  @param  ndx             Index into the counters                     */
+    uint32_t                    ndx;
+    /**
+     *  @param  used            Number of non zero counters                 */
+    uint32_t                    used;
+
+    for( ndx = 0, used = 0; ndx < count; ndx += 1 )
+    {
+        if ( counter[ ndx ] != 0 )
+        {
+            order[ used++ ] = ndx;
+        }
+    }
+
+    sort_key = counter;
+    qsort( order, used, sizeof( order[ 0 ] ), profile_compare );
+
+    return( used );
+}
+
+/****************************************************************************/
+/**
+ *  Mnemonic of the instruction at an address.
+ *
+ *  @param  pc                  Address of the instruction
+ *  @param  mnemonic            DISASSEMBLE_SIZE byte buffer
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Prefixed instructions that are not decoded show their bytes.
+ *
+ ****************************************************************************/
+
+static
+void
+profile_mnemonic(
+    uint16_t                    pc,
+    char                    *   mnemonic
+    )
+{
+    /**
+     *  @param  op_code         First byte of the instruction               */
+    uint8_t                     op_code;
+
+    op_code = memory_get_8( pc );
+
+    //  Is it a base instruction ?
+    if ( disassemble_mnemonic( EIS_BASE, op_code, mnemonic ) != 0 )
+    {
+        //  YES:    Done
+        return;
+    }
+
+    //  Is it an 'ED' instruction ?
+    if (    ( op_code == 0xED )
+         && ( disassemble_mnemonic( EIS_ED, memory_get_8( pc + 1 ), mnemonic ) != 0 ) )
+    {
+        //  YES:    Done
+        return;
+    }
+
+    //  Show the prefix and op-code
+    snprintf( mnemonic, DISASSEMBLE_SIZE, "%02X %02X",
+              op_code, memory_get_8( pc + 1 ) );
+}
+
+/****************************************************************************/
+/**
+ *  Write the sorted hot-spot report.
+ *
+ *  @param  file                Where to write it
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+void
+profile_report_hot(
+    FILE                    *   file
+    )
+{
+    /**
+     *  @param  order           Indexes sorted by cost                      */
+    static
+    uint32_t                    order[ 0x10000 ];
+    /**
+     *  @param  used            Number of entries in order[ ]               */
+    uint32_t                    used;
+    /**
+     *  @param  ndx             Index into order[ ]                         */
+    uint32_t                    ndx;
+    /**
+     *  @param  table           Op-code table being listed                  */
+    int                         table;
+    /**
+     *  @param  total_inst      Instructions executed                       */
+    uint64_t                    total_inst;
+    /**
+     *  @param  total_states    Clock states executed                       */
+    uint64_t                    total_states;
+    /**
+     *  @param  mnemonic        Instruction mnemonic                        */
+    char                        mnemonic[ DISASSEMBLE_SIZE ];
+    /**
+     *  @param  mnemonic_2      Mnemonic of the second of a pair            */
+    char                        mnemonic_2[ DISASSEMBLE_SIZE ];
+
+    //  Totals for the percentages
+    for( ndx = 0, total_inst = 0, total_states = 0; ndx < 0x10000; ndx += 1 )
+    {
+        total_inst   += profile_pc[ ndx ];
+        total_states += profile_states[ ndx ];
+    }
+    if ( total_inst == 0 )   total_inst = 1;
+    if ( total_states == 0 ) total_states = 1;
+
+    fprintf( file, "Instructions: %"PRIu64"  T-states: %"PRIu64"\n\n",
+             total_inst, total_states );
+
+    /************************************************************************
+     *  Addresses by clock states
+     ************************************************************************/
+
+    fprintf( file, "%-4s  %16s  %16s  %6s  %s\n",
+             "ADDR", "COUNT", "T-STATES", "%", "MNEMONIC" );
+
+    used = profile_sort( profile_states, 0x10000, order );
+    for( ndx = 0; ndx < used && ndx < PROFILE_TOP_PC; ndx += 1 )
+    {
+        profile_mnemonic( (uint16_t)order[ ndx ], mnemonic );
+        fprintf( file, "%04X  %16"PRIu64"  %16"PRIu64"  %6.2f  %s\n",
+                 order[ ndx ],
+                 profile_pc[ order[ ndx ] ],
+                 profile_states[ order[ ndx ] ],
+                 100.0 * profile_states[ order[ ndx ] ] / total_states,
+                 mnemonic );
+    }
+
+    /************************************************************************
+     *  Op-codes by table
+     ************************************************************************/
+
+    for( table = 0; table < PROFILE_TABLES; table += 1 )
+    {
+        used = profile_sort( profile_op[ table ], 0x100, order );
+        if ( used == 0 )
+        {
+            continue;
+        }
+
+        fprintf( file, "\nOP-CODES ( %s )\n%-2s  %16s  %6s  %s\n",
+                 table_name[ table ], "OP", "COUNT", "%", "MNEMONIC" );
+
+        for( ndx = 0; ndx < used; ndx += 1 )
+        {
+            //  Only the base and 'ED' tables have mnemonics
+            if ( table <= PROFILE_Z80 )
+                disassemble_mnemonic( EIS_BASE, (uint8_t)order[ ndx ], mnemonic );
+            else
+            if ( table == PROFILE_ED )
+                disassemble_mnemonic( EIS_ED, (uint8_t)order[ ndx ], mnemonic );
+            else
+                mnemonic[ 0 ] = '\0';
+
+            fprintf( file, "%02X  %16"PRIu64"  %6.2f  %s\n",
+                     order[ ndx ],
+                     profile_op[ table ][ order[ ndx ] ],
+                     100.0 * profile_op[ table ][ order[ ndx ] ] / total_inst,
+                     mnemonic );
+        }
+    }
+
+    /************************************************************************
+     *  Op-code pairs
+     ************************************************************************/
+
+    fprintf( file, "\nOP-CODE PAIRS\n%-5s  %16s  %6s  %s\n",
+             "OP OP", "COUNT", "%", "MNEMONICS" );
+
+    used = profile_sort( profile_pair, 0x10000, order );
+    for( ndx = 0; ndx < used && ndx < PROFILE_TOP_PAIR; ndx += 1 )
+    {
+        disassemble_mnemonic( EIS_BASE, (uint8_t)( order[ ndx ] >> 8 ), mnemonic );
+        disassemble_mnemonic( EIS_BASE, (uint8_t)order[ ndx ], mnemonic_2 );
+        fprintf( file, "%02X %02X  %16"PRIu64"  %6.2f  %s; %s\n",
+                 order[ ndx ] >> 8, order[ ndx ] & 0xFF,
+                 profile_pair[ order[ ndx ] ],
+                 100.0 * profile_pair[ order[ ndx ] ] / total_inst,
+                 mnemonic, mnemonic_2 );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Write the call tree as folded stacks.
+ *
+ *  @param  file                Where to write it
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      One line per call stack: the subroutine addresses from the outermost
+ *      in, separated by ';', and the clock states spent in the innermost.
+ *
+ ****************************************************************************/
+
+static
+void
+profile_report_folded(
+    FILE                    *   file
+    )
+{
+    /**
+     *  @param  path            Nodes from the innermost out                */
+    static
+    uint32_t                    path[ PROFILE_NODES ];
+    /**
+     *  @param  depth           Number of nodes in path[ ]                  */
+    uint32_t                    depth;
+    /**
+     *  @param  node            Node being written                          */
+    uint32_t                    node;
+
+    for( node = 0; node < node_count; node += 1 )
+    {
+        //  Only stacks that ran code of their own
+        if ( profile_node[ node ].states == 0 )
+        {
+            continue;
+        }
+
+        //  Walk up to the root
+        depth = 0;
+        path[ depth++ ] = node;
+        while( path[ depth - 1 ] != PROFILE_ROOT )
+        {
+            path[ depth ] = profile_node[ path[ depth - 1 ] ].parent;
+            depth += 1;
+        }
+
+        //  Write it outermost first
+        while( depth > 0 )
+        {
+            depth -= 1;
+            fprintf( file, "%04X%c", profile_node[ path[ depth ] ].address,
+                     ( depth == 0 ) ? ' ' : ';' );
+        }
+        fprintf( file, "%"PRIu64"\n", profile_node[ node ].states );
+    }
+}
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Clear the counters at the start of a run.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The report is written when the program exits.
+ *
+ ****************************************************************************/
+
+void
+profile_start(
+    void
+    )
+{
+    /**
+     *  @param  registered      profile_report( ) is called at exit         */
+    static
+    bool                        registered;
+
+    memset( profile_op, 0, sizeof( profile_op ) );
+    memset( profile_pc, 0, sizeof( profile_pc ) );
+    memset( profile_states, 0, sizeof( profile_states ) );
+    memset( profile_pair, 0, sizeof( profile_pair ) );
+    profile_last = 0;
+
+    //  Start a call tree at the current Program Counter
+    memset( &profile_node[ PROFILE_ROOT ], 0, sizeof( profile_node[ 0 ] ) );
+    profile_node[ PROFILE_ROOT ].address = CPU_REG_PC;
+    node_count = 1;
+    node_current = PROFILE_ROOT;
+    node_lost = 0;
+
+    //  Write the report however the program ends
+    if ( registered == false )
+    {
+        atexit( profile_report );
+        registered = true;
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Count an executed instruction.
+ *
+ *  @param  pc                  Address of the instruction
+ *  @param  op_code             First byte of the instruction
+ *  @param  states              Clock states it took
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+profile_inst(
+    uint16_t                    pc,
+    uint8_t                     op_code,
+    int                         states
+    )
+{
+    profile_pc[ pc ] += 1;
+    profile_states[ pc ] += states;
+    profile_pair[ ( profile_last << 8 ) | op_code ] += 1;
+    profile_last = op_code;
+
+    //  Charge the states to the running subroutine
+    profile_node[ node_current ].states += states;
+}
+
+/****************************************************************************/
+/**
+ *  Enter a subroutine on the shadow call stack.
+ *
+ *  @param  address             Address of the subroutine
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called by CALL and RST after the return address was pushed.
+ *
+ ****************************************************************************/
+
+void
+profile_call(
+    uint16_t                    address
+    )
+{
+    /**
+     *  @param  node            Child of the current node                   */
+    uint32_t                    node;
+
+    //  Has the subroutine been called from here before ?
+    for( node = profile_node[ node_current ].child;
+         node != PROFILE_ROOT;
+         node = profile_node[ node ].sibling )
+    {
+        if ( profile_node[ node ].address == address )
+        {
+            //  YES:    It's the new current node
+            node_current = node;
+            return;
+        }
+    }
+
+    //  Is the call tree full ?
+    if ( node_count == PROFILE_NODES )
+    {
+        //  YES:    Charge it to the caller
+        node_lost += 1;
+        return;
+    }
+
+    //  Add it to the tree
+    node = node_count++;
+    profile_node[ node ].address = address;
+    profile_node[ node ].parent = node_current;
+    profile_node[ node ].child = PROFILE_ROOT;
+    profile_node[ node ].sibling = profile_node[ node_current ].child;
+    profile_node[ node ].states = 0;
+    profile_node[ node_current ].child = node;
+    node_current = node;
+}
+
+/****************************************************************************/
+/**
+ *  Leave a subroutine on the shadow call stack.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      A RET with nothing on the shadow stack stays at the root.
+ *
+ ****************************************************************************/
+
+void
+profile_ret(
+    void
+    )
+{
+    //  Was the matching call charged to the caller ?
+    if ( node_lost != 0 )
+    {
+        //  YES:    Nothing to leave
+        node_lost -= 1;
+    }
+    else
+    if ( node_current != PROFILE_ROOT )
+    {
+        //  Back to the caller
+        node_current = profile_node[ node_current ].parent;
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Write PROFILE_REPORT and PROFILE_FOLDED.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Registered with atexit( ) by profile_start( ).
+ *
+ ****************************************************************************/
+
+void
+profile_report(
+    void
+    )
+{
+    /**
+     *  @param  file            Report file                                 */
+    FILE                    *   file;
+
+    //  The sorted report
+    if ( ( file = fopen( PROFILE_REPORT, "w" ) ) != NULL )
+    {
+        profile_report_hot( file );
+        fclose( file );
+    }
+
+    //  The folded call stacks
+    if ( ( file = fopen( PROFILE_FOLDED, "w" ) ) != NULL )
+    {
+        profile_report_folded( file );
+        fclose( file );
+    }
+}
+
+/****************************************************************************/
+
+#endif                          //  PROFILE_ENABLE
@@ -0,0 +1,149 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Guest hot-spot profiler.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * System APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Application APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  PROFILE_OP          Count an op-code in one of the tables
+ *  @param  PROFILE_INST        Count an executed instruction
+ *  @param  PROFILE_CALL        A subroutine was entered
+ *  @param  PROFILE_RET         A subroutine returned
+ *  @note   Nothing is generated unless PROFILE_ENABLE is set.              */
+#if PROFILE_ENABLE
+#define PROFILE_OP( TABLE, OP_CODE )                                        \
+                                profile_op[ TABLE ][ OP_CODE ] += 1
+#define PROFILE_INST( PC, OP_CODE, STATES )                                 \
+                                profile_inst( PC, OP_CODE, STATES )
+#define PROFILE_CALL( ADDRESS ) profile_call( ADDRESS )
+#define PROFILE_RET( )          profile_ret( )
+#else
+#define PROFILE_OP( TABLE, OP_CODE )
+#define PROFILE_INST( PC, OP_CODE, STATES )
+#define PROFILE_CALL( ADDRESS )
+#define PROFILE_RET( )
+#endif
+//----------------------------------------------------------------------------
+/**
+ *  @param  PROFILE_REPORT      Sorted hot-spot report written at exit      */
+#define PROFILE_REPORT          "i80-emul.profile"
+//----------------------------------------------------------------------------
+/**
+ *  @param  PROFILE_FOLDED      Folded call stacks ( for flame graphs )     */
+#define PROFILE_FOLDED          "i80-emul.folded"
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  profile_table_e     Op-code tables that are counted             */
+enum    profile_table_e
+{
+    PROFILE_I80             = 0,                //  Intel 8080
+    PROFILE_Z80             = 1,                //  Zilog Z80
+    PROFILE_CB              = 2,                //  Z80 CB
+    PROFILE_DD              = 3,                //  Z80 DD
+    PROFILE_DDCB            = 4,                //  Z80 DD CB
+    PROFILE_ED              = 5,                //  Z80 ED
+    PROFILE_FD              = 6,                //  Z80 FD
+    PROFILE_FDCB            = 7,                //  Z80 FD CB
+    PROFILE_TABLES          = 8                 //  Number of tables
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  profile_op          Executions of every op-code by table        */
+extern
+uint64_t                        profile_op[ PROFILE_TABLES ][ 0x100 ];
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Prototypes
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+void
+profile_start(
+    void
+    );
+//----------------------------------------------------------------------------
+void
+profile_inst(
+    uint16_t                    pc,
+    uint8_t                     op_code,
+    int                         states
+    );
+//----------------------------------------------------------------------------
+void
+profile_call(
+    uint16_t                    address
+    );
+//----------------------------------------------------------------------------
+void
+profile_ret(
+    void
+    );
+//----------------------------------------------------------------------------
+void
+profile_report(
+    void
+    );
+//----------------------------------------------------------------------------
+
+/****************************************************************************/
+
+#endif                      //    PROFILE_H
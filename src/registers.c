@@ -38,6 +38,9 @@
 #include "global.h"             //  Global definitions
 #include "memory.h"             //  Memory management and access
 #include "registers.h"          //  All things CPU registers.
+#include "flags.h"              //  Precomputed condition flag tables
+#include "stats.h"              //  Performance counters
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -66,6 +69,21 @@
  ****************************************************************************/
 
 //----------------------------------------------------------------------------
+/**
+ *  @param  cpu_reg_r           Offset of the register for each 'rrr' code
+ *                              in cpu_regs_t ( see REG_R )                 */
+const
+uint8_t                         cpu_reg_r[ 8 ] =
+{
+    offsetof( struct cpu_regs_t, bc.b.h ),  //  R_B
+    offsetof( struct cpu_regs_t, bc.b.l ),  //  R_C
+    offsetof( struct cpu_regs_t, de.b.h ),  //  R_D
+    offsetof( struct cpu_regs_t, de.b.l ),  //  R_E
+    offsetof( struct cpu_regs_t, hl.b.h ),  //  R_H
+    offsetof( struct cpu_regs_t, hl.b.l ),  //  R_L
+    offsetof( struct cpu_regs_t, hl_p ),    //  R_HL_p  ( not a register )
+    offsetof( struct cpu_regs_t, af.b.h )   //  R_A
+};
 //----------------------------------------------------------------------------
 
 /****************************************************************************
@@ -79,6 +97,67 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************/
+/**
+ *  Count the M1 ( op-code fetch ) cycles of the instructions retired.
+ *
+ *  @param
+ *
+ *  @return                     M1 cycles up to the last instruction retired.
+ *
+ *  @note
+ *      Valid between instructions, after the instruction loops published
+ *      the instructions retired.
+ *
+ ****************************************************************************/
+
+static
+uint64_t
+refresh_retired(
+    void
+    )
+{
+    /**
+     *  @param  m1              M1 cycles                                   */
+    uint64_t                    m1;
+
+    m1  = machine->stats.instructions;
+    m1 += machine->stats.prefix[ STATS_PREFIX_CB ];
+    m1 += machine->stats.prefix[ STATS_PREFIX_DD ];
+    m1 += machine->stats.prefix[ STATS_PREFIX_ED ];
+    m1 += machine->stats.prefix[ STATS_PREFIX_FD ];
+
+    //  DONE!
+    return( m1 );
+}
+
+/****************************************************************************/
+/**
+ *  Count the M1 ( op-code fetch ) cycles of the run so far.
+ *
+ *  @param
+ *
+ *  @return                     M1 cycles up to and including the current
+ *                              instruction.
+ *
+ *  @note
+ *      Only valid while an op-code handler runs, or after the handler that
+ *      ended the run.  The instruction loops publish the instructions
+ *      retired before the current one, the prefix fetch functions count
+ *      their own M1 cycle, and the current op-code adds one more.
+ *
+ ****************************************************************************/
+
+static
+uint64_t
+refresh_count(
+    void
+    )
+{
+    //  DONE!
+    return( refresh_retired( ) + 1 );
+}
+
 
 /****************************************************************************
  * MAIN
@@ -101,36 +180,8 @@ reg_get_sr(
     uint8_t                     op_code
     )
 {
-    /**
-     *  @param  data            Register contents                           */
-    uint8_t                     data;
-
-    //  Mask for the source register
-    switch( op_code & 0x07 )
-    {
-        case    R_B:            //  Source register B
-            data = GET_B( );
-            break;
-        case    R_C:            //  Source register C
-            data = GET_C( );
-            break;
-        case    R_D:            //  Source register D
-            data = GET_D( );
-            break;
-        case    R_E:            //  Source register E
-            data = GET_E( );
-            break;
-        case    R_H:            //  Source register H
-            data = GET_H( );
-            break;
-        case    R_L:            //  Source register L
-            data = GET_L( );
-            break;
-        case    R_A:            //  Source register A
-            data = GET_A( );
-            break;
-    }
-    return( data );
+    //  One load through the register table
+    return( REG_R( op_code & 0x07 ) );
 }
 
 /****************************************************************************/
@@ -150,36 +201,8 @@ reg_get_dr(
     uint8_t                     op_code
     )
 {
-    /**
-     *  @param  data            Register contents                           */
-    uint8_t                     data;
-
-    //  Mask for the destination register
-    switch( ( op_code & 0x38 ) >> 3 )
-    {
-        case    R_B:            //  Source register B
-            data = GET_B( );
-            break;
-        case    R_C:            //  Source register C
-            data = GET_C( );
-            break;
-        case    R_D:            //  Source register D
-            data = GET_D( );
-            break;
-        case    R_E:            //  Source register E
-            data = GET_E( );
-            break;
-        case    R_H:            //  Source register H
-            data = GET_H( );
-            break;
-        case    R_L:            //  Source register L
-            data = GET_L( );
-            break;
-        case    R_A:            //  Source register A
-            data = GET_A( );
-            break;
-    }
-    return( data );
+    //  One load through the register table
+    return( REG_R( ( op_code & 0x38 ) >> 3 ) );
 }
 
 /****************************************************************************/
@@ -201,31 +224,8 @@ reg_put_dr(
     uint8_t                     data
     )
 {
-    //  Mask for the destination register
-    switch( ( op_code & 0x38 ) >> 3 )
-    {
-        case    R_B:            //  Destination register B
-            PUT_B( data );
-            break;
-        case    R_C:            //  Destination register C
-            PUT_C( data );
-            break;
-        case    R_D:            //  Destination register D
-            PUT_D( data );
-            break;
-        case    R_E:            //  Destination register E
-            PUT_E( data );
-            break;
-        case    R_H:            //  Destination register H
-            PUT_H( data );
-            break;
-        case    R_L:            //  Destination register L
-            PUT_L( data );
-            break;
-        case    R_A:            //  Destination register A
-            PUT_A( data );
-            break;
-    }
+    //  One store through the register table
+    REG_R( ( op_code & 0x38 ) >> 3 ) = data;
 }
 
 /****************************************************************************/
@@ -354,6 +354,7 @@ reg_get_qq(
             data = CPU_REG_HL;
             break;
         case    QQ_AF:          //  Source register pair AF
+            FLAGS_SYNC( );
             data = CPU_REG_AF;
             break;
     }
@@ -397,8 +398,281 @@ reg_put_qq(
             CPU_REG_HL = data;
             break;
         case    QQ_AF:          //  Source register pair AF
+            machine->flags_lazy.op = FLAGS_OP_NONE;
             CPU_REG_AF = data;
             break;
     }
 }
-/****************************************************************************/
\ No newline at end of file
+
+/****************************************************************************/
+/**
+ *  Bring F up to date with the last recorded ALU operation.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The flags come from the tables built by flags_init( ), they are the
+ *      same as add_8( ), sub_8( ), inc_8( ), dec_8( ), and_8( ), or_8( ),
+ *      xor_8( ) and compare_8( ) used to set when they were called.
+ *
+ ****************************************************************************/
+
+void
+flags_sync(
+    void
+    )
+{
+    /**
+     *  @param  flags           The new flags                               */
+    uint8_t                     flags;
+    /**
+     *  @param  mode            Table row of the recorded CPU mode          */
+    int                         mode;
+
+    /************************************************************************
+     *  Function Initialization
+     ************************************************************************/
+
+    //  Is there anything to do ?
+    if ( machine->flags_lazy.op == FLAGS_OP_NONE )
+        return;
+
+    //  out_n_i80( ) syncs before it changes the CPU mode
+    mode = FLAGS_MODE( CPU );
+
+    /************************************************************************
+     *  Function Code
+     ************************************************************************/
+
+    switch( machine->flags_lazy.op )
+    {
+        case    FLAGS_OP_ADD:
+            flags = flags_add[ mode ][ FLAGS_INDEX( machine->flags_lazy.carry,
+                                                    machine->flags_lazy.operand_1,
+                                                    machine->flags_lazy.operand_2 ) ];
+            break;
+
+        case    FLAGS_OP_SUB:
+            flags = flags_sub[ mode ][ FLAGS_INDEX( machine->flags_lazy.carry,
+                                                    machine->flags_lazy.operand_1,
+                                                    machine->flags_lazy.operand_2 ) ];
+            break;
+
+        case    FLAGS_OP_INC:
+            //  Carry is not effected, restore it in case it was never set.
+            flags = flags_inc[ mode ][ machine->flags_lazy.operand_1 & 0x00FF ]
+                  | ( machine->flags_lazy.carry != 0 ? CPU_FLAG_C : 0 );
+            break;
+
+        case    FLAGS_OP_DEC:
+            //  Carry is not effected, restore it in case it was never set.
+            flags = flags_dec[ mode ][ machine->flags_lazy.operand_1 & 0x00FF ]
+                  | ( machine->flags_lazy.carry != 0 ? CPU_FLAG_C : 0 );
+            break;
+
+        default:
+            //  AND, OR, XOR clear C, N and H
+            flags = flags_szp[ machine->flags_lazy.result & 0x00FF ];
+            break;
+    }
+
+    //  Done with the operation
+    machine->flags_lazy.op = FLAGS_OP_NONE;
+    CPU_REG_AF = ( CPU_REG_AF & ( 0xFF00 | FLAGS_KEEP ) ) | flags;
+
+    /************************************************************************
+     *  Function Exit
+     ************************************************************************/
+
+}
+
+/****************************************************************************/
+/**
+ *  Read some of the flags.
+ *
+ *  @param  mask                CPU_FLAG_xx bits that are wanted
+ *
+ *  @return                     F & mask
+ *
+ *  @note
+ *      Z, S and C come straight from the recorded operation, anything else
+ *      brings all of F up to date first.
+ *
+ ****************************************************************************/
+
+uint8_t
+flags_get(
+    uint8_t                     mask
+    )
+{
+    /**
+     *  @param  flags           The flags                                   */
+    uint8_t                     flags;
+
+    //  Is there an operation that needs more than Z, S or C ?
+    if (    ( machine->flags_lazy.op == FLAGS_OP_NONE )
+         || ( ( mask & ~( CPU_FLAG_Z | CPU_FLAG_S | CPU_FLAG_C ) ) != 0 ) )
+    {
+        //  YES:    Use F
+        FLAGS_SYNC( );
+        return( CPU_REG_AF & mask );
+    }
+
+    //  ZERO
+    flags = ( ( machine->flags_lazy.result & 0x00FF ) == 0 ) ? CPU_FLAG_Z : 0;
+
+    //  SIGN
+    flags |= ( machine->flags_lazy.result & 0x0080 ) ? CPU_FLAG_S : 0;
+
+    //  Carry
+    switch( machine->flags_lazy.op )
+    {
+        case    FLAGS_OP_ADD:
+        case    FLAGS_OP_SUB:
+            flags |= ( machine->flags_lazy.result & 0x0100 ) ? CPU_FLAG_C : 0;
+            break;
+        case    FLAGS_OP_INC:
+        case    FLAGS_OP_DEC:
+            flags |= ( machine->flags_lazy.carry != 0 ) ? CPU_FLAG_C : 0;
+            break;
+        default:
+            break;
+    }
+
+    //  DONE!
+    return( flags & mask );
+}
+
+/****************************************************************************/
+/**
+ *  Read the Memory Refresh register.
+ *
+ *  @param
+ *
+ *  @return                     The value of R.
+ *
+ *  @note
+ *      The lower seven bits advance once for every M1 cycle since R was
+ *      stored, bit 7 only changes when R is loaded.
+ *
+ ****************************************************************************/
+
+uint8_t
+refresh_get(
+    void
+    )
+{
+    /**
+     *  @param  advance         M1 cycles since R was stored                */
+    uint8_t                     advance;
+
+    advance = (uint8_t)( refresh_count( ) - machine->refresh_m1 );
+
+    //  DONE!
+    return( ( ( CPU_REG_R + advance ) & 0x7F ) | ( CPU_REG_R & 0x80 ) );
+}
+
+/****************************************************************************/
+/**
+ *  Load the Memory Refresh register.
+ *
+ *  @param  data                New value of R.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+refresh_put(
+    uint8_t                     data
+    )
+{
+    CPU_REG_R = data;
+    machine->refresh_m1 = refresh_count( );
+}
+
+/****************************************************************************/
+/**
+ *  Advance the Memory Refresh register.
+ *
+ *  @param  m1                  M1 cycles the instruction loops do not see.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      The repeating block instructions run every repeat in one call, each
+ *      repeat fetches ED and the op-code again.
+ *
+ ****************************************************************************/
+
+void
+refresh_advance(
+    uint32_t                    m1
+    )
+{
+    /**
+     *  @param  data            Current value of R                          */
+    uint8_t                     data;
+
+    data = refresh_get( );
+
+    refresh_put( ( ( data + (uint8_t)m1 ) & 0x7F ) | ( data & 0x80 ) );
+}
+
+/****************************************************************************/
+/**
+ *  Count the M1 cycle of an interrupt acknowledge.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called between instructions, where refresh_count( ) would already
+ *      include the instruction that has not been fetched yet.
+ *
+ ****************************************************************************/
+
+void
+refresh_acknowledge(
+    void
+    )
+{
+    /**
+     *  @param  data            Value of R after the last instruction       */
+    uint8_t                     data;
+
+    data  = CPU_REG_R;
+    data += (uint8_t)( refresh_retired( ) - machine->refresh_m1 );
+    data  = ( ( data + 1 ) & 0x7F ) | ( CPU_REG_R & 0x80 );
+
+    CPU_REG_R = data;
+    machine->refresh_m1 = refresh_retired( );
+}
+
+/****************************************************************************/
+/**
+ *  Leave the current value of R in CPU_REG_R.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called by the instruction loops when a run ends.
+ *
+ ****************************************************************************/
+
+void
+refresh_sync(
+    void
+    )
+{
+    refresh_put( refresh_get( ) );
+}
+
+/****************************************************************************/
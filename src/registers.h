@@ -116,29 +116,77 @@
 #define GET_HL_p( )             ( memory_get_8( CPU_REG_HL ) )
 #define PUT_HL_p( N )           ( memory_put_8( CPU_REG_HL, N ) )
 //----------------------------------------------------------------------------
-#define GET_A( )    ( ( CPU_REG_AF & 0xFF00 ) >> 8 )
-#define GET_F( )    ( ( CPU_REG_AF & 0x00FF )      )
+/*  F is brought up to date before it is read or modified                  */
+#define FLAGS_SYNC( )   ( ( machine->flags_lazy.op != FLAGS_OP_NONE ) ? flags_sync( ) : (void)0 )
 
-#define GET_B( )    ( ( CPU_REG_BC & 0xFF00 ) >> 8 )
-#define GET_C( )    ( ( CPU_REG_BC & 0x00FF )      )
+/*  Record an ALU operation instead of setting the flags                    */
+#if FLAGS_LAZY
+#define FLAGS_RECORD( OP, OPERAND_1, OPERAND_2, CARRY, RESULT )             \
+                        machine->flags_lazy.op        = ( OP );             \
+                        machine->flags_lazy.operand_1 = ( OPERAND_1 );      \
+                        machine->flags_lazy.operand_2 = ( OPERAND_2 );      \
+                        machine->flags_lazy.carry     = ( CARRY );          \
+                        machine->flags_lazy.result    = ( RESULT )
+#else
+#define FLAGS_RECORD( OP, OPERAND_1, OPERAND_2, CARRY, RESULT )             \
+                        machine->flags_lazy.op        = ( OP );             \
+                        machine->flags_lazy.operand_1 = ( OPERAND_1 );      \
+                        machine->flags_lazy.operand_2 = ( OPERAND_2 );      \
+                        machine->flags_lazy.carry     = ( CARRY );          \
+                        machine->flags_lazy.result    = ( RESULT );         \
+                        flags_sync( )
+#endif
 
-#define GET_D( )    ( ( CPU_REG_DE & 0xFF00 ) >> 8 )
-#define GET_E( )    ( ( CPU_REG_DE & 0x00FF )      )
+#define GET_A( )    ( machine->cpu_regs.af.b.h )
+#define GET_F( )    ( FLAGS_SYNC( ), machine->cpu_regs.af.b.l )
 
-#define GET_H( )    ( ( CPU_REG_HL & 0xFF00 ) >> 8 )
-#define GET_L( )    ( ( CPU_REG_HL & 0x00FF )      )
+#define GET_B( )    ( machine->cpu_regs.bc.b.h )
+#define GET_C( )    ( machine->cpu_regs.bc.b.l )
 
-#define PUT_A( X )  CPU_REG_AF = ( ( (uint16_t)X << 8 ) | ( CPU_REG_AF & 0x00FF ) )
-#define PUT_F( X )  CPU_REG_AF = ( ( CPU_REG_AF & 0xFF00 ) | X )
+#define GET_D( )    ( machine->cpu_regs.de.b.h )
+#define GET_E( )    ( machine->cpu_regs.de.b.l )
 
-#define PUT_B( X )  CPU_REG_BC = ( ( (uint16_t)X << 8 ) | ( CPU_REG_BC & 0x00FF ) )
-#define PUT_C( X )  CPU_REG_BC = ( ( CPU_REG_BC & 0xFF00 ) | X )
+#define GET_H( )    ( machine->cpu_regs.hl.b.h )
+#define GET_L( )    ( machine->cpu_regs.hl.b.l )
 
-#define PUT_D( X )  CPU_REG_DE = ( ( (uint16_t)X << 8 ) | ( CPU_REG_DE & 0x00FF ) )
-#define PUT_E( X )  CPU_REG_DE = ( ( CPU_REG_DE & 0xFF00 ) | X )
+#define PUT_A( X )  ( machine->cpu_regs.af.b.h = (uint8_t)( X ) )
+#define PUT_F( X )  ( FLAGS_SYNC( ), machine->cpu_regs.af.b.l = (uint8_t)( X ) )
 
-#define PUT_H( X )  CPU_REG_HL = ( ( (uint16_t)X << 8 ) | ( CPU_REG_HL & 0x00FF ) )
-#define PUT_L( X )  CPU_REG_HL = ( ( CPU_REG_HL & 0xFF00 ) | X )
+#define PUT_B( X )  ( machine->cpu_regs.bc.b.h = (uint8_t)( X ) )
+#define PUT_C( X )  ( machine->cpu_regs.bc.b.l = (uint8_t)( X ) )
+
+#define PUT_D( X )  ( machine->cpu_regs.de.b.h = (uint8_t)( X ) )
+#define PUT_E( X )  ( machine->cpu_regs.de.b.l = (uint8_t)( X ) )
+
+#define PUT_H( X )  ( machine->cpu_regs.hl.b.h = (uint8_t)( X ) )
+#define PUT_L( X )  ( machine->cpu_regs.hl.b.l = (uint8_t)( X ) )
+//----------------------------------------------------------------------------
+/*  X( R ) for every 8 bit register, X( D, S ) for every register with D    */
+#define REG_R_EACH( X )                                                     \
+            X( B ) X( C ) X( D ) X( E ) X( H ) X( L ) X( A )
+#define REG_R_EACH_2( X, TO )                                               \
+            X( TO, B ) X( TO, C ) X( TO, D ) X( TO, E ) X( TO, H ) X( TO, L ) X( TO, A )
+//----------------------------------------------------------------------------
+/*  8 bit register from the 'rrr' field of an op-code ( not R_HL_p )        */
+#define REG_R( R )  ( *( (uint8_t *)&machine->cpu_regs + cpu_reg_r[ ( R ) & 0x07 ] ) )
+//----------------------------------------------------------------------------
+/*      Main Register Set                                                   */
+#define CPU_REG_AF  ( machine->cpu_regs.af.w )
+#define CPU_REG_BC  ( machine->cpu_regs.bc.w )
+#define CPU_REG_DE  ( machine->cpu_regs.de.w )
+#define CPU_REG_HL  ( machine->cpu_regs.hl.w )
+/*      Alternate Register Set                                              */
+#define CPU_REG_AF_ ( machine->cpu_regs.af_ )
+#define CPU_REG_BC_ ( machine->cpu_regs.bc_ )
+#define CPU_REG_DE_ ( machine->cpu_regs.de_ )
+#define CPU_REG_HL_ ( machine->cpu_regs.hl_ )
+/*      Special Purpose Registers                                           */
+#define CPU_REG_PC  ( machine->cpu_regs.pc )
+#define CPU_REG_SP  ( machine->cpu_regs.sp )
+#define CPU_REG_IX  ( machine->cpu_regs.ix )
+#define CPU_REG_IY  ( machine->cpu_regs.iy )
+#define CPU_REG_I   ( machine->cpu_regs.i )
+#define CPU_REG_R   ( machine->cpu_regs.r )
 //----------------------------------------------------------------------------
 #define CLEAR_FLAG_C( )     PUT_F( GET_F( ) & CPU_FLAG_NOT_C )
 #define SET_FLAG_C( )       PUT_F( GET_F( ) | CPU_FLAG_C )
@@ -183,12 +231,105 @@ enum                        EIS_e
     EIS_FDCB                = 6                 //  Z80 FD ED
 };
 //----------------------------------------------------------------------------
+/**
+ *  @param  flags_op_e          ALU operation whose flags are not in F yet */
+enum                        flags_op_e
+{
+    FLAGS_OP_NONE           = 0,                //  F is up to date
+    FLAGS_OP_ADD            = 1,                //  add_8( )
+    FLAGS_OP_SUB            = 2,                //  sub_8( ), compare_8( )
+    FLAGS_OP_INC            = 3,                //  inc_8( )
+    FLAGS_OP_DEC            = 4,                //  dec_8( )
+    FLAGS_OP_LOGIC          = 5                 //  and_8( ), or_8( ), xor_8( )
+};
+//----------------------------------------------------------------------------
 
 /****************************************************************************
  * Structures
  ****************************************************************************/
 
 //----------------------------------------------------------------------------
+/**
+ *  @param  reg_pair_u          A register pair and its two 8 bit halves    */
+union   reg_pair_u
+{
+    /**
+     *  @param  w               The pair ( BC )                             */
+    uint16_t                    w;
+    /**
+     *  @param  b               The halves ( B is h, C is l )               */
+    struct
+    {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        uint8_t                 h;
+        uint8_t                 l;
+#else
+        uint8_t                 l;
+        uint8_t                 h;
+#endif
+    }                           b;
+};
+//----------------------------------------------------------------------------
+/**
+ *  @param  cpu_regs_t          The register file, in one cache line        */
+struct  cpu_regs_t
+{
+    /*      Main Register Set                                               */
+    _Alignas( 64 )
+    union   reg_pair_u          af;
+    union   reg_pair_u          bc;
+    union   reg_pair_u          de;
+    union   reg_pair_u          hl;
+    /*      Special Purpose Registers                                       */
+    /**
+     *  @param  pc              Program Counter                             */
+    uint16_t                    pc;
+    /**
+     *  @param  sp              Stack Pointer                               */
+    uint16_t                    sp;
+    /**
+     *  @param  ix              Index-X                                     */
+    uint16_t                    ix;
+    /**
+     *  @param  iy              Index-Y                                     */
+    uint16_t                    iy;
+    /*      Alternate Register Set                                          */
+    uint16_t                    af_;
+    uint16_t                    bc_;
+    uint16_t                    de_;
+    uint16_t                    hl_;
+    /**
+     *  @param  i               Interrupt                                   */
+    uint8_t                     i;
+    /**
+     *  @param  r               Refresh                                     */
+    uint8_t                     r;
+    /**
+     *  @param  hl_p            Stands in for (HL) in cpu_reg_r[ ]          */
+    uint8_t                     hl_p;
+};
+//----------------------------------------------------------------------------
+/**
+ *  @param  flags_lazy_t        The last ALU operation.  F is worked out from
+ *                              it only when something reads the flags.     */
+struct  flags_lazy_t
+{
+    /**
+     *  @param  op              enum flags_op_e                             */
+    uint8_t                     op;
+    /**
+     *  @param  operand_1       First operand (addend, minuend, number)     */
+    uint16_t                    operand_1;
+    /**
+     *  @param  operand_2       Second operand (augend, subtrahend)         */
+    uint16_t                    operand_2;
+    /**
+     *  @param  carry           Carry/borrow in, the old C for INC/DEC      */
+    uint16_t                    carry;
+    /**
+     *  @param  result          Result before it was truncated to 8 bits    */
+    uint16_t                    result;
+};
 //----------------------------------------------------------------------------
 
 /****************************************************************************
@@ -197,58 +338,12 @@ enum                        EIS_e
 
 
 //----------------------------------------------------------------------------
-//      CPU Execution Flags
-/**
- *  @param  Extended Instruction Set    (CB), (DD), (DE), (FD)              */
-enum    EIS_e               EIS;
-//----------------------------------------------------------------------------
-/*      Main Register Set                                                   */
-/**
- *  @param  CPU_REG_BC                                                      */
-uint16_t                    CPU_REG_AF;
-/**
- *  @param  CPU_REG_BC                                                      */
-uint16_t                    CPU_REG_BC;
-/**
- *  @param  CPU_REG_DE                                                      */
-uint16_t                    CPU_REG_DE;
 /**
- *  @param  CPU_REG_HL                                                      */
-uint16_t                    CPU_REG_HL;
-//----------------------------------------------------------------------------
-/*      Alternate Register Set                                              */
-/**
- *  @param  CPU_REG_AF_                                                     */
-uint16_t                    CPU_REG_AF_;
-/**
- *  @param  CPU_REG_BC_                                                     */
-uint16_t                    CPU_REG_BC_;
-/**
- *  @param  CPU_REG_DE_                                                     */
-uint16_t                    CPU_REG_DE_;
-/**
- *  @param  CPU_REG_HL_                                                     */
-uint16_t                    CPU_REG_HL_;
-//----------------------------------------------------------------------------
-/*      Special Purpose Registers                                           */
-/**
- *  @param  CPU_REG_PC          Program Counter                             */
-uint16_t                    CPU_REG_PC;
-/**
- *  @param  CPU_REG_SP          Stack Pointer                               */
-uint16_t                    CPU_REG_SP;
-/**
- *  @param  CPU_REG_IX          Index-X                                     */
-uint16_t                    CPU_REG_IX;
-/**
- *  @param  CPU_REG_IY          Index-Y                                     */
-uint16_t                    CPU_REG_IY;
-/**
- *  @param  CPU_REG_I           Interrupt                                   */
-uint8_t                     CPU_REG_I;
-/**
- *  @param  CPU_REG_R           Refresh                                     */
-uint8_t                     CPU_REG_R;
+ *  @param  cpu_reg_r           Offset of the register for each 'rrr' code
+ *                              in cpu_regs_t ( see REG_R )                 */
+extern
+const
+uint8_t                         cpu_reg_r[ 8 ];
 //----------------------------------------------------------------------------
 
 /****************************************************************************
@@ -294,6 +389,41 @@ reg_put_qq(
     uint16_t                    data
     );
 //----------------------------------------------------------------------------
+void
+flags_sync(
+    void
+    );
+//----------------------------------------------------------------------------
+uint8_t
+flags_get(
+    uint8_t                     mask
+    );
+//----------------------------------------------------------------------------
+uint8_t
+refresh_get(
+    void
+    );
+//----------------------------------------------------------------------------
+void
+refresh_put(
+    uint8_t                     data
+    );
+//----------------------------------------------------------------------------
+void
+refresh_advance(
+    uint32_t                    m1
+    );
+//----------------------------------------------------------------------------
+void
+refresh_acknowledge(
+    void
+    );
+//----------------------------------------------------------------------------
+void
+refresh_sync(
+    void
+    );
+//----------------------------------------------------------------------------
 
 /****************************************************************************/
 
@@ -38,7 +38,9 @@
 #include "global.h"             //  Global definitions
 #include "memory.h"             //  Memory management and access
 #include "registers.h"          //  All things CPU registers.
+#include "flags.h"              //  Precomputed condition flag tables
 #include "shift.h"              //  Shift and Rotate instructions
+#include "machine.h"            //  Guest machine context
                                 //*******************************************
 
 /****************************************************************************
@@ -153,7 +155,7 @@ shift_rlca_i80(
     // S is not affected.
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -227,7 +229,7 @@ shift_rla_i80(
     // S is not affected.
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -298,7 +300,7 @@ shift_rrca_i80(
     // S is not affected.
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -372,7 +374,7 @@ shift_rra_i80(
     // S is not affected.
 
     //  Set the number of states for this instruction
-    operation_rc.states =   4;
+    machine->operation_rc.states =   4;
 }
 
 /****************************************************************************/
@@ -435,10 +437,10 @@ shift_rrd_ED(
     CLEAR_FLAG_N( );
 
     //  PARITY/OVERFLOW
-    if ( parity_8( GET_A( ) & 0x00FF ) == 0 )
-        CLEAR_FLAG_PV( );       //  Parity Even
+    if ( ( flags_szp[ GET_A( ) & 0x00FF ] & CPU_FLAG_PV ) == 0 )
+        CLEAR_FLAG_PV( );       //  Parity Odd
     else
-        SET_FLAG_PV( );         //  Parity Odd
+        SET_FLAG_PV( );         //  Parity Even
 
     //  HALF CARRY
     CLEAR_FLAG_H( );
@@ -456,6 +458,6 @@ shift_rrd_ED(
         CLEAR_FLAG_S( );
 
     //  Set the number of states for this instruction
-    operation_rc.states =  18;
+    machine->operation_rc.states =  18;
 }
 /****************************************************************************/
\ No newline at end of file
@@ -0,0 +1,342 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Performance counters.
+ *
+ *  inst_fetch( ) resets the counters with stats_start( ) and the
+ *  instruction loops keep the instruction and clock state counts up to
+ *  date with STATS_SYNC( ).  The BIOS and the prefix fetch functions count
+ *  their own calls.  The counters are reported by the CP 'STATS' command,
+ *  on SIGUSR1 and as JSON when the BIOS shuts down.  printf( ) can't be
+ *  used in a signal handler, so SIGUSR1 only sets stats_requested and the
+ *  report is displayed at the next STATS_SYNC( ) or console poll:
+ *
+ *      MIPS            Instructions retired per host microsecond
+ *      MHz             Clock states executed per host microsecond, the
+ *                      clock speed of a real CPU doing the same work
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+#define _POSIX_C_SOURCE 200112L //  clock_gettime( )
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <inttypes.h>           //  PRIu64
+#include <stdlib.h>             //  ANSI standard library.
+#include <stdio.h>              //  Standard I/O definitions
+#include <string.h>             //  Functions for managing strings
+#include <time.h>               //  Time stuff
+                                //*******************************************
+
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "stats.h"              //  Performance counters
+#include "machine.h"            //  Guest machine context
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  NS_PER_SECOND       Nanoseconds in one second                   */
+#define NS_PER_SECOND           ( 1000000000 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  stats_requested     Set by SIGUSR1, the report is displayed by
+ *                              stats_poll( ) outside the signal handler    */
+volatile
+sig_atomic_t                    stats_requested;
+//----------------------------------------------------------------------------
+/**
+ *  @param  prefix_name         Names of the counted prefix tables          */
+static
+const
+char                        *   prefix_name[ STATS_PREFIXES ] =
+{
+    "CB", "DD", "ED", "FD"
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Read the monotonic host clock.
+ *
+ *  @param
+ *
+ *  @return                     Host time in nanoseconds.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+uint64_t
+stats_now(
+    void
+    )
+{
+    /**
+     *  @param  now             Current host time                           */
+    struct timespec             now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return( ( (uint64_t)now.tv_sec * NS_PER_SECOND ) + now.tv_nsec );
+}
+
+/****************************************************************************/
+/**
+ *  Host time of the run so far.
+ *
+ *  @param
+ *
+ *  @return                     Nanoseconds since stats_start( ), never 0.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+static
+uint64_t
+stats_host_ns(
+    void
+    )
+{
+    /**
+     *  @param  host_ns         Elapsed host time                           */
+    uint64_t                    host_ns;
+
+    //  Is the run still going ?
+    if ( machine->stats.stop_ns == 0 )
+    {
+        //  YES:    Measure up to now
+        host_ns = stats_now( ) - machine->stats.start_ns;
+    }
+    else
+    {
+        //  NO:     Measure up to the end of the run
+        host_ns = machine->stats.stop_ns - machine->stats.start_ns;
+    }
+
+    //  Keep the rates finite
+    return( ( host_ns == 0 ) ? 1 : host_ns );
+}
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Reset the counters at the start of a run.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+stats_start(
+    void
+    )
+{
+    //  Clear everything
+    memset( &machine->stats, 0, sizeof( machine->stats ) );
+
+    //  Start the host clock
+    machine->stats.start_ns = stats_now( );
+}
+
+/****************************************************************************/
+/**
+ *  Stop the host clock at the end of a run.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+void
+stats_stop(
+    void
+    )
+{
+    //  Stop the host clock
+    machine->stats.stop_ns = stats_now( );
+}
+
+/****************************************************************************/
+/**
+ *  Display the counters.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Used by the CP 'STATS' command and stats_poll( ).
+ *
+ ****************************************************************************/
+
+void
+stats_report(
+    void
+    )
+{
+    /**
+     *  @param  host_ns         Elapsed host time                           */
+    uint64_t                    host_ns;
+    /**
+     *  @param  prefix_ndx      Index into the prefix counters              */
+    int                         prefix_ndx;
+
+    host_ns = stats_host_ns( );
+
+    printf( "\r\nInstructions:   %"PRIu64"\r\n", machine->stats.instructions );
+    printf( "T-states:       %"PRIu64"\r\n", machine->stats.states );
+    printf( "Host time:      %.3f s\r\n",
+            (double)host_ns / NS_PER_SECOND );
+    printf( "MIPS:           %.2f\r\n",
+            (double)machine->stats.instructions * 1000.0 / host_ns );
+    printf( "Effective MHz:  %.2f\r\n",
+            (double)machine->stats.states * 1000.0 / host_ns );
+    printf( "BIOS traps:     %"PRIu64"\r\n", machine->stats.bios_traps );
+
+    for( prefix_ndx = 0; prefix_ndx < STATS_PREFIXES; prefix_ndx += 1 )
+    {
+        printf( "Prefix %s:      %"PRIu64"\r\n",
+                prefix_name[ prefix_ndx ], machine->stats.prefix[ prefix_ndx ] );
+    }
+    fflush( stdout );
+}
+
+/****************************************************************************/
+/**
+ *  Display the counters when SIGUSR1 asked for them.
+ *
+ *  @param
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called by STATS_SYNC( ) and while the console waits for a key.
+ *
+ ****************************************************************************/
+
+void
+stats_poll(
+    void
+    )
+{
+    //  Was a report asked for ?
+    if ( stats_requested != 0 )
+    {
+        //  YES:    Display it
+        stats_requested = 0;
+        stats_report( );
+    }
+}
+
+/****************************************************************************/
+/**
+ *  Write the counters as a JSON object.
+ *
+ *  @param  file                Where to write them.
+ *
+ *  @return                     No information is returned from this function.
+ *
+ *  @note
+ *      Called by bios_shutdown( ).
+ *
+ ****************************************************************************/
+
+void
+stats_json(
+    FILE                    *   file
+    )
+{
+    /**
+     *  @param  host_ns         Elapsed host time                           */
+    uint64_t                    host_ns;
+    /**
+     *  @param  prefix_ndx      Index into the prefix counters              */
+    int                         prefix_ndx;
+
+    host_ns = stats_host_ns( );
+
+    fprintf( file, "{\n" );
+    fprintf( file, "  \"instructions\": %"PRIu64",\n", machine->stats.instructions );
+    fprintf( file, "  \"t_states\": %"PRIu64",\n", machine->stats.states );
+    fprintf( file, "  \"host_ns\": %"PRIu64",\n", host_ns );
+    fprintf( file, "  \"mips\": %.3f,\n",
+             (double)machine->stats.instructions * 1000.0 / host_ns );
+    fprintf( file, "  \"effective_mhz\": %.3f,\n",
+             (double)machine->stats.states * 1000.0 / host_ns );
+    fprintf( file, "  \"bios_traps\": %"PRIu64",\n", machine->stats.bios_traps );
+    fprintf( file, "  \"prefix\": {" );
+
+    for( prefix_ndx = 0; prefix_ndx < STATS_PREFIXES; prefix_ndx += 1 )
+    {
+        fprintf( file, "%s \"%s\": %"PRIu64,
+                 ( prefix_ndx == 0 ) ? "" : ",",
+                 prefix_name[ prefix_ndx ], machine->stats.prefix[ prefix_ndx ] );
+    }
+    fprintf( file, " }\n" );
+    fprintf( file, "}\n" );
+    fflush( file );
+}
+
+/****************************************************************************/
@@ -0,0 +1,156 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+#ifndef STATS_H
+#define STATS_H
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Performance counters.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * System APIs
+ ****************************************************************************/
+
+                                //*******************************************
+#include <signal.h>             //  sig_atomic_t
+                                //*******************************************
+
+/****************************************************************************
+ * Application APIs
+ ****************************************************************************/
+
+                                //*******************************************
+                                //*******************************************
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  STATS_SYNC          Publish the instruction loop's running
+ *                              counts.  The loops keep them in locals and
+ *                              only store them at block or instruction
+ *                              boundaries, which is also where a report
+ *                              asked for by SIGUSR1 is displayed.          */
+#define STATS_SYNC( INSTRUCTIONS, STATES )                                  \
+                                do                                          \
+                                {                                           \
+                                    machine->stats.instructions = ( INSTRUCTIONS ); \
+                                    machine->stats.states = ( STATES );     \
+                                    if ( stats_requested != 0 )             \
+                                        stats_poll( );                      \
+                                }   while( 0 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  stats_prefix_e      Prefix tables that are counted              */
+enum    stats_prefix_e
+{
+    STATS_PREFIX_CB         = 0,                //  CB  Bit instructions
+    STATS_PREFIX_DD         = 1,                //  DD  IX instructions
+    STATS_PREFIX_ED         = 2,                //  ED  Extended instructions
+    STATS_PREFIX_FD         = 3,                //  FD  IY instructions
+    STATS_PREFIXES          = 4                 //  Number of prefixes
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  stats_t             Counters for one run of inst_fetch( )       */
+struct  stats_t
+{
+    /**
+     *  @param  instructions    Instructions retired                        */
+    uint64_t                    instructions;
+    /**
+     *  @param  states          Clock states executed                       */
+    uint64_t                    states;
+    /**
+     *  @param  bios_traps      CP/M BIOS calls ( OUT x'FF )                */
+    uint64_t                    bios_traps;
+    /**
+     *  @param  prefix          Dispatches through each prefix table        */
+    uint64_t                    prefix[ STATS_PREFIXES ];
+    /**
+     *  @param  start_ns        Host time the run started                   */
+    uint64_t                    start_ns;
+    /**
+     *  @param  stop_ns         Host time the run ended, zero while running */
+    uint64_t                    stop_ns;
+};
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  stats_requested     Set by SIGUSR1, the report is displayed by
+ *                              stats_poll( ) outside the signal handler    */
+extern
+volatile
+sig_atomic_t                    stats_requested;
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Prototypes
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+void
+stats_start(
+    void
+    );
+//----------------------------------------------------------------------------
+void
+stats_stop(
+    void
+    );
+//----------------------------------------------------------------------------
+void
+stats_report(
+    void
+    );
+//----------------------------------------------------------------------------
+void
+stats_poll(
+    void
+    );
+//----------------------------------------------------------------------------
+void
+stats_json(
+    FILE                    *   file
+    );
+//----------------------------------------------------------------------------
+
+/****************************************************************************/
+
+#endif                      //    STATS_H
@@ -0,0 +1,261 @@
+/*******************************  COPYRIGHT  ********************************/
+/*
+ *  Author? "Gregory N. Leonhardt"
+ *  License? "CC BY-NC 2.0"
+ *           "https://creativecommons.org/licenses/by-nc/2.0/"
+ *
+ ****************************************************************************/
+
+/******************************** JAVADOC ***********************************/
+/**
+ *  Fork server for batch jobs.
+ *
+ *  Started with --zygote {socket}, the emulator boots CP/M once without a
+ *  terminal.  The first time the CCP waits for a command, bios_conin( )
+ *  calls zygote_serve( ), which never returns in this process: it waits
+ *  on a Unix domain socket and forks once per connection.
+ *
+ *  The child inherits the booted guest, memory and BIOS state included,
+ *  copy-on-write.  It routes the console to the connection and gives
+ *  itself private copies of the mounted disks, so a job can not change
+ *  what the next job sees.  Everything the client sends is typed at the
+ *  CCP prompt, everything CP/M writes to the console is sent back, and
+ *  the job ends when the input is used up and CP/M asks for more.
+ *
+ *      printf 'DIR\nSTAT\n' | socat - UNIX-CONNECT:{socket}
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Compiler directives
+ ****************************************************************************/
+
+#define _DEFAULT_SOURCE         //  fork( ), struct sockaddr_un
+
+/****************************************************************************
+ * System Function
+ ****************************************************************************/
+
+                                //*******************************************
+#include <stdbool.h>            //  TRUE, FALSE, etc.
+#include <stdint.h>             //  Alternative storage types
+#include <stdlib.h>             //  ANSI standard library.
+#include <unistd.h>             //  UNIX standard library.
+#include <stdio.h>              //  Standard I/O definitions
+#include <string.h>             //  Functions for managing strings
+#include <errno.h>              //  EINTR
+#include <signal.h>             //  SIGCHLD
+#include <sys/socket.h>         //  socket( ), accept( )
+#include <sys/un.h>             //  struct sockaddr_un
+                                //*******************************************
+
+
+/****************************************************************************
+ * Application
+ ****************************************************************************/
+
+                                //*******************************************
+#include "global.h"             //  Global definitions
+#include "bios.h"               //  CP/M BIOS
+#include "zygote.h"             //  Fork server for batch jobs
+#include "machine.h"            //  Guest machine context
+                                //*******************************************
+
+/****************************************************************************
+ * Enumerations
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Definitions
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  ZYGOTE_BACKLOG      Connections waiting to be forked            */
+#define ZYGOTE_BACKLOG          ( 16 )
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Structures
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Storage Allocation
+ ****************************************************************************/
+
+//----------------------------------------------------------------------------
+/**
+ *  @param  zygote_fd           Listening socket, -1 in a job or when off   */
+static
+int                             zygote_fd = -1;
+//----------------------------------------------------------------------------
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * MAIN
+ ****************************************************************************/
+
+/****************************************************************************/
+/**
+ *  Open the socket jobs connect to.
+ *
+ *  @param  socket_name         Path of the Unix domain socket, an existing
+ *                              file of that name is replaced.
+ *
+ *  @return                     TRUE when the socket is listening, else
+ *                              FALSE is returned.
+ *
+ *  @note
+ *      Called before the guest boots.  Children are not waited for.
+ *
+ ****************************************************************************/
+
+int
+zygote_init(
+    const
+    char                    *   socket_name
+    )
+{
+    /**
+     *  @param  address         Address of the socket                       */
+    struct  sockaddr_un         address;
+
+    //  Will the name fit ?
+    if ( strlen( socket_name ) >= sizeof( address.sun_path ) )
+    {
+        //  NO:     Can't be used
+        return( false );
+    }
+
+    memset( &address, 0, sizeof( address ) );
+    address.sun_family = AF_UNIX;
+    strcpy( address.sun_path, socket_name );
+
+    //  Create, bind and listen
+    zygote_fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if ( zygote_fd < 0 )
+    {
+        return( false );
+    }
+    unlink( socket_name );
+    if (    ( bind( zygote_fd, (struct sockaddr *)&address, sizeof( address ) ) != 0 )
+         || ( listen( zygote_fd, ZYGOTE_BACKLOG )                                != 0 ) )
+    {
+        close( zygote_fd );
+        zygote_fd = -1;
+        return( false );
+    }
+
+    //  Finished jobs are reaped by the kernel
+    signal( SIGCHLD, SIG_IGN );
+
+    //  DONE!
+    return( true );
+}
+
+/****************************************************************************/
+/**
+ *  Is this the fork server, still waiting for its first prompt ?
+ *
+ *  @param
+ *
+ *  @return                     TRUE in the fork server, FALSE in a job or
+ *                              when --zygote was not given.
+ *
+ *  @note
+ *
+ ****************************************************************************/
+
+bool
+zygote_armed(
+    void
+    )
+{
+    //  DONE!
+    return( zygote_fd >= 0 );
+}
+
+/****************************************************************************/
+/**
+ *  Fork a job for every connection.
+ *
+ *  @param
+ *
+ *  @return                     Only returns in a job, with the console of
+ *                              the bound guest routed to the connection.
+ *
+ *  @note
+ *      Called by the BIOS the first time the booted guest waits for input.
+ *
+ ****************************************************************************/
+
+void
+zygote_serve(
+    void
+    )
+{
+    /**
+     *  @param  job_fd          Connection of the job                       */
+    int                         job_fd;
+    /**
+     *  @param  pid             Process ID of the job                       */
+    pid_t                       pid;
+
+    printf( "ZYGOTE: ready\n" );
+    fflush( stdout );
+
+    //  Loop forever
+    for( ; ; )
+    {
+        //  Wait for a job
+        job_fd = accept( zygote_fd, NULL, NULL );
+        if ( job_fd < 0 )
+        {
+            //  Was it a signal ?
+            if ( errno == EINTR )
+            {
+                //  YES:    Keep waiting
+                continue;
+            }
+            perror( "ZYGOTE: accept" );
+            exit( 1 );
+        }
+
+        //  Flush before the child gets a copy of the buffers
+        fflush( stdout );
+
+        pid = fork( );
+        if ( pid == 0 )
+        {
+            //  The job:    It is not a fork server
+            close( zygote_fd );
+            zygote_fd = -1;
+
+            //  Talk to the client and keep the disks to itself
+            bios_console_fd( job_fd, job_fd );
+            bios_private_disks( );
+
+            //  Run the job
+            return;
+        }
+        else
+        if ( pid < 0 )
+        {
+            perror( "ZYGOTE: fork" );
+        }
+
+        //  The job has its own copy of the connection
+        close( job_fd );
+    }
+}
+
+/****************************************************************************/